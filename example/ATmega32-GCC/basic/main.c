@@ -38,7 +38,7 @@
 
 int main(void)
 {
-  HT1382_Handler_t Handler;
+  HT1382_Handler_t Handler = {0};
   HT1382_DateTime_t DateTime =
   {
     .Second   = 0,
@@ -0,0 +1,192 @@
+/**
+ **********************************************************************************
+ * @file   main.c
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  benchmark firmware for HT1382 Driver (for ATmega32 under simavr)
+ **********************************************************************************
+ *
+ * Copyright (c) 2024 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+
+/**
+ * Every measured call is bracketed by writes to BENCH_MARK_PORT: the call id
+ * before the call and 0 after it. The simavr harness (sim/bench_sim.c)
+ * timestamps those writes with the simulator cycle counter, so the counts are
+ * exact and include no printf or measurement overhead.
+ *
+ * For HT1382_SetDateTime, HT1382_FireDateTime and HT1382_WriteRaw (the same
+ * time as a compile-time image) the start marker stands for the sync edge:
+ * the harness also reports the time from it to the write of the seconds
+ * register.
+ *
+ * HT1382_StampEnc_PutRegs converts the date only on the first of its runs
+ * (max cycles) and decodes just the seconds register on the others (min
+ * cycles). HT1382_StampDec_Get decodes keyframes.
+ *
+ * The firmware itself reports the stack high-water mark of each call: the
+ * free RAM below the stack is painted with BENCH_STACK_PAINT before the call
+ * and scanned afterwards.
+ */
+
+#include <stdio.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+#include <util/delay.h>
+#include "Retarget.h"
+#include "HT1382.h"
+#include "HT1382_platform.h"
+#include "HT1382_time.h"
+#include "HT1382_tz.h"
+#include "HT1382_tz_zones.h"
+#include "HT1382_stamp.h"
+
+
+#define BENCH_MARK_PORT     PORTC
+#define BENCH_MARK_DDR      DDRC
+#define BENCH_REPEAT        4
+#define BENCH_STACK_PAINT   0xC5
+#define BENCH_STACK_GUARD   32
+
+
+extern uint8_t __heap_start;
+
+static HT1382_Handler_t Handler = {0};
+static HT1382_DateTime_t DateTime =
+{
+  .Second   = 50,
+  .Minute   = 59,
+  .Hour     = 23,
+  .WeekDay  = 1,
+  .Day      = 31,
+  .Month    = 12,
+  .Year     = 23
+};
+static const uint8_t DateTimeImage[] = HT1382_TIME_IMAGE(50, 59, 23, 1, 31, 12, 23);
+static HT1382_StampEnc_t StampEnc;
+static HT1382_StampDec_t StampDec;
+static uint8_t Stamp[HT1382_STAMP_RECORD_MAX];
+
+
+static uint8_t *
+Bench_StackPaint(void)
+{
+  uint8_t *Bottom = &__heap_start;
+  uint8_t *Top = (uint8_t *)SP - BENCH_STACK_GUARD;
+  uint8_t *p;
+
+  for (p = Bottom; p < Top; p++)
+    *p = BENCH_STACK_PAINT;
+
+  return Top;
+}
+
+static uint16_t
+Bench_StackUsed(uint8_t *Top)
+{
+  uint8_t *p = &__heap_start;
+
+  while (p < Top && *p == BENCH_STACK_PAINT)
+    p++;
+
+  return (uint16_t)(Top - p);
+}
+
+// PREP runs before each measured CALL, outside the markers
+#define BENCH_RUN_PREP(ID, NAME, PREP, CALL)                          \
+  do                                                                  \
+  {                                                                   \
+    uint8_t *Top_ = Bench_StackPaint();                               \
+    uint8_t i_;                                                       \
+    for (i_ = 0; i_ < BENCH_REPEAT; i_++)                             \
+    {                                                                 \
+      PREP;                                                           \
+      BENCH_MARK_PORT = (ID);                                         \
+      CALL;                                                           \
+      BENCH_MARK_PORT = 0;                                            \
+    }                                                                 \
+    printf("stack %-22s %4u bytes\r\n", NAME, Bench_StackUsed(Top_)); \
+  } while (0)
+
+#define BENCH_RUN(ID, NAME, CALL) BENCH_RUN_PREP(ID, NAME, (void)0, CALL)
+
+
+int main(void)
+{
+  HT1382_Image_t Image;
+  HT1382_Status_t Status;
+  HT1382_Query_t Query;
+  uint32_t Epoch = 0;
+  uint32_t Local = 0;
+
+  BENCH_MARK_DDR = 0xFF;
+  BENCH_MARK_PORT = 0;
+
+  Retarget_Init(F_CPU, 9600);
+  printf("HT1382 benchmark\r\n");
+
+  HT1382_Platform_Init(&Handler);
+
+  // status tick: time, ST2/INT and USR1-4 (2 bursts instead of 3)
+  HT1382_Query_Init(&Query);
+  HT1382_Query_Add(&Query, HT1382_QUERY_TIME);
+  HT1382_Query_Add(&Query, HT1382_QUERY_REGS(HT1382_REG_ADDR_ST2, 2));
+  HT1382_Query_Add(&Query, HT1382_QUERY_REGS(HT1382_REG_ADDR_USR1, 4));
+
+  BENCH_RUN(1, "HT1382_Init",         HT1382_Init(&Handler));
+  BENCH_RUN(2, "HT1382_SetDateTime",  HT1382_SetDateTime(&Handler, &DateTime));
+  BENCH_RUN(3, "HT1382_GetDateTime",  HT1382_GetDateTime(&Handler, &DateTime));
+  BENCH_RUN(4, "HT1382_SetOutWave",   HT1382_SetOutWave(&Handler, HT1382_OUTWAVE_1HZ));
+  BENCH_RUN(5, "HT1382_ReadImage",    HT1382_ReadImage(&Handler, &Image));
+  BENCH_RUN(6, "HT1382_WriteImage",   HT1382_WriteImage(&Handler, &Image, NULL, HT1382_IMAGE_EXCLUDE_TIME));
+  BENCH_RUN(7, "HT1382_Probe",        HT1382_Probe(&Handler, &Status, HT1382_PROBE_READ_ONLY));
+  BENCH_RUN(8, "HT1382_Time_ToEpoch", Epoch = HT1382_Time_ToEpoch(&DateTime));
+  BENCH_RUN(9, "HT1382_Time_FromEpoch", HT1382_Time_FromEpoch(Epoch, &DateTime));
+  BENCH_RUN(10, "HT1382_Tz_ToLocal",  Local = HT1382_Tz_ToLocal(&HT1382_TzZones[HT1382_TZ_BENCH], Epoch, NULL));
+  BENCH_RUN(11, "HT1382_Tz_ToUtc",    Epoch = HT1382_Tz_ToUtc(&HT1382_TzZones[HT1382_TZ_BENCH], Local, HT1382_TZ_EARLIER));
+  BENCH_RUN(12, "HT1382_ArmDateTime", HT1382_ArmDateTime(&Handler, &DateTime));
+  BENCH_RUN_PREP(13, "HT1382_FireDateTime", HT1382_ArmDateTime(&Handler, &DateTime),
+                 HT1382_FireDateTime(&Handler));
+  BENCH_RUN(14, "HT1382_ReadQuery",   HT1382_ReadQuery(&Handler, &Query));
+  BENCH_RUN(15, "HT1382_WriteRaw",    HT1382_WriteRaw(&Handler, DateTimeImage, sizeof(DateTimeImage)));
+
+  // stamp codec: the first stamp is a keyframe, the others 1-byte deltas
+  HT1382_StampEnc_Init(&StampEnc, 256);
+  HT1382_StampDec_Init(&StampDec);
+  BENCH_RUN(16, "HT1382_StampEnc_Put", HT1382_StampEnc_Put(&StampEnc, Epoch, Stamp));
+  BENCH_RUN(17, "HT1382_StampEnc_PutRegs", HT1382_StampEnc_PutRegs(&StampEnc, &DateTimeImage[1], Stamp));
+  BENCH_RUN_PREP(18, "HT1382_StampDec_Get", HT1382_StampEnc_Key(&StampEnc);
+                 HT1382_StampEnc_Put(&StampEnc, Epoch, Stamp),
+                 HT1382_StampDec_Get(&StampDec, Stamp, sizeof(Stamp), &Epoch));
+
+  printf("done\r\n");
+  _delay_ms(20); // let the UART drain
+
+  // tell simavr we are finished
+  cli();
+  sleep_enable();
+  sleep_cpu();
+
+  return 0;
+}
@@ -0,0 +1,325 @@
+/**
+ **********************************************************************************
+ * @file   bench_sim.c
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  simavr harness: runs the benchmark firmware against a simulated HT1382
+ **********************************************************************************
+ *
+ * Copyright (c) 2024 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+
+/**
+ * Usage: bench_sim FIRMWARE.elf
+ *
+ * - Attaches an HT1382 model (I2C address 0x68, 21 registers, auto-increment
+ *   register pointer, seconds ticking with the simulated clock) to TWI.
+ * - Forwards UART0 output to stdout.
+ * - Watches PORTC: a write of a non-zero id starts a measurement, a write of
+ *   0 ends it. Min/max cycles per id are printed when the firmware sleeps
+ *   with interrupts disabled.
+ * - For calls that write the seconds register, also prints the cycles from
+ *   the start marker to the write of the seconds byte (edge-to-write
+ *   latency of HT1382_SetDateTime and HT1382_FireDateTime).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sim_avr.h"
+#include "sim_elf.h"
+#include "avr_twi.h"
+#include "avr_uart.h"
+#include "avr_ioport.h"
+
+
+#define HT1382_SIM_ADDRESS  (0x68 << 1)
+#define HT1382_SIM_REGS     0x15
+#define BENCH_IDS           19
+
+
+typedef struct HT1382_Sim_s
+{
+  avr_t       *Avr;
+  avr_irq_t   *Irq;
+  uint8_t     Regs[HT1382_SIM_REGS];
+  uint8_t     Pointer;
+  uint8_t     Selected;
+  uint8_t     Index;
+  avr_cycle_count_t SecondStart;
+  avr_cycle_count_t SecondsWritten;
+} HT1382_Sim_t;
+
+typedef struct Bench_s
+{
+  HT1382_Sim_t      *Sim;
+  uint8_t           Id;
+  avr_cycle_count_t Start;
+  avr_cycle_count_t Min[BENCH_IDS];
+  avr_cycle_count_t Max[BENCH_IDS];
+  unsigned          Runs[BENCH_IDS];
+  avr_cycle_count_t ToWrite[BENCH_IDS];
+} Bench_t;
+
+
+static const char *Bench_Names[BENCH_IDS] =
+{
+  NULL,
+  "HT1382_Init", "HT1382_SetDateTime", "HT1382_GetDateTime",
+  "HT1382_SetOutWave", "HT1382_ReadImage", "HT1382_WriteImage",
+  "HT1382_Probe", "HT1382_Time_ToEpoch", "HT1382_Time_FromEpoch",
+  "HT1382_Tz_ToLocal", "HT1382_Tz_ToUtc", "HT1382_ArmDateTime",
+  "HT1382_FireDateTime", "HT1382_ReadQuery", "HT1382_WriteRaw",
+  "HT1382_StampEnc_Put", "HT1382_StampEnc_PutRegs", "HT1382_StampDec_Get",
+};
+
+
+/* HT1382 model -----------------------------------------------------------------*/
+static uint8_t
+BCD_Inc(uint8_t Value, uint8_t Limit, uint8_t *Carry)
+{
+  uint8_t Dec = (Value >> 4) * 10 + (Value & 0x0F) + 1;
+
+  *Carry = (Dec >= Limit);
+  if (*Carry)
+    Dec = 0;
+
+  return (uint8_t)(((Dec / 10) << 4) | (Dec % 10));
+}
+
+static void
+HT1382_Sim_Tick(HT1382_Sim_t *Sim)
+{
+  uint8_t Carry = 0;
+
+  // only seconds/minutes/hours roll over; enough for benchmark runs
+  while (Sim->Avr->cycle - Sim->SecondStart >= Sim->Avr->frequency)
+  {
+    Sim->SecondStart += Sim->Avr->frequency;
+    if (Sim->Regs[0] & 0x80)
+      continue; // CH: oscillator stopped
+    Sim->Regs[0] = BCD_Inc(Sim->Regs[0], 60, &Carry);
+    if (Carry)
+      Sim->Regs[1] = BCD_Inc(Sim->Regs[1], 60, &Carry);
+    if (Carry)
+      Sim->Regs[2] = (Sim->Regs[2] & 0x80) | BCD_Inc(Sim->Regs[2] & 0x3F, 24, &Carry);
+  }
+}
+
+static void
+HT1382_Sim_Hook(struct avr_irq_t *Irq, uint32_t Value, void *Param)
+{
+  HT1382_Sim_t *Sim = (HT1382_Sim_t *)Param;
+  avr_twi_msg_irq_t Msg;
+
+  (void)Irq;
+  Msg.u.v = Value;
+
+  if (Msg.u.twi.msg & TWI_COND_STOP)
+    Sim->Selected = 0;
+
+  if (Msg.u.twi.msg & TWI_COND_START)
+  {
+    Sim->Selected = 0;
+    Sim->Index = 0;
+    if ((Msg.u.twi.addr & 0xFE) == HT1382_SIM_ADDRESS)
+    {
+      Sim->Selected = Msg.u.twi.addr;
+      HT1382_Sim_Tick(Sim);
+      avr_raise_irq(Sim->Irq + TWI_IRQ_INPUT,
+                    avr_twi_irq_msg(TWI_COND_ACK, Sim->Selected, 1));
+    }
+  }
+
+  if (!Sim->Selected)
+    return;
+
+  if (Msg.u.twi.msg & TWI_COND_WRITE)
+  {
+    avr_raise_irq(Sim->Irq + TWI_IRQ_INPUT,
+                  avr_twi_irq_msg(TWI_COND_ACK, Sim->Selected, 1));
+    if (Sim->Index++ == 0)
+    {
+      Sim->Pointer = Msg.u.twi.data % HT1382_SIM_REGS;
+    }
+    else
+    {
+      // writes other than ST1 are ignored while WP is set
+      if (Sim->Pointer == 0x07 || !(Sim->Regs[0x07] & 0x80))
+      {
+        Sim->Regs[Sim->Pointer] = Msg.u.twi.data;
+        if (Sim->Pointer == 0x00)
+          Sim->SecondsWritten = Sim->Avr->cycle;
+      }
+      if (Sim->Pointer == 0x00)
+        Sim->SecondStart = Sim->Avr->cycle;
+      Sim->Pointer = (Sim->Pointer + 1) % HT1382_SIM_REGS;
+    }
+  }
+
+  if (Msg.u.twi.msg & TWI_COND_READ)
+  {
+    avr_raise_irq(Sim->Irq + TWI_IRQ_INPUT,
+                  avr_twi_irq_msg(TWI_COND_READ, Sim->Selected, Sim->Regs[Sim->Pointer]));
+    Sim->Pointer = (Sim->Pointer + 1) % HT1382_SIM_REGS;
+  }
+}
+
+static void
+HT1382_Sim_Attach(HT1382_Sim_t *Sim, avr_t *Avr)
+{
+  static const char *Names[2] =
+  {
+    [TWI_IRQ_INPUT]  = "8>ht1382.out",
+    [TWI_IRQ_OUTPUT] = "32<ht1382.in",
+  };
+
+  memset(Sim, 0, sizeof(*Sim));
+  Sim->Avr = Avr;
+  Sim->Regs[0x02] = 0x80; // 24h mode
+  Sim->Regs[0x03] = 0x01;
+  Sim->Regs[0x04] = 0x01;
+  Sim->Regs[0x05] = 0x01;
+  Sim->Regs[0x07] = 0x80; // WP
+
+  Sim->Irq = avr_alloc_irq(&Avr->irq_pool, 0, 2, Names);
+  avr_irq_register_notify(Sim->Irq + TWI_IRQ_OUTPUT, HT1382_Sim_Hook, Sim);
+  avr_connect_irq(Sim->Irq + TWI_IRQ_INPUT,
+                  avr_io_getirq(Avr, AVR_IOCTL_TWI_GETIRQ(0), TWI_IRQ_INPUT));
+  avr_connect_irq(avr_io_getirq(Avr, AVR_IOCTL_TWI_GETIRQ(0), TWI_IRQ_OUTPUT),
+                  Sim->Irq + TWI_IRQ_OUTPUT);
+}
+
+
+/* UART and markers -------------------------------------------------------------*/
+static void
+Uart_Hook(struct avr_irq_t *Irq, uint32_t Value, void *Param)
+{
+  (void)Irq;
+  (void)Param;
+  if (Value != '\r')
+    putchar((int)Value);
+}
+
+static avr_t *Bench_Avr = NULL;
+
+static void
+Port_Hook(struct avr_irq_t *Irq, uint32_t Value, void *Param)
+{
+  Bench_t *Bench = (Bench_t *)Param;
+  avr_cycle_count_t Cycles;
+
+  (void)Irq;
+  Value &= 0xFF;
+  if (Value && !Bench->Id)
+  {
+    Bench->Id = (uint8_t)(Value % BENCH_IDS);
+    Bench->Start = Bench_Avr->cycle;
+  }
+  else if (!Value && Bench->Id)
+  {
+    Cycles = Bench_Avr->cycle - Bench->Start;
+    if (!Bench->Runs[Bench->Id] || Cycles < Bench->Min[Bench->Id])
+      Bench->Min[Bench->Id] = Cycles;
+    if (Cycles > Bench->Max[Bench->Id])
+      Bench->Max[Bench->Id] = Cycles;
+    Bench->Runs[Bench->Id]++;
+    if (Bench->Sim->SecondsWritten > Bench->Start)
+    {
+      Cycles = Bench->Sim->SecondsWritten - Bench->Start;
+      if (!Bench->ToWrite[Bench->Id] || Cycles < Bench->ToWrite[Bench->Id])
+        Bench->ToWrite[Bench->Id] = Cycles;
+    }
+    Bench->Id = 0;
+  }
+}
+
+
+int main(int argc, char *argv[])
+{
+  elf_firmware_t Firmware;
+  HT1382_Sim_t Sim;
+  Bench_t Bench;
+  avr_t *Avr = NULL;
+  uint32_t Flags = 0;
+  int State = cpu_Running;
+  int i;
+
+  if (argc < 2)
+  {
+    fprintf(stderr, "usage: %s FIRMWARE.elf\n", argv[0]);
+    return 2;
+  }
+
+  memset(&Firmware, 0, sizeof(Firmware));
+  if (elf_read_firmware(argv[1], &Firmware) != 0)
+  {
+    fprintf(stderr, "cannot read %s\n", argv[1]);
+    return 1;
+  }
+  if (!Firmware.mmcu[0])
+    strcpy(Firmware.mmcu, "atmega32");
+  if (!Firmware.frequency)
+    Firmware.frequency = 8000000;
+
+  Avr = avr_make_mcu_by_name(Firmware.mmcu);
+  if (!Avr)
+  {
+    fprintf(stderr, "unknown MCU %s\n", Firmware.mmcu);
+    return 1;
+  }
+  avr_init(Avr);
+  avr_load_firmware(Avr, &Firmware);
+  Bench_Avr = Avr;
+
+  HT1382_Sim_Attach(&Sim, Avr);
+
+  avr_ioctl(Avr, AVR_IOCTL_UART_GET_FLAGS('0'), &Flags);
+  Flags &= ~AVR_UART_FLAG_STDIO;
+  avr_ioctl(Avr, AVR_IOCTL_UART_SET_FLAGS('0'), &Flags);
+  avr_irq_register_notify(avr_io_getirq(Avr, AVR_IOCTL_UART_GETIRQ('0'), UART_IRQ_OUTPUT),
+                          Uart_Hook, NULL);
+
+  memset(&Bench, 0, sizeof(Bench));
+  Bench.Sim = &Sim;
+  avr_irq_register_notify(avr_io_getirq(Avr, AVR_IOCTL_IOPORT_GETIRQ('C'), IOPORT_IRQ_PIN_ALL),
+                          Port_Hook, &Bench);
+
+  while (State != cpu_Done && State != cpu_Crashed)
+    State = avr_run(Avr);
+
+  printf("\n%-24s %10s %10s %10s %10s\n", "function", "cycles", "max", "us@F_CPU", "us to sec");
+  for (i = 1; i < BENCH_IDS; i++)
+  {
+    if (!Bench.Runs[i])
+      continue;
+    printf("%-24s %10llu %10llu %10.1f", Bench_Names[i] ? Bench_Names[i] : "?",
+           (unsigned long long)Bench.Min[i], (unsigned long long)Bench.Max[i],
+           (double)Bench.Min[i] * 1e6 / Avr->frequency);
+    if (Bench.ToWrite[i])
+      printf(" %10.1f", (double)Bench.ToWrite[i] * 1e6 / Avr->frequency);
+    printf("\n");
+  }
+
+  return State == cpu_Crashed ? 1 : 0;
+}
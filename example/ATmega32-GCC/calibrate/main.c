@@ -0,0 +1,80 @@
+/**
+ **********************************************************************************
+ * @file   main.c
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  RC oscillator calibration example for HT1382 Driver (for ATmega32)
+ **********************************************************************************
+ *
+ * Copyright (c) 2024 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+
+
+/**
+ * Wire SQW/OUT to ICP1 (PD6). The MCU runs from its internal 8 MHz RC
+ * oscillator: it is trimmed to the RTC with a full search at startup,
+ * before the UART is used, and tracked every 10 seconds afterwards.
+ */
+
+#include <stdio.h>
+#include <avr/io.h>
+#include <util/delay.h>
+#include "Retarget.h"
+#include "HT1382.h"
+#include "HT1382_platform.h"
+#include "HT1382_cal.h"
+
+
+int main(void)
+{
+  HT1382_Handler_t Handler = {0};
+  HT1382_Cal_t Cal;
+  HT1382_Result_t Result;
+  uint8_t FactoryTrim = OSCCAL;
+
+  HT1382_Platform_Init(&Handler);
+  HT1382_Init(&Handler);
+  HT1382_Platform_CalInit(&Cal, &Handler);
+  Result = HT1382_Cal_Run(&Cal, HT1382_CAL_SEARCH);
+
+  Retarget_Init(F_CPU, 9600);
+  printf("HT1382 Calibration Example\r\n\r\n");
+  printf("Search: %s, OSCCAL 0x%02X -> 0x%02X, %ld ppm, %u measurements\r\n",
+         Result == HT1382_OK ? "ok" : "failed", FactoryTrim, Cal.Trim,
+         (long)Cal.ErrorPpm, Cal.Measurements);
+
+  while (1)
+  {
+    _delay_ms(10000);
+
+    // wait for the UART to finish before the clock moves
+    _delay_ms(10);
+    Result = HT1382_Cal_Run(&Cal, HT1382_CAL_TRACK);
+    printf("Track: %s, OSCCAL 0x%02X, %ld ppm, %u measurements\r\n",
+           Result == HT1382_OK ? "ok" : "failed", Cal.Trim,
+           (long)Cal.ErrorPpm, Cal.Measurements);
+  }
+
+  HT1382_DeInit(&Handler);
+  return 0;
+}
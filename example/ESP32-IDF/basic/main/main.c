@@ -42,7 +42,7 @@ static const char *TAG = "example";
 
 void app_main(void)
 {
-  HT1382_Handler_t Handler;
+  HT1382_Handler_t Handler = {0};
   HT1382_DateTime_t DateTime =
   {
     .Second   = 0,
@@ -0,0 +1,140 @@
+/**
+ **********************************************************************************
+ * @file   main.cpp
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  Host benchmark: C API vs header-only ht1382::Device<Bus>
+ **********************************************************************************
+ *
+ * Copyright (c) 2024 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+
+/**
+ * Both APIs drive the same in-memory HT1382 model (RamBus), so the numbers
+ * isolate driver overhead: function-pointer dispatch and out-of-line calls
+ * in the C API against the inlined template. "make asm" dumps the generated
+ * code of both paths for comparison.
+ *
+ * The C API is built with HT1382_CONFIG_SHADOW=0 (see makefile) and the out
+ * wave alternates, so SetOutWave reads and writes INT on both sides.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <ctime>
+#include "HT1382.h"
+#include "HT1382.hpp"
+
+
+#define BENCH_ITERATIONS  10000000UL
+
+
+struct RamBus
+{
+  static uint8_t Regs[0x15];
+  static uint8_t Pointer;
+
+  static int8_t
+  Send(uint8_t Address, uint8_t *Data, uint8_t Len)
+  {
+    (void)Address;
+    Pointer = Data[0];
+    for (uint8_t i = 1; i < Len; i++)
+      Regs[(Pointer + i - 1) % sizeof(Regs)] = Data[i];
+    return 0;
+  }
+
+  static int8_t
+  Receive(uint8_t Address, uint8_t *Data, uint8_t Len)
+  {
+    (void)Address;
+    for (uint8_t i = 0; i < Len; i++)
+      Data[i] = Regs[(Pointer + i) % sizeof(Regs)];
+    return 0;
+  }
+};
+
+uint8_t RamBus::Regs[0x15];
+uint8_t RamBus::Pointer;
+
+typedef ht1382::Device<RamBus> Rtc;
+typedef ht1382::clock<RamBus> RtcClock;
+
+
+template <class Func>
+static double
+Bench_NsPerCall(Func F)
+{
+  auto Start = std::chrono::steady_clock::now();
+  for (unsigned long i = 0; i < BENCH_ITERATIONS; i++)
+    F();
+  auto End = std::chrono::steady_clock::now();
+
+  return std::chrono::duration<double, std::nano>(End - Start).count() / BENCH_ITERATIONS;
+}
+
+
+static HT1382_OutWave_t
+Bench_Wave(unsigned i)
+{
+  return (i & 1) ? HT1382_OUTWAVE_4096HZ : HT1382_OUTWAVE_1HZ;
+}
+
+
+int main(void)
+{
+  HT1382_Handler_t Handler = {};
+  HT1382_DateTime_t DateTime = {0, 2, 10, 5, 23, 11, 23};
+  volatile uint8_t Sink = 0;
+  unsigned Wave = 0;
+  struct tm Tm = {};
+
+  HT1382_PLATFORM_LINK_SEND(&Handler, RamBus::Send);
+  HT1382_PLATFORM_LINK_RECEIVE(&Handler, RamBus::Receive);
+  HT1382_Init(&Handler);
+
+  printf("%-28s %10s %10s\n", "operation", "C API", "C++");
+  printf("%-28s %7.2f ns %7.2f ns\n", "SetDateTime",
+         Bench_NsPerCall([&] { HT1382_SetDateTime(&Handler, &DateTime); }),
+         Bench_NsPerCall([&] { Rtc::SetDateTime(DateTime); }));
+  printf("%-28s %7.2f ns %7.2f ns\n", "GetDateTime",
+         Bench_NsPerCall([&] { HT1382_GetDateTime(&Handler, &DateTime); Sink = DateTime.Second; }),
+         Bench_NsPerCall([&] { Rtc::GetDateTime(DateTime); Sink = DateTime.Second; }));
+  printf("%-28s %7.2f ns %7.2f ns\n", "SetOutWave",
+         Bench_NsPerCall([&] { HT1382_SetOutWave(&Handler, Bench_Wave(Wave++)); }),
+         Bench_NsPerCall([&] { Rtc::SetOutWave(Bench_Wave(Wave++)); }));
+  printf("%-28s %10s %7.2f ns\n", "clock::now", "-",
+         Bench_NsPerCall([&] { Sink = (uint8_t)RtcClock::now().time_since_epoch().count(); }));
+  (void)Sink;
+
+  Tm.tm_year = 123; Tm.tm_mon = 10; Tm.tm_mday = 23; Tm.tm_hour = 10; Tm.tm_min = 2;
+  Rtc::SetDateTime(DateTime);
+  if (RtcClock::to_time_t(RtcClock::now()) != timegm(&Tm))
+  {
+    printf("clock::now mismatch\n");
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,486 @@
+/**
+ **********************************************************************************
+ * @file   HT1382_fleet.c
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  Parallel set/verify engine for racks of HT1382 boards
+ **********************************************************************************
+ *
+ * Copyright (c) 2024 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+
+
+/* Includes ---------------------------------------------------------------------*/
+#include "HT1382_fleet.h"
+#include "HT1382_time.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/i2c-dev.h>
+
+
+/* Private Data Types -----------------------------------------------------------*/
+typedef struct Fleet_Worker_s
+{
+  HT1382_Fleet_t *Fleet;
+  uint8_t        Bus;
+  pthread_t      Thread;
+} Fleet_Worker_t;
+
+typedef struct Fleet_I2cDev_s
+{
+  int Fd;
+  int SlaveAddress;
+} Fleet_I2cDev_t;
+
+
+/* Private Variables ------------------------------------------------------------*/
+// bus of the calling worker, used by the platform functions of all handlers
+static _Thread_local HT1382_FleetBus_t *Fleet_CurrentBus = NULL;
+
+static const char *const Fleet_ResultNames[] =
+{
+  [HT1382_FLEET_PASS]     = "PASS",
+  [HT1382_FLEET_NOT_RUN]  = "NOT_RUN",
+  [HT1382_FLEET_MUX]      = "FAIL_MUX",
+  [HT1382_FLEET_SET]      = "FAIL_SET",
+  [HT1382_FLEET_READ]     = "FAIL_READ",
+  [HT1382_FLEET_STOPPED]  = "FAIL_STOPPED",
+  [HT1382_FLEET_DRIFT]    = "FAIL_DRIFT",
+};
+
+
+
+/**
+ ==================================================================================
+                           ##### Private Functions #####                           
+ ==================================================================================
+ */
+
+static uint64_t
+Fleet_NowNs(void)
+{
+  struct timespec Ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &Ts);
+  return (uint64_t)Ts.tv_sec * 1000000000ULL + (uint64_t)Ts.tv_nsec;
+}
+
+static void
+Fleet_SleepUntil(uint64_t Ns)
+{
+  struct timespec Ts;
+  int Err;
+
+  Ts.tv_sec = (time_t)(Ns / 1000000000ULL);
+  Ts.tv_nsec = (long)(Ns % 1000000000ULL);
+  // restart after a signal, any other error returns at once
+  do
+  {
+    Err = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &Ts, NULL);
+  } while (Err == EINTR);
+}
+
+static int8_t
+Fleet_Send(uint8_t Address, uint8_t *Data, uint8_t DataLen)
+{
+  HT1382_FleetBus_t *Bus = Fleet_CurrentBus;
+
+  return Bus->Send(Bus->Context, Address, Data, DataLen);
+}
+
+static int8_t
+Fleet_Receive(uint8_t Address, uint8_t *Data, uint8_t DataLen)
+{
+  HT1382_FleetBus_t *Bus = Fleet_CurrentBus;
+
+  return Bus->Receive(Bus->Context, Address, Data, DataLen);
+}
+
+/**
+ * @brief  Route the bus to Device, releasing the channel of another mux
+ */
+static int8_t
+Fleet_Select(HT1382_FleetBus_t *Bus, const HT1382_FleetDevice_t *Device)
+{
+  uint8_t Mask = 0;
+
+  if (Bus->MuxAddress == Device->MuxAddress &&
+      (Bus->MuxAddress == HT1382_FLEET_NO_MUX || Bus->MuxChannel == Device->MuxChannel))
+    return 0;
+
+  if (Bus->MuxAddress != HT1382_FLEET_NO_MUX &&
+      Bus->MuxAddress != Device->MuxAddress)
+  {
+    if (Bus->Send(Bus->Context, Bus->MuxAddress, &Mask, 1) < 0)
+      return -1;
+    Bus->MuxAddress = HT1382_FLEET_NO_MUX;
+  }
+
+  if (Device->MuxAddress == HT1382_FLEET_NO_MUX)
+    return 0;
+
+  Mask = (uint8_t)(1 << Device->MuxChannel);
+  if (Bus->Send(Bus->Context, Device->MuxAddress, &Mask, 1) < 0)
+  {
+    Bus->MuxAddress = HT1382_FLEET_NO_MUX;
+    return -1;
+  }
+
+  Bus->MuxAddress = Device->MuxAddress;
+  Bus->MuxChannel = Device->MuxChannel;
+  return 0;
+}
+
+static void
+Fleet_SetDevice(HT1382_FleetBus_t *Bus, HT1382_FleetDevice_t *Device)
+{
+  HT1382_DateTime_t DateTime;
+  struct timespec Now;
+  uint64_t Start = Fleet_NowNs();
+
+  if (Fleet_Select(Bus, Device) < 0)
+  {
+    Device->Result = HT1382_FLEET_MUX;
+  }
+  else
+  {
+    clock_gettime(CLOCK_REALTIME, &Now);
+    Device->SetEpoch = (uint32_t)Now.tv_sec;
+    HT1382_Time_FromEpoch(Device->SetEpoch, &DateTime);
+    if (HT1382_SetDateTime(&Device->Handler, &DateTime) != HT1382_OK)
+      Device->Result = HT1382_FLEET_SET;
+  }
+
+  // the chip counts from the end of the time write
+  Device->SetNs = Fleet_NowNs();
+  Device->SetUs = (uint32_t)((Device->SetNs - Start) / 1000);
+}
+
+static void
+Fleet_VerifyDevice(HT1382_Fleet_t *Fleet, HT1382_FleetBus_t *Bus,
+                   HT1382_FleetDevice_t *Device)
+{
+  HT1382_DateTime_t DateTime;
+  uint64_t Start = 0;
+  uint64_t End = 0;
+  uint32_t Epoch = 0;
+  uint32_t Expected = 0;
+
+  Fleet_SleepUntil(Device->SetNs + (uint64_t)Fleet->SettleMs * 1000000ULL);
+
+  Start = Fleet_NowNs();
+  if (Fleet_Select(Bus, Device) < 0)
+    Device->Result = HT1382_FLEET_MUX;
+  else if (HT1382_GetDateTime(&Device->Handler, &DateTime) != HT1382_OK)
+    Device->Result = HT1382_FLEET_READ;
+  End = Fleet_NowNs();
+
+  Device->VerifyUs = (uint32_t)((End - Start) / 1000);
+  Device->TurnaroundUs = Device->SetUs + (uint32_t)((End - Device->SetNs) / 1000);
+  if (Device->Result != HT1382_FLEET_NOT_RUN)
+    return;
+
+  Epoch = HT1382_Time_ToEpoch(&DateTime);
+  Expected = Device->SetEpoch + (uint32_t)((End - Device->SetNs) / 1000000000ULL);
+  Device->Error = (int32_t)(Epoch - Expected);
+
+  if (Epoch <= Device->SetEpoch)
+    Device->Result = HT1382_FLEET_STOPPED;
+  else if (Device->Error > Fleet->Tolerance || -Device->Error > Fleet->Tolerance)
+    Device->Result = HT1382_FLEET_DRIFT;
+  else
+    Device->Result = HT1382_FLEET_PASS;
+}
+
+static void *
+Fleet_Worker(void *Arg)
+{
+  Fleet_Worker_t *Worker = (Fleet_Worker_t *)Arg;
+  HT1382_Fleet_t *Fleet = Worker->Fleet;
+  HT1382_FleetBus_t *Bus = &Fleet->Buses[Worker->Bus];
+  HT1382_FleetDevice_t *Device = NULL;
+  uint16_t i = 0;
+
+  Fleet_CurrentBus = Bus;
+  Bus->MuxAddress = HT1382_FLEET_NO_MUX;
+
+  for (i = 0; i < Fleet->DeviceCount; i++)
+  {
+    Device = &Fleet->Devices[i];
+    if (Device->Bus == Worker->Bus)
+      Fleet_SetDevice(Bus, Device);
+  }
+
+  // devices come due in the order they were set
+  for (i = 0; i < Fleet->DeviceCount; i++)
+  {
+    Device = &Fleet->Devices[i];
+    if (Device->Bus == Worker->Bus && Device->Result == HT1382_FLEET_NOT_RUN)
+      Fleet_VerifyDevice(Fleet, Bus, Device);
+  }
+
+  // leave no mux channel connected
+  if (Bus->MuxAddress != HT1382_FLEET_NO_MUX)
+  {
+    uint8_t Mask = 0;
+    Bus->Send(Bus->Context, Bus->MuxAddress, &Mask, 1);
+    Bus->MuxAddress = HT1382_FLEET_NO_MUX;
+  }
+
+  Fleet_CurrentBus = NULL;
+  return NULL;
+}
+
+static int8_t
+Fleet_I2cDevSend(void *Context, uint8_t Address, uint8_t *Data, uint8_t DataLen)
+{
+  Fleet_I2cDev_t *Dev = (Fleet_I2cDev_t *)Context;
+
+  if (Dev->SlaveAddress != Address)
+  {
+    if (ioctl(Dev->Fd, I2C_SLAVE, Address) < 0)
+      return -1;
+    Dev->SlaveAddress = Address;
+  }
+
+  if (write(Dev->Fd, Data, DataLen) != DataLen)
+    return -3;
+
+  return 0;
+}
+
+static int8_t
+Fleet_I2cDevReceive(void *Context, uint8_t Address, uint8_t *Data, uint8_t DataLen)
+{
+  Fleet_I2cDev_t *Dev = (Fleet_I2cDev_t *)Context;
+
+  if (Dev->SlaveAddress != Address)
+  {
+    if (ioctl(Dev->Fd, I2C_SLAVE, Address) < 0)
+      return -1;
+    Dev->SlaveAddress = Address;
+  }
+
+  if (read(Dev->Fd, Data, DataLen) != DataLen)
+    return -3;
+
+  return 0;
+}
+
+
+
+/**
+ ==================================================================================
+                         ##### Public Fleet Functions #####                        
+ ==================================================================================
+ */
+
+/**
+ * @brief  Set and verify all devices, one worker thread per bus
+ * @param  Fleet: Pointer to fleet
+ * @retval HT1382_Result_t
+ *         - HT1382_OK: All devices were processed (see their Result).
+ *         - HT1382_FAIL: A worker thread could not be started.
+ *         - HT1382_INVALID_PARAM: One of parameters is invalid.
+ */
+HT1382_Result_t
+HT1382_Fleet_Run(HT1382_Fleet_t *Fleet)
+{
+  Fleet_Worker_t *Workers = NULL;
+  HT1382_FleetDevice_t *Device = NULL;
+  HT1382_Result_t Result = HT1382_OK;
+  uint64_t Start = 0;
+  uint16_t i = 0;
+  uint8_t Started = 0;
+
+  if (!Fleet->Buses || !Fleet->BusCount || !Fleet->Devices ||
+      Fleet->SettleMs < 1000)
+    return HT1382_INVALID_PARAM;
+
+  for (i = 0; i < Fleet->BusCount; i++)
+  {
+    if (!Fleet->Buses[i].Send || !Fleet->Buses[i].Receive)
+      return HT1382_INVALID_PARAM;
+  }
+
+  for (i = 0; i < Fleet->DeviceCount; i++)
+  {
+    Device = &Fleet->Devices[i];
+    if (Device->Bus >= Fleet->BusCount || Device->MuxChannel > 7)
+      return HT1382_INVALID_PARAM;
+
+    memset(&Device->Handler, 0, sizeof(Device->Handler));
+    HT1382_PLATFORM_LINK_SEND(&Device->Handler, Fleet_Send);
+    HT1382_PLATFORM_LINK_RECEIVE(&Device->Handler, Fleet_Receive);
+    if (HT1382_Init(&Device->Handler) != HT1382_OK)
+      return HT1382_INVALID_PARAM;
+
+    Device->Result = HT1382_FLEET_NOT_RUN;
+    Device->SetUs = 0;
+    Device->VerifyUs = 0;
+    Device->TurnaroundUs = 0;
+    Device->Error = 0;
+  }
+
+  Workers = calloc(Fleet->BusCount, sizeof(*Workers));
+  if (!Workers)
+    return HT1382_FAIL;
+
+  Start = Fleet_NowNs();
+  for (Started = 0; Started < Fleet->BusCount; Started++)
+  {
+    Workers[Started].Fleet = Fleet;
+    Workers[Started].Bus = Started;
+    if (pthread_create(&Workers[Started].Thread, NULL, Fleet_Worker, &Workers[Started]))
+    {
+      Result = HT1382_FAIL;
+      break;
+    }
+  }
+
+  while (Started)
+    pthread_join(Workers[--Started].Thread, NULL);
+
+  Fleet->ElapsedUs = (Fleet_NowNs() - Start) / 1000;
+  free(Workers);
+
+  Fleet->Passed = 0;
+  for (i = 0; i < Fleet->DeviceCount; i++)
+  {
+    if (Fleet->Devices[i].Result == HT1382_FLEET_PASS)
+      Fleet->Passed++;
+  }
+
+  return Result;
+}
+
+
+/**
+ * @brief  Print the per-device pass/fail and latency report
+ * @param  Fleet: Pointer to fleet after HT1382_Fleet_Run
+ * @param  Out: Output stream
+ * @param  Verbose: 0: summary and failed devices only, 1: every device
+ * @retval None
+ */
+void
+HT1382_Fleet_Report(const HT1382_Fleet_t *Fleet, FILE *Out, uint8_t Verbose)
+{
+  const HT1382_FleetDevice_t *Device = NULL;
+  uint64_t BusUs = 0;
+  uint64_t SerialUs = 0;
+  uint32_t MaxTurnaround = 0;
+  uint16_t i = 0;
+
+  fprintf(Out, "%-4s %-16s %-4s %-2s %-12s %9s %9s %13s %6s\n",
+          "dev", "bus", "mux", "ch", "result", "set[us]", "verify[us]",
+          "turnaround[ms]", "err[s]");
+
+  for (i = 0; i < Fleet->DeviceCount; i++)
+  {
+    Device = &Fleet->Devices[i];
+    BusUs += Device->SetUs + Device->VerifyUs;
+    if (Device->TurnaroundUs > MaxTurnaround)
+      MaxTurnaround = Device->TurnaroundUs;
+
+    if (!Verbose && Device->Result == HT1382_FLEET_PASS)
+      continue;
+
+    fprintf(Out, "%-4u %-16s ", i, Fleet->Buses[Device->Bus].Name ? Fleet->Buses[Device->Bus].Name : "-");
+    if (Device->MuxAddress == HT1382_FLEET_NO_MUX)
+      fprintf(Out, "%-4s %-2s ", "-", "-");
+    else
+      fprintf(Out, "0x%02x %-2u ", Device->MuxAddress, Device->MuxChannel);
+    fprintf(Out, "%-12s %9u %9u %13.1f %6d\n", Fleet_ResultNames[Device->Result],
+            Device->SetUs, Device->VerifyUs, Device->TurnaroundUs / 1000.0, Device->Error);
+  }
+
+  // one device at a time: every device pays its bus time and the settle time
+  SerialUs = BusUs + (uint64_t)Fleet->DeviceCount * Fleet->SettleMs * 1000;
+
+  fprintf(Out, "%u devices on %u buses: %u passed, %u failed in %.3f s (%.1f devices/s)\n",
+          Fleet->DeviceCount, Fleet->BusCount, Fleet->Passed,
+          Fleet->DeviceCount - Fleet->Passed, Fleet->ElapsedUs / 1e6,
+          Fleet->ElapsedUs ? Fleet->DeviceCount * 1e6 / Fleet->ElapsedUs : 0.0);
+  fprintf(Out, "bus time %.2f ms/device, max turnaround %.1f ms, one-by-one estimate %.1f s\n",
+          Fleet->DeviceCount ? BusUs / 1000.0 / Fleet->DeviceCount : 0.0,
+          MaxTurnaround / 1000.0, SerialUs / 1e6);
+}
+
+
+/**
+ * @brief  Open an i2c-dev node as a fleet bus
+ * @param  Bus: Pointer to bus
+ * @param  Path: Path of i2c-dev node (e.g. "/dev/i2c-1")
+ * @retval HT1382_Result_t
+ *         - HT1382_OK: Operation was successful.
+ *         - HT1382_FAIL: The node could not be opened.
+ */
+HT1382_Result_t
+HT1382_Fleet_OpenI2cDev(HT1382_FleetBus_t *Bus, const char *Path)
+{
+  Fleet_I2cDev_t *Dev = malloc(sizeof(*Dev));
+
+  if (!Dev)
+    return HT1382_FAIL;
+
+  Dev->Fd = open(Path, O_RDWR);
+  Dev->SlaveAddress = -1;
+  if (Dev->Fd < 0)
+  {
+    free(Dev);
+    return HT1382_FAIL;
+  }
+
+  memset(Bus, 0, sizeof(*Bus));
+  Bus->Name = Path;
+  Bus->Send = Fleet_I2cDevSend;
+  Bus->Receive = Fleet_I2cDevReceive;
+  Bus->Context = Dev;
+
+  return HT1382_OK;
+}
+
+
+/**
+ * @brief  Close a bus opened by HT1382_Fleet_OpenI2cDev
+ * @param  Bus: Pointer to bus
+ * @retval None
+ */
+void
+HT1382_Fleet_CloseI2cDev(HT1382_FleetBus_t *Bus)
+{
+  Fleet_I2cDev_t *Dev = (Fleet_I2cDev_t *)Bus->Context;
+
+  if (!Dev)
+    return;
+
+  close(Dev->Fd);
+  free(Dev);
+  Bus->Context = NULL;
+}
@@ -0,0 +1,207 @@
+/**
+ **********************************************************************************
+ * @file   HT1382_fleet.h
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  Parallel set/verify engine for racks of HT1382 boards
+ **********************************************************************************
+ *
+ * Copyright (c) 2024 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+
+
+/**
+ * A fleet is a set of I2C buses, each driven by its own worker thread, and
+ * the devices behind them. A device sits either directly on its bus or on one
+ * channel of a PCA9548-style mux (one HT1382 per channel, as they all answer
+ * at 0x68).
+ *
+ * Every worker pipelines its devices: it selects each one in turn and writes
+ * the host UTC time, then returns to the first device as soon as that device's
+ * settle time has passed and reads the time back. The settle time is thus
+ * waited once per bus instead of once per device. A device passes when the
+ * read-back time has advanced and matches the written time plus the elapsed
+ * time within the tolerance.
+ *
+ * The HT1382 platform functions have no context argument, so the worker
+ * stores its bus in a thread-local variable and the handlers of all devices
+ * share one set of platform functions that forward to it.
+ */
+
+/* Define to prevent recursive inclusion ----------------------------------------*/
+#ifndef _HT1382_FLEET_H_
+#define _HT1382_FLEET_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* Includes ---------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdio.h>
+#include "HT1382.h"
+
+
+/* Exported Constants -----------------------------------------------------------*/
+/**
+ * @brief  MuxAddress of devices connected to the bus directly
+ */
+#define HT1382_FLEET_NO_MUX       0x00
+
+
+/* Exported Data Types ----------------------------------------------------------*/
+/**
+ * @brief  Bus transfer functions (0: success, < 0: failure)
+ */
+typedef int8_t (*HT1382_FleetTransfer_t)(void *Context, uint8_t Address,
+                                         uint8_t *Data, uint8_t DataLen);
+
+/**
+ * @brief  Bus data type
+ */
+typedef struct HT1382_FleetBus_s
+{
+  const char             *Name;
+  HT1382_FleetTransfer_t Send;
+  HT1382_FleetTransfer_t Receive;
+  void                   *Context;
+
+  // Library internal
+  uint8_t                MuxAddress;  // mux with a channel selected
+  uint8_t                MuxChannel;
+} HT1382_FleetBus_t;
+
+/**
+ * @brief  Device result
+ */
+typedef enum HT1382_FleetResult_e
+{
+  HT1382_FLEET_PASS     = 0,
+  HT1382_FLEET_NOT_RUN  = 1,  // skipped
+  HT1382_FLEET_MUX      = 2,  // mux did not answer
+  HT1382_FLEET_SET      = 3,  // setting the time failed
+  HT1382_FLEET_READ     = 4,  // reading the time failed
+  HT1382_FLEET_STOPPED  = 5,  // the time did not advance
+  HT1382_FLEET_DRIFT    = 6,  // the time is out of tolerance
+} HT1382_FleetResult_t;
+
+/**
+ * @brief  Device data type
+ */
+typedef struct HT1382_FleetDevice_s
+{
+  uint8_t              Bus;         // index in HT1382_Fleet_t.Buses
+  uint8_t              MuxAddress;  // HT1382_FLEET_NO_MUX or 0x70 ... 0x77
+  uint8_t              MuxChannel;  // 0 ... 7
+
+  // Results
+  HT1382_FleetResult_t Result;
+  uint32_t             SetUs;       // duration of mux select + set
+  uint32_t             VerifyUs;    // duration of mux select + read-back
+  uint32_t             TurnaroundUs; // start of set to end of read-back
+  int32_t              Error;       // read-back minus expected time (seconds)
+
+  // Library internal
+  HT1382_Handler_t     Handler;
+  uint32_t             SetEpoch;
+  uint64_t             SetNs;
+} HT1382_FleetDevice_t;
+
+/**
+ * @brief  Fleet data type
+ */
+typedef struct HT1382_Fleet_s
+{
+  HT1382_FleetBus_t    *Buses;
+  uint8_t              BusCount;
+  HT1382_FleetDevice_t *Devices;
+  uint16_t             DeviceCount;
+  uint32_t             SettleMs;    // set to read-back delay (>= 1000)
+  uint8_t              Tolerance;   // seconds
+
+  // Results
+  uint64_t             ElapsedUs;   // wall time of HT1382_Fleet_Run
+  uint16_t             Passed;
+} HT1382_Fleet_t;
+
+
+
+/**
+ ==================================================================================
+                            ##### Fleet Functions #####                           
+ ==================================================================================
+ */
+
+/**
+ * @brief  Set and verify all devices, one worker thread per bus
+ * @note   Devices are processed in array order within each bus; list the
+ *         devices of a mux together to avoid extra mux writes.
+ * @param  Fleet: Pointer to fleet
+ * @retval HT1382_Result_t
+ *         - HT1382_OK: All devices were processed (see their Result).
+ *         - HT1382_FAIL: A worker thread could not be started.
+ *         - HT1382_INVALID_PARAM: One of parameters is invalid.
+ */
+HT1382_Result_t
+HT1382_Fleet_Run(HT1382_Fleet_t *Fleet);
+
+
+/**
+ * @brief  Print the per-device pass/fail and latency report
+ * @param  Fleet: Pointer to fleet after HT1382_Fleet_Run
+ * @param  Out: Output stream
+ * @param  Verbose: 0: summary and failed devices only, 1: every device
+ * @retval None
+ */
+void
+HT1382_Fleet_Report(const HT1382_Fleet_t *Fleet, FILE *Out, uint8_t Verbose);
+
+
+/**
+ * @brief  Open an i2c-dev node as a fleet bus
+ * @param  Bus: Pointer to bus
+ * @param  Path: Path of i2c-dev node (e.g. "/dev/i2c-1")
+ * @retval HT1382_Result_t
+ *         - HT1382_OK: Operation was successful.
+ *         - HT1382_FAIL: The node could not be opened.
+ */
+HT1382_Result_t
+HT1382_Fleet_OpenI2cDev(HT1382_FleetBus_t *Bus, const char *Path);
+
+
+/**
+ * @brief  Close a bus opened by HT1382_Fleet_OpenI2cDev
+ * @param  Bus: Pointer to bus
+ * @retval None
+ */
+void
+HT1382_Fleet_CloseI2cDev(HT1382_FleetBus_t *Bus);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif //! _HT1382_FLEET_H_
@@ -0,0 +1,320 @@
+/**
+ **********************************************************************************
+ * @file   main.c
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  End-of-line RTC verification of many HT1382 boards
+ **********************************************************************************
+ *
+ * Copyright (c) 2024 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+
+
+/**
+ * Usage: ht1382-fleet --bus PATH[:MUX[,MUX...]] [--bus ...] [options]
+ *        ht1382-fleet --sim [--buses B] [--devices N] [--rate HZ]
+ *                     [--overhead US] [--fail N] [--seed S] [options]
+ *        ht1382-fleet --bench [--devices N] [--rate HZ] [--overhead US]
+ *
+ * Options: --settle MS (default 1100), --tolerance S (default 1), -v
+ *
+ * With --bus, every listed mux (e.g. 0x70) contributes one device per
+ * channel; a bus without muxes has one device. With --sim, N devices are
+ * spread over B simulated buses (at most 64 per bus), --fail N gives N random
+ * devices a fault. --bench runs the simulated fleet with 1, 2, 4, ... buses and
+ * prints how the throughput and the time spent beyond the settle time scale.
+ *
+ * The exit status is 0 only if every device passed.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "HT1382_fleet.h"
+#include "sim.h"
+
+
+#define MAX_BUSES     32
+#define MAX_DEVICES   (MAX_BUSES * SIM_MUX_MAX * SIM_CHANNELS)
+
+
+static HT1382_FleetBus_t Buses[MAX_BUSES];
+static HT1382_FleetDevice_t Devices[MAX_DEVICES];
+static Sim_Bus_t *SimBuses[MAX_BUSES];
+static uint32_t Rand_State = 1;
+
+static uint32_t
+Rand_Next(void)
+{
+  // xorshift32
+  Rand_State ^= Rand_State << 13;
+  Rand_State ^= Rand_State >> 17;
+  Rand_State ^= Rand_State << 5;
+  return Rand_State;
+}
+
+/**
+ * @brief  Build a simulated fleet of Count devices on BusCount buses
+ */
+static int
+Sim_Build(HT1382_Fleet_t *Fleet, uint8_t BusCount, uint16_t Count,
+          uint32_t Rate, uint32_t OverheadUs, uint16_t Faults)
+{
+  static char Names[MAX_BUSES][16];
+  uint16_t PerBus = (uint16_t)((Count + BusCount - 1) / BusCount);
+  uint16_t i = 0;
+  uint8_t b = 0;
+
+  if (!BusCount || BusCount > MAX_BUSES || PerBus > SIM_MUX_MAX * SIM_CHANNELS)
+  {
+    fprintf(stderr, "%u devices do not fit on %u buses (64 per bus)\n", Count, BusCount);
+    return -1;
+  }
+
+  for (b = 0; b < BusCount; b++)
+  {
+    SimBuses[b] = Sim_BusCreate(Rate, OverheadUs,
+                                (uint8_t)((PerBus + SIM_CHANNELS - 1) / SIM_CHANNELS));
+    if (!SimBuses[b])
+      return -1;
+    snprintf(Names[b], sizeof(Names[b]), "sim%u", b);
+    memset(&Buses[b], 0, sizeof(Buses[b]));
+    Buses[b].Name = Names[b];
+    Buses[b].Send = Sim_Send;
+    Buses[b].Receive = Sim_Receive;
+    Buses[b].Context = SimBuses[b];
+  }
+
+  // devices of one mux are listed together
+  for (i = 0; i < Count; i++)
+  {
+    memset(&Devices[i], 0, sizeof(Devices[i]));
+    Devices[i].Bus = (uint8_t)(i / PerBus);
+    Devices[i].MuxAddress = (uint8_t)(SIM_MUX_BASE + (i % PerBus) / SIM_CHANNELS);
+    Devices[i].MuxChannel = (uint8_t)((i % PerBus) % SIM_CHANNELS);
+  }
+
+  while (Faults--)
+  {
+    i = (uint16_t)(Rand_Next() % Count);
+    Sim_BusSetFault(SimBuses[Devices[i].Bus], Devices[i].MuxAddress - SIM_MUX_BASE,
+                    Devices[i].MuxChannel, (Sim_Fault_t)(1 + Rand_Next() % (SIM_FAULT_COUNT - 1)));
+  }
+
+  Fleet->Buses = Buses;
+  Fleet->BusCount = BusCount;
+  Fleet->Devices = Devices;
+  Fleet->DeviceCount = Count;
+  return 0;
+}
+
+static void
+Sim_Free(uint8_t BusCount)
+{
+  while (BusCount)
+  {
+    BusCount--;
+    Sim_BusDestroy(SimBuses[BusCount]);
+    SimBuses[BusCount] = NULL;
+  }
+}
+
+/**
+ * @brief  Add an i2c-dev bus given as PATH[:MUX[,MUX...]]
+ */
+static int
+Hw_AddBus(HT1382_Fleet_t *Fleet, char *Spec)
+{
+  char *Muxes = strchr(Spec, ':');
+  char *Token = NULL;
+  uint8_t Mux = 0;
+  uint8_t Channel = 0;
+
+  if (Fleet->BusCount >= MAX_BUSES)
+    return -1;
+  if (Muxes)
+    *Muxes++ = '\0';
+
+  if (HT1382_Fleet_OpenI2cDev(&Buses[Fleet->BusCount], Spec) != HT1382_OK)
+  {
+    perror(Spec);
+    return -1;
+  }
+
+  if (!Muxes)
+  {
+    memset(&Devices[Fleet->DeviceCount], 0, sizeof(Devices[0]));
+    Devices[Fleet->DeviceCount].Bus = Fleet->BusCount;
+    Devices[Fleet->DeviceCount++].MuxAddress = HT1382_FLEET_NO_MUX;
+  }
+
+  for (Token = strtok(Muxes, ","); Token; Token = strtok(NULL, ","))
+  {
+    Mux = (uint8_t)strtoul(Token, NULL, 0);
+    if (Mux < 0x70 || Mux > 0x77 || Fleet->DeviceCount + SIM_CHANNELS > MAX_DEVICES)
+      return -1;
+    for (Channel = 0; Channel < SIM_CHANNELS; Channel++)
+    {
+      memset(&Devices[Fleet->DeviceCount], 0, sizeof(Devices[0]));
+      Devices[Fleet->DeviceCount].Bus = Fleet->BusCount;
+      Devices[Fleet->DeviceCount].MuxAddress = Mux;
+      Devices[Fleet->DeviceCount++].MuxChannel = Channel;
+    }
+  }
+
+  Fleet->BusCount++;
+  return 0;
+}
+
+static int
+Bench(HT1382_Fleet_t *Fleet, uint16_t Count, uint32_t Rate, uint32_t OverheadUs)
+{
+  double Base = 0;
+  double Busy = 0;
+  uint8_t BusCount = 0;
+
+  printf("%u devices, %u Hz, %u us adapter overhead, %u ms settle\n",
+         Count, Rate, OverheadUs, Fleet->SettleMs);
+  // the settle time is paid once per run whatever the bus count
+  printf("%5s %10s %12s %14s %8s\n", "buses", "time[s]", "devices/s", "w/o settle[s]", "speedup");
+
+  for (BusCount = 1; BusCount <= MAX_BUSES; BusCount *= 2)
+  {
+    if ((Count + BusCount - 1) / BusCount > SIM_MUX_MAX * SIM_CHANNELS)
+      continue;
+    if (Sim_Build(Fleet, BusCount, Count, Rate, OverheadUs, 0) < 0)
+      return 1;
+    if (HT1382_Fleet_Run(Fleet) != HT1382_OK || Fleet->Passed != Count)
+    {
+      HT1382_Fleet_Report(Fleet, stdout, 0);
+      Sim_Free(BusCount);
+      return 1;
+    }
+    Sim_Free(BusCount);
+
+    Busy = Fleet->ElapsedUs - Fleet->SettleMs * 1000.0;
+    if (!Base)
+      Base = Busy;
+    printf("%5u %10.3f %12.1f %14.3f %7.2fx\n", BusCount, Fleet->ElapsedUs / 1e6,
+           Count * 1e6 / Fleet->ElapsedUs, Busy / 1e6, Base / Busy);
+    if ((Count + BusCount - 1) / BusCount <= 1)
+      break;
+  }
+
+  return 0;
+}
+
+
+int main(int argc, char *argv[])
+{
+  HT1382_Fleet_t Fleet = {0};
+  uint32_t Rate = 100000;
+  uint32_t OverheadUs = 50;
+  uint16_t Count = 64;
+  uint16_t Faults = 0;
+  uint8_t BusCount = 4;
+  uint8_t Verbose = 0;
+  int Mode = 0; // 0: hardware, 1: simulation, 2: benchmark
+  int Status = 0;
+  int i = 0;
+
+  Fleet.SettleMs = 1100;
+  Fleet.Tolerance = 1;
+
+  for (i = 1; i < argc; i++)
+  {
+    if (!strcmp(argv[i], "--bus") && i + 1 < argc)
+    {
+      if (Hw_AddBus(&Fleet, argv[++i]) < 0)
+        return 2;
+    }
+    else if (!strcmp(argv[i], "--sim"))
+      Mode = 1;
+    else if (!strcmp(argv[i], "--bench"))
+      Mode = 2;
+    else if (!strcmp(argv[i], "--buses") && i + 1 < argc)
+      BusCount = (uint8_t)atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--devices") && i + 1 < argc)
+      Count = (uint16_t)atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--rate") && i + 1 < argc)
+      Rate = (uint32_t)atol(argv[++i]);
+    else if (!strcmp(argv[i], "--overhead") && i + 1 < argc)
+      OverheadUs = (uint32_t)atol(argv[++i]);
+    else if (!strcmp(argv[i], "--fail") && i + 1 < argc)
+      Faults = (uint16_t)atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--seed") && i + 1 < argc)
+      Rand_State = (uint32_t)atol(argv[++i]) | 1;
+    else if (!strcmp(argv[i], "--settle") && i + 1 < argc)
+      Fleet.SettleMs = (uint32_t)atol(argv[++i]);
+    else if (!strcmp(argv[i], "--tolerance") && i + 1 < argc)
+      Fleet.Tolerance = (uint8_t)atoi(argv[++i]);
+    else if (!strcmp(argv[i], "-v"))
+      Verbose = 1;
+    else
+    {
+      fprintf(stderr,
+              "usage: %s --bus PATH[:MUX[,MUX...]] [--bus ...] [options]\n"
+              "       %s --sim [--buses B] [--devices N] [--rate HZ] [--overhead US]\n"
+              "                [--fail N] [--seed S] [options]\n"
+              "       %s --bench [--devices N] [--rate HZ] [--overhead US]\n"
+              "options: --settle MS, --tolerance S, -v\n",
+              argv[0], argv[0], argv[0]);
+      return 2;
+    }
+  }
+
+  if (Count > MAX_DEVICES || Rate == 0)
+    return 2;
+
+  if (Mode == 2)
+    return Bench(&Fleet, Count, Rate, OverheadUs);
+
+  if (Mode == 1 && Sim_Build(&Fleet, BusCount, Count, Rate, OverheadUs, Faults) < 0)
+    return 2;
+
+  if (!Fleet.BusCount)
+  {
+    fprintf(stderr, "no bus given (--bus or --sim)\n");
+    return 2;
+  }
+
+  if (HT1382_Fleet_Run(&Fleet) != HT1382_OK)
+  {
+    fprintf(stderr, "fleet run failed\n");
+    Status = 2;
+  }
+  else
+  {
+    HT1382_Fleet_Report(&Fleet, stdout, Verbose);
+    Status = (Fleet.Passed == Fleet.DeviceCount) ? 0 : 1;
+  }
+
+  if (Mode == 1)
+    Sim_Free(Fleet.BusCount);
+  else
+    for (i = 0; i < Fleet.BusCount; i++)
+      HT1382_Fleet_CloseI2cDev(&Buses[i]);
+
+  return Status;
+}
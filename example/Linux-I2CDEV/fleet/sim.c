@@ -0,0 +1,272 @@
+/**
+ **********************************************************************************
+ * @file   sim.c
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  Simulated I2C buses with PCA9548 muxes and HT1382 chips
+ **********************************************************************************
+ *
+ * Copyright (c) 2024 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+
+
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "sim.h"
+#include "HT1382.h"
+#include "HT1382_time.h"
+
+
+#define SIM_RTC_ADDRESS     0x68
+#define SIM_RTC_REGS        21
+
+
+typedef struct Sim_Rtc_s
+{
+  Sim_Fault_t Fault;
+  uint8_t     Regs[SIM_RTC_REGS];
+  uint32_t    BaseEpoch;    // time at BaseNs
+  uint64_t    BaseNs;
+} Sim_Rtc_t;
+
+struct Sim_Bus_s
+{
+  uint32_t  Rate;
+  uint64_t  OverheadNs;
+  uint8_t   MuxCount;
+  uint8_t   MuxMask[SIM_MUX_MAX];
+  uint8_t   Pointer;
+  uint64_t  FreeNs;         // end of the last transaction
+  Sim_Rtc_t Rtc[SIM_MUX_MAX][SIM_CHANNELS];
+};
+
+
+static uint64_t
+Sim_NowNs(void)
+{
+  struct timespec Ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &Ts);
+  return (uint64_t)Ts.tv_sec * 1000000000ULL + (uint64_t)Ts.tv_nsec;
+}
+
+/**
+ * @brief  Occupy the bus for a transaction of Bytes bytes after the address
+ */
+static void
+Sim_Transfer(Sim_Bus_t *Bus, uint8_t Bytes)
+{
+  struct timespec Ts;
+  uint64_t Now = Sim_NowNs();
+  // START, address, data bytes with ACK, STOP
+  uint64_t Bits = 2 + 9 * (1 + (uint64_t)Bytes);
+
+  if (Bus->FreeNs < Now)
+    Bus->FreeNs = Now;
+  Bus->FreeNs += Bus->OverheadNs + Bits * 1000000000ULL / Bus->Rate;
+
+  Ts.tv_sec = (time_t)(Bus->FreeNs / 1000000000ULL);
+  Ts.tv_nsec = (long)(Bus->FreeNs % 1000000000ULL);
+  while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &Ts, NULL))
+    ;
+}
+
+/**
+ * @brief  Chip selected by the muxes, NULL if none or more than one
+ */
+static Sim_Rtc_t *
+Sim_Route(Sim_Bus_t *Bus)
+{
+  Sim_Rtc_t *Rtc = NULL;
+  uint8_t Mux, Channel;
+
+  for (Mux = 0; Mux < Bus->MuxCount; Mux++)
+    for (Channel = 0; Channel < SIM_CHANNELS; Channel++)
+      if ((Bus->MuxMask[Mux] >> Channel) & 0x01)
+      {
+        if (Rtc || Bus->Rtc[Mux][Channel].Fault == SIM_FAULT_MISSING)
+          return NULL; // collision or no chip
+        Rtc = &Bus->Rtc[Mux][Channel];
+      }
+
+  return Rtc;
+}
+
+static uint32_t
+Sim_RtcNow(const Sim_Rtc_t *Rtc, uint64_t Ns)
+{
+  if (Rtc->Fault == SIM_FAULT_STOPPED)
+    return Rtc->BaseEpoch;
+
+  return Rtc->BaseEpoch + (uint32_t)((Ns - Rtc->BaseNs) / 1000000000ULL);
+}
+
+static uint8_t
+Sim_BCD(uint8_t Value)
+{
+  return (uint8_t)(((Value / 10) << 4) | (Value % 10));
+}
+
+static uint8_t
+Sim_DEC(uint8_t Value)
+{
+  return (uint8_t)((Value >> 4) * 10 + (Value & 0x0F));
+}
+
+
+Sim_Bus_t *
+Sim_BusCreate(uint32_t Rate, uint32_t OverheadUs, uint8_t MuxCount)
+{
+  Sim_Bus_t *Bus = calloc(1, sizeof(*Bus));
+  struct timespec Now;
+  uint8_t Mux, Channel;
+
+  if (!Bus || !Rate || MuxCount > SIM_MUX_MAX)
+  {
+    free(Bus);
+    return NULL;
+  }
+
+  Bus->Rate = Rate;
+  Bus->OverheadNs = (uint64_t)OverheadUs * 1000;
+  Bus->MuxCount = MuxCount;
+
+  // chips start a day behind with write protection on
+  clock_gettime(CLOCK_REALTIME, &Now);
+  for (Mux = 0; Mux < SIM_MUX_MAX; Mux++)
+    for (Channel = 0; Channel < SIM_CHANNELS; Channel++)
+    {
+      Bus->Rtc[Mux][Channel].BaseEpoch = (uint32_t)Now.tv_sec - 86400;
+      Bus->Rtc[Mux][Channel].BaseNs = Sim_NowNs();
+      Bus->Rtc[Mux][Channel].Regs[0x07] = 0x80;
+    }
+
+  return Bus;
+}
+
+void
+Sim_BusDestroy(Sim_Bus_t *Bus)
+{
+  free(Bus);
+}
+
+void
+Sim_BusSetFault(Sim_Bus_t *Bus, uint8_t Mux, uint8_t Channel, Sim_Fault_t Fault)
+{
+  if (Mux < SIM_MUX_MAX && Channel < SIM_CHANNELS)
+    Bus->Rtc[Mux][Channel].Fault = Fault;
+}
+
+int8_t
+Sim_Send(void *Context, uint8_t Address, uint8_t *Data, uint8_t DataLen)
+{
+  Sim_Bus_t *Bus = (Sim_Bus_t *)Context;
+  HT1382_DateTime_t DateTime;
+  Sim_Rtc_t *Rtc = NULL;
+  uint8_t Reg = 0;
+  uint8_t i = 0;
+
+  if (Address >= SIM_MUX_BASE && Address < SIM_MUX_BASE + Bus->MuxCount)
+  {
+    Sim_Transfer(Bus, DataLen);
+    if (DataLen)
+      Bus->MuxMask[Address - SIM_MUX_BASE] = Data[DataLen - 1];
+    return 0;
+  }
+
+  Rtc = (Address == SIM_RTC_ADDRESS) ? Sim_Route(Bus) : NULL;
+  if (!Rtc || !DataLen)
+  {
+    Sim_Transfer(Bus, 0); // address NACK
+    return -1;
+  }
+
+  Sim_Transfer(Bus, DataLen);
+  Bus->Pointer = Data[0];
+
+  // the ST1 register itself is always writable
+  for (i = 1, Reg = Bus->Pointer; i < DataLen && Reg < SIM_RTC_REGS; i++, Reg++)
+    if (Reg == 0x07 || !(Rtc->Regs[0x07] & 0x80))
+      Rtc->Regs[Reg] = Data[i];
+
+  if (Bus->Pointer == 0x00 && DataLen >= 8 && !(Rtc->Regs[0x07] & 0x80))
+  {
+    DateTime.Second  = Sim_DEC(Rtc->Regs[0] & 0x7F);
+    DateTime.Minute  = Sim_DEC(Rtc->Regs[1]);
+    DateTime.Hour    = Sim_DEC(Rtc->Regs[2] & 0x3F);
+    DateTime.Day     = Sim_DEC(Rtc->Regs[3]);
+    DateTime.Month   = Sim_DEC(Rtc->Regs[4]);
+    DateTime.WeekDay = Sim_DEC(Rtc->Regs[5]);
+    DateTime.Year    = Sim_DEC(Rtc->Regs[6]);
+    Rtc->BaseEpoch = HT1382_Time_ToEpoch(&DateTime);
+    if (Rtc->Fault == SIM_FAULT_OFFSET)
+      Rtc->BaseEpoch += 3;
+    Rtc->BaseNs = Bus->FreeNs;
+  }
+
+  return 0;
+}
+
+int8_t
+Sim_Receive(void *Context, uint8_t Address, uint8_t *Data, uint8_t DataLen)
+{
+  Sim_Bus_t *Bus = (Sim_Bus_t *)Context;
+  HT1382_DateTime_t DateTime;
+  Sim_Rtc_t *Rtc = NULL;
+  uint8_t i = 0;
+
+  if (Address >= SIM_MUX_BASE && Address < SIM_MUX_BASE + Bus->MuxCount)
+  {
+    Sim_Transfer(Bus, DataLen);
+    memset(Data, Bus->MuxMask[Address - SIM_MUX_BASE], DataLen);
+    return 0;
+  }
+
+  Rtc = (Address == SIM_RTC_ADDRESS) ? Sim_Route(Bus) : NULL;
+  if (!Rtc)
+  {
+    Sim_Transfer(Bus, 0);
+    return -1;
+  }
+
+  // time registers are latched at START
+  if (HT1382_Time_FromEpoch(Sim_RtcNow(Rtc, Sim_NowNs()), &DateTime) == HT1382_OK)
+  {
+    Rtc->Regs[0] = Sim_BCD(DateTime.Second);
+    Rtc->Regs[1] = Sim_BCD(DateTime.Minute);
+    Rtc->Regs[2] = Sim_BCD(DateTime.Hour) | 0x80;
+    Rtc->Regs[3] = Sim_BCD(DateTime.Day);
+    Rtc->Regs[4] = Sim_BCD(DateTime.Month);
+    Rtc->Regs[5] = Sim_BCD(DateTime.WeekDay);
+    Rtc->Regs[6] = Sim_BCD(DateTime.Year);
+  }
+
+  Sim_Transfer(Bus, DataLen);
+  for (i = 0; i < DataLen; i++)
+    Data[i] = Rtc->Regs[(Bus->Pointer + i) % SIM_RTC_REGS];
+  Bus->Pointer = (uint8_t)((Bus->Pointer + DataLen) % SIM_RTC_REGS);
+
+  return 0;
+}
@@ -0,0 +1,78 @@
+/**
+ **********************************************************************************
+ * @file   sim.h
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  Simulated I2C buses with PCA9548 muxes and HT1382 chips
+ **********************************************************************************
+ *
+ * Copyright (c) 2024 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+
+
+/**
+ * Every simulated bus holds MuxCount PCA9548 muxes at 0x70 ... and an HT1382
+ * on each of their channels. A transaction takes the time its bits need at
+ * the bus rate plus a fixed adapter overhead; the bus keeps its own timeline
+ * so sleeping jitter does not add up. The chips keep time from the host
+ * monotonic clock.
+ */
+
+#ifndef _SIM_H_
+#define _SIM_H_
+
+#include <stdint.h>
+
+
+#define SIM_MUX_BASE        0x70
+#define SIM_MUX_MAX         8
+#define SIM_CHANNELS        8
+
+typedef enum Sim_Fault_e
+{
+  SIM_FAULT_NONE    = 0,
+  SIM_FAULT_MISSING = 1,  // no chip on the channel (NACK)
+  SIM_FAULT_STOPPED = 2,  // oscillator does not run
+  SIM_FAULT_OFFSET  = 3,  // time jumps 3 s ahead after a write
+  SIM_FAULT_COUNT   = 4,
+} Sim_Fault_t;
+
+typedef struct Sim_Bus_s Sim_Bus_t;
+
+
+Sim_Bus_t *
+Sim_BusCreate(uint32_t Rate, uint32_t OverheadUs, uint8_t MuxCount);
+
+void
+Sim_BusDestroy(Sim_Bus_t *Bus);
+
+void
+Sim_BusSetFault(Sim_Bus_t *Bus, uint8_t Mux, uint8_t Channel, Sim_Fault_t Fault);
+
+int8_t
+Sim_Send(void *Context, uint8_t Address, uint8_t *Data, uint8_t DataLen);
+
+int8_t
+Sim_Receive(void *Context, uint8_t Address, uint8_t *Data, uint8_t DataLen);
+
+#endif
@@ -0,0 +1,395 @@
+/**
+ **********************************************************************************
+ * @file   main.c
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  hwclock-style system time synchronization tool for HT1382 (Linux i2c-dev)
+ **********************************************************************************
+ *
+ * Copyright (c) 2024 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+
+/**
+ * Usage:
+ *   ht1382-hwclock --show     Print RTC time (drift corrected)
+ *   ht1382-hwclock --hctosys  Set system time from RTC
+ *   ht1382-hwclock --systohc  Set RTC from system time
+ * Options:
+ *   --device PATH   i2c-dev node (default HT1382_I2C_DEV)
+ *   --adjfile PATH  drift file (default HT1382_ADJFILE)
+ *   --nodrift       do not read or update the drift file
+ *
+ * The RTC is assumed to hold UTC.
+ *
+ * Reads are aligned to the RTC second edge: the seconds register is polled
+ * until it changes, so the sub-second phase of the RTC is known to within
+ * one bus transaction. Writes are issued so that the time registers land on
+ * the start of the next system second, compensated by the measured bus
+ * latency of a 7-byte burst (which costs the same number of bytes on the wire
+ * as the WP unlock plus the time burst of HT1382_SetDateTime).
+ *
+ * The drift file holds the RTC gain in seconds per day and the time of the
+ * last --systohc. On every --systohc done at least HT1382_DRIFT_MIN_INTERVAL
+ * seconds after the previous one, the error accumulated since then is used to
+ * update the drift factor. --show and --hctosys apply the correction.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include "HT1382.h"
+#include "HT1382_platform.h"
+
+
+#define HT1382_ADJFILE              "/etc/ht1382.adjtime"
+#define HT1382_DRIFT_MIN_INTERVAL   (6 * 3600)
+#define HT1382_LATENCY_SAMPLES      8
+#define HT1382_EDGE_TIMEOUT_NS      1500000000LL
+#define HT1382_EDGE_POLL_NS         2000000L   // edge resolution +-1 ms
+
+#define NSEC_PER_SEC                1000000000LL
+
+
+typedef struct Drift_s
+{
+  double  GainPerDay; // seconds the RTC gains per day
+  int64_t LastSet;    // epoch of last --systohc, 0 if unknown
+} Drift_t;
+
+
+static int64_t
+Timespec_ToNs(const struct timespec *Ts)
+{
+  return (int64_t)Ts->tv_sec * NSEC_PER_SEC + Ts->tv_nsec;
+}
+
+static int64_t
+Clock_NowNs(clockid_t Clock)
+{
+  struct timespec Ts;
+  clock_gettime(Clock, &Ts);
+  return Timespec_ToNs(&Ts);
+}
+
+static int64_t
+RTC_ToEpoch(const HT1382_DateTime_t *DateTime)
+{
+  struct tm Tm = {0};
+
+  Tm.tm_sec  = DateTime->Second;
+  Tm.tm_min  = DateTime->Minute;
+  Tm.tm_hour = DateTime->Hour;
+  Tm.tm_mday = DateTime->Day;
+  Tm.tm_mon  = DateTime->Month - 1;
+  Tm.tm_year = DateTime->Year + 100;
+
+  return (int64_t)timegm(&Tm);
+}
+
+static void
+RTC_FromEpoch(int64_t Epoch, HT1382_DateTime_t *DateTime)
+{
+  time_t T = (time_t)Epoch;
+  struct tm Tm;
+
+  gmtime_r(&T, &Tm);
+  DateTime->Second  = Tm.tm_sec;
+  DateTime->Minute  = Tm.tm_min;
+  DateTime->Hour    = Tm.tm_hour;
+  DateTime->WeekDay = Tm.tm_wday + 1;
+  DateTime->Day     = Tm.tm_mday;
+  DateTime->Month   = Tm.tm_mon + 1;
+  DateTime->Year    = Tm.tm_year - 100;
+}
+
+static void
+Drift_Load(const char *Path, Drift_t *Drift)
+{
+  FILE *File = NULL;
+  long long LastSet = 0;
+
+  Drift->GainPerDay = 0;
+  Drift->LastSet = 0;
+
+  if (!Path || !(File = fopen(Path, "r")))
+    return;
+
+  if (fscanf(File, "%lf %lld", &Drift->GainPerDay, &LastSet) == 2)
+    Drift->LastSet = LastSet;
+  else
+    Drift->GainPerDay = 0;
+
+  fclose(File);
+}
+
+static int
+Drift_Save(const char *Path, const Drift_t *Drift)
+{
+  FILE *File = NULL;
+
+  if (!Path)
+    return 0;
+
+  if (!(File = fopen(Path, "w")))
+    return -1;
+
+  fprintf(File, "%.6f %lld\n", Drift->GainPerDay, (long long)Drift->LastSet);
+  return fclose(File);
+}
+
+/**
+ * @brief  Correction (in ns) to subtract from a raw RTC reading
+ */
+static int64_t
+Drift_CorrectionNs(const Drift_t *Drift, int64_t RtcEpoch)
+{
+  double Days = 0;
+
+  if (!Drift->LastSet || RtcEpoch <= Drift->LastSet)
+    return 0;
+
+  Days = (double)(RtcEpoch - Drift->LastSet) / 86400.0;
+  return (int64_t)(Drift->GainPerDay * Days * NSEC_PER_SEC);
+}
+
+/**
+ * @brief  Minimum duration of a 7-byte time burst read (ns)
+ */
+static int64_t
+RTC_MeasureLatency(HT1382_Handler_t *Handler)
+{
+  HT1382_DateTime_t DateTime;
+  int64_t Best = INT64_MAX;
+  int64_t Start, Dur;
+  int i;
+
+  for (i = 0; i < HT1382_LATENCY_SAMPLES; i++)
+  {
+    Start = Clock_NowNs(CLOCK_MONOTONIC);
+    if (HT1382_GetDateTime(Handler, &DateTime) != HT1382_OK)
+      return -1;
+    Dur = Clock_NowNs(CLOCK_MONOTONIC) - Start;
+    if (Dur < Best)
+      Best = Dur;
+  }
+
+  return Best;
+}
+
+/**
+ * @brief  Wait for the RTC seconds edge.
+ * @note   Polls every HT1382_EDGE_POLL_NS, the edge is estimated between the
+ *         last two reads.
+ * @param  RtcEpoch: RTC time just after the edge
+ * @param  SysNs: CLOCK_REALTIME (ns) estimated at the edge
+ */
+static int
+RTC_ReadAtEdge(HT1382_Handler_t *Handler, int64_t *RtcEpoch, int64_t *SysNs)
+{
+  HT1382_DateTime_t DateTime;
+  int64_t Begin = Clock_NowNs(CLOCK_MONOTONIC);
+  int64_t PrevMid = 0, Mid = 0;
+  int64_t T0, T1;
+  struct timespec Ts;
+  int PrevSecond = -1;
+
+  while (Clock_NowNs(CLOCK_MONOTONIC) - Begin < HT1382_EDGE_TIMEOUT_NS)
+  {
+    T0 = Clock_NowNs(CLOCK_REALTIME);
+    if (HT1382_GetDateTime(Handler, &DateTime) != HT1382_OK)
+      return -1;
+    T1 = Clock_NowNs(CLOCK_REALTIME);
+    Mid = T0 + (T1 - T0) / 2;
+
+    if (PrevSecond >= 0 && DateTime.Second != PrevSecond)
+    {
+      *RtcEpoch = RTC_ToEpoch(&DateTime);
+      *SysNs = PrevMid + (Mid - PrevMid) / 2;
+      return 0;
+    }
+
+    PrevSecond = DateTime.Second;
+    PrevMid = Mid;
+
+    Ts.tv_sec = 0;
+    Ts.tv_nsec = HT1382_EDGE_POLL_NS;
+    nanosleep(&Ts, NULL);
+  }
+
+  fprintf(stderr, "RTC seconds did not advance (oscillator stopped?)\n");
+  return -1;
+}
+
+static int
+Cmd_Show(HT1382_Handler_t *Handler, const Drift_t *Drift)
+{
+  int64_t RtcEpoch = 0, SysNs = 0, RtcNs = 0;
+  time_t T;
+  struct tm Tm;
+  char Str[32];
+
+  if (RTC_ReadAtEdge(Handler, &RtcEpoch, &SysNs) < 0)
+    return -1;
+
+  RtcNs = RtcEpoch * NSEC_PER_SEC - Drift_CorrectionNs(Drift, RtcEpoch);
+  T = (time_t)(RtcNs / NSEC_PER_SEC);
+  gmtime_r(&T, &Tm);
+  strftime(Str, sizeof(Str), "%Y-%m-%d %H:%M:%S", &Tm);
+  printf("%s.%06lld UTC  (RTC - system = %+.6f s)\n",
+         Str, (long long)(RtcNs % NSEC_PER_SEC) / 1000,
+         (double)(RtcNs - SysNs) / NSEC_PER_SEC);
+
+  return 0;
+}
+
+static int
+Cmd_HcToSys(HT1382_Handler_t *Handler, const Drift_t *Drift)
+{
+  int64_t RtcEpoch = 0, SysNs = 0, NewNs = 0;
+  struct timespec Ts;
+
+  if (RTC_ReadAtEdge(Handler, &RtcEpoch, &SysNs) < 0)
+    return -1;
+
+  NewNs  = RtcEpoch * NSEC_PER_SEC - Drift_CorrectionNs(Drift, RtcEpoch);
+  NewNs += Clock_NowNs(CLOCK_REALTIME) - SysNs;
+
+  Ts.tv_sec  = (time_t)(NewNs / NSEC_PER_SEC);
+  Ts.tv_nsec = (long)(NewNs % NSEC_PER_SEC);
+  if (clock_settime(CLOCK_REALTIME, &Ts) < 0)
+  {
+    perror("clock_settime");
+    return -1;
+  }
+
+  return 0;
+}
+
+static int
+Cmd_SysToHc(HT1382_Handler_t *Handler, Drift_t *Drift, int UpdateDrift)
+{
+  HT1382_DateTime_t DateTime;
+  int64_t RtcEpoch = 0, SysNs = 0, ErrNs = 0;
+  int64_t Latency = 0, Target = 0, WakeNs = 0;
+  struct timespec Ts;
+  int Err = 0;
+
+  if (UpdateDrift && Drift->LastSet &&
+      Clock_NowNs(CLOCK_REALTIME) / NSEC_PER_SEC - Drift->LastSet >= HT1382_DRIFT_MIN_INTERVAL)
+  {
+    if (RTC_ReadAtEdge(Handler, &RtcEpoch, &SysNs) < 0)
+      return -1;
+
+    ErrNs = RtcEpoch * NSEC_PER_SEC - SysNs;
+    Drift->GainPerDay = ((double)ErrNs / NSEC_PER_SEC) /
+                        ((double)(SysNs / NSEC_PER_SEC - Drift->LastSet) / 86400.0);
+  }
+
+  Latency = RTC_MeasureLatency(Handler);
+  if (Latency < 0)
+    return -1;
+
+  // first whole second that leaves room for the bus transfer
+  Target = Clock_NowNs(CLOCK_REALTIME) / NSEC_PER_SEC + 1;
+  if (Target * NSEC_PER_SEC - Latency - Clock_NowNs(CLOCK_REALTIME) < NSEC_PER_SEC / 100)
+    Target++;
+  RTC_FromEpoch(Target, &DateTime);
+
+  WakeNs = Target * NSEC_PER_SEC - Latency;
+  Ts.tv_sec  = (time_t)(WakeNs / NSEC_PER_SEC);
+  Ts.tv_nsec = (long)(WakeNs % NSEC_PER_SEC);
+  do
+  {
+    Err = clock_nanosleep(CLOCK_REALTIME, TIMER_ABSTIME, &Ts, NULL);
+  } while (Err == EINTR);
+  if (Err)
+  {
+    fprintf(stderr, "clock_nanosleep: %s\n", strerror(Err));
+    return -1;
+  }
+
+  if (HT1382_SetDateTime(Handler, &DateTime) != HT1382_OK)
+    return -1;
+
+  Drift->LastSet = Target;
+  return 0;
+}
+
+
+int main(int argc, char *argv[])
+{
+  HT1382_Handler_t Handler = {0};
+  Drift_t Drift;
+  const char *Cmd = NULL;
+  const char *AdjFile = HT1382_ADJFILE;
+  int Result = 0;
+  int i;
+
+  for (i = 1; i < argc; i++)
+  {
+    if (!strcmp(argv[i], "--show") ||
+        !strcmp(argv[i], "--hctosys") ||
+        !strcmp(argv[i], "--systohc"))
+      Cmd = argv[i];
+    else if (!strcmp(argv[i], "--device") && i + 1 < argc)
+      HT1382_Platform_SetDevice(argv[++i]);
+    else if (!strcmp(argv[i], "--adjfile") && i + 1 < argc)
+      AdjFile = argv[++i];
+    else if (!strcmp(argv[i], "--nodrift"))
+      AdjFile = NULL;
+    else
+      Cmd = NULL, i = argc;
+  }
+
+  if (!Cmd)
+  {
+    fprintf(stderr, "usage: %s --show|--hctosys|--systohc "
+                    "[--device PATH] [--adjfile PATH] [--nodrift]\n", argv[0]);
+    return 2;
+  }
+
+  HT1382_Platform_Init(&Handler);
+  if (HT1382_Init(&Handler) != HT1382_OK)
+  {
+    fprintf(stderr, "cannot open RTC\n");
+    return 1;
+  }
+
+  Drift_Load(AdjFile, &Drift);
+
+  if (!strcmp(Cmd, "--show"))
+    Result = Cmd_Show(&Handler, &Drift);
+  else if (!strcmp(Cmd, "--hctosys"))
+    Result = Cmd_HcToSys(&Handler, &Drift);
+  else
+  {
+    Result = Cmd_SysToHc(&Handler, &Drift, AdjFile != NULL);
+    if (!Result && Drift_Save(AdjFile, &Drift) < 0)
+      perror(AdjFile);
+  }
+
+  HT1382_DeInit(&Handler);
+  return Result ? 1 : 0;
+}
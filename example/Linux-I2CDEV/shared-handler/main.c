@@ -0,0 +1,243 @@
+/**
+ **********************************************************************************
+ * @file   main.c
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  Multi-thread stress example for a shared HT1382 handler (Linux)
+ **********************************************************************************
+ *
+ * Copyright (c) 2024 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+
+/**
+ * Usage: shared-handler [--threads N] [--calls N] [--sim] [--nolock]
+ *
+ * N threads call HT1382_GetDateTime on one handler. With --sim an in-memory
+ * HT1382 model replaces the i2c-dev bus: every transaction takes
+ * SIM_TRANSACTION_US and the model flags a read whose register pointer was
+ * set by a different thread (an interleaved transaction).
+ *
+ * Build with -DHT1382_SINGLE_FLIGHT=1 (the "-sf" binary of the makefile) to
+ * see concurrent callers share one bus read instead of issuing their own.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <unistd.h>
+#include "HT1382.h"
+#include "HT1382_platform.h"
+
+
+#define MAX_THREADS         64
+#define SIM_TRANSACTION_US  200
+
+
+/* Simulated HT1382 -------------------------------------------------------------*/
+static uint8_t Sim_Pointer = 0;
+static _Thread_local int Sim_PointerOwner = 0;
+static _Atomic int Sim_PointerSetBy = 0;
+static _Atomic int Sim_NextThreadId = 1;
+static _Thread_local int Sim_ThreadId = 0;
+static _Atomic unsigned Sim_Reads = 0;
+static _Atomic unsigned Sim_Interleaved = 0;
+static pthread_mutex_t Sim_Mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static int
+Sim_Self(void)
+{
+  if (!Sim_ThreadId)
+    Sim_ThreadId = atomic_fetch_add(&Sim_NextThreadId, 1);
+  return Sim_ThreadId;
+}
+
+static uint8_t
+Sim_BCD(int Value)
+{
+  return (uint8_t)(((Value / 10) << 4) | (Value % 10));
+}
+
+static int8_t
+Sim_Init(void)
+{
+  return 0;
+}
+
+static int8_t
+Sim_Send(uint8_t Address, uint8_t *Data, uint8_t Len)
+{
+  (void)Address;
+  usleep(SIM_TRANSACTION_US);
+  Sim_Pointer = Data[0];
+  Sim_PointerOwner = 1;
+  atomic_store(&Sim_PointerSetBy, Sim_Self());
+  (void)Len;
+  return 0;
+}
+
+static int8_t
+Sim_Receive(uint8_t Address, uint8_t *Data, uint8_t Len)
+{
+  time_t Now = time(NULL);
+  struct tm Tm;
+  uint8_t Regs[7];
+  uint8_t i;
+
+  (void)Address;
+  usleep(SIM_TRANSACTION_US);
+  if (!Sim_PointerOwner || atomic_load(&Sim_PointerSetBy) != Sim_Self())
+    atomic_fetch_add(&Sim_Interleaved, 1);
+  Sim_PointerOwner = 0;
+  atomic_fetch_add(&Sim_Reads, 1);
+
+  gmtime_r(&Now, &Tm);
+  Regs[0] = Sim_BCD(Tm.tm_sec);
+  Regs[1] = Sim_BCD(Tm.tm_min);
+  Regs[2] = Sim_BCD(Tm.tm_hour) | 0x80;
+  Regs[3] = Sim_BCD(Tm.tm_mday);
+  Regs[4] = Sim_BCD(Tm.tm_mon + 1);
+  Regs[5] = Sim_BCD(Tm.tm_wday + 1);
+  Regs[6] = Sim_BCD(Tm.tm_year - 100);
+  for (i = 0; i < Len; i++)
+    Data[i] = (Sim_Pointer + i < 7) ? Regs[Sim_Pointer + i] : 0;
+
+  return 0;
+}
+
+static int8_t
+Sim_Lock(void)
+{
+  return pthread_mutex_lock(&Sim_Mutex) ? -1 : 0;
+}
+
+static int8_t
+Sim_Unlock(void)
+{
+  pthread_mutex_unlock(&Sim_Mutex);
+  return 0;
+}
+
+
+/* Stress -----------------------------------------------------------------------*/
+static HT1382_Handler_t Handler = {0};
+static int CallsPerThread = 200;
+static _Atomic unsigned Failures = 0;
+
+static void *
+Worker_Thread(void *Arg)
+{
+  HT1382_DateTime_t DateTime;
+  int i;
+
+  (void)Arg;
+  for (i = 0; i < CallsPerThread; i++)
+  {
+    if (HT1382_GetDateTime(&Handler, &DateTime) != HT1382_OK ||
+        DateTime.Second > 59 || DateTime.Month == 0 || DateTime.Month > 12)
+      atomic_fetch_add(&Failures, 1);
+  }
+
+  return NULL;
+}
+
+
+int main(int argc, char *argv[])
+{
+  pthread_t Threads[MAX_THREADS];
+  struct timespec T0, T1;
+  int ThreadCount = 8;
+  int Sim = 0, NoLock = 0;
+  double Elapsed;
+  unsigned Calls;
+  int i;
+
+  for (i = 1; i < argc; i++)
+  {
+    if (!strcmp(argv[i], "--threads") && i + 1 < argc)
+      ThreadCount = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--calls") && i + 1 < argc)
+      CallsPerThread = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--sim"))
+      Sim = 1;
+    else if (!strcmp(argv[i], "--nolock"))
+      NoLock = 1;
+    else
+    {
+      fprintf(stderr, "usage: %s [--threads N] [--calls N] [--sim] [--nolock]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  if (ThreadCount < 1 || ThreadCount > MAX_THREADS)
+    ThreadCount = 8;
+
+  if (Sim)
+  {
+    HT1382_PLATFORM_LINK_INIT(&Handler, Sim_Init);
+    HT1382_PLATFORM_LINK_SEND(&Handler, Sim_Send);
+    HT1382_PLATFORM_LINK_RECEIVE(&Handler, Sim_Receive);
+    HT1382_PLATFORM_LINK_LOCK(&Handler, Sim_Lock);
+    HT1382_PLATFORM_LINK_UNLOCK(&Handler, Sim_Unlock);
+  }
+  else
+  {
+    HT1382_Platform_Init(&Handler);
+  }
+
+  if (NoLock)
+  {
+    HT1382_PLATFORM_LINK_LOCK(&Handler, NULL);
+    HT1382_PLATFORM_LINK_UNLOCK(&Handler, NULL);
+  }
+
+  if (HT1382_Init(&Handler) != HT1382_OK)
+  {
+    fprintf(stderr, "cannot open RTC\n");
+    return 1;
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &T0);
+  for (i = 0; i < ThreadCount; i++)
+    pthread_create(&Threads[i], NULL, Worker_Thread, NULL);
+  for (i = 0; i < ThreadCount; i++)
+    pthread_join(Threads[i], NULL);
+  clock_gettime(CLOCK_MONOTONIC, &T1);
+
+  Elapsed = (T1.tv_sec - T0.tv_sec) + (T1.tv_nsec - T0.tv_nsec) / 1e9;
+  Calls = (unsigned)(ThreadCount * CallsPerThread);
+
+  printf("single-flight: %s, lock: %s\n",
+         HT1382_SINGLE_FLIGHT ? "on" : "off", NoLock ? "off" : "on");
+  printf("threads: %d, calls: %u, failed: %u, time: %.3f s\n",
+         ThreadCount, Calls, atomic_load(&Failures), Elapsed);
+  if (Sim)
+    printf("bus reads: %u (%.2f per call), interleaved transactions: %u\n",
+           atomic_load(&Sim_Reads), (double)atomic_load(&Sim_Reads) / Calls,
+           atomic_load(&Sim_Interleaved));
+
+  HT1382_DeInit(&Handler);
+  return (atomic_load(&Failures) || atomic_load(&Sim_Interleaved)) ? 1 : 0;
+}
@@ -0,0 +1,208 @@
+/**
+ **********************************************************************************
+ * @file   HT1382_shm.h
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  Shared-memory time page published by ht1382-timed
+ *         Functionalities of the this file:
+ *          + Layout of the shared time page
+ *          + Lock-free (seqlock) client read
+ **********************************************************************************
+ *
+ * Copyright (c) 2024 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+
+/* Define to prevent recursive inclusion ----------------------------------------*/
+#ifndef _HT1382_SHM_H_
+#define _HT1382_SHM_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* Includes ---------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdatomic.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "HT1382.h"
+
+
+/* Exported Constants -----------------------------------------------------------*/
+#define HT1382_SHM_NAME     "/ht1382-time"
+#define HT1382_SHM_MAGIC    0x48543133UL // "HT13"
+#define HT1382_SHM_VERSION  1
+
+/**
+ * @brief  Seq reads HT1382_Shm_Read tries before it gives up
+ * @note   An update takes well under a microsecond; Seq stays odd only when
+ *         the daemon died mid-update or retired the page on restart/exit.
+ */
+#define HT1382_SHM_READ_RETRIES  100000
+
+
+/* Exported Data Types ----------------------------------------------------------*/
+/**
+ * @brief  Time snapshot published by the daemon
+ * @note   MonoNs is CLOCK_MONOTONIC at the moment the RTC burst completed, so
+ *         a client can tell the age of a snapshot and extrapolate from it.
+ */
+typedef struct HT1382_ShmTime_s
+{
+  int64_t           Epoch;    // RTC time as Unix time (UTC)
+  int64_t           MonoNs;   // CLOCK_MONOTONIC when it was read
+  uint32_t          Updates;  // number of successful RTC reads
+  uint32_t          Errors;   // number of failed RTC reads
+  HT1382_DateTime_t DateTime;
+} HT1382_ShmTime_t;
+
+/**
+ * @brief  Shared page layout
+ * @note   Seq is a seqlock counter: odd while the daemon is writing. A page
+ *         the daemon left (exit or restart) keeps an odd Seq forever.
+ */
+typedef struct HT1382_ShmPage_s
+{
+  uint32_t          Magic;
+  uint32_t          Version;
+  uint32_t          PeriodMs;
+  _Atomic uint32_t  Seq;
+  HT1382_ShmTime_t  Time;
+} HT1382_ShmPage_t;
+
+
+
+/**
+ ==================================================================================
+                           ##### Client Functions #####                            
+ ==================================================================================
+ */
+
+/**
+ * @brief  Map the shared time page read-only
+ * @retval Pointer to page or NULL if the daemon is not running
+ * @note   The daemon creates the object empty and sizes it afterwards; a
+ *         short object is not mapped, since reading past its end raises
+ *         SIGBUS.
+ */
+static inline const HT1382_ShmPage_t *
+HT1382_Shm_Open(void)
+{
+  const HT1382_ShmPage_t *Page = NULL;
+  struct stat St;
+  int Fd = shm_open(HT1382_SHM_NAME, O_RDONLY, 0);
+
+  if (Fd < 0)
+    return NULL;
+
+  if (fstat(Fd, &St) < 0 || St.st_size < (off_t)sizeof(HT1382_ShmPage_t))
+  {
+    close(Fd);
+    return NULL;
+  }
+
+  Page = (const HT1382_ShmPage_t *)mmap(NULL, sizeof(HT1382_ShmPage_t),
+                                        PROT_READ, MAP_SHARED, Fd, 0);
+  close(Fd);
+
+  if (Page == MAP_FAILED)
+    return NULL;
+
+  if (Page->Magic != HT1382_SHM_MAGIC || Page->Version != HT1382_SHM_VERSION)
+  {
+    munmap((void *)Page, sizeof(HT1382_ShmPage_t));
+    return NULL;
+  }
+
+  return Page;
+}
+
+/**
+ * @brief  Unmap the shared time page
+ */
+static inline void
+HT1382_Shm_Close(const HT1382_ShmPage_t *Page)
+{
+  munmap((void *)Page, sizeof(HT1382_ShmPage_t));
+}
+
+/**
+ * @brief  Read a consistent snapshot without locking
+ * @note   Retries only while the daemon is in the middle of an update.
+ * @retval 0 on success, -1 if the page was left by the daemon (close it and
+ *         open the page again)
+ */
+static inline int
+HT1382_Shm_Read(const HT1382_ShmPage_t *Page, HT1382_ShmTime_t *Time)
+{
+  uint32_t Seq1, Seq2;
+  uint32_t Retry;
+
+  for (Retry = 0; Retry < HT1382_SHM_READ_RETRIES; Retry++)
+  {
+    Seq1 = atomic_load_explicit(&Page->Seq, memory_order_acquire);
+    if (Seq1 & 1)
+      continue;
+    *Time = *(const volatile HT1382_ShmTime_t *)&Page->Time;
+    atomic_thread_fence(memory_order_acquire);
+    Seq2 = atomic_load_explicit(&Page->Seq, memory_order_relaxed);
+    if (Seq1 == Seq2)
+      return 0;
+  }
+
+  return -1;
+}
+
+/**
+ * @brief  Leave a page (daemon side): readers of it fail from now on
+ */
+static inline void
+HT1382_Shm_Retire(HT1382_ShmPage_t *Page)
+{
+  atomic_fetch_or_explicit(&Page->Seq, 1, memory_order_release);
+}
+
+/**
+ * @brief  Publish a snapshot (daemon side)
+ */
+static inline void
+HT1382_Shm_Write(HT1382_ShmPage_t *Page, const HT1382_ShmTime_t *Time)
+{
+  uint32_t Seq = atomic_load_explicit(&Page->Seq, memory_order_relaxed);
+
+  atomic_store_explicit(&Page->Seq, Seq + 1, memory_order_relaxed);
+  atomic_thread_fence(memory_order_release);
+  *(volatile HT1382_ShmTime_t *)&Page->Time = *Time;
+  atomic_store_explicit(&Page->Seq, Seq + 2, memory_order_release);
+}
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif //! _HT1382_SHM_H_
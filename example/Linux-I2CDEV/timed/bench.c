@@ -0,0 +1,188 @@
+/**
+ **********************************************************************************
+ * @file   bench.c
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  Concurrent reader benchmark for the ht1382-timed shared time page
+ **********************************************************************************
+ *
+ * Copyright (c) 2024 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+
+/**
+ * Usage: ht1382-timed-bench [--readers N] [--seconds S] [--attach]
+ *
+ * Starts N reader threads that call HT1382_Shm_Read() in a tight loop and
+ * reports reads per second and ns per read. By default a private page is
+ * published by an in-process writer thread every 1 ms (10-100x the rate of
+ * a real daemon, to stress the retry path); with --attach the page of a
+ * running ht1382-timed is used instead.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include "HT1382_shm.h"
+
+
+#define BENCH_MAX_READERS   256
+
+
+typedef struct Reader_s
+{
+  pthread_t Thread;
+  uint64_t  Reads;
+  uint64_t  Torn;
+  int       Failed;   // the daemon left the page
+} Reader_t;
+
+
+static const HT1382_ShmPage_t *Page = NULL;
+static HT1382_ShmPage_t *PrivatePage = NULL;
+static _Atomic int Running = 1;
+
+
+static void *
+Reader_Thread(void *Arg)
+{
+  Reader_t *Reader = (Reader_t *)Arg;
+  HT1382_ShmTime_t Time;
+
+  while (atomic_load_explicit(&Running, memory_order_relaxed))
+  {
+    if (HT1382_Shm_Read(Page, &Time) < 0)
+    {
+      Reader->Failed = 1;
+      break;
+    }
+    // the writer keeps Epoch == Updates, so a torn copy is detectable
+    if (PrivatePage && Time.Epoch != (int64_t)Time.Updates)
+      Reader->Torn++;
+    Reader->Reads++;
+  }
+
+  return NULL;
+}
+
+static void *
+Writer_Thread(void *Arg)
+{
+  HT1382_ShmTime_t Time = {0};
+  struct timespec Delay = {0, 1000000L};
+
+  (void)Arg;
+  while (atomic_load_explicit(&Running, memory_order_relaxed))
+  {
+    Time.Updates++;
+    Time.Epoch = Time.Updates;
+    Time.DateTime.Second = Time.Updates % 60;
+    HT1382_Shm_Write(PrivatePage, &Time);
+    nanosleep(&Delay, NULL);
+  }
+
+  return NULL;
+}
+
+
+int main(int argc, char *argv[])
+{
+  static Reader_t Readers[BENCH_MAX_READERS];
+  pthread_t Writer;
+  struct timespec Duration = {2, 0};
+  uint64_t TotalReads = 0, TotalTorn = 0;
+  int Failed = 0;
+  int ReaderCount = 4;
+  int Attach = 0;
+  int i;
+
+  for (i = 1; i < argc; i++)
+  {
+    if (!strcmp(argv[i], "--readers") && i + 1 < argc)
+      ReaderCount = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--seconds") && i + 1 < argc)
+      Duration.tv_sec = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--attach"))
+      Attach = 1;
+    else
+    {
+      fprintf(stderr, "usage: %s [--readers N] [--seconds S] [--attach]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  if (ReaderCount < 1 || ReaderCount > BENCH_MAX_READERS)
+    ReaderCount = 4;
+
+  if (Attach)
+  {
+    Page = HT1382_Shm_Open();
+    if (!Page)
+    {
+      fprintf(stderr, "ht1382-timed is not running\n");
+      return 1;
+    }
+  }
+  else
+  {
+    PrivatePage = (HT1382_ShmPage_t *)calloc(1, sizeof(HT1382_ShmPage_t));
+    Page = PrivatePage;
+    pthread_create(&Writer, NULL, Writer_Thread, NULL);
+  }
+
+  for (i = 0; i < ReaderCount; i++)
+    pthread_create(&Readers[i].Thread, NULL, Reader_Thread, &Readers[i]);
+
+  nanosleep(&Duration, NULL);
+  atomic_store(&Running, 0);
+
+  for (i = 0; i < ReaderCount; i++)
+  {
+    pthread_join(Readers[i].Thread, NULL);
+    TotalReads += Readers[i].Reads;
+    TotalTorn += Readers[i].Torn;
+    Failed |= Readers[i].Failed;
+  }
+
+  if (PrivatePage)
+    pthread_join(Writer, NULL);
+
+  printf("readers: %d, duration: %ld s\n", ReaderCount, (long)Duration.tv_sec);
+  printf("total reads: %llu (%.1f M/s)\n", (unsigned long long)TotalReads,
+         (double)TotalReads / Duration.tv_sec / 1e6);
+  printf("per reader: %.1f ns/read\n",
+         (double)Duration.tv_sec * 1e9 * ReaderCount / (double)TotalReads);
+  if (PrivatePage)
+    printf("torn snapshots: %llu\n", (unsigned long long)TotalTorn);
+
+  if (Failed)
+    printf("ht1382-timed exited or restarted during the run\n");
+
+  if (Attach)
+    HT1382_Shm_Close(Page);
+  else
+    free(PrivatePage);
+
+  return Failed ? 1 : 0;
+}
@@ -0,0 +1,217 @@
+/**
+ **********************************************************************************
+ * @file   daemon.c
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  Time service daemon: owns the HT1382 and publishes its time in shared memory
+ **********************************************************************************
+ *
+ * Copyright (c) 2024 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+
+/**
+ * Usage: ht1382-timed [--device PATH] [--period MS]
+ *
+ * The daemon is the only process that touches the I2C bus. It reads the RTC
+ * every PERIOD milliseconds (default HT1382_TIMED_PERIOD_MS) and publishes the
+ * result in the HT1382_SHM_NAME page. Clients map the page with
+ * HT1382_Shm_Open() and read it with HT1382_Shm_Read() without any syscall.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/stat.h>
+#include "HT1382.h"
+#include "HT1382_platform.h"
+#include "HT1382_shm.h"
+
+
+#define HT1382_TIMED_PERIOD_MS  100
+
+
+static volatile sig_atomic_t Running = 1;
+
+
+static void
+Signal_Handler(int Sig)
+{
+  (void)Sig;
+  Running = 0;
+}
+
+static int64_t
+DateTime_ToEpoch(const HT1382_DateTime_t *DateTime)
+{
+  struct tm Tm = {0};
+
+  Tm.tm_sec  = DateTime->Second;
+  Tm.tm_min  = DateTime->Minute;
+  Tm.tm_hour = DateTime->Hour;
+  Tm.tm_mday = DateTime->Day;
+  Tm.tm_mon  = DateTime->Month - 1;
+  Tm.tm_year = DateTime->Year + 100;
+
+  return (int64_t)timegm(&Tm);
+}
+
+static HT1382_ShmPage_t *
+Shm_Map(int Fd)
+{
+  HT1382_ShmPage_t *Page = NULL;
+
+  Page = (HT1382_ShmPage_t *)mmap(NULL, sizeof(HT1382_ShmPage_t),
+                                  PROT_READ | PROT_WRITE, MAP_SHARED, Fd, 0);
+  close(Fd);
+
+  return (Page == MAP_FAILED) ? NULL : Page;
+}
+
+static HT1382_ShmPage_t *
+Shm_Create(uint32_t PeriodMs)
+{
+  HT1382_ShmPage_t *Page = NULL;
+  struct stat St;
+  int Fd = shm_open(HT1382_SHM_NAME, O_RDWR, 0);
+
+  // clients may still map the page of a previous daemon: retire it and
+  // unlink it, a new page is never shared with an old one
+  if (Fd >= 0)
+  {
+    if (fstat(Fd, &St) == 0 && St.st_size >= (off_t)sizeof(HT1382_ShmPage_t))
+    {
+      Page = Shm_Map(Fd);
+      if (Page)
+      {
+        HT1382_Shm_Retire(Page);
+        munmap(Page, sizeof(HT1382_ShmPage_t));
+      }
+    }
+    else
+    {
+      close(Fd);
+    }
+    shm_unlink(HT1382_SHM_NAME);
+  }
+
+  Fd = shm_open(HT1382_SHM_NAME, O_RDWR | O_CREAT | O_EXCL, 0644);
+  if (Fd < 0)
+    return NULL;
+
+  if (ftruncate(Fd, sizeof(HT1382_ShmPage_t)) < 0)
+  {
+    close(Fd);
+    shm_unlink(HT1382_SHM_NAME);
+    return NULL;
+  }
+
+  // a new page is zero-filled by ftruncate
+  Page = Shm_Map(Fd);
+  if (!Page)
+  {
+    shm_unlink(HT1382_SHM_NAME);
+    return NULL;
+  }
+
+  Page->PeriodMs = PeriodMs;
+  Page->Version = HT1382_SHM_VERSION;
+  atomic_thread_fence(memory_order_release);
+  Page->Magic = HT1382_SHM_MAGIC;
+
+  return Page;
+}
+
+
+int main(int argc, char *argv[])
+{
+  HT1382_Handler_t Handler = {0};
+  HT1382_ShmPage_t *Page = NULL;
+  HT1382_ShmTime_t Time = {0};
+  struct timespec Next, Now;
+  uint32_t PeriodMs = HT1382_TIMED_PERIOD_MS;
+  int i;
+
+  for (i = 1; i < argc; i++)
+  {
+    if (!strcmp(argv[i], "--device") && i + 1 < argc)
+      HT1382_Platform_SetDevice(argv[++i]);
+    else if (!strcmp(argv[i], "--period") && i + 1 < argc)
+      PeriodMs = (uint32_t)strtoul(argv[++i], NULL, 0);
+    else
+    {
+      fprintf(stderr, "usage: %s [--device PATH] [--period MS]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  if (!PeriodMs)
+    PeriodMs = 1;
+
+  HT1382_Platform_Init(&Handler);
+  if (HT1382_Init(&Handler) != HT1382_OK)
+  {
+    fprintf(stderr, "cannot open RTC\n");
+    return 1;
+  }
+
+  Page = Shm_Create(PeriodMs);
+  if (!Page)
+  {
+    perror(HT1382_SHM_NAME);
+    HT1382_DeInit(&Handler);
+    return 1;
+  }
+
+  signal(SIGINT, Signal_Handler);
+  signal(SIGTERM, Signal_Handler);
+
+  clock_gettime(CLOCK_MONOTONIC, &Next);
+  while (Running)
+  {
+    if (HT1382_GetDateTime(&Handler, &Time.DateTime) == HT1382_OK)
+    {
+      clock_gettime(CLOCK_MONOTONIC, &Now);
+      Time.Epoch  = DateTime_ToEpoch(&Time.DateTime);
+      Time.MonoNs = (int64_t)Now.tv_sec * 1000000000LL + Now.tv_nsec;
+      Time.Updates++;
+    }
+    else
+    {
+      Time.Errors++;
+    }
+    HT1382_Shm_Write(Page, &Time);
+
+    Next.tv_nsec += (long)(PeriodMs % 1000) * 1000000L;
+    Next.tv_sec  += PeriodMs / 1000 + Next.tv_nsec / 1000000000L;
+    Next.tv_nsec %= 1000000000L;
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &Next, NULL);
+  }
+
+  HT1382_Shm_Retire(Page);
+  munmap(Page, sizeof(HT1382_ShmPage_t));
+  shm_unlink(HT1382_SHM_NAME);
+  HT1382_DeInit(&Handler);
+  return 0;
+}
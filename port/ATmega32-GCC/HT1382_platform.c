@@ -54,6 +54,13 @@
 #endif
 
 
+/* Private Constants ------------------------------------------------------------*/
+/**
+ * @brief  Smallest TWBR value allowed in master mode (ATmega32 datasheet)
+ */
+#define PLATFORM_TWBR_MIN  10
+
+
 
 /**
  ==================================================================================
@@ -61,14 +68,45 @@
  ==================================================================================
  */
 
+/**
+ * @note   SCL = F_CPU / (16 + 2 * TWBR * 4^TWPS). The smallest prescaler that
+ *         fits TWBR in 8 bits is used, and TWBR is rounded up so that SCL
+ *         never exceeds Rate.
+ */
 static int8_t
-Platform_Init(void)
+Platform_SetRate(uint32_t Rate)
 {
-  TWBR = (uint8_t)(F_CPU - 1600000) / (2 * HT1382_I2C_RATE);
+  uint32_t Divider = 0;
+  uint32_t Twbr = 0;
+  uint8_t Twps = 0;
+
+  if (!Rate || F_CPU / Rate < 16 + 2 * PLATFORM_TWBR_MIN)
+    return -1;
+
+  Divider = (F_CPU + Rate - 1) / Rate - 16; // 2 * TWBR * 4^TWPS
+  for (Twps = 0; Twps < 4; Twps++)
+  {
+    Twbr = (Divider + (2UL << (2 * Twps)) - 1) / (2UL << (2 * Twps));
+    if (Twbr <= 0xFF)
+      break;
+  }
+  if (Twps == 4)
+    return -1; // slower than F_CPU / (16 + 2 * 255 * 64)
+
+  TWBR = (uint8_t)Twbr;
+  TWSR = Twps; // TWPS1:0 are the only writable bits of TWSR
+
   return 0;
 }
 
 
+static int8_t
+Platform_Init(void)
+{
+  return Platform_SetRate(HT1382_I2C_RATE);
+}
+
+
 static int8_t
 Platform_DeInit(void)
 {
@@ -129,6 +167,90 @@ Platform_ReadData(uint8_t Address, uint8_t *Data, uint8_t DataLen)
 }
 
 
+#if HT1382_PLATFORM_CAL
+/**
+ * @note   Polls the Timer1 capture and overflow flags; at 8 MHz a 4096 Hz
+ *         edge comes every 1953 cycles. An overflow that is pending together
+ *         with a capture in the lower half of the count came before it.
+ */
+static int32_t
+Platform_CalMeasure(uint16_t Periods)
+{
+  uint8_t SavedTCCR1A = TCCR1A;
+  uint8_t SavedTCCR1B = TCCR1B;
+  uint8_t SavedTIMSK = TIMSK;
+  uint32_t Limit = (((F_CPU / 512) * Periods) >> 16) + 2; // 2x the slowest reference
+  uint32_t Overflows = 0;
+  uint16_t Start = 0;
+  uint16_t Capture = 0;
+  uint16_t Edges = 0;
+  uint8_t Flags = 0;
+  int32_t Result = -1;
+
+  cbi(DDRD, PD6); // ICP1 input with pull-up
+  sbi(PORTD, PD6);
+
+  TIMSK &= ~(_BV(TICIE1) | _BV(TOIE1));
+  TCCR1A = 0;
+  TCCR1B = _BV(ICES1) | _BV(CS10); // rising edge, F_CPU / 1
+  TIFR = _BV(ICF1) | _BV(TOV1);
+
+  while (Overflows <= Limit)
+  {
+    Flags = TIFR;
+    if (Flags & _BV(ICF1))
+    {
+      Capture = ICR1;
+      TIFR = _BV(ICF1);
+      if ((Flags & _BV(TOV1)) && Capture < 0x8000)
+      {
+        TIFR = _BV(TOV1);
+        Overflows++;
+      }
+
+      if (Edges == 0)
+      {
+        Start = Capture;
+        Overflows = 0;
+      }
+      else if (Edges == Periods)
+      {
+        Result = (int32_t)((Overflows << 16) + Capture - Start);
+        break;
+      }
+      Edges++;
+    }
+    else if (Flags & _BV(TOV1))
+    {
+      TIFR = _BV(TOV1);
+      Overflows++;
+    }
+  }
+
+  TCCR1B = SavedTCCR1B;
+  TCCR1A = SavedTCCR1A;
+  TIMSK = SavedTIMSK;
+
+  return Result;
+}
+
+
+static uint8_t
+Platform_CalGetTrim(void)
+{
+  return OSCCAL;
+}
+
+
+static void
+Platform_CalSetTrim(uint8_t Trim)
+{
+  // large OSCCAL jumps can upset the CPU, move one step at a time
+  while (OSCCAL != Trim)
+    OSCCAL = (OSCCAL < Trim) ? OSCCAL + 1 : OSCCAL - 1;
+}
+#endif
+
 
 /**
  ==================================================================================
@@ -148,4 +270,26 @@ HT1382_Platform_Init(HT1382_Handler_t *Handler)
   HT1382_PLATFORM_LINK_DEINIT(Handler, Platform_DeInit);
   HT1382_PLATFORM_LINK_SEND(Handler, Platform_WriteData);
   HT1382_PLATFORM_LINK_RECEIVE(Handler, Platform_ReadData);
+  HT1382_PLATFORM_LINK_LOCK(Handler, NULL);
+  HT1382_PLATFORM_LINK_UNLOCK(Handler, NULL);
+  HT1382_PLATFORM_LINK_SETRATE(Handler, Platform_SetRate);
+}
+
+
+#if HT1382_PLATFORM_CAL
+/**
+ * @brief  Initialize RC oscillator calibration with the Timer1 input capture
+ *         and OSCCAL functions of this port.
+ * @note   Interrupt handlers must be shorter than one reference period
+ *         (244 us at 4096 Hz) while HT1382_Cal_Run measures.
+ * @param  Cal: Pointer to calibration
+ * @param  Handler: Pointer to an initialized handler
+ * @retval HT1382_Result_t (see HT1382_Cal_Init)
+ */
+HT1382_Result_t
+HT1382_Platform_CalInit(HT1382_Cal_t *Cal, HT1382_Handler_t *Handler)
+{
+  return HT1382_Cal_Init(Cal, Handler, Platform_CalMeasure,
+                         Platform_CalGetTrim, Platform_CalSetTrim, F_CPU);
 }
+#endif
@@ -44,8 +44,21 @@ extern "C" {
 
 
 /* Functionality Options --------------------------------------------------------*/
+// Initial bus clock in Hz (can be changed later with Platform.SetRate).
+// TWBR must be 10 or more, so the fastest clock is F_CPU / 36
+// (222 kHz at 8 MHz, 400 kHz needs F_CPU >= 14.4 MHz).
 #define HT1382_I2C_RATE  100000
 
+// RC oscillator calibration against SQW/OUT (HT1382_cal.c), 1: Enable, 0: Disable.
+// SQW/OUT must be wired to ICP1 (PD6); Timer1 is used during HT1382_Cal_Run.
+#ifndef HT1382_PLATFORM_CAL
+#define HT1382_PLATFORM_CAL  0
+#endif
+
+#if HT1382_PLATFORM_CAL
+#include "HT1382_cal.h"
+#endif
+
 
 
 /**
@@ -63,6 +76,21 @@ void
 HT1382_Platform_Init(HT1382_Handler_t *Handler);
 
 
+#if HT1382_PLATFORM_CAL
+/**
+ * @brief  Initialize RC oscillator calibration with the Timer1 input capture
+ *         and OSCCAL functions of this port.
+ * @note   Interrupt handlers must be shorter than one reference period
+ *         (244 us at 4096 Hz) while HT1382_Cal_Run measures.
+ * @param  Cal: Pointer to calibration
+ * @param  Handler: Pointer to an initialized handler
+ * @retval HT1382_Result_t (see HT1382_Cal_Init)
+ */
+HT1382_Result_t
+HT1382_Platform_CalInit(HT1382_Cal_t *Cal, HT1382_Handler_t *Handler);
+#endif
+
+
 #ifdef __cplusplus
 }
 #endif
@@ -36,6 +36,13 @@
 #include "esp_system.h"
 #include "driver/i2c.h"
 #include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+
+/* Private Variables ------------------------------------------------------------*/
+#if HT1382_PLATFORM_LOCK
+static SemaphoreHandle_t Platform_Mutex = NULL;
+#endif
 
 
 
@@ -46,7 +53,7 @@
  */
 
 static int8_t
-Platform_Init(void)
+Platform_Config(uint32_t Rate)
 {
   i2c_config_t conf = {0};
 
@@ -55,11 +62,29 @@ Platform_Init(void)
   conf.sda_pullup_en = GPIO_PULLUP_DISABLE;
   conf.scl_io_num = HT1382_SCL_GPIO;
   conf.scl_pullup_en = GPIO_PULLUP_DISABLE;
-  conf.master.clk_speed = HT1382_I2C_RATE;
+  conf.master.clk_speed = Rate;
   if (i2c_param_config(HT1382_I2C_NUM, &conf) != ESP_OK)
     return -1;
 
-  if (i2c_driver_install(HT1382_I2C_NUM, conf.mode,
+  return 0;
+}
+
+
+static int8_t
+Platform_Init(void)
+{
+#if HT1382_PLATFORM_LOCK
+  // the mutex is shared by all handlers and kept by Platform_DeInit
+  if (!Platform_Mutex)
+    Platform_Mutex = xSemaphoreCreateMutex();
+  if (!Platform_Mutex)
+    return -3;
+#endif
+
+  if (Platform_Config(HT1382_I2C_RATE) < 0)
+    return -1;
+
+  if (i2c_driver_install(HT1382_I2C_NUM, I2C_MODE_MASTER,
                          0, 0, 0) != ESP_OK)
     return -2;
 
@@ -67,6 +92,20 @@ Platform_Init(void)
 }
 
 
+/**
+ * @note   The I2C controller supports up to 1 MHz and the clock can be changed
+ *         while the driver is installed.
+ */
+static int8_t
+Platform_SetRate(uint32_t Rate)
+{
+  if (!Rate || Rate > 1000000)
+    return -1;
+
+  return Platform_Config(Rate);
+}
+
+
 static int8_t
 Platform_DeInit(void)
 {
@@ -128,6 +167,29 @@ Platform_ReadData(uint8_t Address, uint8_t *Data, uint8_t DataLen)
 }
 
 
+#if HT1382_PLATFORM_LOCK
+static int8_t
+Platform_Lock(void)
+{
+  if (!Platform_Mutex)
+    return -1;
+
+  if (xSemaphoreTake(Platform_Mutex, portMAX_DELAY) != pdTRUE)
+    return -1;
+
+  return 0;
+}
+
+
+static int8_t
+Platform_Unlock(void)
+{
+  xSemaphoreGive(Platform_Mutex);
+  return 0;
+}
+#endif
+
+
 
 /**
  ==================================================================================
@@ -147,4 +209,12 @@ HT1382_Platform_Init(HT1382_Handler_t *Handler)
   HT1382_PLATFORM_LINK_DEINIT(Handler, Platform_DeInit);
   HT1382_PLATFORM_LINK_SEND(Handler, Platform_WriteData);
   HT1382_PLATFORM_LINK_RECEIVE(Handler, Platform_ReadData);
+  HT1382_PLATFORM_LINK_SETRATE(Handler, Platform_SetRate);
+#if HT1382_PLATFORM_LOCK
+  HT1382_PLATFORM_LINK_LOCK(Handler, Platform_Lock);
+  HT1382_PLATFORM_LINK_UNLOCK(Handler, Platform_Unlock);
+#else
+  HT1382_PLATFORM_LINK_LOCK(Handler, NULL);
+  HT1382_PLATFORM_LINK_UNLOCK(Handler, NULL);
+#endif
 }
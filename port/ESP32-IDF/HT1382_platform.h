@@ -49,6 +49,10 @@ extern "C" {
 #define HT1382_SCL_GPIO  GPIO_NUM_16
 #define HT1382_SDA_GPIO  GPIO_NUM_15
 
+// 1: serialize driver calls from several tasks with a FreeRTOS mutex
+// (follows HT1382_CONFIG_LOCK, the driver never calls the mutex without it)
+#define HT1382_PLATFORM_LOCK  HT1382_CONFIG_LOCK
+
 
 
 /**
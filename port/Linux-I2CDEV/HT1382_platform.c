@@ -0,0 +1,175 @@
+/**
+ **********************************************************************************
+ * @file   HT1382_platform.c
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  HT1382 chip driver platform dependent part
+ *         Functionalities of the this file:
+ *          + Initialization the platform-dependent part of handler
+ **********************************************************************************
+ *
+ * Copyright (c) 2024 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+
+/* Includes ---------------------------------------------------------------------*/
+#include "HT1382_platform.h"
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/i2c-dev.h>
+
+
+/* Private Variables ------------------------------------------------------------*/
+static const char *Platform_DevPath = HT1382_I2C_DEV;
+static int Platform_Fd = -1;
+static int Platform_SlaveAddress = -1;
+static pthread_mutex_t Platform_Mutex = PTHREAD_MUTEX_INITIALIZER;
+
+
+
+/**
+ ==================================================================================
+                           ##### Private Functions #####                           
+ ==================================================================================
+ */
+
+static int8_t
+Platform_Init(void)
+{
+  Platform_Fd = open(Platform_DevPath, O_RDWR);
+  if (Platform_Fd < 0)
+    return -1;
+
+  Platform_SlaveAddress = -1;
+  return 0;
+}
+
+
+static int8_t
+Platform_DeInit(void)
+{
+  if (Platform_Fd >= 0)
+    close(Platform_Fd);
+
+  Platform_Fd = -1;
+  return 0;
+}
+
+
+static int8_t
+Platform_SelectSlave(uint8_t Address)
+{
+  if (Platform_SlaveAddress == Address)
+    return 0;
+
+  if (ioctl(Platform_Fd, I2C_SLAVE, Address) < 0)
+    return -1;
+
+  Platform_SlaveAddress = Address;
+  return 0;
+}
+
+
+static int8_t
+Platform_WriteData(uint8_t Address, uint8_t *Data, uint8_t DataLen)
+{
+  if (Platform_SelectSlave(Address) < 0)
+    return -1;
+
+  if (write(Platform_Fd, Data, DataLen) != DataLen)
+    return -3;
+
+  return 0;
+}
+
+
+static int8_t
+Platform_ReadData(uint8_t Address, uint8_t *Data, uint8_t DataLen)
+{
+  if (Platform_SelectSlave(Address) < 0)
+    return -1;
+
+  if (read(Platform_Fd, Data, DataLen) != DataLen)
+    return -3;
+
+  return 0;
+}
+
+
+static int8_t
+Platform_Lock(void)
+{
+  if (pthread_mutex_lock(&Platform_Mutex))
+    return -1;
+
+  return 0;
+}
+
+
+static int8_t
+Platform_Unlock(void)
+{
+  pthread_mutex_unlock(&Platform_Mutex);
+  return 0;
+}
+
+
+
+/**
+ ==================================================================================
+                            ##### Public Functions #####                           
+ ==================================================================================
+ */
+
+/**
+ * @brief  Initialize platform device to communicate HT1382.
+ * @param  Handler: Pointer to handler
+ * @retval None
+ */
+void
+HT1382_Platform_Init(HT1382_Handler_t *Handler)
+{
+  HT1382_PLATFORM_LINK_INIT(Handler, Platform_Init);
+  HT1382_PLATFORM_LINK_DEINIT(Handler, Platform_DeInit);
+  HT1382_PLATFORM_LINK_SEND(Handler, Platform_WriteData);
+  HT1382_PLATFORM_LINK_RECEIVE(Handler, Platform_ReadData);
+  HT1382_PLATFORM_LINK_LOCK(Handler, Platform_Lock);
+  HT1382_PLATFORM_LINK_UNLOCK(Handler, Platform_Unlock);
+  // the bus clock is set by the kernel (clock-frequency of the adapter)
+  HT1382_PLATFORM_LINK_SETRATE(Handler, NULL);
+}
+
+
+/**
+ * @brief  Select the i2c-dev device node used by the platform layer.
+ * @note   Must be called before HT1382_Init. If it is not called,
+ *         HT1382_I2C_DEV is used.
+ * @param  Path: Path of i2c-dev node (e.g. "/dev/i2c-1")
+ * @retval None
+ */
+void
+HT1382_Platform_SetDevice(const char *Path)
+{
+  Platform_DevPath = Path;
+}
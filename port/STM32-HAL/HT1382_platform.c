@@ -40,6 +40,27 @@
 #define HT1382_TIMEOUT 100
 #endif
 
+// I2C_DUTYCYCLE_2 exists on peripherals clocked by ClockSpeed (F1/F2/F4/L1)
+#if defined(I2C_DUTYCYCLE_2) || \
+    (defined(HT1382_I2C_TIMING_100K) && defined(HT1382_I2C_TIMING_400K))
+#define PLATFORM_SETRATE  1
+#else
+#define PLATFORM_SETRATE  0
+#endif
+
+
+/* Private Variables ------------------------------------------------------------*/
+#if HT1382_PLATFORM_MIRROR
+static HT1382_Mirror_t Platform_Mirror HT1382_MIRROR_ATTR;
+// a DMA read of the mirror is running
+static volatile uint8_t Platform_MirrorBusy = 0;
+// the driver uses the bus, no new mirror reads
+static volatile uint8_t Platform_MirrorPaused = 0;
+// Lock/Unlock linked by the application before HT1382_Platform_MirrorStart
+static HT1382_PlatformLockUnlock_t Platform_UserLock = NULL;
+static HT1382_PlatformLockUnlock_t Platform_UserUnlock = NULL;
+#endif
+
 
 /**
  ==================================================================================
@@ -54,6 +75,37 @@ Platform_Init(void)
 }
 
 
+#if PLATFORM_SETRATE
+static int8_t
+Platform_SetRate(uint32_t Rate)
+{
+  extern I2C_HandleTypeDef HT1382_HI2C;
+
+#if defined(I2C_DUTYCYCLE_2)
+  if (!Rate || Rate > 400000)
+    return -1;
+  HT1382_HI2C.Init.ClockSpeed = Rate;
+  HT1382_HI2C.Init.DutyCycle = I2C_DUTYCYCLE_2;
+#else
+  if (Rate == 100000)
+    HT1382_HI2C.Init.Timing = HT1382_I2C_TIMING_100K;
+  else if (Rate == 400000)
+    HT1382_HI2C.Init.Timing = HT1382_I2C_TIMING_400K;
+  else
+    return -1;
+#endif
+
+  // HAL computes the clock registers from Init in HAL_I2C_Init
+  if (HAL_I2C_DeInit(&HT1382_HI2C) != HAL_OK)
+    return -1;
+  if (HAL_I2C_Init(&HT1382_HI2C) != HAL_OK)
+    return -1;
+
+  return 0;
+}
+#endif
+
+
 static int8_t
 Platform_DeInit(void)
 {
@@ -66,6 +118,12 @@ Platform_WriteData(uint8_t Address, uint8_t *Data, uint8_t DataLen)
 {
   extern I2C_HandleTypeDef HT1382_HI2C;
 
+#if HT1382_PLATFORM_MIRROR
+  // a register write may change the time, the next mirror read restores Valid
+  if (DataLen > 1)
+    Platform_Mirror.Valid = 0;
+#endif
+
   Address <<= 1;
   if (HAL_I2C_Master_Transmit(&HT1382_HI2C, Address,
                               Data, DataLen, HT1382_TIMEOUT))
@@ -89,6 +147,67 @@ Platform_ReadData(uint8_t Address, uint8_t *Data, uint8_t DataLen)
 }
 
 
+#if HT1382_PLATFORM_MIRROR
+/**
+ * @brief  Wait for a running mirror read and keep new ones from starting
+ */
+static int8_t
+Platform_MirrorPause(void)
+{
+  uint32_t Start = HAL_GetTick();
+
+  Platform_MirrorPaused = 1;
+  while (Platform_MirrorBusy)
+  {
+    if (HAL_GetTick() - Start > HT1382_TIMEOUT)
+    {
+      Platform_MirrorPaused = 0;
+      return -1;
+    }
+  }
+
+  return 0;
+}
+
+
+/**
+ * @note   Fails in interrupt context: the wait for a mirror read needs
+ *         SysTick and the application mutex can not be taken there.
+ */
+static int8_t
+Platform_Lock(void)
+{
+  if (__get_IPSR() != 0)
+    return -1;
+
+  if (Platform_UserLock)
+    if (Platform_UserLock() < 0)
+      return -1;
+
+  if (Platform_MirrorPause() < 0)
+  {
+    if (Platform_UserUnlock)
+      Platform_UserUnlock();
+    return -1;
+  }
+
+  return 0;
+}
+
+
+static int8_t
+Platform_Unlock(void)
+{
+  Platform_MirrorPaused = 0;
+
+  if (Platform_UserUnlock)
+    return Platform_UserUnlock();
+
+  return 0;
+}
+#endif
+
+
 
 /**
  ==================================================================================
@@ -108,4 +227,143 @@ HT1382_Platform_Init(HT1382_Handler_t *Handler)
   HT1382_PLATFORM_LINK_DEINIT(Handler, Platform_DeInit);
   HT1382_PLATFORM_LINK_SEND(Handler, Platform_WriteData);
   HT1382_PLATFORM_LINK_RECEIVE(Handler, Platform_ReadData);
+  HT1382_PLATFORM_LINK_LOCK(Handler, NULL);
+  HT1382_PLATFORM_LINK_UNLOCK(Handler, NULL);
+#if PLATFORM_SETRATE
+  HT1382_PLATFORM_LINK_SETRATE(Handler, Platform_SetRate);
+#else
+  HT1382_PLATFORM_LINK_SETRATE(Handler, NULL);
+#endif
 }
+
+
+#if HT1382_PLATFORM_MIRROR
+/**
+ * @brief  Start the time register mirror.
+ * @note   Call after HT1382_Init, with the application mutex (if any)
+ *         already linked as Platform.Lock/Unlock. The mirror wraps it: the
+ *         mutex is taken first, then the mirror reads are paused.
+ * @note   In interrupt context the wrapped Lock fails, so HT1382_GetDateTime
+ *         returns HT1382_FAIL there when the mirror is not valid, and the
+ *         other driver functions always fail.
+ * @param  Handler: Pointer to an initialized handler
+ * @retval HT1382_Result_t
+ *         - HT1382_OK: Operation was successful.
+ *         - HT1382_FAIL: Failed to start the timer.
+ */
+HT1382_Result_t
+HT1382_Platform_MirrorStart(HT1382_Handler_t *Handler)
+{
+  extern TIM_HandleTypeDef HT1382_MIRROR_HTIM;
+
+  Platform_Mirror.Valid = 0;
+  Platform_MirrorPaused = 0;
+  Platform_UserLock = Handler->Platform.Lock;
+  Platform_UserUnlock = Handler->Platform.Unlock;
+  HT1382_PLATFORM_LINK_LOCK(Handler, Platform_Lock);
+  HT1382_PLATFORM_LINK_UNLOCK(Handler, Platform_Unlock);
+  Handler->Mirror = &Platform_Mirror;
+
+  if (HAL_TIM_Base_Start_IT(&HT1382_MIRROR_HTIM) != HAL_OK)
+  {
+    HT1382_Platform_MirrorStop(Handler);
+    return HT1382_FAIL;
+  }
+
+  return HT1382_OK;
+}
+
+
+/**
+ * @brief  Stop the time register mirror and wait for a running read.
+ * @note   Links the application Lock/Unlock saved by MirrorStart again.
+ * @param  Handler: Pointer to handler
+ * @retval None
+ */
+void
+HT1382_Platform_MirrorStop(HT1382_Handler_t *Handler)
+{
+  extern TIM_HandleTypeDef HT1382_MIRROR_HTIM;
+
+  HAL_TIM_Base_Stop_IT(&HT1382_MIRROR_HTIM);
+  if (Platform_MirrorPause() == 0)
+    Platform_MirrorPaused = 0;
+
+  Handler->Mirror = NULL;
+  Platform_Mirror.Valid = 0;
+  HT1382_PLATFORM_LINK_LOCK(Handler, Platform_UserLock);
+  HT1382_PLATFORM_LINK_UNLOCK(Handler, Platform_UserUnlock);
+}
+
+
+/**
+ * @brief  Start a mirror read. Call from HAL_TIM_PeriodElapsedCallback.
+ * @note   The read goes to the buffer after the latest one, readers of the
+ *         latest buffer are not disturbed.
+ * @param  htim: Timer handle passed to the callback
+ * @retval None
+ */
+void
+HT1382_Platform_MirrorTick(TIM_HandleTypeDef *htim)
+{
+  extern TIM_HandleTypeDef HT1382_MIRROR_HTIM;
+  extern I2C_HandleTypeDef HT1382_HI2C;
+  uint8_t *Buffer = NULL;
+
+  if (htim != &HT1382_MIRROR_HTIM || Platform_MirrorBusy)
+    return;
+
+  // Busy before Paused, Platform_Lock checks them in the opposite order
+  Platform_MirrorBusy = 1;
+  if (Platform_MirrorPaused)
+  {
+    Platform_MirrorBusy = 0;
+    return;
+  }
+
+  Buffer = Platform_Mirror.Buffer[(uint8_t)(Platform_Mirror.Seq + 1) & 1];
+  if (HAL_I2C_Mem_Read_DMA(&HT1382_HI2C, HT1382_ADDRESS << 1,
+                           HT1382_REG_ADDR_SECONDS, I2C_MEMADD_SIZE_8BIT,
+                           Buffer, 7) != HAL_OK)
+    Platform_MirrorBusy = 0;
+}
+
+
+/**
+ * @brief  Publish a completed mirror read. Call from
+ *         HAL_I2C_MemRxCpltCallback.
+ * @param  hi2c: I2C handle passed to the callback
+ * @retval None
+ */
+void
+HT1382_Platform_MirrorDone(I2C_HandleTypeDef *hi2c)
+{
+  extern I2C_HandleTypeDef HT1382_HI2C;
+
+  if (hi2c != &HT1382_HI2C || !Platform_MirrorBusy)
+    return;
+
+  HT1382_MIRROR_BARRIER();
+  Platform_Mirror.Seq++;
+  Platform_Mirror.Valid = 1;
+  Platform_MirrorBusy = 0;
+}
+
+
+/**
+ * @brief  Drop a failed mirror read. Call from HAL_I2C_ErrorCallback.
+ * @param  hi2c: I2C handle passed to the callback
+ * @retval None
+ */
+void
+HT1382_Platform_MirrorError(I2C_HandleTypeDef *hi2c)
+{
+  extern I2C_HandleTypeDef HT1382_HI2C;
+
+  if (hi2c != &HT1382_HI2C || !Platform_MirrorBusy)
+    return;
+
+  Platform_Mirror.Valid = 0;
+  Platform_MirrorBusy = 0;
+}
+#endif
@@ -46,6 +46,35 @@ extern "C" {
 /* Functionality Options --------------------------------------------------------*/
 #define HT1382_HI2C      hi2c2
 
+// I2C peripherals with a TIMINGR register (F0/F3/F7/G0/G4/H7/L0/L4/...) need
+// timing values generated by CubeMX for the actual kernel clock. Define both
+// to let Platform.SetRate switch between 100 kHz and 400 kHz on them.
+// #define HT1382_I2C_TIMING_100K  0x10909CEC
+// #define HT1382_I2C_TIMING_400K  0x00702991
+
+// Time register mirror (HT1382_CONFIG_MIRROR and HT1382_CONFIG_LOCK must be 1).
+// Each period of this timer reads the 7 time registers with I2C DMA into RAM
+// and HT1382_GetDateTime decodes the latest read without using the bus.
+// I2C RX DMA and the I2C and timer interrupts must be enabled in CubeMX.
+// #define HT1382_MIRROR_HTIM  htim6
+
+// Placement of the mirror buffers. DMA bypasses the D-cache of Cortex-M7
+// cores, so put them in non-cacheable RAM there, e.g.
+// __attribute__((section(".dma_buffer"))).
+#ifndef HT1382_MIRROR_ATTR
+#define HT1382_MIRROR_ATTR
+#endif
+
+#if defined(HT1382_MIRROR_HTIM)
+#if !HT1382_CONFIG_MIRROR || !HT1382_CONFIG_LOCK
+#error "HT1382_MIRROR_HTIM requires HT1382_CONFIG_MIRROR and HT1382_CONFIG_LOCK"
+#endif
+#define HT1382_PLATFORM_MIRROR  1
+#include "main.h"
+#else
+#define HT1382_PLATFORM_MIRROR  0
+#endif
+
 
 
 /**
@@ -63,6 +92,60 @@ void
 HT1382_Platform_Init(HT1382_Handler_t *Handler);
 
 
+#if HT1382_PLATFORM_MIRROR
+/**
+ * @brief  Start the time register mirror.
+ * @note   Call after HT1382_Init, with the application mutex (if any)
+ *         already linked as Platform.Lock/Unlock. The mirror wraps it: the
+ *         mutex is taken first, then the mirror reads are paused. Without a
+ *         mutex only one task may call the driver.
+ * @note   In interrupt context the wrapped Lock fails, so HT1382_GetDateTime
+ *         returns HT1382_FAIL there when the mirror is not valid, and the
+ *         other driver functions always fail.
+ * @param  Handler: Pointer to an initialized handler
+ * @retval HT1382_Result_t
+ *         - HT1382_OK: Operation was successful.
+ *         - HT1382_FAIL: Failed to start the timer.
+ */
+HT1382_Result_t
+HT1382_Platform_MirrorStart(HT1382_Handler_t *Handler);
+
+/**
+ * @brief  Stop the time register mirror and wait for a running read.
+ * @note   Links the application Lock/Unlock saved by MirrorStart again.
+ * @param  Handler: Pointer to handler
+ * @retval None
+ */
+void
+HT1382_Platform_MirrorStop(HT1382_Handler_t *Handler);
+
+/**
+ * @brief  Start a mirror read. Call from HAL_TIM_PeriodElapsedCallback.
+ * @param  htim: Timer handle passed to the callback
+ * @retval None
+ */
+void
+HT1382_Platform_MirrorTick(TIM_HandleTypeDef *htim);
+
+/**
+ * @brief  Publish a completed mirror read. Call from
+ *         HAL_I2C_MemRxCpltCallback.
+ * @param  hi2c: I2C handle passed to the callback
+ * @retval None
+ */
+void
+HT1382_Platform_MirrorDone(I2C_HandleTypeDef *hi2c);
+
+/**
+ * @brief  Drop a failed mirror read. Call from HAL_I2C_ErrorCallback.
+ * @param  hi2c: I2C handle passed to the callback
+ * @retval None
+ */
+void
+HT1382_Platform_MirrorError(I2C_HandleTypeDef *hi2c);
+#endif
+
+
 #ifdef __cplusplus
 }
 #endif
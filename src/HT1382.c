@@ -34,124 +34,35 @@
 
 
 /* Private Constants ------------------------------------------------------------*/
-/**
- * @brief  The HT1382 Address on I2C BUS
- */ 
-#define HT1382_ADDRESS  0x68
-
-/**
- * @brief  Internal Registers Address
- */ 
-#define HT1382_REG_ADDR_SECONDS         0x00
-#define HT1382_REG_ADDR_MINUTES         0x01
-#define HT1382_REG_ADDR_HOURS           0x02
-#define HT1382_REG_ADDR_DATE            0x03
-#define HT1382_REG_ADDR_MONTH           0x04
-#define HT1382_REG_ADDR_DAY             0x05
-#define HT1382_REG_ADDR_YEAR            0x06
-#define HT1382_REG_ADDR_ST1             0x07
-#define HT1382_REG_ADDR_ST2             0x08
-#define HT1382_REG_ADDR_INT             0x09
-#define HT1382_REG_ADDR_SECONDS_ALARM   0x0A
-#define HT1382_REG_ADDR_MINUTES_ALARM   0x0B
-#define HT1382_REG_ADDR_HOURS_ALARM     0x0C
-#define HT1382_REG_ADDR_DATE_ALARM      0x0D
-#define HT1382_REG_ADDR_MONTH_ALARM     0x0E
-#define HT1382_REG_ADDR_DAY_ALARM       0x0F
-#define HT1382_REG_ADDR_DT              0x10
-#define HT1382_REG_ADDR_USR1            0x11
-#define HT1382_REG_ADDR_USR2            0x12
-#define HT1382_REG_ADDR_USR3            0x13
-#define HT1382_REG_ADDR_USR4            0x14
-
-/**
- * @brief  Register bits of Seconds register
- */
-#define HT1382_SECONDS_CH               7
-
-/**
- * @brief  Register bits of Hours register
- */
-#define HT1382_HOURS_AM_PM              5
-#define HT1382_HOURS_12_24              7
-
-
-/**
- * @brief  Register bits of ST1 register
- */
-#define HT1382_ST1_WP                   7
-
-/**
- * @brief  Register bits of ST2 register
- */
-#define HT1382_ST2_BE                   1
-#define HT1382_ST2_AI                   2
-#define HT1382_ST2_EB                   3
-#define HT1382_ST2_EWE                  4
-#define HT1382_ST2_ARE                  7
+// chip address, registers and register bits are defined in HT1382_chip.h
 
 /**
- * @brief  Register bits of INT register
+ * @brief  Largest gap of unchanged registers merged into one write burst
+ * @note   A new burst costs a START, the slave address and the register
+ *         pointer, so rewriting two unchanged bytes is cheaper.
  */
-#define HT1382_INT_FO0                  0
-#define HT1382_INT_FO1                  1
-#define HT1382_INT_FO2                  2
-#define HT1382_INT_FO3                  3
-#define HT1382_INT_OEOBM                4
-#define HT1382_INT_LPM                  5
-#define HT1382_INT_AE                   6
-#define HT1382_INT_IME                  7
+#define HT1382_IMAGE_MERGE_GAP          2
 
-/**
- * @brief  Register bits of Seconds Alarm register
- */
-#define HT1382_SECONDS_ALARM_SECEN      7
-
-/**
- * @brief  Register bits of Minutes Alarm register
- */
-#define HT1382_MINUTES_ALARM_MINEN      7
-
-/**
- * @brief  Register bits of Hours Alarm register
- */
-#define HT1382_HOURS_ALARM_HREN         7
 
 /**
- * @brief  Register bits of Date Alarm register
+ * @brief  Copies of the mirror HT1382_GetDateTime tries before it reads the
+ *         chip
+ * @note   A copy is retried only if a mirror read completed during it.
  */
-#define HT1382_DATE_ALARM_DTEN          7
+#define HT1382_MIRROR_RETRIES           3
 
-/**
- * @brief  Register bits of Month Alarm register
- */
-#define HT1382_MONTH_ALARM_MOEN         7
-
-/**
- * @brief  Register bits of Day Alarm register
- */
-#define HT1382_DAY_ALARM_DAYEN          7
 
+/* Private Macro ----------------------------------------------------------------*/
 /**
- * @brief  Register bits of DT register
+ * @brief  Register managed by the library that a register image must not set
  */
-#define HT1382_DT_DT0                   0
-#define HT1382_DT_DT1                   1
-#define HT1382_DT_DT2                   2
-#define HT1382_DT_DT3                   3
-#define HT1382_DT_DT4                   4
-#define HT1382_DT_DT5                   5
-#define HT1382_DT_DT6                   6
-#define HT1382_DT_DTS                   7
-
-
-/* Private Macro ----------------------------------------------------------------*/
-#ifndef MIN
-#define MIN(a, b) (((a) < (b)) ? (a) : (b))
+#if HT1382_CHIP_HAS_WP
+#define HT1382_IS_WP_REG(REG)           ((REG) == HT1382_REG_ADDR_ST1)
+#else
+#define HT1382_IS_WP_REG(REG)           0
 #endif
 
 
-
 /**
  ==================================================================================
                            ##### Private Functions #####                           
@@ -178,26 +89,49 @@ HT1382_BCDtoDEC(uint8_t BCD)
   return DEC;
 }
 
+/**
+ * @brief  Validate DateTime and encode it as the seconds-to-year burst
+ * @note   Frame[1..7] receive registers 0x00-0x06 with CH cleared and 24-hour
+ *         mode selected. Frame[0] is left for the register pointer.
+ */
 static int8_t
-HT1382_WriteRegs(HT1382_Handler_t *Handler,
-                 uint8_t StartReg, uint8_t *Data, uint8_t BytesCount)
+HT1382_EncodeTime(const HT1382_DateTime_t *DateTime, uint8_t *Frame)
 {
-  uint8_t Buffer[HT1382_SEND_BUFFER_SIZE] = {0};
-  uint8_t Len = 0;
+#if HT1382_CONFIG_VALIDATION
+  if (DateTime->Second > 59 ||
+      DateTime->Minute > 59 ||
+      DateTime->Hour > 23 ||
+      DateTime->WeekDay > 7 || DateTime->WeekDay == 0 ||
+      DateTime->Day > 31 || DateTime->Day == 0 ||
+      DateTime->Month > 12 || DateTime->Month == 0 ||
+      DateTime->Year > 99)
+    return -1;
+#endif
 
-  Buffer[0] = StartReg; // send register address to set RTC pointer
-  while (BytesCount)
-  {
-    Len = MIN(BytesCount, sizeof(Buffer)-1);
-    memcpy((void*)(Buffer+1), (const void*)Data, Len);
+  // convert value of parameter to BCD
+  Frame[1 + HT1382_REG_ADDR_SECONDS] = HT1382_DECtoBCD(DateTime->Second) & ~(1 << HT1382_SECONDS_CH);
+  Frame[1 + HT1382_REG_ADDR_MINUTES] = HT1382_DECtoBCD(DateTime->Minute);
+  Frame[1 + HT1382_REG_ADDR_HOURS]   = HT1382_DECtoBCD(DateTime->Hour) | HT1382_CHIP_HOURS_24H;
+  Frame[1 + HT1382_REG_ADDR_DAY]     = HT1382_DECtoBCD(DateTime->WeekDay);
+  Frame[1 + HT1382_REG_ADDR_DATE]    = HT1382_DECtoBCD(DateTime->Day);
+  Frame[1 + HT1382_REG_ADDR_MONTH]   = HT1382_DECtoBCD(DateTime->Month);
+  Frame[1 + HT1382_REG_ADDR_YEAR]    = HT1382_DECtoBCD(DateTime->Year);
 
-    if (Handler->Platform.Send(HT1382_ADDRESS, Buffer, Len+1) < 0)
-      return -1;
+  return 0;
+}
 
-    Data += Len;
-    Buffer[0] += Len;
-    BytesCount -= Len;
-  }
+/**
+ * @note   Frame[0] is overwritten with StartReg and the data to write starts at
+ *         Frame[1], so callers build the data in place and no copy is needed.
+ */
+static int8_t
+HT1382_WriteRegs(HT1382_Handler_t *Handler,
+                 uint8_t StartReg, uint8_t *Frame, uint8_t BytesCount)
+{
+  Frame[0] = StartReg; // send register address to set RTC pointer
+
+  if (Handler->Platform.Send(HT1382_ADDRESS, Frame, BytesCount + 1) < 0)
+    return -1;
 
   return 0;
 }
@@ -215,14 +149,295 @@ HT1382_ReadRegs(HT1382_Handler_t *Handler,
   return 0;
 }
 
+/**
+ * @brief  Read the 7 time registers as one coherent snapshot
+ * @note   The chip copies the time counters to the user buffer at the START
+ *         condition of a read and the burst is clocked out of that buffer, so
+ *         a single 7-byte Receive can not mix fields across a rollover.
+ * @note   With HT1382_SNAPSHOT_CHECK, a read that returns second 59 is
+ *         verified with a 1-byte seconds read. If the seconds changed, the
+ *         burst is read once more; the next rollover is a minute away.
+ */
+static int8_t
+HT1382_ReadTime(HT1382_Handler_t *Handler, uint8_t *Buffer)
+{
+#if HT1382_SNAPSHOT_CHECK
+  uint8_t Seconds = 0;
+#endif
+
+  if (HT1382_ReadRegs(Handler, HT1382_REG_ADDR_SECONDS, Buffer, 7) < 0)
+    return -1;
+
+#if HT1382_SNAPSHOT_CHECK
+  if ((Buffer[HT1382_REG_ADDR_SECONDS] & 0x7F) != 0x59)
+    return 0;
+
+  if (HT1382_ReadRegs(Handler, HT1382_REG_ADDR_SECONDS, &Seconds, 1) < 0)
+    return -1;
+
+  if (Seconds != Buffer[HT1382_REG_ADDR_SECONDS])
+  {
+    if (HT1382_ReadRegs(Handler, HT1382_REG_ADDR_SECONDS, Buffer, 7) < 0)
+      return -1;
+  }
+#endif
+
+  return 0;
+}
+
+/**
+ * @brief  Decode the 7 time registers, Buffer[n] holds register n
+ */
+static void
+HT1382_DecodeTime(const uint8_t *Buffer, HT1382_DateTime_t *DateTime)
+{
+  // convert BCD value to decimal
+  DateTime->Second  = HT1382_BCDtoDEC(Buffer[HT1382_REG_ADDR_SECONDS] & 0x7F);
+  DateTime->Minute  = HT1382_BCDtoDEC(Buffer[HT1382_REG_ADDR_MINUTES] & 0x7F);
+#if HT1382_CONFIG_12H_DECODE
+  DateTime->Hour    = HT1382_CHIP_HOURS_TO_DEC(Buffer[HT1382_REG_ADDR_HOURS]);
+#else
+  DateTime->Hour    = HT1382_BCDtoDEC(Buffer[HT1382_REG_ADDR_HOURS] & 0x3F);
+#endif
+  DateTime->WeekDay = HT1382_BCDtoDEC(Buffer[HT1382_REG_ADDR_DAY] & 0x07);
+  DateTime->Day     = HT1382_BCDtoDEC(Buffer[HT1382_REG_ADDR_DATE] & 0x3F);
+  DateTime->Month   = HT1382_BCDtoDEC(Buffer[HT1382_REG_ADDR_MONTH] & 0x1F);
+  DateTime->Year    = HT1382_BCDtoDEC(Buffer[HT1382_REG_ADDR_YEAR]);
+}
+
 static int8_t
 HT1382_WriteProtection(HT1382_Handler_t *Handler, uint8_t Enable)
 {
+#if HT1382_CHIP_HAS_WP
+  uint8_t Frame[2] = {0};
+
   if (Enable)
-    Enable = (1 << HT1382_ST1_WP);
+    Frame[1] = (1 << HT1382_ST1_WP);
+
+#if HT1382_CONFIG_ARMED
+  // HT1382_FireDateTime must find the time registers unlocked
+  if (Handler->Armed)
+    Frame[1] = 0;
+#endif
+
+#if HT1382_CONFIG_SHADOW
+  Handler->Shadow[HT1382_CHIP_SHADOW_INDEX(HT1382_REG_ADDR_ST1)] = Frame[1];
+#endif
+
+  return HT1382_WriteRegs(Handler, HT1382_REG_ADDR_ST1, Frame, 1);
+#else
+  (void)Handler;
+  (void)Enable;
+  return 0;
+#endif
+}
+
+static int8_t
+HT1382_WriteRegsUnprotected(HT1382_Handler_t *Handler,
+                            uint8_t StartReg, uint8_t *Frame, uint8_t BytesCount)
+{
+  if (HT1382_WriteProtection(Handler, 0) < 0)
+    return -1;
+
+  if (HT1382_WriteRegs(Handler, StartReg, Frame, BytesCount) < 0)
+    return -1;
+
+  if (HT1382_WriteProtection(Handler, 1) < 0)
+    return -1;
+
+  return 0;
+}
+
+static int8_t
+HT1382_Lock(HT1382_Handler_t *Handler)
+{
+#if HT1382_CONFIG_LOCK
+  if (Handler->Platform.Lock)
+    if (Handler->Platform.Lock() < 0)
+      return -1;
+#endif
+
+#if HT1382_CONFIG_ARMED
+  // HT1382_FireDateTime must not start a transfer in the middle of this call
+  Handler->Busy = 1;
+#else
+  (void)Handler;
+#endif
+
+  return 0;
+}
+
+static void
+HT1382_Unlock(HT1382_Handler_t *Handler)
+{
+#if HT1382_CONFIG_ARMED
+  Handler->Busy = 0;
+#endif
+
+#if HT1382_CONFIG_LOCK
+  if (Handler->Platform.Unlock)
+    Handler->Platform.Unlock();
+#else
+  (void)Handler;
+#endif
+}
+
+#if HT1382_CONFIG_SHADOW
+static void
+HT1382_ShadowLoad(HT1382_Handler_t *Handler,
+                  uint8_t StartReg, const uint8_t *Data, uint8_t BytesCount)
+{
+  uint8_t Reg = 0;
+
+  for (Reg = StartReg; Reg < StartReg + BytesCount; Reg++)
+  {
+    if (HT1382_CHIP_IS_SHADOW_REG(Reg))
+      Handler->Shadow[HT1382_CHIP_SHADOW_INDEX(Reg)] = Data[Reg - StartReg];
+  }
+}
+
+static int8_t
+HT1382_ShadowResync(HT1382_Handler_t *Handler)
+{
+  uint8_t Buffer[HT1382_CHIP_SHADOW_SPAN];
+
+  Handler->ShadowValid = 0;
+
+  if (HT1382_ReadRegs(Handler, HT1382_CHIP_SHADOW_FIRST, Buffer, sizeof(Buffer)) < 0)
+    return -1;
+
+  HT1382_ShadowLoad(Handler, HT1382_CHIP_SHADOW_FIRST, Buffer, sizeof(Buffer));
+  Handler->ShadowValid = 1;
+
+  return 0;
+}
+#endif
+
+#if HT1382_CONFIG_MIRROR
+/**
+ * @brief  Copy the latest complete read of the mirror
+ * @note   Seq changes when a read completes; the read after it goes to the
+ *         buffer being copied, so the copy is kept only if Seq did not change.
+ */
+static int8_t
+HT1382_MirrorRead(const HT1382_Mirror_t *Mirror, uint8_t *Buffer)
+{
+  const volatile uint8_t *Latest = NULL;
+  uint8_t Retry = 0;
+  uint8_t Seq = 0;
+  uint8_t i = 0;
+
+  for (Retry = 0; Retry < HT1382_MIRROR_RETRIES; Retry++)
+  {
+    Seq = Mirror->Seq;
+    HT1382_MIRROR_BARRIER();
+    if (!Mirror->Valid)
+      return -1;
+
+    Latest = Mirror->Buffer[Seq & 1];
+    for (i = 0; i < 7; i++)
+      Buffer[i] = Latest[i];
+
+    HT1382_MIRROR_BARRIER();
+    if (Mirror->Seq == Seq && Mirror->Valid)
+      return 0;
+  }
+
+  return -1;
+}
+#endif
+
+#if HT1382_CONFIG_OUTWAVE || HT1382_CONFIG_POWER
+/**
+ * @brief  Get the current value of a control register
+ * @note   Served from the shadow when HT1382_CONFIG_SHADOW is enabled.
+ */
+static int8_t
+HT1382_ReadControl(HT1382_Handler_t *Handler, uint8_t Reg, uint8_t *Value)
+{
+#if HT1382_CONFIG_SHADOW
+  if (!Handler->ShadowValid)
+  {
+    if (HT1382_ShadowResync(Handler) < 0)
+      return -1;
+  }
+
+  *Value = Handler->Shadow[HT1382_CHIP_SHADOW_INDEX(Reg)];
+  return 0;
+#else
+  return HT1382_ReadRegs(Handler, Reg, Value, 1);
+#endif
+}
+
+/**
+ * @brief  Update the Mask bits of a control register to Value
+ * @note   With Mask 0xFF the register is written without reading it first.
+ *         Otherwise the write is skipped if the bits already match.
+ */
+static int8_t
+HT1382_WriteControl(HT1382_Handler_t *Handler,
+                    uint8_t Reg, uint8_t Mask, uint8_t Value)
+{
+  uint8_t Frame[2] = {0};
+
+  if (Mask != 0xFF)
+  {
+    if (HT1382_ReadControl(Handler, Reg, &Frame[1]) < 0)
+      return -1;
+
+    Value = (Frame[1] & ~Mask) | (Value & Mask);
+    if (Value == Frame[1])
+      return 0;
+  }
+
+  Frame[1] = Value;
+  if (HT1382_WriteRegsUnprotected(Handler, Reg, Frame, 1) < 0)
+  {
+#if HT1382_CONFIG_SHADOW
+    Handler->ShadowValid = 0;
+#endif
+    return -1;
+  }
+
+#if HT1382_CONFIG_SHADOW
+  Handler->Shadow[HT1382_CHIP_SHADOW_INDEX(Reg)] = Value;
+#endif
+
+  return 0;
+}
+#endif
+
+#if HT1382_CONFIG_POWER
+/**
+ * @brief  Encode the INT register, the power bits share the out wave register
+ */
+static uint8_t
+HT1382_IntEncode(const HT1382_IntConfig_t *Config)
+{
+  uint8_t Reg = HT1382_CHIP_OUTWAVE_BITS(Config->OutWave);
+
+  if (Config->OutputOnBattery)
+    Reg |= (1 << HT1382_INT_OEOBM);
+  if (Config->LowPower)
+    Reg |= (1 << HT1382_INT_LPM);
+  if (Config->AlarmEnable)
+    Reg |= (1 << HT1382_INT_AE);
+  if (Config->InterruptMode)
+    Reg |= (1 << HT1382_INT_IME);
+
+  return Reg;
+}
 
-  return HT1382_WriteRegs(Handler, HT1382_REG_ADDR_ST1, &Enable, 1);
+static void
+HT1382_IntDecode(uint8_t Reg, HT1382_IntConfig_t *Config)
+{
+  Config->OutWave         = (HT1382_OutWave_t)((Reg & HT1382_CHIP_OUTWAVE_MASK) >> HT1382_INT_FO0);
+  Config->OutputOnBattery = (Reg >> HT1382_INT_OEOBM) & 0x01;
+  Config->LowPower        = (Reg >> HT1382_INT_LPM) & 0x01;
+  Config->AlarmEnable     = (Reg >> HT1382_INT_AE) & 0x01;
+  Config->InterruptMode   = (Reg >> HT1382_INT_IME) & 0x01;
 }
+#endif
 
 
 
@@ -243,14 +458,49 @@ HT1382_WriteProtection(HT1382_Handler_t *Handler, uint8_t Enable)
 HT1382_Result_t
 HT1382_Init(HT1382_Handler_t *Handler)
 {
+#if HT1382_CONFIG_VALIDATION
   if (!Handler->Platform.Send ||
       !Handler->Platform.Receive)
     return HT1382_INVALID_PARAM;
 
+#if HT1382_CONFIG_LOCK
+  if (!Handler->Platform.Lock != !Handler->Platform.Unlock)
+    return HT1382_INVALID_PARAM;
+#endif
+#endif
+
+#if HT1382_SINGLE_FLIGHT
+  Handler->ReadSeq = 0;
+  Handler->ReadValid = 0;
+#endif
+
+#if HT1382_CONFIG_SHADOW
+  Handler->ShadowValid = 0;
+#endif
+
+#if HT1382_CONFIG_ARMED
+  Handler->Armed = 0;
+  Handler->Busy = 0;
+#endif
+
+#if HT1382_CONFIG_MIRROR
+  Handler->Mirror = NULL;
+#endif
+
+#if HT1382_CONFIG_PROBE
+  Handler->HealthProbed = 0;
+  memset(&Handler->Status, 0, sizeof(Handler->Status));
+#endif
+
   if (Handler->Platform.Init)
     if (Handler->Platform.Init() < 0)
       return HT1382_FAIL;
 
+#if HT1382_INIT_PROBE
+  if (HT1382_Probe(Handler, NULL, HT1382_INIT_PROBE_OPTIONS) != HT1382_OK)
+    return HT1382_FAIL;
+#endif
+
   return HT1382_OK;
 }
 
@@ -273,95 +523,459 @@ HT1382_DeInit(HT1382_Handler_t *Handler)
 
 
 
+#if HT1382_CONFIG_SHADOW
 /**
- ==================================================================================
-                         ##### Public RTC Functions #####                          
- ==================================================================================
- */
-
-/**
- * @brief  Set date and time on HT1382 real time chip
+ * @brief  Reload the control register shadow from the chip
  * @param  Handler: Pointer to handler
- * @param  DateTime: pointer to date and time value structure
  * @retval HT1382_Result_t
  *         - HT1382_OK: Operation was successful.
  *         - HT1382_FAIL: Failed to send or receive data.
- *         - HT1382_INVALID_PARAM: One of parameters is invalid.
  */
 HT1382_Result_t
-HT1382_SetDateTime(HT1382_Handler_t *Handler, HT1382_DateTime_t *DateTime)
+HT1382_ResyncShadow(HT1382_Handler_t *Handler)
 {
-  uint8_t Buffer[7] = {0};
+  int8_t Result = 0;
 
-  if (DateTime->Second > 59 ||
-      DateTime->Minute > 59 ||
-      DateTime->Hour > 23 ||
-      DateTime->WeekDay > 7 || DateTime->WeekDay == 0 ||
-      DateTime->Day > 31 || DateTime->Day == 0 ||
-      DateTime->Month > 12 || DateTime->Month == 0 ||
-      DateTime->Year > 99)
-    return HT1382_INVALID_PARAM;
+  if (HT1382_Lock(Handler) < 0)
+    return HT1382_FAIL;
 
-  // convert value of parameter to BCD
-  Buffer[HT1382_REG_ADDR_SECONDS] = HT1382_DECtoBCD(DateTime->Second) & ~(1 << HT1382_SECONDS_CH);
-  Buffer[HT1382_REG_ADDR_MINUTES] = HT1382_DECtoBCD(DateTime->Minute);
-  Buffer[HT1382_REG_ADDR_HOURS]   = HT1382_DECtoBCD(DateTime->Hour) | (1 << HT1382_HOURS_12_24);
-  Buffer[HT1382_REG_ADDR_DAY]     = HT1382_DECtoBCD(DateTime->WeekDay);
-  Buffer[HT1382_REG_ADDR_DATE]    = HT1382_DECtoBCD(DateTime->Day);
-  Buffer[HT1382_REG_ADDR_MONTH]   = HT1382_DECtoBCD(DateTime->Month);
-  Buffer[HT1382_REG_ADDR_YEAR]    = HT1382_DECtoBCD(DateTime->Year);
+  Result = HT1382_ShadowResync(Handler);
 
-  if (HT1382_WriteProtection(Handler, 0) < 0)
-    return HT1382_FAIL;
+  HT1382_Unlock(Handler);
 
-  if (HT1382_WriteRegs(Handler, HT1382_REG_ADDR_SECONDS, Buffer, 7) < 0)
+  if (Result < 0)
     return HT1382_FAIL;
 
-  if (HT1382_WriteProtection(Handler, 1) < 0)
-    return HT1382_FAIL;
-  
   return HT1382_OK;
 }
+#endif
 
 
+
+#if HT1382_CONFIG_PROBE
 /**
- * @brief  Get date and time from HT1382 real time chip
+ * @brief  Read seconds, ST1, ST2 and INT in one burst and decode the status
  * @param  Handler: Pointer to handler
- * @param  DateTime: pointer to date and time value structure
+ * @param  Status: Pointer to status (can be NULL, Handler->Status is updated)
+ * @param  Options: HT1382_PROBE_READ_ONLY or HT1382_PROBE_xxx flags ORed
  * @retval HT1382_Result_t
  *         - HT1382_OK: Operation was successful.
  *         - HT1382_FAIL: Failed to send or receive data.
  */
 HT1382_Result_t
-HT1382_GetDateTime(HT1382_Handler_t *Handler, HT1382_DateTime_t *DateTime)
+HT1382_Probe(HT1382_Handler_t *Handler, HT1382_Status_t *Status, uint8_t Options)
 {
-  uint8_t Buffer[7] = {0};
+  uint8_t Buffer[HT1382_REG_ADDR_INT + 1] = {0};
+  uint8_t Flags = 0;
+  uint8_t Frame[2] = {0};
+  int8_t Result = 0;
 
-  if (HT1382_ReadRegs(Handler, HT1382_REG_ADDR_SECONDS, Buffer, 7) < 0)
+  if (HT1382_Lock(Handler) < 0)
     return HT1382_FAIL;
 
-  // convert BCD value to decimal
-  DateTime->Second  = HT1382_BCDtoDEC(Buffer[HT1382_REG_ADDR_SECONDS] & ~(1 << HT1382_SECONDS_CH));
-  DateTime->Minute  = HT1382_BCDtoDEC(Buffer[HT1382_REG_ADDR_MINUTES]);
-  if ((Buffer[HT1382_REG_ADDR_HOURS] >> HT1382_HOURS_12_24) & 0x01) // 24 hours mode
+  Result = HT1382_ReadRegs(Handler, HT1382_REG_ADDR_SECONDS, Buffer, sizeof(Buffer));
+  if (Result == 0)
+  {
+    if ((Buffer[HT1382_REG_ADDR_SECONDS] >> HT1382_SECONDS_CH) & 0x01)
+      Flags |= HT1382_STATUS_OSC_STOPPED;
+    if (!((Buffer[HT1382_REG_ADDR_ST1] >> HT1382_ST1_WP) & 0x01))
+      Flags |= HT1382_STATUS_WP_DISABLED;
+    if ((Buffer[HT1382_REG_ADDR_ST2] >> HT1382_ST2_BE) & 0x01)
+      Flags |= HT1382_STATUS_BE;
+    if ((Buffer[HT1382_REG_ADDR_ST2] >> HT1382_ST2_EB) & 0x01)
+      Flags |= HT1382_STATUS_EB;
+    if ((Buffer[HT1382_REG_ADDR_ST2] >> HT1382_ST2_AI) & 0x01)
+      Flags |= HT1382_STATUS_ALARM;
+
+#if HT1382_CONFIG_SHADOW
+    HT1382_ShadowLoad(Handler, HT1382_REG_ADDR_SECONDS, Buffer, sizeof(Buffer));
+#endif
+  }
+
+  if (Result == 0 && (Flags & HT1382_STATUS_OSC_STOPPED) &&
+      (Options & HT1382_PROBE_RESTART_OSC))
   {
-    DateTime->Hour  = HT1382_BCDtoDEC(Buffer[HT1382_REG_ADDR_HOURS] & 0x3F);
+    Frame[1] = Buffer[HT1382_REG_ADDR_SECONDS] & ~(1 << HT1382_SECONDS_CH);
+    Result = HT1382_WriteRegsUnprotected(Handler, HT1382_REG_ADDR_SECONDS, Frame, 1);
+    if (Result == 0)
+      Flags |= HT1382_STATUS_OSC_RESTARTED;
   }
-  else
+  else if (Result == 0 && (Flags & HT1382_STATUS_WP_DISABLED) &&
+           (Options & HT1382_PROBE_RELOCK))
   {
-    DateTime->Hour = HT1382_BCDtoDEC(Buffer[HT1382_REG_ADDR_HOURS] & 0x1F);
-    DateTime->Hour += ((Buffer[HT1382_REG_ADDR_HOURS] >> HT1382_HOURS_AM_PM) & 0x01) ? 12 : 0;
+    Result = HT1382_WriteProtection(Handler, 1);
   }
-  DateTime->WeekDay = HT1382_BCDtoDEC(Buffer[HT1382_REG_ADDR_DAY]);
-  DateTime->Day     = HT1382_BCDtoDEC(Buffer[HT1382_REG_ADDR_DATE]);
-  DateTime->Month   = HT1382_BCDtoDEC(Buffer[HT1382_REG_ADDR_MONTH]);
-  DateTime->Year    = HT1382_BCDtoDEC(Buffer[HT1382_REG_ADDR_YEAR]);
-
-  return HT1382_OK;
-}
 
+  if (Result == 0)
+  {
+    Handler->Status.Flags   = Flags;
+    Handler->Status.Seconds = Buffer[HT1382_REG_ADDR_SECONDS];
+    Handler->Status.ST1     = Buffer[HT1382_REG_ADDR_ST1];
+    Handler->Status.ST2     = Buffer[HT1382_REG_ADDR_ST2];
+    Handler->Status.INT     = Buffer[HT1382_REG_ADDR_INT];
+  }
+
+  HT1382_Unlock(Handler);
+
+  if (Result < 0)
+    return HT1382_FAIL;
+
+  if (Status)
+    *Status = Handler->Status;
+
+  return HT1382_OK;
+}
+
+
+/**
+ * @brief  Low-duty background health check
+ * @note   Call it often (e.g. from the main loop). A probe is issued only if
+ *         Handler->HealthPeriod ms have passed since the last one, so the bus
+ *         cost is one 10-byte read per period. Set the period with
+ *         HT1382_SetHealthPeriod.
+ * @param  Handler: Pointer to handler
+ * @param  Tick: Current time in ms (free running, may wrap)
+ * @param  Status: Pointer to status, receives the latest probe result
+ *                 (can be NULL)
+ * @param  Options: HT1382_PROBE_READ_ONLY or HT1382_PROBE_xxx flags ORed
+ * @retval HT1382_Result_t
+ *         - HT1382_OK: Operation was successful or no probe was due.
+ *         - HT1382_FAIL: Failed to send or receive data.
+ */
+HT1382_Result_t
+HT1382_HealthCheck(HT1382_Handler_t *Handler, uint32_t Tick,
+                   HT1382_Status_t *Status, uint8_t Options)
+{
+  if (Handler->HealthPeriod &&
+      (!Handler->HealthProbed || Tick - Handler->HealthLastTick >= Handler->HealthPeriod))
+  {
+    Handler->HealthLastTick = Tick;
+    Handler->HealthProbed = 1;
+    if (HT1382_Probe(Handler, NULL, Options) != HT1382_OK)
+      return HT1382_FAIL;
+  }
+
+  if (Status)
+    *Status = Handler->Status;
+
+  return HT1382_OK;
+}
+
+
+/**
+ * @brief  Set the bus budget of HT1382_HealthCheck
+ * @param  Handler: Pointer to handler
+ * @param  Period: Minimum time between two probes in ms, 0: disabled
+ * @retval None
+ */
+void
+HT1382_SetHealthPeriod(HT1382_Handler_t *Handler, uint32_t Period)
+{
+  Handler->HealthPeriod = Period;
+  Handler->HealthProbed = 0;
+}
+#endif
+
+
+
+#if HT1382_CONFIG_BUS_PROBE
+/**
+ * @brief  Find the fastest bus clock with reliable read-back
+ * @note   The registers that never change by themselves (INT to USR4 on
+ *         HT1382) are read at Rates[0] as reference.
+ *         Then each rate is set with Platform.SetRate and the same registers
+ *         are read HT1382_BUS_PROBE_READS times and compared. The probe stops
+ *         at the first rate that fails and the bus is left at the fastest
+ *         rate that passed.
+ * @note   Nothing is written to the chip.
+ * @param  Handler: Pointer to handler
+ * @param  Rates: Bus clocks in Hz in ascending order. Rates[0] must be a rate
+ *                known to work (e.g. 100000).
+ * @param  Count: Number of rates
+ * @param  Rate: Pointer to selected rate (can be NULL)
+ * @retval HT1382_Result_t
+ *         - HT1382_OK: Operation was successful.
+ *         - HT1382_FAIL: Failed to send or receive data at Rates[0].
+ *         - HT1382_INVALID_PARAM: Platform.SetRate is not linked or Count is 0.
+ */
+HT1382_Result_t
+HT1382_ProbeBusSpeed(HT1382_Handler_t *Handler, const uint32_t *Rates,
+                     uint8_t Count, uint32_t *Rate)
+{
+  // registers that do not change by themselves
+  uint8_t Reference[HT1382_CHIP_STATIC_COUNT] = {0};
+  uint8_t Buffer[HT1382_CHIP_STATIC_COUNT] = {0};
+  uint8_t Good = 0;
+  uint8_t i = 0;
+  uint8_t j = 0;
+  int8_t Result = 0;
+
+#if HT1382_CONFIG_VALIDATION
+  if (!Handler->Platform.SetRate || !Count)
+    return HT1382_INVALID_PARAM;
+#endif
+
+  if (HT1382_Lock(Handler) < 0)
+    return HT1382_FAIL;
+
+  Result = Handler->Platform.SetRate(Rates[0]);
+  if (Result == 0)
+    Result = HT1382_ReadRegs(Handler, HT1382_CHIP_REG_STATIC, Reference, sizeof(Reference));
+
+  for (i = 1; Result == 0 && i < Count; i++)
+  {
+    if (Handler->Platform.SetRate(Rates[i]) < 0)
+      break;
+
+    for (j = 0; j < HT1382_BUS_PROBE_READS; j++)
+    {
+      memset(Buffer, 0, sizeof(Buffer));
+      if (HT1382_ReadRegs(Handler, HT1382_CHIP_REG_STATIC, Buffer, sizeof(Buffer)) < 0 ||
+          memcmp(Buffer, Reference, sizeof(Buffer)) != 0)
+        break;
+    }
+    if (j < HT1382_BUS_PROBE_READS)
+      break;
+
+    Good = i;
+  }
+
+  // settle on the fastest rate that passed
+  if (Result == 0 && Good != Count - 1)
+    Result = Handler->Platform.SetRate(Rates[Good]);
+
+  HT1382_Unlock(Handler);
+
+  if (Result < 0)
+    return HT1382_FAIL;
+
+  if (Rate)
+    *Rate = Rates[Good];
+
+  return HT1382_OK;
+}
+#endif
+
+
+
+/**
+ ==================================================================================
+                         ##### Public RTC Functions #####                          
+ ==================================================================================
+ */
+
+/**
+ * @brief  Set date and time on HT1382 real time chip
+ * @param  Handler: Pointer to handler
+ * @param  DateTime: pointer to date and time value structure
+ * @retval HT1382_Result_t
+ *         - HT1382_OK: Operation was successful.
+ *         - HT1382_FAIL: Failed to send or receive data.
+ *         - HT1382_INVALID_PARAM: One of parameters is invalid.
+ */
+HT1382_Result_t
+HT1382_SetDateTime(HT1382_Handler_t *Handler, HT1382_DateTime_t *DateTime)
+{
+  uint8_t Frame[1 + 7] = {0}; // register pointer + time registers
+  int8_t Result = 0;
+
+  if (HT1382_EncodeTime(DateTime, Frame) < 0)
+    return HT1382_INVALID_PARAM;
+
+  if (HT1382_Lock(Handler) < 0)
+    return HT1382_FAIL;
+
+#if HT1382_SINGLE_FLIGHT
+  Handler->ReadValid = 0;
+#endif
+  Result = HT1382_WriteRegsUnprotected(Handler, HT1382_REG_ADDR_SECONDS, Frame, 7);
+
+  HT1382_Unlock(Handler);
+
+  if (Result < 0)
+    return HT1382_FAIL;
+
+  return HT1382_OK;
+}
+
+
+/**
+ * @brief  Get date and time from HT1382 real time chip
+ * @note   With a valid mirror (HT1382_CONFIG_MIRROR) the time is decoded from
+ *         RAM without locking or bus traffic.
+ * @param  Handler: Pointer to handler
+ * @param  DateTime: pointer to date and time value structure
+ * @retval HT1382_Result_t
+ *         - HT1382_OK: Operation was successful.
+ *         - HT1382_FAIL: Failed to send or receive data.
+ */
+HT1382_Result_t
+HT1382_GetDateTime(HT1382_Handler_t *Handler, HT1382_DateTime_t *DateTime)
+{
+  uint8_t Buffer[7] = {0};
+  int8_t Result = 0;
+#if HT1382_SINGLE_FLIGHT
+  uint8_t ReadSeq = Handler->ReadSeq;
+#endif
+
+#if HT1382_CONFIG_MIRROR
+  if (Handler->Mirror && HT1382_MirrorRead(Handler->Mirror, Buffer) == 0)
+  {
+    HT1382_DecodeTime(Buffer, DateTime);
+    return HT1382_OK;
+  }
+#endif
+
+  if (HT1382_Lock(Handler) < 0)
+    return HT1382_FAIL;
+
+#if HT1382_SINGLE_FLIGHT
+  // another caller completed a read while we were waiting for the lock
+  if (Handler->ReadValid && ReadSeq != Handler->ReadSeq)
+  {
+    memcpy(Buffer, Handler->ReadCache, sizeof(Buffer));
+  }
+  else
+  {
+    Result = HT1382_ReadTime(Handler, Buffer);
+    if (Result == 0)
+    {
+      memcpy(Handler->ReadCache, Buffer, sizeof(Buffer));
+      Handler->ReadValid = 1;
+      Handler->ReadSeq++;
+    }
+  }
+#else
+  Result = HT1382_ReadTime(Handler, Buffer);
+#endif
 
+  HT1382_Unlock(Handler);
+
+  if (Result < 0)
+    return HT1382_FAIL;
 
+  HT1382_DecodeTime(Buffer, DateTime);
+
+  return HT1382_OK;
+}
+
+
+#if HT1382_CONFIG_ARMED
+/**
+ ==================================================================================
+                    ##### Public Armed Time Write Functions #####                  
+ ==================================================================================
+ */
+
+/**
+ * @brief  Prepare a time write to be sent later by HT1382_FireDateTime
+ * @param  Handler: Pointer to handler
+ * @param  DateTime: Time the chip must hold at the moment of the fire
+ * @retval HT1382_Result_t
+ *         - HT1382_OK: Operation was successful.
+ *         - HT1382_FAIL: Failed to send or receive data.
+ *         - HT1382_INVALID_PARAM: One of parameters is invalid.
+ */
+HT1382_Result_t
+HT1382_ArmDateTime(HT1382_Handler_t *Handler, const HT1382_DateTime_t *DateTime)
+{
+  uint8_t Frame[1 + 7] = {0};
+  int8_t Result = 0;
+
+  if (HT1382_EncodeTime(DateTime, Frame) < 0)
+    return HT1382_INVALID_PARAM;
+  Frame[0] = HT1382_REG_ADDR_SECONDS;
+
+  if (HT1382_Lock(Handler) < 0)
+    return HT1382_FAIL;
+
+  // the frame is complete before Armed tells the ISR to use it
+  Handler->Armed = 0;
+  memcpy(Handler->ArmedFrame, Frame, sizeof(Frame));
+  Result = HT1382_WriteProtection(Handler, 0);
+  if (Result == 0)
+    Handler->Armed = 1;
+
+  HT1382_Unlock(Handler);
+
+  if (Result < 0)
+    return HT1382_FAIL;
+
+  return HT1382_OK;
+}
+
+
+/**
+ * @brief  Send the time prepared by HT1382_ArmDateTime
+ * @note   Platform.Lock is not called, so it can run from an ISR. It fails
+ *         without a transfer if it interrupts another driver call.
+ * @param  Handler: Pointer to handler
+ * @retval HT1382_Result_t
+ *         - HT1382_OK: Operation was successful.
+ *         - HT1382_FAIL: Failed to send or receive data, or the bus is in use.
+ *         - HT1382_INVALID_PARAM: The handler is not armed.
+ */
+HT1382_Result_t
+HT1382_FireDateTime(HT1382_Handler_t *Handler)
+{
+  int8_t Result = 0;
+
+  if (!Handler->Armed)
+    return HT1382_INVALID_PARAM;
+
+  // interrupted a driver call: the handler stays armed for the next edge
+  if (Handler->Busy)
+    return HT1382_FAIL;
+
+  // the only transfer between the edge and the time registers
+  Result = Handler->Platform.Send(HT1382_ADDRESS, Handler->ArmedFrame,
+                                  sizeof(Handler->ArmedFrame));
+
+#if HT1382_SINGLE_FLIGHT
+  Handler->ReadValid = 0;
+#endif
+  Handler->Armed = 0;
+
+  if (HT1382_WriteProtection(Handler, 1) < 0 || Result < 0)
+    return HT1382_FAIL;
+
+  return HT1382_OK;
+}
+
+
+/**
+ * @brief  Cancel a time write prepared by HT1382_ArmDateTime
+ * @param  Handler: Pointer to handler
+ * @retval HT1382_Result_t
+ *         - HT1382_OK: Operation was successful.
+ *         - HT1382_FAIL: Failed to send or receive data.
+ */
+HT1382_Result_t
+HT1382_DisarmDateTime(HT1382_Handler_t *Handler)
+{
+  int8_t Result = 0;
+
+  if (HT1382_Lock(Handler) < 0)
+    return HT1382_FAIL;
+
+  if (Handler->Armed)
+  {
+    Handler->Armed = 0;
+    Result = HT1382_WriteProtection(Handler, 1);
+  }
+
+  HT1382_Unlock(Handler);
+
+  if (Result < 0)
+    return HT1382_FAIL;
+
+  return HT1382_OK;
+}
+#endif
+
+
+
+#if HT1382_CONFIG_OUTWAVE
 /**
  ==================================================================================
                      ##### Public Out Wave Functions #####                         
@@ -380,28 +994,551 @@ HT1382_GetDateTime(HT1382_Handler_t *Handler, HT1382_DateTime_t *DateTime)
 HT1382_Result_t
 HT1382_SetOutWave(HT1382_Handler_t *Handler, HT1382_OutWave_t OutWave)
 {
-  uint8_t RegBuffer = 0;
+  int8_t Result = 0;
 
-  if (OutWave > HT1382_OUTWAVE_1_32HZ)
+#if HT1382_CONFIG_VALIDATION
+  if (!HT1382_CHIP_OUTWAVE_VALID(OutWave))
     return HT1382_INVALID_PARAM;
+#endif
 
-  if (HT1382_ReadRegs(Handler, HT1382_REG_ADDR_INT, &RegBuffer, 1) < 0)
+  if (HT1382_Lock(Handler) < 0)
     return HT1382_FAIL;
 
-  RegBuffer &= ~(0x0F << HT1382_INT_FO0);
-  RegBuffer |= ((OutWave & 0x0F) << HT1382_INT_FO0);
+  Result = HT1382_WriteControl(Handler, HT1382_CHIP_REG_OUTWAVE,
+                               HT1382_CHIP_OUTWAVE_MASK,
+                               HT1382_CHIP_OUTWAVE_BITS(OutWave));
 
-  if (HT1382_WriteProtection(Handler, 0) < 0)
+  HT1382_Unlock(Handler);
+
+  if (Result < 0)
     return HT1382_FAIL;
-  
-  if (HT1382_WriteRegs(Handler, HT1382_REG_ADDR_INT, &RegBuffer, 1) < 0)
+
+  return HT1382_OK; 
+}
+#endif
+
+
+
+#if HT1382_CONFIG_POWER
+/**
+ ==================================================================================
+                        ##### Public Power Functions #####                         
+ ==================================================================================
+ */
+
+/**
+ * @brief  Write out wave, low power, battery output and alarm interrupt
+ *         settings in one INT register write
+ * @param  Handler: Pointer to handler
+ * @param  Config: Pointer to INT configuration
+ * @retval HT1382_Result_t
+ *         - HT1382_OK: Operation was successful.
+ *         - HT1382_FAIL: Failed to send or receive data.
+ *         - HT1382_INVALID_PARAM: One of parameters is invalid.
+ */
+HT1382_Result_t
+HT1382_SetIntConfig(HT1382_Handler_t *Handler, const HT1382_IntConfig_t *Config)
+{
+  int8_t Result = 0;
+
+#if HT1382_CONFIG_VALIDATION
+  if (!HT1382_CHIP_OUTWAVE_VALID(Config->OutWave))
+    return HT1382_INVALID_PARAM;
+#endif
+
+  if (HT1382_Lock(Handler) < 0)
     return HT1382_FAIL;
 
-  if (HT1382_WriteProtection(Handler, 1) < 0)
+  Result = HT1382_WriteControl(Handler, HT1382_CHIP_REG_OUTWAVE, 0xFF,
+                               HT1382_IntEncode(Config));
+
+  HT1382_Unlock(Handler);
+
+  if (Result < 0)
     return HT1382_FAIL;
 
-  if (HT1382_ReadRegs(Handler, HT1382_REG_ADDR_INT, &RegBuffer, 1) < 0)
+  return HT1382_OK;
+}
+
+
+/**
+ * @brief  Read INT register configuration
+ * @param  Handler: Pointer to handler
+ * @param  Config: Pointer to INT configuration
+ * @retval HT1382_Result_t
+ *         - HT1382_OK: Operation was successful.
+ *         - HT1382_FAIL: Failed to send or receive data.
+ */
+HT1382_Result_t
+HT1382_GetIntConfig(HT1382_Handler_t *Handler, HT1382_IntConfig_t *Config)
+{
+  uint8_t Reg = 0;
+  int8_t Result = 0;
+
+  if (HT1382_Lock(Handler) < 0)
     return HT1382_FAIL;
 
-  return HT1382_OK; 
+  Result = HT1382_ReadRegs(Handler, HT1382_CHIP_REG_OUTWAVE, &Reg, 1);
+#if HT1382_CONFIG_SHADOW
+  if (Result == 0)
+    HT1382_ShadowLoad(Handler, HT1382_CHIP_REG_OUTWAVE, &Reg, 1);
+#endif
+
+  HT1382_Unlock(Handler);
+
+  if (Result < 0)
+    return HT1382_FAIL;
+
+  HT1382_IntDecode(Reg, Config);
+
+  return HT1382_OK;
+}
+
+
+/**
+ * @brief  Put the chip in its lowest-draw configuration before the MCU sleeps
+ * @note   Reads INT once, saves it in Saved and, if anything changes, writes
+ *         the low power configuration with one INT write: LPM set, OEOBM
+ *         cleared, wave disabled and alarm interrupt disabled unless kept by
+ *         Options.
+ * @param  Handler: Pointer to handler
+ * @param  Saved: Pointer to configuration to restore with HT1382_ExitLowPower
+ * @param  Options: HT1382_POWER_LOWEST or HT1382_POWER_KEEP_xxx flags ORed
+ * @retval HT1382_Result_t
+ *         - HT1382_OK: Operation was successful.
+ *         - HT1382_FAIL: Failed to send or receive data.
+ */
+HT1382_Result_t
+HT1382_EnterLowPower(HT1382_Handler_t *Handler, HT1382_IntConfig_t *Saved,
+                     uint8_t Options)
+{
+  HT1382_IntConfig_t Config;
+  uint8_t Reg = 0;
+  uint8_t Value = 0;
+  int8_t Result = 0;
+
+  if (HT1382_Lock(Handler) < 0)
+    return HT1382_FAIL;
+
+  Result = HT1382_ReadControl(Handler, HT1382_CHIP_REG_OUTWAVE, &Reg);
+  if (Result == 0)
+  {
+    HT1382_IntDecode(Reg, Saved);
+
+    Config = *Saved;
+    Config.LowPower = 1;
+    Config.OutputOnBattery = 0;
+    if (!(Options & HT1382_POWER_KEEP_WAVE))
+      Config.OutWave = HT1382_OUTWAVE_DISABLE;
+    if (!(Options & HT1382_POWER_KEEP_ALARM))
+    {
+      Config.AlarmEnable = 0;
+      Config.InterruptMode = 0;
+    }
+
+    Value = HT1382_IntEncode(&Config);
+    if (Value != Reg)
+      Result = HT1382_WriteControl(Handler, HT1382_CHIP_REG_OUTWAVE, 0xFF, Value);
+  }
+
+  HT1382_Unlock(Handler);
+
+  if (Result < 0)
+    return HT1382_FAIL;
+
+  return HT1382_OK;
+}
+
+
+/**
+ * @brief  Restore the configuration saved by HT1382_EnterLowPower
+ * @note   Same as HT1382_SetIntConfig: one INT write, no read.
+ * @param  Handler: Pointer to handler
+ * @param  Saved: Pointer to configuration saved by HT1382_EnterLowPower
+ * @retval HT1382_Result_t
+ *         - HT1382_OK: Operation was successful.
+ *         - HT1382_FAIL: Failed to send or receive data.
+ *         - HT1382_INVALID_PARAM: One of parameters is invalid.
+ */
+HT1382_Result_t
+HT1382_ExitLowPower(HT1382_Handler_t *Handler, const HT1382_IntConfig_t *Saved)
+{
+  return HT1382_SetIntConfig(Handler, Saved);
+}
+#endif
+
+
+
+#if HT1382_CONFIG_IMAGE
+/**
+ ==================================================================================
+                   ##### Public Register Image Functions #####                     
+ ==================================================================================
+ */
+
+/**
+ * @brief  Read all registers of HT1382 in one burst
+ * @param  Handler: Pointer to handler
+ * @param  Image: Pointer to register image
+ * @retval HT1382_Result_t
+ *         - HT1382_OK: Operation was successful.
+ *         - HT1382_FAIL: Failed to send or receive data.
+ */
+HT1382_Result_t
+HT1382_ReadImage(HT1382_Handler_t *Handler, HT1382_Image_t *Image)
+{
+  int8_t Result = 0;
+
+  if (HT1382_Lock(Handler) < 0)
+    return HT1382_FAIL;
+
+  Result = HT1382_ReadRegs(Handler, HT1382_REG_ADDR_SECONDS,
+                           Image->Regs, HT1382_IMAGE_SIZE);
+#if HT1382_CONFIG_SHADOW
+  if (Result == 0)
+  {
+    HT1382_ShadowLoad(Handler, HT1382_REG_ADDR_SECONDS, Image->Regs, HT1382_IMAGE_SIZE);
+    Handler->ShadowValid = 1;
+  }
+#endif
+
+  HT1382_Unlock(Handler);
+
+  if (Result < 0)
+    return HT1382_FAIL;
+
+  return HT1382_OK;
+}
+
+
+/**
+ * @brief  Write a register image to HT1382 in one write-protection bracket
+ * @note   The WP bit of ST1 is managed by the library: write protection is
+ *         always enabled again after the write, whatever Image holds.
+ * @note   If Cached is not NULL, only the registers that differ from it are
+ *         written (nearby changes are merged into one burst) and Cached is
+ *         updated on success. Cached must hold the current chip contents,
+ *         e.g. from HT1382_ReadImage or a previous HT1382_WriteImage.
+ * @param  Handler: Pointer to handler
+ * @param  Image: Pointer to register image to write
+ * @param  Cached: Pointer to image of current chip contents (can be NULL)
+ * @param  Options: HT1382_IMAGE_ALL or HT1382_IMAGE_EXCLUDE_TIME
+ * @retval HT1382_Result_t
+ *         - HT1382_OK: Operation was successful.
+ *         - HT1382_FAIL: Failed to send or receive data.
+ */
+HT1382_Result_t
+HT1382_WriteImage(HT1382_Handler_t *Handler, const HT1382_Image_t *Image,
+                  HT1382_Image_t *Cached, uint8_t Options)
+{
+  uint8_t Buffer[HT1382_IMAGE_SIZE + 1];
+  uint8_t Reg = 0;
+  uint8_t Start = 0;
+  uint8_t End = 0;
+  uint8_t Saved = 0;
+  uint8_t Unlocked = 0;
+  int8_t Result = 0;
+
+  // Buffer[n+1] holds register n; ST1 is written as 0 (WP stays disabled)
+  memcpy(Buffer + 1, Image->Regs, HT1382_IMAGE_SIZE);
+#if HT1382_CHIP_HAS_WP
+  Buffer[1 + HT1382_REG_ADDR_ST1] = 0;
+#endif
+
+  Reg = (Options & HT1382_IMAGE_EXCLUDE_TIME) ? HT1382_REG_ADDR_YEAR + 1 : HT1382_REG_ADDR_SECONDS;
+
+  if (HT1382_Lock(Handler) < 0)
+    return HT1382_FAIL;
+
+#if HT1382_SINGLE_FLIGHT
+  if (!(Options & HT1382_IMAGE_EXCLUDE_TIME))
+    Handler->ReadValid = 0;
+#endif
+
+#if HT1382_CONFIG_SHADOW
+  // reloaded on next use
+  Handler->ShadowValid = 0;
+#endif
+
+  while (Result == 0)
+  {
+    // skip registers that need no write
+    while (Reg < HT1382_IMAGE_SIZE &&
+           (HT1382_IS_WP_REG(Reg) ||
+            (Cached && Image->Regs[Reg] == Cached->Regs[Reg])))
+      Reg++;
+    if (Reg >= HT1382_IMAGE_SIZE)
+      break;
+
+    // extend the span over changed registers at most HT1382_IMAGE_MERGE_GAP apart
+    Start = Reg;
+    End = Reg;
+    for (Reg = Start + 1;
+         Reg < HT1382_IMAGE_SIZE && Reg - End - 1 <= HT1382_IMAGE_MERGE_GAP;
+         Reg++)
+    {
+      if (!HT1382_IS_WP_REG(Reg) &&
+          (!Cached || Image->Regs[Reg] != Cached->Regs[Reg]))
+        End = Reg;
+    }
+    Reg = End + 1;
+
+    if (!Unlocked)
+    {
+      Result = HT1382_WriteProtection(Handler, 0);
+      Unlocked = 1;
+      if (Result < 0)
+        break;
+    }
+
+    // the byte before the span carries the register pointer
+    Saved = Buffer[Start];
+    Buffer[Start] = Start;
+    if (Handler->Platform.Send(HT1382_ADDRESS, &Buffer[Start], End - Start + 2) < 0)
+      Result = -1;
+    Buffer[Start] = Saved;
+  }
+
+  if (Result == 0 && Unlocked)
+    Result = HT1382_WriteProtection(Handler, 1);
+
+  HT1382_Unlock(Handler);
+
+  if (Result < 0)
+    return HT1382_FAIL;
+
+  if (Cached)
+    memcpy(Cached->Regs, Image->Regs, HT1382_IMAGE_SIZE);
+
+  return HT1382_OK;
+}
+#endif
+
+
+
+#if HT1382_CONFIG_RAW
+/**
+ ==================================================================================
+                      ##### Public Raw Write Functions #####                       
+ ==================================================================================
+ */
+
+/**
+ * @brief  Write an encoded register frame to HT1382 as it is
+ * @note   Frame[0] is the first register address and the register values
+ *         follow, as built by HT1382_TIME_IMAGE, HT1382_OUTWAVE_IMAGE and
+ *         HT1382_INT_IMAGE. The values are neither checked nor converted and
+ *         Frame is passed to Platform.Send without a copy.
+ * @note   The frame must not cover ST1: write protection is managed by the
+ *         library.
+ * @param  Handler: Pointer to handler
+ * @param  Frame: Pointer to register pointer and values
+ * @param  Len: Frame size in bytes, register pointer included (sizeof(Frame))
+ * @retval HT1382_Result_t
+ *         - HT1382_OK: Operation was successful.
+ *         - HT1382_FAIL: Failed to send or receive data.
+ *         - HT1382_INVALID_PARAM: One of parameters is invalid.
+ */
+HT1382_Result_t
+HT1382_WriteRaw(HT1382_Handler_t *Handler, const uint8_t *Frame, uint8_t Len)
+{
+  int8_t Result = 0;
+
+#if HT1382_CONFIG_VALIDATION
+  if (Len < 2 || Frame[0] + Len - 1 > HT1382_CHIP_REG_COUNT)
+    return HT1382_INVALID_PARAM;
+#if HT1382_CHIP_HAS_WP
+  if (Frame[0] <= HT1382_REG_ADDR_ST1 && Frame[0] + Len - 1 > HT1382_REG_ADDR_ST1)
+    return HT1382_INVALID_PARAM;
+#endif
+#endif
+
+  if (HT1382_Lock(Handler) < 0)
+    return HT1382_FAIL;
+
+#if HT1382_SINGLE_FLIGHT
+  if (Frame[0] <= HT1382_REG_ADDR_YEAR)
+    Handler->ReadValid = 0;
+#endif
+
+  // Platform.Send does not write to the data
+  if (HT1382_WriteProtection(Handler, 0) < 0 ||
+      Handler->Platform.Send(HT1382_ADDRESS, (uint8_t *)Frame, Len) < 0 ||
+      HT1382_WriteProtection(Handler, 1) < 0)
+    Result = -1;
+
+#if HT1382_CONFIG_SHADOW
+  if (Result == 0)
+    HT1382_ShadowLoad(Handler, Frame[0], Frame + 1, Len - 1);
+  else
+    Handler->ShadowValid = 0;
+#endif
+
+  HT1382_Unlock(Handler);
+
+  if (Result < 0)
+    return HT1382_FAIL;
+
+  return HT1382_OK;
 }
+#endif
+
+
+
+#if HT1382_CONFIG_QUERY
+/**
+ ==================================================================================
+                        ##### Public Query Functions #####                        
+ ==================================================================================
+ */
+
+/**
+ * @brief  Clear a query
+ * @param  Query: Pointer to query
+ * @retval None
+ */
+void
+HT1382_Query_Init(HT1382_Query_t *Query)
+{
+  memset(Query, 0, sizeof(*Query));
+}
+
+
+/**
+ * @brief  Add registers to a query
+ * @param  Query: Pointer to query
+ * @param  Regs: Registers to read (HT1382_QUERY_xxx masks ORed)
+ * @retval None
+ */
+void
+HT1382_Query_Add(HT1382_Query_t *Query, HT1382_QueryMask_t Regs)
+{
+  Query->Mask |= Regs;
+  Query->SpanCount = 0;
+}
+
+
+/**
+ * @brief  Compute the bus reads of a query
+ * @param  Query: Pointer to query
+ * @param  MaxGap: Largest number of unrequested registers read over
+ * @retval Number of bus reads of the plan
+ */
+uint8_t
+HT1382_Query_Plan(HT1382_Query_t *Query, uint8_t MaxGap)
+{
+  HT1382_QueryMask_t Mask = Query->Mask;
+  uint8_t Reg = 0;
+  uint8_t Start = 0;
+  uint8_t End = 0;
+
+  Query->SpanCount = 0;
+  while (Query->SpanCount < HT1382_QUERY_SPANS_MAX)
+  {
+    while (Reg < HT1382_CHIP_REG_COUNT && !((Mask >> Reg) & 1))
+      Reg++;
+    if (Reg >= HT1382_CHIP_REG_COUNT)
+      break;
+
+    // extend the span over requested registers at most MaxGap apart
+    Start = Reg;
+    End = Reg;
+    for (Reg = Start + 1;
+         Reg < HT1382_CHIP_REG_COUNT && Reg - End - 1 <= MaxGap;
+         Reg++)
+    {
+      if ((Mask >> Reg) & 1)
+        End = Reg;
+    }
+    Reg = End + 1;
+
+    Query->SpanFirst[Query->SpanCount] = Start;
+    Query->SpanLen[Query->SpanCount] = End - Start + 1;
+    Query->SpanCount++;
+  }
+
+  return Query->SpanCount;
+}
+
+
+/**
+ * @brief  Read the registers of a query
+ * @param  Handler: Pointer to handler
+ * @param  Query: Pointer to query
+ * @retval HT1382_Result_t
+ *         - HT1382_OK: Operation was successful.
+ *         - HT1382_FAIL: Failed to send or receive data.
+ */
+HT1382_Result_t
+HT1382_ReadQuery(HT1382_Handler_t *Handler, HT1382_Query_t *Query)
+{
+  uint8_t *Data = NULL;
+  uint8_t i = 0;
+  int8_t Result = 0;
+
+  if (!Query->SpanCount)
+    HT1382_Query_Plan(Query, HT1382_QUERY_MERGE_GAP);
+
+  if (HT1382_Lock(Handler) < 0)
+    return HT1382_FAIL;
+
+  for (i = 0; Result == 0 && i < Query->SpanCount; i++)
+  {
+    Data = &Query->Regs[Query->SpanFirst[i]];
+    Result = HT1382_ReadRegs(Handler, Query->SpanFirst[i], Data, Query->SpanLen[i]);
+#if HT1382_CONFIG_SHADOW
+    if (Result == 0)
+      HT1382_ShadowLoad(Handler, Query->SpanFirst[i], Data, Query->SpanLen[i]);
+#endif
+  }
+
+  HT1382_Unlock(Handler);
+
+  if (Result < 0)
+    return HT1382_FAIL;
+
+  return HT1382_OK;
+}
+
+
+/**
+ * @brief  Decode the time from a query read by HT1382_ReadQuery
+ * @param  Query: Pointer to query
+ * @param  DateTime: pointer to date and time value structure
+ * @retval HT1382_Result_t
+ *         - HT1382_OK: Operation was successful.
+ *         - HT1382_INVALID_PARAM: HT1382_QUERY_TIME is not in the query.
+ */
+HT1382_Result_t
+HT1382_Query_GetDateTime(const HT1382_Query_t *Query, HT1382_DateTime_t *DateTime)
+{
+  if ((Query->Mask & HT1382_QUERY_TIME) != HT1382_QUERY_TIME)
+    return HT1382_INVALID_PARAM;
+
+  HT1382_DecodeTime(&Query->Regs[HT1382_REG_ADDR_SECONDS], DateTime);
+
+  return HT1382_OK;
+}
+
+
+#if HT1382_CONFIG_POWER
+/**
+ * @brief  Decode the INT configuration from a query read by HT1382_ReadQuery
+ * @param  Query: Pointer to query
+ * @param  Config: Pointer to INT configuration
+ * @retval HT1382_Result_t
+ *         - HT1382_OK: Operation was successful.
+ *         - HT1382_INVALID_PARAM: The INT register is not in the query.
+ */
+HT1382_Result_t
+HT1382_Query_GetIntConfig(const HT1382_Query_t *Query, HT1382_IntConfig_t *Config)
+{
+  if (!((Query->Mask >> HT1382_REG_ADDR_INT) & 1))
+    return HT1382_INVALID_PARAM;
+
+  HT1382_IntDecode(Query->Regs[HT1382_REG_ADDR_INT], Config);
+
+  return HT1382_OK;
+}
+#endif
+#endif
@@ -0,0 +1,330 @@
+/**
+ **********************************************************************************
+ * @file   HT1382_cal.c
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  HT1382 MCU clock calibration module
+ *         Functionalities of the this file:
+ *          + Trim the MCU RC oscillator (OSCCAL on AVR) against SQW/OUT
+ *          + Full search and temperature tracking modes
+ **********************************************************************************
+ *
+ * Copyright (c) 2024 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+
+/* Includes ---------------------------------------------------------------------*/
+#include "HT1382_cal.h"
+
+
+/* Check Configuration ----------------------------------------------------------*/
+#if !HT1382_CONFIG_OUTWAVE || !HT1382_CONFIG_QUERY || !HT1382_CONFIG_RAW
+#error "HT1382_cal.c requires HT1382_CONFIG_OUTWAVE, HT1382_CONFIG_QUERY and HT1382_CONFIG_RAW"
+#endif
+
+
+/* Private Typedef --------------------------------------------------------------*/
+/**
+ * @brief  State of one HT1382_Cal_Run
+ * @note   Errors are in ticks over Periods periods: >0 means the MCU is fast.
+ */
+typedef struct HT1382_CalRun_s
+{
+  uint32_t  Target;       // tick count of the nominal clock
+  int32_t   BestError;
+} HT1382_CalRun_t;
+
+
+
+/**
+ ==================================================================================
+                           ##### Private Functions #####                           
+ ==================================================================================
+ */
+
+static int32_t
+HT1382_Cal_Abs(int32_t Value)
+{
+  return Value < 0 ? -Value : Value;
+}
+
+/**
+ * @brief  Apply a trim, measure it and keep it in Cal->Trim if it is the best
+ *         so far
+ */
+static int8_t
+HT1382_Cal_Try(HT1382_Cal_t *Cal, HT1382_CalRun_t *Run, uint8_t Trim, int32_t *Error)
+{
+  int32_t Ticks = 0;
+
+  Cal->SetTrim(Trim);
+  Ticks = Cal->Measure(Cal->Periods);
+  if (Cal->Measurements < UINT8_MAX)
+    Cal->Measurements++;
+  if (Ticks <= 0)
+    return -1;
+
+  *Error = Ticks - (int32_t)Run->Target;
+  if (HT1382_Cal_Abs(*Error) < HT1382_Cal_Abs(Run->BestError))
+  {
+    Run->BestError = *Error;
+    Cal->Trim = Trim;
+  }
+
+  return 0;
+}
+
+/**
+ * @brief  Find the lowest trim in Lo..Hi that is not slow, then keep the
+ *         better of it and the trim below (both are measured on the way)
+ */
+static int8_t
+HT1382_Cal_Search(HT1382_Cal_t *Cal, HT1382_CalRun_t *Run, uint8_t Lo, uint8_t Hi)
+{
+  uint8_t Mid = 0;
+  uint8_t HiMeasured = 0;
+  int32_t Error = 0;
+
+  while (Lo < Hi)
+  {
+    Mid = Lo + (Hi - Lo) / 2;
+    if (HT1382_Cal_Try(Cal, Run, Mid, &Error) < 0)
+      return -1;
+
+    if (Error < 0)
+    {
+      Lo = Mid + 1;
+    }
+    else
+    {
+      Hi = Mid;
+      HiMeasured = 1;
+    }
+  }
+
+  // every trim was slow, the top one is not measured yet
+  if (!HiMeasured)
+    return HT1382_Cal_Try(Cal, Run, Lo, &Error);
+
+  return 0;
+}
+
+/**
+ * @brief  Secant steps from the current trim until two neighbouring trims
+ *         bracket the target
+ * @note   The first step is one trim towards the target; after that the
+ *         error slope of the last two trims predicts the jump, so a few
+ *         percent of temperature drift takes about 4 measurements where a
+ *         search takes 8 or 9.
+ */
+static int8_t
+HT1382_Cal_Track(HT1382_Cal_t *Cal, HT1382_CalRun_t *Run)
+{
+  int16_t Lo = (int16_t)Cal->TrimMin - 1; // highest trim known to be slow
+  int16_t Hi = (int16_t)Cal->TrimMax + 1; // lowest trim known to be fast
+  int16_t Trim = Cal->GetTrim();
+  int16_t Next = 0;
+  int16_t PrevTrim = 0;
+  int32_t PrevError = 0;
+  int32_t Error = 0;
+  int32_t Num = 0;
+  int32_t Den = 0;
+  uint8_t Step = 0;
+
+  if (Trim < Cal->TrimMin)
+    Trim = Cal->TrimMin;
+  if (Trim > Cal->TrimMax)
+    Trim = Cal->TrimMax;
+
+  for (Step = 0; Step < HT1382_CAL_TRACK_STEPS; Step++)
+  {
+    if (HT1382_Cal_Try(Cal, Run, (uint8_t)Trim, &Error) < 0)
+      return -1;
+    if (Error == 0)
+      return 0;
+
+    if (Error < 0)
+      Lo = Trim;
+    else
+      Hi = Trim;
+    if (Hi - Lo <= 1)
+      return 0; // bracketed, or the edge of the range is the best there is
+
+    Next = Trim + (Error < 0 ? 1 : -1);
+    if (Step > 0)
+    {
+      // Next = Trim - Error / Slope, rounded
+      Num = -Error * (Trim - PrevTrim);
+      Den = Error - PrevError;
+      if (Den < 0)
+      {
+        Num = -Num;
+        Den = -Den;
+      }
+      if (Den > 0 && (Num < 0) == (Error > 0))
+        Next = Trim + (int16_t)((Num + (Num < 0 ? -Den : Den) / 2) / Den);
+    }
+    if (Next <= Lo)
+      Next = Lo + 1;
+    if (Next >= Hi)
+      Next = Hi - 1;
+
+    PrevTrim = Trim;
+    PrevError = Error;
+    Trim = Next;
+  }
+
+  // no bracket yet: search what is left
+  return HT1382_Cal_Search(Cal, Run, (uint8_t)(Lo + 1),
+                           (uint8_t)(Hi > Cal->TrimMax ? Cal->TrimMax : Hi));
+}
+
+
+
+/**
+ ==================================================================================
+                        ##### Public Calibration Functions #####                  
+ ==================================================================================
+ */
+
+/**
+ * @brief  Initialize calibration with default settings
+ * @note   Selects the 4096 Hz wave, 32 periods (7.8 ms per measurement) and
+ *         the full 0-255 trim range. Change the fields before HT1382_Cal_Run
+ *         if needed.
+ * @param  Cal: Pointer to calibration
+ * @param  Handler: Pointer to an initialized HT1382 handler
+ * @param  Measure: Tick counter over reference periods
+ * @param  GetTrim: Trim read function
+ * @param  SetTrim: Trim write function
+ * @param  TickFreq: Measure tick frequency at the nominal clock (Hz)
+ * @retval HT1382_Result_t
+ *         - HT1382_OK: Operation was successful.
+ *         - HT1382_INVALID_PARAM: One of parameters is invalid.
+ */
+HT1382_Result_t
+HT1382_Cal_Init(HT1382_Cal_t *Cal, HT1382_Handler_t *Handler,
+                HT1382_CalMeasure_t Measure, HT1382_CalGetTrim_t GetTrim,
+                HT1382_CalSetTrim_t SetTrim, uint32_t TickFreq)
+{
+  if (!Handler || !Measure || !GetTrim || !SetTrim || !TickFreq)
+    return HT1382_INVALID_PARAM;
+
+  Cal->Handler = Handler;
+  Cal->Measure = Measure;
+  Cal->GetTrim = GetTrim;
+  Cal->SetTrim = SetTrim;
+  Cal->TickFreq = TickFreq;
+  Cal->OutWave = HT1382_OUTWAVE_4096HZ;
+  Cal->Periods = 32;
+  Cal->TrimMin = 0;
+  Cal->TrimMax = UINT8_MAX;
+  Cal->Trim = 0;
+  Cal->ErrorPpm = 0;
+  Cal->Measurements = 0;
+
+  return HT1382_OK;
+}
+
+
+/**
+ * @brief  Trim the MCU oscillator to the RTC
+ * @note   The out wave register is restored before returning, also on
+ *         failure. If the reference can not be measured, the trim is restored
+ *         too.
+ * @note   Anything timed by the MCU clock (UART, delays) is off while the
+ *         trim is being searched.
+ * @param  Cal: Pointer to calibration
+ * @param  Mode: HT1382_CAL_SEARCH or HT1382_CAL_TRACK
+ * @retval HT1382_Result_t
+ *         - HT1382_OK: Operation was successful.
+ *         - HT1382_FAIL: Failed to send or receive data, or no reference
+ *                        edges.
+ *         - HT1382_INVALID_PARAM: One of parameters is invalid.
+ */
+HT1382_Result_t
+HT1382_Cal_Run(HT1382_Cal_t *Cal, uint8_t Mode)
+{
+  HT1382_CalRun_t Run = {0};
+  HT1382_Query_t Query;
+  uint8_t Saved[2] = {HT1382_CHIP_REG_OUTWAVE, 0};
+  uint16_t WaveFreq = HT1382_Cal_WaveFreq(Cal->OutWave);
+  uint8_t Trim = 0;
+  int8_t Result = 0;
+
+  if (!WaveFreq || !HT1382_CHIP_OUTWAVE_VALID(Cal->OutWave) || !Cal->Periods || Cal->TrimMin > Cal->TrimMax ||
+      Cal->Periods > UINT32_MAX / Cal->TickFreq)
+    return HT1382_INVALID_PARAM;
+
+  Run.Target = (Cal->TickFreq * Cal->Periods + WaveFreq / 2) / WaveFreq;
+  Run.BestError = INT32_MAX;
+
+  // keep the whole register: other bits share it (alarm and power bits on HT1382)
+  HT1382_Query_Init(&Query);
+  HT1382_Query_Add(&Query, HT1382_QUERY_REGS(HT1382_CHIP_REG_OUTWAVE, 1));
+  if (HT1382_ReadQuery(Cal->Handler, &Query) != HT1382_OK)
+    return HT1382_FAIL;
+  Saved[1] = Query.Regs[HT1382_CHIP_REG_OUTWAVE];
+
+  if (HT1382_SetOutWave(Cal->Handler, Cal->OutWave) != HT1382_OK)
+    return HT1382_FAIL;
+
+  Trim = Cal->GetTrim();
+  Cal->Trim = Trim;
+  Cal->Measurements = 0;
+
+  if (Mode == HT1382_CAL_TRACK)
+    Result = HT1382_Cal_Track(Cal, &Run);
+  else
+    Result = HT1382_Cal_Search(Cal, &Run, Cal->TrimMin, Cal->TrimMax);
+
+  if (Result < 0)
+    Cal->Trim = Trim;
+  Cal->SetTrim(Cal->Trim);
+
+  if (HT1382_WriteRaw(Cal->Handler, Saved, sizeof(Saved)) != HT1382_OK)
+    Result = -1;
+
+  if (Result < 0)
+    return HT1382_FAIL;
+
+  Cal->ErrorPpm = (int32_t)(((int64_t)Run.BestError * 1000000) / (int32_t)Run.Target);
+
+  return HT1382_OK;
+}
+
+
+/**
+ * @brief  Frequency of a reference wave
+ * @param  OutWave: HT1382_OUTWAVE_1024HZ or HT1382_OUTWAVE_4096HZ
+ * @retval Frequency in Hz, 0 for other waves
+ */
+uint16_t
+HT1382_Cal_WaveFreq(HT1382_OutWave_t OutWave)
+{
+  if (OutWave == HT1382_OUTWAVE_1024HZ)
+    return 1024;
+  if (OutWave == HT1382_OUTWAVE_4096HZ)
+    return 4096;
+
+  return 0;
+}
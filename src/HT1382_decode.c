@@ -0,0 +1,447 @@
+/**
+ **********************************************************************************
+ * @file   HT1382_decode.c
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  Bulk decode of raw HT1382 time registers (host side)
+ **********************************************************************************
+ *
+ * Copyright (c) 2024 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+
+/* Includes ---------------------------------------------------------------------*/
+#include "HT1382_decode.h"
+#include "HT1382_time.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HT1382_DECODE_X86   1
+#include <immintrin.h>
+#else
+#define HT1382_DECODE_X86   0
+#endif
+
+
+/* Private Constants ------------------------------------------------------------*/
+/**
+ * @brief  Days from 1970-01-01 to 2000-01-01 (HT1382 year 0)
+ */
+#define HT1382_DECODE_DAYS_TO_2000    10957UL
+
+#define HT1382_DECODE_SECONDS_PER_DAY 86400UL
+
+/**
+ * @brief  Hours register bits of a 12-hour mode record
+ */
+#define HT1382_DECODE_HOURS_12H_BITS  ((1 << HT1382_HOURS_12_24) | \
+                                       (1 << HT1382_HOURS_AM_PM) | 0x1F)
+
+
+/* Private Macro ----------------------------------------------------------------*/
+/**
+ * @brief  Set the entry of register REG in both records of a 16-byte pattern
+ */
+#define HT1382_DECODE_AT(REG, VALUE)  [(REG)] = (VALUE), [(REG) + 7] = (VALUE)
+
+
+/* Private Typedef --------------------------------------------------------------*/
+typedef size_t (*HT1382_DecodeBulk_t)(const uint8_t *Records, size_t Count,
+                                      uint32_t *Epochs);
+
+
+/* Private Variables ------------------------------------------------------------*/
+/**
+ * @brief  Per register patterns of two packed records (bytes 14-15 always pass)
+ * @note   NotAllowed: bits that must be zero in 24-hour records
+ *         ValueMask: bits that hold the BCD value
+ *         Min/Max: value range
+ *         Mode/Mode24: a record is in 24-hour mode if (Reg & Mode) == Mode24
+ */
+static const uint8_t HT1382_Decode_NotAllowed[16] =
+{
+  HT1382_DECODE_AT(HT1382_REG_ADDR_SECONDS, 0x00),
+  HT1382_DECODE_AT(HT1382_REG_ADDR_MINUTES, 0x80),
+  HT1382_DECODE_AT(HT1382_REG_ADDR_HOURS,   (uint8_t)~(0x3F | (1 << HT1382_HOURS_12_24))),
+  HT1382_DECODE_AT(HT1382_REG_ADDR_DAY,     0xF8),
+  HT1382_DECODE_AT(HT1382_REG_ADDR_DATE,    0xC0),
+  HT1382_DECODE_AT(HT1382_REG_ADDR_MONTH,   0xE0),
+  HT1382_DECODE_AT(HT1382_REG_ADDR_YEAR,    0x00),
+};
+
+static const uint8_t HT1382_Decode_ValueMask[16] =
+{
+  HT1382_DECODE_AT(HT1382_REG_ADDR_SECONDS, 0x7F),
+  HT1382_DECODE_AT(HT1382_REG_ADDR_MINUTES, 0x7F),
+  HT1382_DECODE_AT(HT1382_REG_ADDR_HOURS,   0x3F),
+  HT1382_DECODE_AT(HT1382_REG_ADDR_DAY,     0x07),
+  HT1382_DECODE_AT(HT1382_REG_ADDR_DATE,    0x3F),
+  HT1382_DECODE_AT(HT1382_REG_ADDR_MONTH,   0x1F),
+  HT1382_DECODE_AT(HT1382_REG_ADDR_YEAR,    0xFF),
+};
+
+static const uint8_t HT1382_Decode_Min[16] =
+{
+  HT1382_DECODE_AT(HT1382_REG_ADDR_SECONDS, 0),
+  HT1382_DECODE_AT(HT1382_REG_ADDR_MINUTES, 0),
+  HT1382_DECODE_AT(HT1382_REG_ADDR_HOURS,   0),
+  HT1382_DECODE_AT(HT1382_REG_ADDR_DAY,     1),
+  HT1382_DECODE_AT(HT1382_REG_ADDR_DATE,    1),
+  HT1382_DECODE_AT(HT1382_REG_ADDR_MONTH,   1),
+  HT1382_DECODE_AT(HT1382_REG_ADDR_YEAR,    0),
+};
+
+static const uint8_t HT1382_Decode_Max[16] =
+{
+  HT1382_DECODE_AT(HT1382_REG_ADDR_SECONDS, 59),
+  HT1382_DECODE_AT(HT1382_REG_ADDR_MINUTES, 59),
+  HT1382_DECODE_AT(HT1382_REG_ADDR_HOURS,   23),
+  HT1382_DECODE_AT(HT1382_REG_ADDR_DAY,     7),
+  HT1382_DECODE_AT(HT1382_REG_ADDR_DATE,    31),
+  HT1382_DECODE_AT(HT1382_REG_ADDR_MONTH,   12),
+  HT1382_DECODE_AT(HT1382_REG_ADDR_YEAR,    99),
+  [14] = 0xFF, [15] = 0xFF,
+};
+
+static const uint8_t HT1382_Decode_Mode[16] =
+{
+  HT1382_DECODE_AT(HT1382_REG_ADDR_HOURS,   (1 << HT1382_HOURS_12_24)),
+};
+
+static const uint8_t HT1382_Decode_Mode24[16] =
+{
+  HT1382_DECODE_AT(HT1382_REG_ADDR_HOURS,   HT1382_CHIP_HOURS_24H),
+};
+
+static const uint8_t HT1382_Decode_MonthDays[13] =
+{
+  0, 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31
+};
+
+static HT1382_DecodeBulk_t HT1382_Decode_Func = NULL;
+
+
+
+/**
+ ==================================================================================
+                           ##### Private Functions #####                           
+ ==================================================================================
+ */
+
+/**
+ * @brief  Unix time of binary register values, HT1382_DECODE_INVALID if the
+ *         day does not exist in the month
+ * @note   Bin[n] holds register n as a binary value (ranges already checked).
+ */
+static inline uint32_t
+HT1382_Decode_Epoch(const uint8_t *Bin)
+{
+  uint8_t Year  = Bin[HT1382_REG_ADDR_YEAR];
+  uint8_t Month = Bin[HT1382_REG_ADDR_MONTH];
+  uint8_t Date  = Bin[HT1382_REG_ADDR_DATE];
+  uint8_t Leap  = !(Year & 0x03); // 2000 is a leap year, 2100 is out of range
+  uint32_t Days = 0;
+
+  if (Date > HT1382_Decode_MonthDays[Month] + (Leap && Month == 2))
+    return HT1382_DECODE_INVALID;
+
+  Days = HT1382_DECODE_DAYS_TO_2000 + 365UL * Year + (Year + 3) / 4 +
+         HT1382_READ_WORD(&HT1382_Time_DaysBeforeMonth[Month - 1]) +
+         (Leap && Month > 2) + Date - 1;
+
+  return Days * HT1382_DECODE_SECONDS_PER_DAY +
+         Bin[HT1382_REG_ADDR_HOURS] * 3600UL +
+         Bin[HT1382_REG_ADDR_MINUTES] * 60U +
+         Bin[HT1382_REG_ADDR_SECONDS];
+}
+
+/**
+ * @brief  BCD to binary with digit and range check, 0xFF if invalid
+ */
+static inline uint8_t
+HT1382_Decode_BCD(uint8_t Value, uint8_t Min, uint8_t Max)
+{
+  uint8_t Bin = Value - 6 * (Value >> 4);
+
+  if ((Value & 0x0F) > 9 || (Value >> 4) > 9 || Bin < Min || Bin > Max)
+    return 0xFF;
+
+  return Bin;
+}
+
+static uint32_t
+HT1382_Decode_One(const uint8_t *Record)
+{
+  uint8_t Bin[HT1382_DECODE_RECORD_SIZE];
+  uint8_t Hours = Record[HT1382_REG_ADDR_HOURS];
+  uint8_t i = 0;
+
+  for (i = 0; i < HT1382_DECODE_RECORD_SIZE; i++)
+  {
+    if (i == HT1382_REG_ADDR_HOURS)
+      continue;
+    if (Record[i] & HT1382_Decode_NotAllowed[i])
+      return HT1382_DECODE_INVALID;
+    Bin[i] = HT1382_Decode_BCD(Record[i] & HT1382_Decode_ValueMask[i],
+                               HT1382_Decode_Min[i], HT1382_Decode_Max[i]);
+    if (Bin[i] == 0xFF)
+      return HT1382_DECODE_INVALID;
+  }
+
+  if (HT1382_CHIP_HOURS_IS_12H(Hours))
+  {
+    if (Hours & ~HT1382_DECODE_HOURS_12H_BITS)
+      return HT1382_DECODE_INVALID;
+    if (HT1382_Decode_BCD(Hours & 0x1F, 1, 12) == 0xFF)
+      return HT1382_DECODE_INVALID;
+    Bin[HT1382_REG_ADDR_HOURS] = HT1382_CHIP_HOURS_TO_DEC(Hours);
+  }
+  else
+  {
+    if (Hours & HT1382_Decode_NotAllowed[HT1382_REG_ADDR_HOURS])
+      return HT1382_DECODE_INVALID;
+    Bin[HT1382_REG_ADDR_HOURS] = HT1382_Decode_BCD(Hours & 0x3F, 0, 23);
+    if (Bin[HT1382_REG_ADDR_HOURS] == 0xFF)
+      return HT1382_DECODE_INVALID;
+  }
+
+  return HT1382_Decode_Epoch(Bin);
+}
+
+static size_t
+HT1382_Decode_BulkScalar(const uint8_t *Records, size_t Count, uint32_t *Epochs)
+{
+  size_t Invalid = 0;
+  size_t i = 0;
+
+  for (i = 0; i < Count; i++, Records += HT1382_DECODE_RECORD_SIZE)
+  {
+    Epochs[i] = HT1382_Decode_One(Records);
+    Invalid += (Epochs[i] == HT1382_DECODE_INVALID);
+  }
+
+  return Invalid;
+}
+
+
+#if HT1382_DECODE_X86
+/**
+ * @brief  Decode the records of one 16-byte lane after the vector check
+ * @note   Good has one bit per byte of the lane. Records that failed the
+ *         vector check (invalid or 12-hour mode) go through the scalar code.
+ */
+static inline size_t
+HT1382_Decode_Lane(const uint8_t *Records, const uint8_t *Bin,
+                   uint32_t Good, uint32_t *Epochs)
+{
+  size_t Invalid = 0;
+  uint8_t j = 0;
+
+  for (j = 0; j < 2; j++)
+  {
+    if (((Good >> (7 * j)) & 0x7F) == 0x7F)
+      Epochs[j] = HT1382_Decode_Epoch(Bin + 7 * j);
+    else
+      Epochs[j] = HT1382_Decode_One(Records + 7 * j);
+    Invalid += (Epochs[j] == HT1382_DECODE_INVALID);
+  }
+
+  return Invalid;
+}
+
+__attribute__((target("sse2")))
+static size_t
+HT1382_Decode_BulkSse2(const uint8_t *Records, size_t Count, uint32_t *Epochs)
+{
+  const __m128i NotAllowed = _mm_loadu_si128((const __m128i *)HT1382_Decode_NotAllowed);
+  const __m128i ValueMask  = _mm_loadu_si128((const __m128i *)HT1382_Decode_ValueMask);
+  const __m128i Min        = _mm_loadu_si128((const __m128i *)HT1382_Decode_Min);
+  const __m128i Max        = _mm_loadu_si128((const __m128i *)HT1382_Decode_Max);
+  const __m128i Mode       = _mm_loadu_si128((const __m128i *)HT1382_Decode_Mode);
+  const __m128i Mode24     = _mm_loadu_si128((const __m128i *)HT1382_Decode_Mode24);
+  const __m128i Low        = _mm_set1_epi8(0x0F);
+  const __m128i Nine       = _mm_set1_epi8(9);
+  const __m128i Zero       = _mm_setzero_si128();
+  __m128i Raw, Value, Hi, Lo, Bin, Ok;
+  uint8_t Out[16];
+  size_t Invalid = 0;
+  size_t i = 0;
+
+  // a 16-byte load covers two records and 2 bytes of the next one
+  for (i = 0; i + 3 <= Count; i += 2)
+  {
+    Raw   = _mm_loadu_si128((const __m128i *)(Records + i * HT1382_DECODE_RECORD_SIZE));
+    Value = _mm_and_si128(Raw, ValueMask);
+    Hi    = _mm_and_si128(_mm_srli_epi16(Value, 4), Low);
+    Lo    = _mm_and_si128(Value, Low);
+    Bin   = _mm_add_epi8(Hi, Hi);                                   // 2 * Hi
+    Bin   = _mm_sub_epi8(Value, _mm_add_epi8(Bin, _mm_add_epi8(Bin, Bin))); // Value - 6 * Hi
+
+    Ok = _mm_cmpeq_epi8(_mm_and_si128(Raw, NotAllowed), Zero);
+    Ok = _mm_and_si128(Ok, _mm_cmpeq_epi8(_mm_max_epu8(Lo, Nine), Nine));
+    Ok = _mm_and_si128(Ok, _mm_cmpeq_epi8(_mm_max_epu8(Hi, Nine), Nine));
+    Ok = _mm_and_si128(Ok, _mm_cmpeq_epi8(_mm_max_epu8(Bin, Max), Max));
+    Ok = _mm_and_si128(Ok, _mm_cmpeq_epi8(_mm_min_epu8(Bin, Min), Min));
+    Ok = _mm_and_si128(Ok, _mm_cmpeq_epi8(_mm_and_si128(Raw, Mode), Mode24));
+
+    _mm_storeu_si128((__m128i *)Out, Bin);
+    Invalid += HT1382_Decode_Lane(Records + i * HT1382_DECODE_RECORD_SIZE, Out,
+                                  (uint32_t)_mm_movemask_epi8(Ok), Epochs + i);
+  }
+
+  return Invalid + HT1382_Decode_BulkScalar(Records + i * HT1382_DECODE_RECORD_SIZE,
+                                            Count - i, Epochs + i);
+}
+
+__attribute__((target("avx2")))
+static size_t
+HT1382_Decode_BulkAvx2(const uint8_t *Records, size_t Count, uint32_t *Epochs)
+{
+  const __m256i NotAllowed = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)HT1382_Decode_NotAllowed));
+  const __m256i ValueMask  = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)HT1382_Decode_ValueMask));
+  const __m256i Min        = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)HT1382_Decode_Min));
+  const __m256i Max        = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)HT1382_Decode_Max));
+  const __m256i Mode       = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)HT1382_Decode_Mode));
+  const __m256i Mode24     = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)HT1382_Decode_Mode24));
+  const __m256i Low        = _mm256_set1_epi8(0x0F);
+  const __m256i Nine       = _mm256_set1_epi8(9);
+  const __m256i Zero       = _mm256_setzero_si256();
+  const uint8_t *Block = NULL;
+  __m256i Raw, Value, Hi, Lo, Bin, Ok;
+  uint8_t Out[32];
+  uint32_t Good = 0;
+  size_t Invalid = 0;
+  size_t i = 0;
+
+  // each 128-bit lane holds two records, the second load ends 2 bytes past
+  // the fourth record
+  for (i = 0; i + 5 <= Count; i += 4)
+  {
+    Block = Records + i * HT1382_DECODE_RECORD_SIZE;
+    Raw   = _mm256_inserti128_si256(
+              _mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)Block)),
+              _mm_loadu_si128((const __m128i *)(Block + 2 * HT1382_DECODE_RECORD_SIZE)), 1);
+    Value = _mm256_and_si256(Raw, ValueMask);
+    Hi    = _mm256_and_si256(_mm256_srli_epi16(Value, 4), Low);
+    Lo    = _mm256_and_si256(Value, Low);
+    Bin   = _mm256_add_epi8(Hi, Hi);
+    Bin   = _mm256_sub_epi8(Value, _mm256_add_epi8(Bin, _mm256_add_epi8(Bin, Bin)));
+
+    Ok = _mm256_cmpeq_epi8(_mm256_and_si256(Raw, NotAllowed), Zero);
+    Ok = _mm256_and_si256(Ok, _mm256_cmpeq_epi8(_mm256_max_epu8(Lo, Nine), Nine));
+    Ok = _mm256_and_si256(Ok, _mm256_cmpeq_epi8(_mm256_max_epu8(Hi, Nine), Nine));
+    Ok = _mm256_and_si256(Ok, _mm256_cmpeq_epi8(_mm256_max_epu8(Bin, Max), Max));
+    Ok = _mm256_and_si256(Ok, _mm256_cmpeq_epi8(_mm256_min_epu8(Bin, Min), Min));
+    Ok = _mm256_and_si256(Ok, _mm256_cmpeq_epi8(_mm256_and_si256(Raw, Mode), Mode24));
+
+    _mm256_storeu_si256((__m256i *)Out, Bin);
+    Good = (uint32_t)_mm256_movemask_epi8(Ok);
+    Invalid += HT1382_Decode_Lane(Block, Out, Good, Epochs + i);
+    Invalid += HT1382_Decode_Lane(Block + 2 * HT1382_DECODE_RECORD_SIZE, Out + 16,
+                                  Good >> 16, Epochs + i + 2);
+  }
+
+  return Invalid + HT1382_Decode_BulkSse2(Records + i * HT1382_DECODE_RECORD_SIZE,
+                                          Count - i, Epochs + i);
+}
+#endif
+
+
+
+/**
+ ==================================================================================
+                        ##### Public Decode Functions #####                        
+ ==================================================================================
+ */
+
+/**
+ * @brief  Decode one raw record to Unix time
+ * @note   12-hour records are accepted (12 AM is 00:00, 12 PM is 12:00). The CH
+ *         bit of the seconds register is ignored.
+ * @param  Record: Pointer to HT1382_DECODE_RECORD_SIZE bytes
+ * @param  Epoch: Pointer to Unix time, HT1382_DECODE_INVALID if invalid
+ * @retval HT1382_Result_t
+ *         - HT1382_OK: Operation was successful.
+ *         - HT1382_INVALID_PARAM: The record is not a valid date and time.
+ */
+HT1382_Result_t
+HT1382_Decode_Record(const uint8_t *Record, uint32_t *Epoch)
+{
+  *Epoch = HT1382_Decode_One(Record);
+
+  if (*Epoch == HT1382_DECODE_INVALID)
+    return HT1382_INVALID_PARAM;
+
+  return HT1382_OK;
+}
+
+
+/**
+ * @brief  Decode an array of raw records to Unix time
+ * @note   Records in 12-hour mode are valid but are decoded by the scalar code.
+ * @param  Records: Pointer to Count * HT1382_DECODE_RECORD_SIZE bytes
+ * @param  Count: Number of records
+ * @param  Epochs: Pointer to Count Unix times, HT1382_DECODE_INVALID for
+ *                 records that are not valid
+ * @retval Number of invalid records
+ */
+size_t
+HT1382_Decode_Bulk(const uint8_t *Records, size_t Count, uint32_t *Epochs)
+{
+  if (!HT1382_Decode_Func)
+    HT1382_Decode_SetImpl(HT1382_DECODE_AUTO);
+
+  return HT1382_Decode_Func(Records, Count, Epochs);
+}
+
+
+/**
+ * @brief  Select the implementation used by HT1382_Decode_Bulk
+ * @param  Impl: Implementation, HT1382_DECODE_AUTO for runtime detection
+ * @retval The selected implementation. It differs from Impl if Impl is not
+ *         supported by the CPU or the build (then the fastest supported one is
+ *         used).
+ */
+HT1382_DecodeImpl_t
+HT1382_Decode_SetImpl(HT1382_DecodeImpl_t Impl)
+{
+#if HT1382_DECODE_X86
+  __builtin_cpu_init();
+
+  if ((Impl == HT1382_DECODE_AUTO || Impl == HT1382_DECODE_AVX2) &&
+      __builtin_cpu_supports("avx2"))
+  {
+    HT1382_Decode_Func = HT1382_Decode_BulkAvx2;
+    return HT1382_DECODE_AVX2;
+  }
+
+  if (Impl != HT1382_DECODE_SCALAR && __builtin_cpu_supports("sse2"))
+  {
+    HT1382_Decode_Func = HT1382_Decode_BulkSse2;
+    return HT1382_DECODE_SSE2;
+  }
+#else
+  (void)Impl;
+#endif
+
+  HT1382_Decode_Func = HT1382_Decode_BulkScalar;
+  return HT1382_DECODE_SCALAR;
+}
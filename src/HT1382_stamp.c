@@ -0,0 +1,265 @@
+/**
+ **********************************************************************************
+ * @file   HT1382_stamp.c
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  HT1382 timestamp stream codec for event logs
+ **********************************************************************************
+ *
+ * Copyright (c) 2024 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+
+
+
+/* Includes ---------------------------------------------------------------------*/
+#include <string.h>
+#include "HT1382_stamp.h"
+#include "HT1382_time.h"
+
+
+/* Private Constants ------------------------------------------------------------*/
+/**
+ * @brief  ZigZag deltas from this value on are sent as keyframes (a 4-byte
+ *         varint carries 28 bits, one of them is the delta/keyframe bit)
+ */
+#define HT1382_STAMP_ZIGZAG_LIMIT     (1UL << 27)
+
+
+
+/**
+ ==================================================================================
+                           ##### Private Functions #####                           
+ ==================================================================================
+ */
+
+static uint8_t
+HT1382_Stamp_BCDtoDEC(uint8_t BCD)
+{
+  return (BCD >> 4) * 10 + (BCD & 0x0F);
+}
+
+/**
+ * @brief  Unix time of second 0 of the minute in the time registers
+ */
+static uint32_t
+HT1382_Stamp_MinuteEpoch(const uint8_t *Regs)
+{
+  HT1382_DateTime_t DateTime = {0};
+
+  DateTime.Minute = HT1382_Stamp_BCDtoDEC(Regs[HT1382_REG_ADDR_MINUTES] & 0x7F);
+  DateTime.Hour   = HT1382_CHIP_HOURS_TO_DEC(Regs[HT1382_REG_ADDR_HOURS]);
+  DateTime.Day    = HT1382_Stamp_BCDtoDEC(Regs[HT1382_REG_ADDR_DATE] & 0x3F);
+  DateTime.Month  = HT1382_Stamp_BCDtoDEC(Regs[HT1382_REG_ADDR_MONTH] & 0x1F);
+  DateTime.Year   = HT1382_Stamp_BCDtoDEC(Regs[HT1382_REG_ADDR_YEAR]);
+
+  return HT1382_Time_ToEpoch(&DateTime);
+}
+
+
+
+/**
+ ==================================================================================
+                        ##### Public Encoder Functions #####                       
+ ==================================================================================
+ */
+
+/**
+ * @brief  Initialize stamp encoder
+ * @note   The first stamp is a keyframe.
+ * @param  Enc: Pointer to encoder
+ * @param  Interval: Stamps per keyframe (0: only the first stamp and stamps
+ *                   after HT1382_StampEnc_Key)
+ * @retval None
+ */
+void
+HT1382_StampEnc_Init(HT1382_StampEnc_t *Enc, uint16_t Interval)
+{
+  memset(Enc, 0, sizeof(HT1382_StampEnc_t));
+  Enc->Interval = Interval;
+  Enc->KeyPending = 1;
+}
+
+
+/**
+ * @brief  Make the next stamp a keyframe (e.g. at the start of a flash page)
+ * @param  Enc: Pointer to encoder
+ * @retval None
+ */
+void
+HT1382_StampEnc_Key(HT1382_StampEnc_t *Enc)
+{
+  Enc->KeyPending = 1;
+}
+
+
+/**
+ * @brief  Encode a stamp from Unix time
+ * @param  Enc: Pointer to encoder
+ * @param  Epoch: Unix time
+ * @param  Out: Output, at least HT1382_STAMP_RECORD_MAX bytes
+ * @retval Number of bytes written to Out
+ */
+uint8_t
+HT1382_StampEnc_Put(HT1382_StampEnc_t *Enc, uint32_t Epoch, uint8_t *Out)
+{
+  uint32_t Delta = Epoch - Enc->Epoch;
+  uint32_t ZigZag = 0;
+  uint8_t Len = 0;
+
+  // ZigZag(d) = 2d for d >= 0, -2d - 1 for d < 0
+  ZigZag = (Delta & 0x80000000UL) ? ~(Delta << 1) : (Delta << 1);
+  Enc->Epoch = Epoch;
+
+  if (Enc->KeyPending || ZigZag >= HT1382_STAMP_ZIGZAG_LIMIT ||
+      (Enc->Interval && Enc->Count >= Enc->Interval))
+  {
+    Enc->KeyPending = 0;
+    Enc->Count = 1;
+    Out[0] = HT1382_STAMP_KEY_TAG;
+    Out[1] = (uint8_t)Epoch;
+    Out[2] = (uint8_t)(Epoch >> 8);
+    Out[3] = (uint8_t)(Epoch >> 16);
+    Out[4] = (uint8_t)(Epoch >> 24);
+    return HT1382_STAMP_KEY_SIZE;
+  }
+
+  Enc->Count++;
+
+  // bit 0 of the first byte is 0 for deltas
+  if (ZigZag < 64)
+  {
+    Out[0] = (uint8_t)(ZigZag << 1);
+    return 1;
+  }
+
+  ZigZag <<= 1;
+  while (ZigZag >= 0x80)
+  {
+    Out[Len++] = (uint8_t)ZigZag | 0x80;
+    ZigZag >>= 7;
+  }
+  Out[Len++] = (uint8_t)ZigZag;
+
+  return Len;
+}
+
+
+/**
+ * @brief  Encode a stamp from the raw time registers
+ * @note   Only the seconds register is decoded while registers 1..6 are the
+ *         same as in the last call, i.e. at most once per minute the date is
+ *         converted. The registers are not validated.
+ * @param  Enc: Pointer to encoder
+ * @param  Regs: The 7 time registers, Regs[n] holds register n (e.g. the
+ *               Regs of an HT1382_Image_t or a time query)
+ * @param  Out: Output, at least HT1382_STAMP_RECORD_MAX bytes
+ * @retval Number of bytes written to Out
+ */
+uint8_t
+HT1382_StampEnc_PutRegs(HT1382_StampEnc_t *Enc, const uint8_t *Regs, uint8_t *Out)
+{
+  uint8_t Second = HT1382_Stamp_BCDtoDEC(Regs[HT1382_REG_ADDR_SECONDS] & 0x7F);
+
+  if (!Enc->MinuteValid ||
+      memcmp(Enc->MinuteRegs, &Regs[1], sizeof(Enc->MinuteRegs)) != 0)
+  {
+    memcpy(Enc->MinuteRegs, &Regs[1], sizeof(Enc->MinuteRegs));
+    Enc->MinuteEpoch = HT1382_Stamp_MinuteEpoch(Regs);
+    Enc->MinuteValid = 1;
+  }
+
+  return HT1382_StampEnc_Put(Enc, Enc->MinuteEpoch + Second, Out);
+}
+
+
+
+/**
+ ==================================================================================
+                        ##### Public Decoder Functions #####                       
+ ==================================================================================
+ */
+
+/**
+ * @brief  Initialize stamp decoder
+ * @note   Decoding must start at a keyframe.
+ * @param  Dec: Pointer to decoder
+ * @retval None
+ */
+void
+HT1382_StampDec_Init(HT1382_StampDec_t *Dec)
+{
+  Dec->Synced = 0;
+  Dec->Epoch = 0;
+}
+
+
+/**
+ * @brief  Decode one stamp
+ * @param  Dec: Pointer to decoder
+ * @param  Data: Pointer to the stamp record
+ * @param  Len: Number of bytes available at Data
+ * @param  Epoch: Pointer to Unix time of the stamp
+ * @retval Number of bytes of the stamp record, 0 if it is truncated, reserved
+ *         or a delta before the first keyframe
+ */
+uint8_t
+HT1382_StampDec_Get(HT1382_StampDec_t *Dec, const uint8_t *Data, uint16_t Len,
+                    uint32_t *Epoch)
+{
+  uint32_t ZigZag = 0;
+  uint8_t Shift = 0;
+  uint8_t i = 0;
+
+  if (!Len)
+    return 0;
+
+  if (Data[0] & 0x01)
+  {
+    if (Data[0] != HT1382_STAMP_KEY_TAG || Len < HT1382_STAMP_KEY_SIZE)
+      return 0;
+
+    Dec->Epoch = (uint32_t)Data[1] | ((uint32_t)Data[2] << 8) |
+                 ((uint32_t)Data[3] << 16) | ((uint32_t)Data[4] << 24);
+    Dec->Synced = 1;
+    *Epoch = Dec->Epoch;
+    return HT1382_STAMP_KEY_SIZE;
+  }
+
+  if (!Dec->Synced)
+    return 0;
+
+  // varint of at most 4 bytes
+  do
+  {
+    if (i == Len || i == 4)
+      return 0;
+    ZigZag |= (uint32_t)(Data[i] & 0x7F) << Shift;
+    Shift += 7;
+  } while (Data[i++] & 0x80);
+
+  ZigZag >>= 1;
+  Dec->Epoch += (ZigZag & 1) ? ~(ZigZag >> 1) : (ZigZag >> 1);
+  *Epoch = Dec->Epoch;
+
+  return i;
+}
@@ -0,0 +1,400 @@
+/**
+ **********************************************************************************
+ * @file   HT1382_time.c
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  HT1382 system time module
+ **********************************************************************************
+ *
+ * Copyright (c) 2024 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+
+/* Includes ---------------------------------------------------------------------*/
+#include "HT1382_time.h"
+#if HT1382_TIME_NEWLIB
+#include <sys/time.h>
+#endif
+#if HT1382_TIME_AVRLIBC
+#include <time.h>
+#endif
+
+
+/* Private Constants ------------------------------------------------------------*/
+#define HT1382_TIME_SECONDS_PER_DAY   86400UL
+
+
+/* Exported Variables -----------------------------------------------------------*/
+const uint16_t HT1382_Time_DaysBeforeMonth[13] HT1382_CONST =
+{
+  0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334, 365
+};
+
+
+/* Private Variables ------------------------------------------------------------*/
+static HT1382_Time_t *HT1382_Time_System = NULL;
+
+
+
+/**
+ ==================================================================================
+                           ##### Private Functions #####                           
+ ==================================================================================
+ */
+
+static HT1382_Result_t
+HT1382_Time_ReadEpoch(HT1382_Time_t *Time, uint32_t *Epoch, uint8_t WaitEdge)
+{
+  HT1382_DateTime_t DateTime = {0};
+  uint8_t Second = 0;
+
+  if (HT1382_GetDateTime(Time->Handler, &DateTime) != HT1382_OK)
+    return HT1382_FAIL;
+
+  if (WaitEdge)
+  {
+    Second = DateTime.Second;
+    do
+    {
+      if (HT1382_GetDateTime(Time->Handler, &DateTime) != HT1382_OK)
+        return HT1382_FAIL;
+    } while (DateTime.Second == Second);
+  }
+
+  *Epoch = HT1382_Time_ToEpoch(&DateTime);
+  return HT1382_OK;
+}
+
+
+
+/**
+ ==================================================================================
+                       ##### Public Conversion Functions #####                     
+ ==================================================================================
+ */
+
+/**
+ * @brief  Convert date and time to Unix time
+ * @note   WeekDay is ignored.
+ * @param  DateTime: pointer to date and time value structure (Year 0 = 2000)
+ * @retval Unix time (seconds since 1970-01-01 00:00:00)
+ */
+uint32_t
+HT1382_Time_ToEpoch(const HT1382_DateTime_t *DateTime)
+{
+  uint32_t Days = 0;
+  uint8_t Month = (DateTime->Month - 1) % 12;
+
+  Days  = 365UL * DateTime->Year + (DateTime->Year + 3) / 4;
+  Days += HT1382_READ_WORD(&HT1382_Time_DaysBeforeMonth[Month]);
+  if ((DateTime->Year % 4) == 0 && Month >= 2)
+    Days++;
+  Days += DateTime->Day - 1;
+
+  return HT1382_TIME_EPOCH_2000 + Days * HT1382_TIME_SECONDS_PER_DAY +
+         DateTime->Hour * 3600UL + DateTime->Minute * 60U + DateTime->Second;
+}
+
+
+/**
+ * @brief  Convert Unix time to date and time
+ * @note   WeekDay is 1 for Sunday ... 7 for Saturday.
+ * @param  Epoch: Unix time, from 2000-01-01 to 2099-12-31
+ * @param  DateTime: pointer to date and time value structure
+ * @retval HT1382_Result_t
+ *         - HT1382_OK: Operation was successful.
+ *         - HT1382_INVALID_PARAM: Epoch is out of the RTC range.
+ */
+HT1382_Result_t
+HT1382_Time_FromEpoch(uint32_t Epoch, HT1382_DateTime_t *DateTime)
+{
+  uint32_t Seconds = 0;
+  uint16_t Days = 0;
+  uint16_t YearDays = 0;
+  uint8_t Leap = 0;
+  uint8_t Month = 0;
+
+  if (Epoch < HT1382_TIME_EPOCH_2000)
+    return HT1382_INVALID_PARAM;
+
+  Epoch -= HT1382_TIME_EPOCH_2000;
+  Days = (uint16_t)(Epoch / HT1382_TIME_SECONDS_PER_DAY);
+  Seconds = Epoch % HT1382_TIME_SECONDS_PER_DAY;
+  if (Days >= 36525)
+    return HT1382_INVALID_PARAM;
+
+  DateTime->Hour    = (uint8_t)(Seconds / 3600);
+  DateTime->Minute  = (uint8_t)((Seconds / 60) % 60);
+  DateTime->Second  = (uint8_t)(Seconds % 60);
+  DateTime->WeekDay = (uint8_t)((Days + 6) % 7) + 1; // 2000-01-01 was a Saturday
+
+  // every 4-year block of 2000-2099 starts with a leap year
+  DateTime->Year = (uint8_t)((Days / 1461) * 4);
+  Days %= 1461;
+  if (Days >= 366)
+  {
+    Days -= 366;
+    DateTime->Year += 1 + Days / 365;
+    Days %= 365;
+  }
+  else
+  {
+    Leap = 1;
+  }
+
+  for (Month = 11; Month > 0; Month--)
+  {
+    YearDays = HT1382_READ_WORD(&HT1382_Time_DaysBeforeMonth[Month]) + (Leap && Month >= 2);
+    if (Days >= YearDays)
+      break;
+  }
+  Days -= HT1382_READ_WORD(&HT1382_Time_DaysBeforeMonth[Month]) + (Leap && Month >= 2);
+
+  DateTime->Month = Month + 1;
+  DateTime->Day   = (uint8_t)Days + 1;
+
+  return HT1382_OK;
+}
+
+
+
+/**
+ ==================================================================================
+                       ##### Public Time Base Functions #####                      
+ ==================================================================================
+ */
+
+/**
+ * @brief  Initialize time base
+ * @param  Time: Pointer to time base
+ * @param  Handler: Pointer to an initialized HT1382 handler
+ * @param  GetTick: Monotonic tick source
+ * @param  TickFreq: Tick frequency (Hz)
+ * @retval HT1382_Result_t
+ *         - HT1382_OK: Operation was successful.
+ *         - HT1382_INVALID_PARAM: One of parameters is invalid.
+ */
+HT1382_Result_t
+HT1382_Time_Init(HT1382_Time_t *Time, HT1382_Handler_t *Handler,
+                 HT1382_TimeGetTick_t GetTick, uint32_t TickFreq)
+{
+  if (!Handler || !GetTick || !TickFreq)
+    return HT1382_INVALID_PARAM;
+
+  Time->Handler = Handler;
+  Time->GetTick = GetTick;
+  Time->TickFreq = TickFreq;
+  Time->ResyncPeriod = 0;
+  Time->RefEpoch = 0;
+  Time->RefTick = 0;
+  Time->SyncEpoch = 0;
+  Time->Synced = 0;
+
+  return HT1382_OK;
+}
+
+
+/**
+ * @brief  Read the RTC and rebase the time base on it
+ * @param  Time: Pointer to time base
+ * @param  WaitEdge: If not zero, poll the seconds register until it changes
+ *                   so the sub-second phase is known (takes up to 1 second).
+ * @retval HT1382_Result_t
+ *         - HT1382_OK: Operation was successful.
+ *         - HT1382_FAIL: Failed to send or receive data.
+ */
+HT1382_Result_t
+HT1382_Time_Sync(HT1382_Time_t *Time, uint8_t WaitEdge)
+{
+  uint32_t Epoch = 0;
+
+  if (HT1382_Time_ReadEpoch(Time, &Epoch, WaitEdge) != HT1382_OK)
+    return HT1382_FAIL;
+
+  Time->RefTick = Time->GetTick();
+  Time->RefEpoch = Epoch;
+  Time->SyncEpoch = Epoch;
+  Time->Synced = 1;
+
+  return HT1382_OK;
+}
+
+
+/**
+ * @brief  Get current time without touching the bus
+ * @note   Syncs first if the time base was never synced or ResyncPeriod
+ *         has passed.
+ * @param  Time: Pointer to time base
+ * @param  Seconds: Unix time
+ * @param  MicroSeconds: Sub-second part (can be NULL)
+ * @retval HT1382_Result_t
+ *         - HT1382_OK: Operation was successful.
+ *         - HT1382_FAIL: Failed to send or receive data.
+ */
+HT1382_Result_t
+HT1382_Time_Get(HT1382_Time_t *Time, uint32_t *Seconds, uint32_t *MicroSeconds)
+{
+  uint32_t Elapsed = 0;
+  uint32_t WholeSeconds = 0;
+  uint32_t Epoch = 0;
+
+  if (!Time->Synced)
+  {
+    if (HT1382_Time_Sync(Time, 0) != HT1382_OK)
+      return HT1382_FAIL;
+  }
+
+  Elapsed = Time->GetTick() - Time->RefTick;
+  if (Elapsed >= Time->TickFreq)
+  {
+    WholeSeconds = Elapsed / Time->TickFreq;
+    Time->RefEpoch += WholeSeconds;
+    Time->RefTick += WholeSeconds * Time->TickFreq;
+    Elapsed -= WholeSeconds * Time->TickFreq;
+  }
+
+  if (Time->ResyncPeriod &&
+      Time->RefEpoch - Time->SyncEpoch >= Time->ResyncPeriod)
+  {
+    if (HT1382_Time_ReadEpoch(Time, &Epoch, 0) != HT1382_OK)
+      return HT1382_FAIL;
+
+    // keep the sub-second phase unless the tick drifted a whole second
+    if (Epoch != Time->RefEpoch)
+    {
+      Time->RefEpoch = Epoch;
+      Time->RefTick = Time->GetTick();
+      Elapsed = 0;
+    }
+    Time->SyncEpoch = Epoch;
+  }
+
+  *Seconds = Time->RefEpoch;
+  if (MicroSeconds)
+    *MicroSeconds = (uint32_t)(((uint64_t)Elapsed * 1000000UL) / Time->TickFreq);
+
+  return HT1382_OK;
+}
+
+
+/**
+ * @brief  Write Unix time to the RTC and rebase the time base on it
+ * @param  Time: Pointer to time base
+ * @param  Epoch: Unix time
+ * @retval HT1382_Result_t
+ *         - HT1382_OK: Operation was successful.
+ *         - HT1382_FAIL: Failed to send or receive data.
+ *         - HT1382_INVALID_PARAM: Epoch is out of the RTC range.
+ */
+HT1382_Result_t
+HT1382_Time_Set(HT1382_Time_t *Time, uint32_t Epoch)
+{
+  HT1382_DateTime_t DateTime = {0};
+  HT1382_Result_t Result = HT1382_OK;
+
+  Result = HT1382_Time_FromEpoch(Epoch, &DateTime);
+  if (Result != HT1382_OK)
+    return Result;
+
+  Result = HT1382_SetDateTime(Time->Handler, &DateTime);
+  if (Result != HT1382_OK)
+    return Result;
+
+  Time->RefTick = Time->GetTick();
+  Time->RefEpoch = Epoch;
+  Time->SyncEpoch = Epoch;
+  Time->Synced = 1;
+
+  return HT1382_OK;
+}
+
+
+/**
+ * @brief  Select the time base used by the C library hooks
+ * @param  Time: Pointer to time base (NULL to detach)
+ * @retval None
+ */
+void
+HT1382_Time_SetSystem(HT1382_Time_t *Time)
+{
+  HT1382_Time_System = Time;
+}
+
+
+#if HT1382_TIME_AVRLIBC
+/**
+ * @brief  Load the avr-libc system time from the time base
+ * @note   avr-libc time() counts with system_tick(), which the application
+ *         calls from a 1 Hz interrupt. The SQW/OUT pin of HT1382 configured
+ *         with HT1382_OUTWAVE_1HZ can drive that interrupt, so avr-libc time
+ *         stays locked to the RTC crystal.
+ * @param  Time: Pointer to time base
+ * @retval HT1382_Result_t
+ *         - HT1382_OK: Operation was successful.
+ *         - HT1382_FAIL: Failed to send or receive data.
+ */
+HT1382_Result_t
+HT1382_Time_SyncAvrLibc(HT1382_Time_t *Time)
+{
+  uint32_t Seconds = 0;
+
+  if (HT1382_Time_Get(Time, &Seconds, NULL) != HT1382_OK)
+    return HT1382_FAIL;
+
+  set_system_time((time_t)(Seconds - UNIX_OFFSET));
+  return HT1382_OK;
+}
+#endif
+
+
+
+/**
+ ==================================================================================
+                          ##### C Library Hooks #####                             
+ ==================================================================================
+ */
+
+#if HT1382_TIME_NEWLIB
+/**
+ * @brief  newlib syscall behind time(), gettimeofday() and
+ *         clock_gettime(CLOCK_REALTIME)
+ */
+int
+_gettimeofday(struct timeval *tv, void *tz)
+{
+  uint32_t Seconds = 0;
+  uint32_t MicroSeconds = 0;
+
+  (void)tz;
+  if (!HT1382_Time_System ||
+      HT1382_Time_Get(HT1382_Time_System, &Seconds, &MicroSeconds) != HT1382_OK)
+    return -1;
+
+  if (tv)
+  {
+    tv->tv_sec = (time_t)Seconds;
+    tv->tv_usec = (suseconds_t)MicroSeconds;
+  }
+
+  return 0;
+}
+#endif
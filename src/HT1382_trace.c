@@ -0,0 +1,245 @@
+/**
+ **********************************************************************************
+ * @file   HT1382_trace.c
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  HT1382 bus transaction trace recorder
+ **********************************************************************************
+ *
+ * Copyright (c) 2024 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+
+/* Includes ---------------------------------------------------------------------*/
+#include "HT1382_trace.h"
+
+
+/* Private Variables ------------------------------------------------------------*/
+static HT1382_Trace_t *HT1382_Trace_Active = NULL;
+
+
+
+/**
+ ==================================================================================
+                           ##### Private Functions #####                           
+ ==================================================================================
+ */
+
+static uint8_t
+HT1382_Trace_ByteAt(const HT1382_Trace_t *Trace, uint16_t Offset)
+{
+  return Trace->Buffer[(uint16_t)(((uint32_t)Trace->Head + Offset) % Trace->Size)];
+}
+
+static uint16_t
+HT1382_Trace_RecordLen(const HT1382_Trace_t *Trace, uint16_t Offset)
+{
+  return HT1382_TRACE_RECORD_SIZE + HT1382_Trace_ByteAt(Trace, Offset + 6);
+}
+
+static void
+HT1382_Trace_Put(HT1382_Trace_t *Trace, uint8_t Byte)
+{
+  Trace->Buffer[(uint16_t)(((uint32_t)Trace->Head + Trace->Used) % Trace->Size)] = Byte;
+  Trace->Used++;
+}
+
+static void
+HT1382_Trace_Record(HT1382_Trace_t *Trace, uint8_t Dir, int8_t Result,
+                    uint32_t Tick, uint8_t Reg, const uint8_t *Data, uint8_t Len)
+{
+  uint16_t RecordLen = HT1382_TRACE_RECORD_SIZE + Len;
+  uint16_t Drop = 0;
+  uint8_t i = 0;
+
+  if (RecordLen > Trace->Size)
+    return;
+
+  // make room by dropping the oldest records
+  while (Trace->Size - Trace->Used < RecordLen)
+  {
+    Drop = HT1382_Trace_RecordLen(Trace, 0);
+    Trace->Head = (uint16_t)(((uint32_t)Trace->Head + Drop) % Trace->Size);
+    Trace->Used -= Drop;
+    Trace->Dropped++;
+  }
+
+  HT1382_Trace_Put(Trace, Dir | ((uint8_t)(-Result) & HT1382_TRACE_RESULT_MASK));
+  HT1382_Trace_Put(Trace, (uint8_t)Tick);
+  HT1382_Trace_Put(Trace, (uint8_t)(Tick >> 8));
+  HT1382_Trace_Put(Trace, (uint8_t)(Tick >> 16));
+  HT1382_Trace_Put(Trace, (uint8_t)(Tick >> 24));
+  HT1382_Trace_Put(Trace, Reg);
+  HT1382_Trace_Put(Trace, Len);
+  for (i = 0; i < Len; i++)
+    HT1382_Trace_Put(Trace, Data[i]);
+}
+
+static int8_t
+HT1382_Trace_Send(uint8_t Address, uint8_t *Data, uint8_t Len)
+{
+  HT1382_Trace_t *Trace = HT1382_Trace_Active;
+  uint32_t Tick = Trace->GetTick ? Trace->GetTick() : 0;
+  int8_t Result = Trace->Send(Address, Data, Len);
+
+  if (!Len)
+    return Result;
+
+  HT1382_Trace_Record(Trace, 0, Result, Tick, Data[0], Data + 1, Len - 1);
+  if (Result >= 0)
+    Trace->Pointer = Data[0] + Len - 1;
+
+  return Result;
+}
+
+static int8_t
+HT1382_Trace_Receive(uint8_t Address, uint8_t *Data, uint8_t Len)
+{
+  HT1382_Trace_t *Trace = HT1382_Trace_Active;
+  uint32_t Tick = Trace->GetTick ? Trace->GetTick() : 0;
+  int8_t Result = Trace->Receive(Address, Data, Len);
+
+  HT1382_Trace_Record(Trace, HT1382_TRACE_DIR_RECEIVE, Result, Tick,
+                      Trace->Pointer, Data, Len);
+  if (Result >= 0)
+    Trace->Pointer += Len;
+
+  return Result;
+}
+
+
+
+/**
+ ==================================================================================
+                            ##### Public Functions #####                           
+ ==================================================================================
+ */
+
+/**
+ * @brief  Start recording the bus transactions of a handler
+ * @param  Trace: Pointer to trace recorder
+ * @param  Handler: Pointer to handler (Send/Receive must be linked)
+ * @param  Buffer: Ring buffer memory
+ * @param  Size: Ring buffer size in bytes
+ * @param  GetTick: Timestamp source (can be NULL)
+ * @retval HT1382_Result_t
+ *         - HT1382_OK: Operation was successful.
+ *         - HT1382_INVALID_PARAM: One of parameters is invalid or another
+ *                                 handler is being traced.
+ */
+HT1382_Result_t
+HT1382_Trace_Start(HT1382_Trace_t *Trace, HT1382_Handler_t *Handler,
+                   uint8_t *Buffer, uint16_t Size, HT1382_TraceGetTick_t GetTick)
+{
+  if (HT1382_Trace_Active || !Buffer || !Size ||
+      !Handler->Platform.Send || !Handler->Platform.Receive)
+    return HT1382_INVALID_PARAM;
+
+  Trace->Buffer = Buffer;
+  Trace->Size = Size;
+  Trace->GetTick = GetTick;
+  Trace->Send = Handler->Platform.Send;
+  Trace->Receive = Handler->Platform.Receive;
+  Trace->Pointer = 0;
+  HT1382_Trace_Clear(Trace);
+
+  HT1382_Trace_Active = Trace;
+  HT1382_PLATFORM_LINK_SEND(Handler, HT1382_Trace_Send);
+  HT1382_PLATFORM_LINK_RECEIVE(Handler, HT1382_Trace_Receive);
+
+  return HT1382_OK;
+}
+
+
+/**
+ * @brief  Stop recording and restore the platform functions of the handler
+ * @param  Trace: Pointer to trace recorder
+ * @param  Handler: Pointer to handler
+ * @retval None
+ */
+void
+HT1382_Trace_Stop(HT1382_Trace_t *Trace, HT1382_Handler_t *Handler)
+{
+  if (HT1382_Trace_Active != Trace)
+    return;
+
+  HT1382_PLATFORM_LINK_SEND(Handler, Trace->Send);
+  HT1382_PLATFORM_LINK_RECEIVE(Handler, Trace->Receive);
+  HT1382_Trace_Active = NULL;
+}
+
+
+/**
+ * @brief  Discard all recorded transactions
+ * @param  Trace: Pointer to trace recorder
+ * @retval None
+ */
+void
+HT1382_Trace_Clear(HT1382_Trace_t *Trace)
+{
+  Trace->Head = 0;
+  Trace->Used = 0;
+  Trace->Dropped = 0;
+}
+
+
+/**
+ * @brief  Export the recorded transactions in the trace format
+ * @note   Records that do not fit in Out are left out (oldest first kept).
+ * @param  Trace: Pointer to trace recorder
+ * @param  Out: Output buffer
+ * @param  OutSize: Output buffer size (at least HT1382_TRACE_HEADER_SIZE)
+ * @retval Number of bytes written to Out
+ */
+uint16_t
+HT1382_Trace_Export(const HT1382_Trace_t *Trace, uint8_t *Out, uint16_t OutSize)
+{
+  uint16_t Offset = 0;
+  uint16_t RecordLen = 0;
+  uint16_t Written = HT1382_TRACE_HEADER_SIZE;
+  uint16_t i = 0;
+
+  if (OutSize < HT1382_TRACE_HEADER_SIZE)
+    return 0;
+
+  Out[0] = 'H';
+  Out[1] = 'T';
+  Out[2] = 'T';
+  Out[3] = 'R';
+  Out[4] = HT1382_TRACE_VERSION;
+  Out[5] = 0;
+  Out[6] = (uint8_t)Trace->Dropped;
+  Out[7] = (uint8_t)(Trace->Dropped >> 8);
+
+  while (Offset < Trace->Used)
+  {
+    RecordLen = HT1382_Trace_RecordLen(Trace, Offset);
+    if (OutSize - Written < RecordLen)
+      break;
+
+    for (i = 0; i < RecordLen; i++)
+      Out[Written++] = HT1382_Trace_ByteAt(Trace, Offset + i);
+    Offset += RecordLen;
+  }
+
+  return Written;
+}
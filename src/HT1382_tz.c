@@ -0,0 +1,240 @@
+/**
+ **********************************************************************************
+ * @file   HT1382_tz.c
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  HT1382 local time (time zone and DST) module
+ **********************************************************************************
+ *
+ * Copyright (c) 2024 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+
+
+/* Includes ---------------------------------------------------------------------*/
+#include "HT1382_tz.h"
+
+
+/* Private Constants ------------------------------------------------------------*/
+#define HT1382_TZ_SECONDS_PER_DAY     86400UL
+#define HT1382_TZ_DAYS_MAX            36524U // 2099-12-31
+
+
+
+/**
+ ==================================================================================
+                           ##### Private Functions #####                           
+ ==================================================================================
+ */
+
+/**
+ * @brief  Days from 2000-01-01 to the first day of Month (1 ... 13) of Year
+ */
+static uint16_t
+HT1382_Tz_MonthStart(uint8_t Year, uint8_t Month)
+{
+  uint16_t Days = 365U * Year + (Year + 3) / 4;
+
+  Days += HT1382_READ_WORD(&HT1382_Time_DaysBeforeMonth[Month - 1]);
+  if ((Year % 4) == 0 && Month > 2)
+    Days++;
+
+  return Days;
+}
+
+/**
+ * @brief  Seconds from 2000-01-01 00:00 UTC to the transition of Rule in Year
+ * @param  Offset: UTC offset in effect before the transition (minutes)
+ */
+static uint32_t
+HT1382_Tz_Transition(const HT1382_TzRule_t *Rule, uint8_t Year, int16_t Offset)
+{
+  uint8_t Month = HT1382_READ_BYTE(&Rule->Month);
+  uint8_t Week = HT1382_READ_BYTE(&Rule->Week);
+  uint8_t WeekDay = HT1382_READ_BYTE(&Rule->WeekDay);
+  int16_t Minute = (int16_t)HT1382_READ_WORD(&Rule->Minute);
+  uint16_t First = HT1382_Tz_MonthStart(Year, Month);
+  uint16_t Day = 0;
+
+  // 2000-01-01 was a Saturday (WeekDay 7)
+  Day = First + (uint8_t)(WeekDay + 7 - (uint8_t)((First + 6) % 7) - 1) % 7 +
+        7 * (Week - 1);
+  if (Week == 5 && Day >= HT1382_Tz_MonthStart(Year, Month + 1))
+    Day -= 7;
+
+  return Day * HT1382_TZ_SECONDS_PER_DAY + (uint32_t)((int32_t)(Minute - Offset) * 60);
+}
+
+/**
+ * @brief  Check if DST is in effect at Seconds after 2000-01-01 00:00 UTC
+ */
+static uint8_t
+HT1382_Tz_IsDstAt(const HT1382_TzZone_t *Zone, uint32_t Seconds,
+                  int16_t StdOffset, int16_t DstOffset)
+{
+  uint16_t Days = 0;
+  uint8_t Year = 0;
+  uint32_t Start = 0;
+  uint32_t End = 0;
+
+  if (StdOffset == DstOffset)
+    return 0;
+
+  if (Seconds / HT1382_TZ_SECONDS_PER_DAY > HT1382_TZ_DAYS_MAX)
+    Days = (Seconds >= 0xC0000000UL) ? 0 : HT1382_TZ_DAYS_MAX; // wrapped: before 2000
+  else
+    Days = (uint16_t)(Seconds / HT1382_TZ_SECONDS_PER_DAY);
+
+  // every 4-year block of 2000-2099 starts with a leap year
+  Year = (uint8_t)((Days / 1461) * 4);
+  Days %= 1461;
+  if (Days)
+    Year += (uint8_t)((Days - 1) / 365);
+
+  Start = HT1382_Tz_Transition(&Zone->Start, Year, StdOffset);
+  End = HT1382_Tz_Transition(&Zone->End, Year, DstOffset);
+
+  if (Start < End)
+    return (Seconds >= Start && Seconds < End);
+
+  // DST over the new year (southern hemisphere)
+  return (Seconds >= Start || Seconds < End);
+}
+
+
+
+/**
+ ==================================================================================
+                       ##### Public Conversion Functions #####                     
+ ==================================================================================
+ */
+
+/**
+ * @brief  Check if DST is in effect
+ * @param  Zone: Pointer to zone (may be in flash, see HT1382_CONST)
+ * @param  Epoch: Unix time, from 2000-01-01 to 2099-12-31
+ * @retval 1: DST, 0: standard time
+ */
+uint8_t
+HT1382_Tz_IsDst(const HT1382_TzZone_t *Zone, uint32_t Epoch)
+{
+  return HT1382_Tz_IsDstAt(Zone, Epoch - HT1382_TIME_EPOCH_2000,
+                           (int16_t)HT1382_READ_WORD(&Zone->StdOffset),
+                           (int16_t)HT1382_READ_WORD(&Zone->DstOffset));
+}
+
+
+/**
+ * @brief  Convert Unix time to local epoch
+ * @param  Zone: Pointer to zone (may be in flash, see HT1382_CONST)
+ * @param  Epoch: Unix time, from 2000-01-01 to 2099-12-31
+ * @param  IsDst: Pointer to DST flag (can be NULL)
+ * @retval Local epoch
+ */
+uint32_t
+HT1382_Tz_ToLocal(const HT1382_TzZone_t *Zone, uint32_t Epoch, uint8_t *IsDst)
+{
+  int16_t StdOffset = (int16_t)HT1382_READ_WORD(&Zone->StdOffset);
+  int16_t DstOffset = (int16_t)HT1382_READ_WORD(&Zone->DstOffset);
+  uint8_t Dst = 0;
+
+  Dst = HT1382_Tz_IsDstAt(Zone, Epoch - HT1382_TIME_EPOCH_2000, StdOffset, DstOffset);
+  if (IsDst)
+    *IsDst = Dst;
+
+  return Epoch + (uint32_t)((int32_t)(Dst ? DstOffset : StdOffset) * 60);
+}
+
+
+/**
+ * @brief  Convert local epoch to Unix time
+ * @note   A wall clock time that occurs twice (end of DST) or never (start of
+ *         DST) has two candidate instants, one per offset; Fold selects one.
+ * @param  Zone: Pointer to zone (may be in flash, see HT1382_CONST)
+ * @param  Local: Local epoch
+ * @param  Fold: HT1382_TZ_EARLIER or HT1382_TZ_LATER
+ * @retval Unix time
+ */
+uint32_t
+HT1382_Tz_ToUtc(const HT1382_TzZone_t *Zone, uint32_t Local, uint8_t Fold)
+{
+  int16_t StdOffset = (int16_t)HT1382_READ_WORD(&Zone->StdOffset);
+  int16_t DstOffset = (int16_t)HT1382_READ_WORD(&Zone->DstOffset);
+  uint32_t Std = Local - (uint32_t)((int32_t)StdOffset * 60);
+  uint32_t Dst = Local - (uint32_t)((int32_t)DstOffset * 60);
+  uint8_t StdValid = 0;
+  uint8_t DstValid = 0;
+
+  if (StdOffset == DstOffset)
+    return Std;
+
+  StdValid = !HT1382_Tz_IsDstAt(Zone, Std - HT1382_TIME_EPOCH_2000, StdOffset, DstOffset);
+  DstValid = HT1382_Tz_IsDstAt(Zone, Dst - HT1382_TIME_EPOCH_2000, StdOffset, DstOffset);
+
+  if (StdValid != DstValid)
+    return StdValid ? Std : Dst;
+
+  // ambiguous or skipped wall clock time
+  if ((Fold == HT1382_TZ_LATER) == (Std > Dst))
+    return Std;
+  return Dst;
+}
+
+
+/**
+ * @brief  Convert UTC date and time (e.g. read from the RTC) to local time
+ * @param  Zone: Pointer to zone (may be in flash, see HT1382_CONST)
+ * @param  Utc: pointer to UTC date and time
+ * @param  Local: pointer to local date and time
+ * @param  IsDst: Pointer to DST flag (can be NULL)
+ * @retval HT1382_Result_t
+ *         - HT1382_OK: Operation was successful.
+ *         - HT1382_INVALID_PARAM: Local time is out of the RTC range.
+ */
+HT1382_Result_t
+HT1382_Tz_DateTimeToLocal(const HT1382_TzZone_t *Zone,
+                          const HT1382_DateTime_t *Utc,
+                          HT1382_DateTime_t *Local, uint8_t *IsDst)
+{
+  return HT1382_Time_FromEpoch(HT1382_Tz_ToLocal(Zone, HT1382_Time_ToEpoch(Utc), IsDst),
+                               Local);
+}
+
+
+/**
+ * @brief  Convert local date and time to UTC (e.g. to set the RTC)
+ * @param  Zone: Pointer to zone (may be in flash, see HT1382_CONST)
+ * @param  Local: pointer to local date and time
+ * @param  Fold: HT1382_TZ_EARLIER or HT1382_TZ_LATER
+ * @param  Utc: pointer to UTC date and time
+ * @retval HT1382_Result_t
+ *         - HT1382_OK: Operation was successful.
+ *         - HT1382_INVALID_PARAM: UTC time is out of the RTC range.
+ */
+HT1382_Result_t
+HT1382_Tz_DateTimeToUtc(const HT1382_TzZone_t *Zone,
+                        const HT1382_DateTime_t *Local, uint8_t Fold,
+                        HT1382_DateTime_t *Utc)
+{
+  return HT1382_Time_FromEpoch(HT1382_Tz_ToUtc(Zone, HT1382_Time_ToEpoch(Local), Fold),
+                               Utc);
+}
@@ -39,6 +39,8 @@ extern "C" {
 
 /* Includes ---------------------------------------------------------------------*/
 #include <stdint.h>
+#include <stddef.h>
+#include "HT1382_config.h"
 
 
 /* Exported Data Types ----------------------------------------------------------*/
@@ -75,14 +77,38 @@ typedef int8_t (*HT1382_PlatformInitDeinit_t)(void);
 typedef int8_t (*HT1382_PlatformSendReceive_t)(uint8_t Address,
                                                uint8_t *Data, uint8_t Len);
 
+/**
+ * @brief  Function type for Lock/Unlock the bus for a driver operation.
+ * @note   Lock must block until the caller owns the handler (e.g. take a
+ *         mutex) and Unlock must release it.
+ * @retval 
+ *         -  0: The operation was successful.
+ *         - -1: The operation failed. 
+ */
+typedef int8_t (*HT1382_PlatformLockUnlock_t)(void);
+
+/**
+ * @brief  Function type for changing the bus clock.
+ * @param  Rate: I2C clock in Hz
+ * @retval 
+ *         -  0: The operation was successful.
+ *         - -1: The rate is not supported. 
+ */
+typedef int8_t (*HT1382_PlatformSetRate_t)(uint32_t Rate);
+
 /**
  * @brief  Platform dependent layer data type
  * @note   It is optional to initialize this functions:
  *         - Init
  *         - DeInit
+ *         - Lock
+ *         - Unlock
+ *         - SetRate
  * @note   It is mandatory to initialize this functions:
  *         - Send
  *         - Receive
+ * @note   Optional functions that are not linked must be NULL. Zero the
+ *         handler before linking (HT1382_Handler_t Handler = {0}).
  * @note   If success the functions must return 0 
  */
 typedef struct HT1382_Platform_s
@@ -96,8 +122,69 @@ typedef struct HT1382_Platform_s
   HT1382_PlatformSendReceive_t Send;
   // Receive data from the slave
   HT1382_PlatformSendReceive_t Receive;
+
+  // Take exclusive access to the handler (multi-task use)
+  HT1382_PlatformLockUnlock_t Lock;
+  // Release exclusive access to the handler
+  HT1382_PlatformLockUnlock_t Unlock;
+
+  // Change the bus clock (used by HT1382_ProbeBusSpeed)
+  HT1382_PlatformSetRate_t SetRate;
 } HT1382_Platform_t;
 
+#if HT1382_CONFIG_PROBE
+/**
+ * @brief  Chip status data type
+ * @note   Flags is a combination of HT1382_STATUS_xxx. The raw registers are
+ *         read in one burst.
+ */
+typedef struct HT1382_Status_s
+{
+  uint8_t   Flags;
+  uint8_t   Seconds;
+  uint8_t   ST1;
+  uint8_t   ST2;
+  uint8_t   INT;
+} HT1382_Status_t;
+
+/**
+ * @brief  HT1382_Status_t flags
+ */
+#define HT1382_STATUS_OSC_STOPPED     0x01  // CH bit was set: time is not valid
+#define HT1382_STATUS_OSC_RESTARTED   0x02  // The probe cleared CH
+#define HT1382_STATUS_WP_DISABLED     0x04  // Write protection was left disabled
+#define HT1382_STATUS_BE              0x08  // BE bit of ST2
+#define HT1382_STATUS_EB              0x10  // EB bit of ST2
+#define HT1382_STATUS_ALARM           0x20  // AI (alarm interrupt) bit of ST2
+
+/**
+ * @brief  HT1382_Probe options (can be ORed)
+ */
+#define HT1382_PROBE_READ_ONLY        0x00  // Only read and decode
+#define HT1382_PROBE_RESTART_OSC      0x01  // Clear CH if the oscillator is stopped
+#define HT1382_PROBE_RELOCK           0x02  // Enable write protection if disabled
+#endif
+
+#if HT1382_CONFIG_MIRROR
+/**
+ * @brief  Time registers kept in RAM by the port
+ * @note   The port reads the 7 time registers into Buffer[(Seq + 1) & 1],
+ *         then increments Seq, so Buffer[Seq & 1] is always the latest
+ *         complete read and the next read goes to the other buffer. A reader
+ *         copies Buffer[Seq & 1] and keeps the copy if Seq did not change
+ *         meanwhile. Valid is 0 before the first read, after a bus error and
+ *         after the driver wrote to the chip.
+ * @note   Bus access of the driver is bracketed by Platform.Lock/Unlock,
+ *         which the port uses to pause the mirror reads.
+ */
+typedef struct HT1382_Mirror_s
+{
+  volatile uint8_t  Seq;
+  volatile uint8_t  Valid;
+  uint8_t           Buffer[2][7];
+} HT1382_Mirror_t;
+#endif
+
 /**
  * @brief  Handler
  * @note   User must initialize platform dependent layer functions
@@ -105,6 +192,41 @@ typedef struct HT1382_Platform_s
 typedef struct HT1382_Handler_s
 {
   HT1382_Platform_t Platform;
+
+#if HT1382_CONFIG_PROBE
+  // Latest probe result (see HT1382_Probe and HT1382_HealthCheck)
+  HT1382_Status_t Status;
+  // Background health check period in ms, 0: disabled
+  uint32_t HealthPeriod;
+  // Library internal
+  uint32_t HealthLastTick;
+  uint8_t HealthProbed;
+#endif
+
+#if HT1382_CONFIG_SHADOW
+  // Control register shadow (library internal, see HT1382_ResyncShadow)
+  uint8_t Shadow[HT1382_CHIP_SHADOW_COUNT];
+  uint8_t ShadowValid;
+#endif
+
+#if HT1382_SINGLE_FLIGHT
+  // Single-flight state of HT1382_GetDateTime (library internal)
+  volatile uint8_t ReadSeq;
+  uint8_t ReadValid;
+  uint8_t ReadCache[7];
+#endif
+
+#if HT1382_CONFIG_ARMED
+  // Time write prepared by HT1382_ArmDateTime (library internal)
+  uint8_t ArmedFrame[1 + 7];
+  volatile uint8_t Armed;
+  volatile uint8_t Busy;        // a driver call holds the bus
+#endif
+
+#if HT1382_CONFIG_MIRROR
+  // Time register mirror, linked by the port after HT1382_Init
+  const HT1382_Mirror_t *Mirror;
+#endif
 } HT1382_Handler_t;
 
 /**
@@ -144,15 +266,77 @@ typedef enum HT1382_OutWave_e
   HT1382_OUTWAVE_1_32HZ     = 15, // 1/32Hz
 } HT1382_OutWave_t;
 
+/**
+ * @brief  INT register configuration data type
+ * @note   All fields are applied by one write of the INT register.
+ */
+typedef struct HT1382_IntConfig_s
+{
+  HT1382_OutWave_t  OutWave;          // SQW/OUT pin frequency
+  uint8_t           LowPower;         // LPM: 1: low power mode
+  uint8_t           OutputOnBattery;  // OEOBM: 1: keep SQW/OUT running on VBAT
+  uint8_t           AlarmEnable;      // AE: 1: alarm enabled
+  uint8_t           InterruptMode;    // IME: 1: SQW/OUT pin signals the alarm
+} HT1382_IntConfig_t;
+
+/**
+ * @brief  HT1382_EnterLowPower options (can be ORed)
+ */
+#define HT1382_POWER_LOWEST       0x00  // Wave, alarm and battery output off
+#define HT1382_POWER_KEEP_ALARM   0x01  // Keep AE and IME (alarm can wake the MCU)
+#define HT1382_POWER_KEEP_WAVE    0x02  // Keep the SQW/OUT frequency
+
+/**
+ * @brief  Number of registers of the chip (0x00 to 0x14 on HT1382)
+ */
+#define HT1382_IMAGE_SIZE         HT1382_CHIP_REG_COUNT
+
+/**
+ * @brief  Register image data type
+ * @note   Regs[n] holds the register at address n.
+ */
+typedef struct HT1382_Image_s
+{
+  uint8_t   Regs[HT1382_IMAGE_SIZE];
+} HT1382_Image_t;
+
+/**
+ * @brief  HT1382_WriteImage options (can be ORed)
+ */
+#define HT1382_IMAGE_ALL          0x00  // Write all registers
+#define HT1382_IMAGE_EXCLUDE_TIME 0x01  // Do not write time registers (0x00-0x06)
 
-/* Functionality Options --------------------------------------------------------*/
+#if HT1382_CONFIG_QUERY
 /**
- * @brief  Specify Send buffer size.
- * @note   larger buffer size => better performance
- * @note   The HT1382_SEND_BUFFER_SIZE must be set larger than 1 (9 or more is
- *         suggested)
- */   
-#define HT1382_SEND_BUFFER_SIZE   9
+ * @brief  Register set of a query, bit n selects register n
+ */
+#if HT1382_CHIP_REG_COUNT <= 32
+typedef uint32_t HT1382_QueryMask_t;
+#else
+typedef uint64_t HT1382_QueryMask_t;
+#endif
+
+/**
+ * @brief  Maximum number of bus reads of a query plan
+ */
+#define HT1382_QUERY_SPANS_MAX    ((HT1382_CHIP_REG_COUNT + 1) / 2)
+
+/**
+ * @brief  Batched register query data type
+ * @note   Regs[n] holds register n after HT1382_ReadQuery, for the registers
+ *         in Mask and the registers read over between them.
+ */
+typedef struct HT1382_Query_s
+{
+  HT1382_QueryMask_t  Mask;
+  uint8_t             Regs[HT1382_IMAGE_SIZE];
+
+  // Read plan (library internal, see HT1382_Query_Plan)
+  uint8_t             SpanCount;
+  uint8_t             SpanFirst[HT1382_QUERY_SPANS_MAX];
+  uint8_t             SpanLen[HT1382_QUERY_SPANS_MAX];
+} HT1382_Query_t;
+#endif
 
 
 /* Exported Macros --------------------------------------------------------------*/
@@ -188,6 +372,123 @@ typedef enum HT1382_OutWave_e
 #define HT1382_PLATFORM_LINK_RECEIVE(HANDLER, FUNC) \
   (HANDLER)->Platform.Receive = FUNC
 
+/**
+ * @brief  Link platform dependent layer functions to handler
+ * @param  HANDLER: Pointer to handler
+ * @param  FUNC: Function name
+ */
+#define HT1382_PLATFORM_LINK_LOCK(HANDLER, FUNC) \
+  (HANDLER)->Platform.Lock = FUNC
+
+/**
+ * @brief  Link platform dependent layer functions to handler
+ * @param  HANDLER: Pointer to handler
+ * @param  FUNC: Function name
+ */
+#define HT1382_PLATFORM_LINK_UNLOCK(HANDLER, FUNC) \
+  (HANDLER)->Platform.Unlock = FUNC
+
+/**
+ * @brief  Link platform dependent layer functions to handler
+ * @param  HANDLER: Pointer to handler
+ * @param  FUNC: Function name
+ */
+#define HT1382_PLATFORM_LINK_SETRATE(HANDLER, FUNC) \
+  (HANDLER)->Platform.SetRate = FUNC
+
+#if HT1382_CONFIG_QUERY
+/**
+ * @brief  Query mask of COUNT (1 or more) registers from FIRST
+ */
+#define HT1382_QUERY_REGS(FIRST, COUNT) \
+  ((((HT1382_QueryMask_t)2 << ((COUNT) - 1)) - 1) << (FIRST))
+
+/**
+ * @brief  Query mask of the time registers (HT1382_Query_GetDateTime)
+ */
+#define HT1382_QUERY_TIME         HT1382_QUERY_REGS(HT1382_REG_ADDR_SECONDS, 7)
+#endif
+
+/**
+ * @brief  Compile-time register images (C only, see ht1382::MakeTimeImage in
+ *         HT1382.hpp for C++)
+ * @note   Each macro expands to the initializer of a uint8_t array holding the
+ *         register pointer followed by the encoded register values, ready for
+ *         HT1382_WriteRaw:
+ *
+ *           static const uint8_t Epoch[] = HT1382_TIME_IMAGE(0, 0, 0, 7, 1, 1, 0);
+ *           HT1382_WriteRaw(&Handler, Epoch, sizeof(Epoch));
+ *
+ * @note   Arguments must be integer constant expressions. An out of range
+ *         field stops the build with a "negative width" error that names it,
+ *         e.g. HT1382_IMAGE_DAY_OUT_OF_RANGE for February 30.
+ */
+#define HT1382_IMAGE_CHECK(COND, NAME) \
+  (0 * sizeof(struct { int NAME : (COND) ? 1 : -1; }))
+
+#define HT1382_IMAGE_FIELD(VALUE, MIN, MAX, NAME)                       \
+  ((uint8_t)(((((VALUE) / 10) % 10) << 4) + ((VALUE) % 10) +            \
+             HT1382_IMAGE_CHECK((VALUE) >= (MIN) && (VALUE) <= (MAX), NAME)))
+
+#define HT1382_IMAGE_DAYS_IN_MONTH(MONTH, YEAR) \
+  ((MONTH) == 2 ? 28 + ((YEAR) % 4 == 0) : 30 + (((MONTH) + ((MONTH) > 7)) & 1))
+
+/**
+ * @brief  Image of the time registers, same fields as HT1382_DateTime_t
+ * @note   Selects 24-hour mode and keeps the oscillator running, like
+ *         HT1382_SetDateTime.
+ */
+#define HT1382_TIME_IMAGE(SECOND, MINUTE, HOUR, WEEKDAY, DAY, MONTH, YEAR)             \
+  {                                                                                    \
+    [0] = HT1382_REG_ADDR_SECONDS,                                                     \
+    [1 + HT1382_REG_ADDR_SECONDS] =                                                    \
+      HT1382_IMAGE_FIELD(SECOND, 0, 59, HT1382_IMAGE_SECOND_OUT_OF_RANGE),             \
+    [1 + HT1382_REG_ADDR_MINUTES] =                                                    \
+      HT1382_IMAGE_FIELD(MINUTE, 0, 59, HT1382_IMAGE_MINUTE_OUT_OF_RANGE),             \
+    [1 + HT1382_REG_ADDR_HOURS] =                                                      \
+      HT1382_IMAGE_FIELD(HOUR, 0, 23, HT1382_IMAGE_HOUR_OUT_OF_RANGE) |                \
+      HT1382_CHIP_HOURS_24H,                                                           \
+    [1 + HT1382_REG_ADDR_DAY] =                                                        \
+      HT1382_IMAGE_FIELD(WEEKDAY, 1, 7, HT1382_IMAGE_WEEKDAY_OUT_OF_RANGE),            \
+    [1 + HT1382_REG_ADDR_DATE] =                                                       \
+      HT1382_IMAGE_FIELD(DAY, 1, HT1382_IMAGE_DAYS_IN_MONTH(MONTH, YEAR),              \
+                         HT1382_IMAGE_DAY_OUT_OF_RANGE),                               \
+    [1 + HT1382_REG_ADDR_MONTH] =                                                      \
+      HT1382_IMAGE_FIELD(MONTH, 1, 12, HT1382_IMAGE_MONTH_OUT_OF_RANGE),               \
+    [1 + HT1382_REG_ADDR_YEAR] =                                                       \
+      HT1382_IMAGE_FIELD(YEAR, 0, 99, HT1382_IMAGE_YEAR_OUT_OF_RANGE),                 \
+  }
+
+/**
+ * @brief  Image of the out wave register
+ * @note   The whole register is written: on HT1382 this also clears the LPM,
+ *         OEOBM, AE and IME bits of INT (use HT1382_INT_IMAGE to set them).
+ */
+#define HT1382_OUTWAVE_IMAGE(OUTWAVE)                                                  \
+  {                                                                                    \
+    HT1382_CHIP_REG_OUTWAVE,                                                           \
+    (uint8_t)(HT1382_CHIP_OUTWAVE_BITS(OUTWAVE) +                                      \
+              HT1382_IMAGE_CHECK(HT1382_CHIP_OUTWAVE_VALID(OUTWAVE),                   \
+                                 HT1382_IMAGE_OUTWAVE_NOT_SUPPORTED)),                 \
+  }
+
+#if HT1382_CHIP_HAS_POWER
+/**
+ * @brief  Image of the INT register, same fields as HT1382_IntConfig_t
+ */
+#define HT1382_INT_IMAGE(OUTWAVE, LOW_POWER, OUTPUT_ON_BATTERY, ALARM_ENABLE, INTERRUPT_MODE) \
+  {                                                                                    \
+    HT1382_REG_ADDR_INT,                                                               \
+    (uint8_t)(HT1382_CHIP_OUTWAVE_BITS(OUTWAVE) +                                      \
+              HT1382_IMAGE_CHECK(HT1382_CHIP_OUTWAVE_VALID(OUTWAVE),                   \
+                                 HT1382_IMAGE_OUTWAVE_NOT_SUPPORTED) +                 \
+              (!!(OUTPUT_ON_BATTERY) << HT1382_INT_OEOBM) +                            \
+              (!!(LOW_POWER) << HT1382_INT_LPM) +                                      \
+              (!!(ALARM_ENABLE) << HT1382_INT_AE) +                                    \
+              (!!(INTERRUPT_MODE) << HT1382_INT_IME)),                                 \
+  }
+#endif
+
 
 
 /**
@@ -219,6 +520,92 @@ HT1382_Result_t
 HT1382_DeInit(HT1382_Handler_t *Handler);
 
 
+#if HT1382_CONFIG_SHADOW
+/**
+ * @brief  Reload the control register shadow from the chip
+ * @note   The shadow is loaded on first use. Call this function only when
+ *         another bus master or a chip reset may have changed the control
+ *         registers since.
+ * @param  Handler: Pointer to handler
+ * @retval HT1382_Result_t
+ *         - HT1382_OK: Operation was successful.
+ *         - HT1382_FAIL: Failed to send or receive data.
+ */
+HT1382_Result_t
+HT1382_ResyncShadow(HT1382_Handler_t *Handler);
+#endif
+
+
+#if HT1382_CONFIG_PROBE
+/**
+ * @brief  Read seconds, ST1, ST2 and INT in one burst and decode the status
+ * @param  Handler: Pointer to handler
+ * @param  Status: Pointer to status (can be NULL, Handler->Status is updated)
+ * @param  Options: HT1382_PROBE_READ_ONLY or HT1382_PROBE_xxx flags ORed
+ * @retval HT1382_Result_t
+ *         - HT1382_OK: Operation was successful.
+ *         - HT1382_FAIL: Failed to send or receive data.
+ */
+HT1382_Result_t
+HT1382_Probe(HT1382_Handler_t *Handler, HT1382_Status_t *Status, uint8_t Options);
+
+
+/**
+ * @brief  Low-duty background health check
+ * @note   Call it often (e.g. from the main loop). A probe is issued only if
+ *         Handler->HealthPeriod ms have passed since the last one, so the bus
+ *         cost is one 10-byte read per period. Set the period with
+ *         HT1382_SetHealthPeriod.
+ * @param  Handler: Pointer to handler
+ * @param  Tick: Current time in ms (free running, may wrap)
+ * @param  Status: Pointer to status, receives the latest probe result
+ *                 (can be NULL)
+ * @param  Options: HT1382_PROBE_READ_ONLY or HT1382_PROBE_xxx flags ORed
+ * @retval HT1382_Result_t
+ *         - HT1382_OK: Operation was successful or no probe was due.
+ *         - HT1382_FAIL: Failed to send or receive data.
+ */
+HT1382_Result_t
+HT1382_HealthCheck(HT1382_Handler_t *Handler, uint32_t Tick,
+                   HT1382_Status_t *Status, uint8_t Options);
+
+
+/**
+ * @brief  Set the bus budget of HT1382_HealthCheck
+ * @param  Handler: Pointer to handler
+ * @param  Period: Minimum time between two probes in ms, 0: disabled
+ * @retval None
+ */
+void
+HT1382_SetHealthPeriod(HT1382_Handler_t *Handler, uint32_t Period);
+#endif
+
+
+#if HT1382_CONFIG_BUS_PROBE
+/**
+ * @brief  Find the fastest bus clock with reliable read-back
+ * @note   Registers INT to USR4 (0x09-0x14) are read at Rates[0] as reference.
+ *         Then each rate is set with Platform.SetRate and the same registers
+ *         are read HT1382_BUS_PROBE_READS times and compared. The probe stops
+ *         at the first rate that fails and the bus is left at the fastest
+ *         rate that passed.
+ * @note   Nothing is written to the chip.
+ * @param  Handler: Pointer to handler
+ * @param  Rates: Bus clocks in Hz in ascending order. Rates[0] must be a rate
+ *                known to work (e.g. 100000).
+ * @param  Count: Number of rates
+ * @param  Rate: Pointer to selected rate (can be NULL)
+ * @retval HT1382_Result_t
+ *         - HT1382_OK: Operation was successful.
+ *         - HT1382_FAIL: Failed to send or receive data at Rates[0].
+ *         - HT1382_INVALID_PARAM: Platform.SetRate is not linked or Count is 0.
+ */
+HT1382_Result_t
+HT1382_ProbeBusSpeed(HT1382_Handler_t *Handler, const uint32_t *Rates,
+                     uint8_t Count, uint32_t *Rate);
+#endif
+
+
 
 /**
  ==================================================================================
@@ -241,6 +628,12 @@ HT1382_SetDateTime(HT1382_Handler_t *Handler, HT1382_DateTime_t *DateTime);
 
 /**
  * @brief  Get date and time from HT1382 real time chip
+ * @note   All fields come from one coherent snapshot (see
+ *         HT1382_SNAPSHOT_CHECK), also around midnight and year rollover.
+ * @note   With a valid mirror (HT1382_CONFIG_MIRROR) the time is decoded from
+ *         RAM without locking or bus traffic. Otherwise the bus is read under
+ *         Platform.Lock: from an ISR it is only safe if that Lock fails there
+ *         (the STM32 port's mirror Lock does), then HT1382_FAIL is returned.
  * @param  Handler: Pointer to handler
  * @param  DateTime: pointer to date and time value structure
  * @retval HT1382_Result_t
@@ -251,7 +644,75 @@ HT1382_Result_t
 HT1382_GetDateTime(HT1382_Handler_t *Handler, HT1382_DateTime_t *DateTime);
 
 
+#if HT1382_CONFIG_ARMED
+/**
+ ==================================================================================
+                      ##### Armed Time Write Functions #####                      
+ ==================================================================================
+ */
 
+/**
+ * @brief  Prepare a time write to be sent later by HT1382_FireDateTime
+ * @note   Validation, BCD encoding and the write protection unlock are done
+ *         here, so the fire is a single burst. Write protection stays
+ *         disabled until the fire or HT1382_DisarmDateTime: every other
+ *         driver write made while armed (SetOutWave, SetDateTime, ...) also
+ *         leaves it disabled. Both the fire and HT1382_DisarmDateTime enable
+ *         it again. Arming again replaces the time.
+ * @note   Arm with the time of the coming edge, e.g. the second a GPS PPS
+ *         pulse marks.
+ * @param  Handler: Pointer to handler
+ * @param  DateTime: Time the chip must hold at the moment of the fire
+ * @retval HT1382_Result_t
+ *         - HT1382_OK: Operation was successful.
+ *         - HT1382_FAIL: Failed to send or receive data.
+ *         - HT1382_INVALID_PARAM: One of parameters is invalid.
+ */
+HT1382_Result_t
+HT1382_ArmDateTime(HT1382_Handler_t *Handler, const HT1382_DateTime_t *DateTime);
+
+
+/**
+ * @brief  Send the time prepared by HT1382_ArmDateTime
+ * @note   Sends the prepared seconds-to-year burst, then enables write
+ *         protection again with a second write. Platform.Lock is not called,
+ *         so it can run from an ISR or a high priority task. If it interrupts
+ *         another driver call of this handler, it returns HT1382_FAIL with no
+ *         transfer and stays armed. Other users of the bus (other devices,
+ *         port transfers) are not detected.
+ * @note   Edge-to-write latency: the seconds register is written when its
+ *         byte is acknowledged, 28 bit times after the START (address,
+ *         register pointer and seconds): 280 us at 100 kHz, 70 us at
+ *         400 kHz, plus the ISR entry and Platform.Send call overhead.
+ *         HT1382_SetDateTime adds the validation, the encoding and the
+ *         unlock write (3 more bytes) in front of that. The benchmark in
+ *         example/ATmega32-GCC/benchmark measures both.
+ * @param  Handler: Pointer to handler
+ * @retval HT1382_Result_t
+ *         - HT1382_OK: Operation was successful.
+ *         - HT1382_FAIL: Failed to send or receive data, or the bus is in use.
+ *         - HT1382_INVALID_PARAM: The handler is not armed.
+ */
+HT1382_Result_t
+HT1382_FireDateTime(HT1382_Handler_t *Handler);
+
+
+/**
+ * @brief  Cancel a time write prepared by HT1382_ArmDateTime
+ * @note   Enables write protection again. Nothing is done if the handler is
+ *         not armed.
+ * @param  Handler: Pointer to handler
+ * @retval HT1382_Result_t
+ *         - HT1382_OK: Operation was successful.
+ *         - HT1382_FAIL: Failed to send or receive data.
+ */
+HT1382_Result_t
+HT1382_DisarmDateTime(HT1382_Handler_t *Handler);
+#endif
+
+
+
+#if HT1382_CONFIG_OUTWAVE
 /**
  ==================================================================================
                           ##### Out Wave Functions #####                           
@@ -260,6 +721,8 @@ HT1382_GetDateTime(HT1382_Handler_t *Handler, HT1382_DateTime_t *DateTime);
 
 /**
  * @brief  Set output Wave on SQW/Out pin of HT1382
+ * @note   With HT1382_CONFIG_SHADOW this is a single register write (none if
+ *         the wave is already set), otherwise a read followed by a write.
  * @param  Handler: Pointer to handler
  * @param  OutWave: where OutWave Shows different output wave states
  * @retval HT1382_Result_t
@@ -269,6 +732,232 @@ HT1382_GetDateTime(HT1382_Handler_t *Handler, HT1382_DateTime_t *DateTime);
  */
 HT1382_Result_t
 HT1382_SetOutWave(HT1382_Handler_t *Handler, HT1382_OutWave_t OutWave);
+#endif
+
+
+
+#if HT1382_CONFIG_POWER
+/**
+ ==================================================================================
+                            ##### Power Functions #####                            
+ ==================================================================================
+ */
+
+/**
+ * @brief  Write out wave, low power, battery output and alarm interrupt
+ *         settings in one INT register write
+ * @param  Handler: Pointer to handler
+ * @param  Config: Pointer to INT configuration
+ * @retval HT1382_Result_t
+ *         - HT1382_OK: Operation was successful.
+ *         - HT1382_FAIL: Failed to send or receive data.
+ *         - HT1382_INVALID_PARAM: One of parameters is invalid.
+ */
+HT1382_Result_t
+HT1382_SetIntConfig(HT1382_Handler_t *Handler, const HT1382_IntConfig_t *Config);
+
+
+/**
+ * @brief  Read INT register configuration
+ * @param  Handler: Pointer to handler
+ * @param  Config: Pointer to INT configuration
+ * @retval HT1382_Result_t
+ *         - HT1382_OK: Operation was successful.
+ *         - HT1382_FAIL: Failed to send or receive data.
+ */
+HT1382_Result_t
+HT1382_GetIntConfig(HT1382_Handler_t *Handler, HT1382_IntConfig_t *Config);
+
+
+/**
+ * @brief  Put the chip in its lowest-draw configuration before the MCU sleeps
+ * @note   Reads INT once (from the shadow with HT1382_CONFIG_SHADOW), saves
+ *         it in Saved and, if anything changes, writes
+ *         the low power configuration with one INT write: LPM set, OEOBM
+ *         cleared, wave disabled and alarm interrupt disabled unless kept by
+ *         Options.
+ * @param  Handler: Pointer to handler
+ * @param  Saved: Pointer to configuration to restore with HT1382_ExitLowPower
+ * @param  Options: HT1382_POWER_LOWEST or HT1382_POWER_KEEP_xxx flags ORed
+ * @retval HT1382_Result_t
+ *         - HT1382_OK: Operation was successful.
+ *         - HT1382_FAIL: Failed to send or receive data.
+ */
+HT1382_Result_t
+HT1382_EnterLowPower(HT1382_Handler_t *Handler, HT1382_IntConfig_t *Saved,
+                     uint8_t Options);
+
+
+/**
+ * @brief  Restore the configuration saved by HT1382_EnterLowPower
+ * @note   Same as HT1382_SetIntConfig: one INT write, no read.
+ * @param  Handler: Pointer to handler
+ * @param  Saved: Pointer to configuration saved by HT1382_EnterLowPower
+ * @retval HT1382_Result_t
+ *         - HT1382_OK: Operation was successful.
+ *         - HT1382_FAIL: Failed to send or receive data.
+ *         - HT1382_INVALID_PARAM: One of parameters is invalid.
+ */
+HT1382_Result_t
+HT1382_ExitLowPower(HT1382_Handler_t *Handler, const HT1382_IntConfig_t *Saved);
+#endif
+
+
+
+#if HT1382_CONFIG_IMAGE
+/**
+ ==================================================================================
+                         ##### Register Image Functions #####                     
+ ==================================================================================
+ */
+
+/**
+ * @brief  Read all registers of HT1382 in one burst
+ * @param  Handler: Pointer to handler
+ * @param  Image: Pointer to register image
+ * @retval HT1382_Result_t
+ *         - HT1382_OK: Operation was successful.
+ *         - HT1382_FAIL: Failed to send or receive data.
+ */
+HT1382_Result_t
+HT1382_ReadImage(HT1382_Handler_t *Handler, HT1382_Image_t *Image);
+
+
+/**
+ * @brief  Write a register image to HT1382 in one write-protection bracket
+ * @note   The WP bit of ST1 is managed by the library: write protection is
+ *         always enabled again after the write, whatever Image holds.
+ * @note   If Cached is not NULL, only the registers that differ from it are
+ *         written (nearby changes are merged into one burst) and Cached is
+ *         updated on success. Cached must hold the current chip contents,
+ *         e.g. from HT1382_ReadImage or a previous HT1382_WriteImage.
+ * @param  Handler: Pointer to handler
+ * @param  Image: Pointer to register image to write
+ * @param  Cached: Pointer to image of current chip contents (can be NULL)
+ * @param  Options: HT1382_IMAGE_ALL or HT1382_IMAGE_EXCLUDE_TIME
+ * @retval HT1382_Result_t
+ *         - HT1382_OK: Operation was successful.
+ *         - HT1382_FAIL: Failed to send or receive data.
+ */
+HT1382_Result_t
+HT1382_WriteImage(HT1382_Handler_t *Handler, const HT1382_Image_t *Image,
+                  HT1382_Image_t *Cached, uint8_t Options);
+#endif
+
+
+#if HT1382_CONFIG_RAW
+/**
+ ==================================================================================
+                         ##### Raw Write Functions #####                          
+ ==================================================================================
+ */
+
+/**
+ * @brief  Write an encoded register frame to HT1382 as it is
+ * @note   Frame[0] is the first register address and the register values
+ *         follow, as built by HT1382_TIME_IMAGE, HT1382_OUTWAVE_IMAGE and
+ *         HT1382_INT_IMAGE. The values are neither checked nor converted and
+ *         Frame is passed to Platform.Send without a copy.
+ * @note   The frame must not cover ST1: write protection is managed by the
+ *         library.
+ * @param  Handler: Pointer to handler
+ * @param  Frame: Pointer to register pointer and values
+ * @param  Len: Frame size in bytes, register pointer included (sizeof(Frame))
+ * @retval HT1382_Result_t
+ *         - HT1382_OK: Operation was successful.
+ *         - HT1382_FAIL: Failed to send or receive data.
+ *         - HT1382_INVALID_PARAM: One of parameters is invalid.
+ */
+HT1382_Result_t
+HT1382_WriteRaw(HT1382_Handler_t *Handler, const uint8_t *Frame, uint8_t Len);
+#endif
+
+
+#if HT1382_CONFIG_QUERY
+/**
+ ==================================================================================
+                          ##### Query Functions #####                             
+ ==================================================================================
+ */
+
+/**
+ * @brief  Clear a query
+ * @param  Query: Pointer to query
+ * @retval None
+ */
+void
+HT1382_Query_Init(HT1382_Query_t *Query);
+
+
+/**
+ * @brief  Add registers to a query
+ * @note   Callers that need different registers add their own set, e.g.
+ *         HT1382_QUERY_TIME, HT1382_QUERY_REGS(HT1382_REG_ADDR_ST2, 2) and
+ *         HT1382_QUERY_REGS(HT1382_REG_ADDR_USR1, 4). The plan is computed
+ *         again on the next read.
+ * @param  Query: Pointer to query
+ * @param  Regs: Registers to read (HT1382_QUERY_xxx masks ORed)
+ * @retval None
+ */
+void
+HT1382_Query_Add(HT1382_Query_t *Query, HT1382_QueryMask_t Regs);
+
+
+/**
+ * @brief  Compute the bus reads of a query
+ * @note   Requested registers are merged into contiguous spans. Two spans
+ *         are read as one when at most MaxGap unrequested registers lie
+ *         between them. Each gap is decided on its own, so the plan has the
+ *         lowest cost for a fixed price per span. HT1382_ReadQuery plans
+ *         with HT1382_QUERY_MERGE_GAP if this function was not called.
+ * @param  Query: Pointer to query
+ * @param  MaxGap: Largest number of unrequested registers read over
+ * @retval Number of bus reads of the plan
+ */
+uint8_t
+HT1382_Query_Plan(HT1382_Query_t *Query, uint8_t MaxGap);
+
+
+/**
+ * @brief  Read the registers of a query
+ * @note   Each span of the plan is one pointer write and one burst read. The
+ *         time registers are always read in one burst, so the decoded time
+ *         is coherent.
+ * @param  Handler: Pointer to handler
+ * @param  Query: Pointer to query
+ * @retval HT1382_Result_t
+ *         - HT1382_OK: Operation was successful.
+ *         - HT1382_FAIL: Failed to send or receive data.
+ */
+HT1382_Result_t
+HT1382_ReadQuery(HT1382_Handler_t *Handler, HT1382_Query_t *Query);
+
+
+/**
+ * @brief  Decode the time from a query read by HT1382_ReadQuery
+ * @param  Query: Pointer to query
+ * @param  DateTime: pointer to date and time value structure
+ * @retval HT1382_Result_t
+ *         - HT1382_OK: Operation was successful.
+ *         - HT1382_INVALID_PARAM: HT1382_QUERY_TIME is not in the query.
+ */
+HT1382_Result_t
+HT1382_Query_GetDateTime(const HT1382_Query_t *Query, HT1382_DateTime_t *DateTime);
+
+
+#if HT1382_CONFIG_POWER
+/**
+ * @brief  Decode the INT configuration from a query read by HT1382_ReadQuery
+ * @param  Query: Pointer to query
+ * @param  Config: Pointer to INT configuration
+ * @retval HT1382_Result_t
+ *         - HT1382_OK: Operation was successful.
+ *         - HT1382_INVALID_PARAM: The INT register is not in the query.
+ */
+HT1382_Result_t
+HT1382_Query_GetIntConfig(const HT1382_Query_t *Query, HT1382_IntConfig_t *Config);
+#endif
+#endif
 
 
 
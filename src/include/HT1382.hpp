@@ -0,0 +1,464 @@
+/**
+ **********************************************************************************
+ * @file   HT1382.hpp
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  HT1382 RTC chip driver (header-only C++ interface)
+ *         Functionalities of the this file:
+ *          + ht1382::Device<Bus>: driver with the bus as a compile-time policy
+ *          + ht1382::MakeTimeImage, ...: register images encoded at compile time
+ *          + ht1382::clock<Bus>: std::chrono Clock backed by the RTC
+ **********************************************************************************
+ *
+ * Copyright (c) 2024 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+
+/**
+ * A Bus policy is a type with two static member functions that behave like
+ * HT1382_Platform_t Send/Receive:
+ *
+ *   struct MyBus
+ *   {
+ *     static int8_t Send(uint8_t Address, uint8_t *Data, uint8_t Len);
+ *     static int8_t Receive(uint8_t Address, uint8_t *Data, uint8_t Len);
+ *   };
+ *
+ * Because the calls are resolved at compile time the compiler can inline the
+ * bus code and the register constants into each driver function, where the
+ * C API has to call through function pointers.
+ */
+
+/* Define to prevent recursive inclusion ----------------------------------------*/
+#ifndef _HT1382_HPP_
+#define _HT1382_HPP_
+
+
+/* Includes ---------------------------------------------------------------------*/
+#include <stdint.h>
+#include <chrono>
+#include <ctime>
+#include "HT1382.h"
+
+
+namespace ht1382
+{
+
+/* Private Constants ------------------------------------------------------------*/
+/**
+ * @note   Register addresses and bits come from HT1382_chip.h, so the C++
+ *         interface follows the chip selected by HT1382_CHIP like the C API.
+ */
+namespace detail
+{
+constexpr uint8_t Address           = HT1382_ADDRESS;
+
+constexpr uint8_t RegSeconds        = HT1382_REG_ADDR_SECONDS;
+constexpr uint8_t RegMinutes        = HT1382_REG_ADDR_MINUTES;
+constexpr uint8_t RegHours          = HT1382_REG_ADDR_HOURS;
+constexpr uint8_t RegDate           = HT1382_REG_ADDR_DATE;
+constexpr uint8_t RegMonth          = HT1382_REG_ADDR_MONTH;
+constexpr uint8_t RegDay            = HT1382_REG_ADDR_DAY;
+constexpr uint8_t RegYear           = HT1382_REG_ADDR_YEAR;
+constexpr uint8_t RegOutWave        = HT1382_CHIP_REG_OUTWAVE;
+
+constexpr uint8_t SecondsCH         = HT1382_SECONDS_CH;
+constexpr uint8_t Hours24H          = HT1382_CHIP_HOURS_24H;
+
+constexpr uint8_t
+DECtoBCD(uint8_t DEC)
+{
+  return (uint8_t)((((DEC / 10) % 10) << 4) | (DEC % 10));
+}
+
+constexpr uint8_t
+BCDtoDEC(uint8_t BCD)
+{
+  return (uint8_t)((BCD >> 4) * 10 + (BCD & 0x0F));
+}
+
+constexpr int32_t
+DaysFromCivil(int32_t Year, uint16_t DayOfYear)
+{
+  return (Year / 400) * 146097 + (Year % 400) * 365 + (Year % 400) / 4 -
+         (Year % 400) / 100 + DayOfYear - 719468;
+}
+
+/**
+ * @brief  Days since 1970-01-01 of a date (Year >= 1970)
+ */
+constexpr int32_t
+DaysFromCivil(int32_t Year, uint8_t Month, uint8_t Day)
+{
+  return DaysFromCivil(Year - (Month <= 2),
+                       (uint16_t)((153 * (Month > 2 ? Month - 3 : Month + 9) + 2) / 5 + Day - 1));
+}
+
+/**
+ * @brief  Never defined: an image helper calls it only for an invalid field,
+ *         which is a compile error in a constant expression and a link error
+ *         otherwise.
+ */
+uint8_t
+ImageFieldOutOfRange();
+
+constexpr uint8_t
+ImageField(unsigned Value, unsigned Min, unsigned Max)
+{
+  return (Value >= Min && Value <= Max) ? DECtoBCD((uint8_t)Value) : ImageFieldOutOfRange();
+}
+
+constexpr unsigned
+DaysInMonth(unsigned Month, unsigned Year)
+{
+  return Month == 2 ? 28 + (Year % 4 == 0) : 30 + ((Month + (Month > 7)) & 1);
+}
+
+/**
+ * @brief  Encoded value of time register Reg, the order of the date registers
+ *         depends on the chip
+ */
+constexpr uint8_t
+TimeField(uint8_t Reg, unsigned Second, unsigned Minute, unsigned Hour, unsigned WeekDay,
+          unsigned Day, unsigned Month, unsigned Year)
+{
+  return Reg == RegSeconds ? ImageField(Second, 0, 59) :
+         Reg == RegMinutes ? ImageField(Minute, 0, 59) :
+         Reg == RegHours   ? (uint8_t)(ImageField(Hour, 0, 23) | Hours24H) :
+         Reg == RegDay     ? ImageField(WeekDay, 1, 7) :
+         Reg == RegDate    ? ImageField(Day, 1, DaysInMonth(Month, Year)) :
+         Reg == RegMonth   ? ImageField(Month, 1, 12) :
+                             ImageField(Year, 0, 99);
+}
+
+constexpr uint8_t
+OutWaveField(HT1382_OutWave_t OutWave)
+{
+  return HT1382_CHIP_OUTWAVE_VALID(OutWave) ? (uint8_t)HT1382_CHIP_OUTWAVE_BITS(OutWave)
+                                            : ImageFieldOutOfRange();
+}
+} // namespace detail
+
+
+
+/**
+ ==================================================================================
+                          ##### Register Images #####                              
+ ==================================================================================
+ */
+
+/**
+ * @brief  Encoded register frame: the register pointer followed by N register
+ *         values, written as it is by Device<Bus>::WriteRaw
+ */
+template <uint8_t N>
+struct RegImage
+{
+  uint8_t Frame[1 + N];
+};
+
+typedef RegImage<7> TimeImage;
+typedef RegImage<1> OutWaveImage;
+#if HT1382_CHIP_HAS_POWER
+typedef RegImage<1> IntImage;
+#endif
+
+/**
+ * @brief  Image of the time registers, same fields as HT1382_DateTime_t
+ * @note   Declare the result constexpr to have it built by the compiler:
+ *
+ *           constexpr ht1382::TimeImage Epoch = ht1382::MakeTimeImage(0, 0, 0, 7, 1, 1, 0);
+ *
+ *         An out of range field (e.g. February 30) is then a compile error
+ *         that points at detail::ImageFieldOutOfRange.
+ * @note   Selects 24-hour mode, like Device<Bus>::SetDateTime.
+ */
+constexpr TimeImage
+MakeTimeImage(unsigned Second, unsigned Minute, unsigned Hour, unsigned WeekDay,
+              unsigned Day, unsigned Month, unsigned Year)
+{
+  return TimeImage{{
+    detail::RegSeconds,
+    detail::TimeField(0, Second, Minute, Hour, WeekDay, Day, Month, Year),
+    detail::TimeField(1, Second, Minute, Hour, WeekDay, Day, Month, Year),
+    detail::TimeField(2, Second, Minute, Hour, WeekDay, Day, Month, Year),
+    detail::TimeField(3, Second, Minute, Hour, WeekDay, Day, Month, Year),
+    detail::TimeField(4, Second, Minute, Hour, WeekDay, Day, Month, Year),
+    detail::TimeField(5, Second, Minute, Hour, WeekDay, Day, Month, Year),
+    detail::TimeField(6, Second, Minute, Hour, WeekDay, Day, Month, Year),
+  }};
+}
+
+/**
+ * @brief  Image of the out wave register, like HT1382_OUTWAVE_IMAGE
+ * @note   The whole register is written: on HT1382 this also clears the LPM,
+ *         OEOBM, AE and IME bits of INT (use MakeIntImage to set them).
+ */
+constexpr OutWaveImage
+MakeOutWaveImage(HT1382_OutWave_t OutWave)
+{
+  return OutWaveImage{{
+    detail::RegOutWave,
+    detail::OutWaveField(OutWave),
+  }};
+}
+
+#if HT1382_CHIP_HAS_POWER
+/**
+ * @brief  Image of the INT register, same fields as HT1382_IntConfig_t
+ * @note   The whole register is written, so MakeIntImage(Wave) also clears
+ *         the LPM, OEOBM, AE and IME bits.
+ */
+constexpr IntImage
+MakeIntImage(HT1382_OutWave_t OutWave, bool LowPower = false, bool OutputOnBattery = false,
+             bool AlarmEnable = false, bool InterruptMode = false)
+{
+  return IntImage{{
+    HT1382_REG_ADDR_INT,
+    (uint8_t)(detail::OutWaveField(OutWave) |
+              (OutputOnBattery << HT1382_INT_OEOBM) | (LowPower << HT1382_INT_LPM) |
+              (AlarmEnable << HT1382_INT_AE) | (InterruptMode << HT1382_INT_IME)),
+  }};
+}
+#endif
+
+
+
+/**
+ ==================================================================================
+                              ##### Device #####                                   
+ ==================================================================================
+ */
+
+/**
+ * @brief  HT1382 driver with compile-time bus dispatch
+ * @note   Same validation as the C API of HT1382.h. The device keeps no
+ *         state, so each call reads and writes like the C API built with
+ *         HT1382_CONFIG_SHADOW=0, except that SetOutWave always writes the
+ *         register where the C API skips a write that changes nothing.
+ */
+template <class Bus>
+class Device
+{
+public:
+  /**
+   * @brief  Set date and time on HT1382 real time chip
+   * @param  DateTime: date and time value structure
+   * @retval HT1382_Result_t
+   *         - HT1382_OK: Operation was successful.
+   *         - HT1382_FAIL: Failed to send or receive data.
+   *         - HT1382_INVALID_PARAM: One of parameters is invalid.
+   */
+  static HT1382_Result_t
+  SetDateTime(const HT1382_DateTime_t &DateTime)
+  {
+    uint8_t Buffer[8];
+
+    if (DateTime.Second > 59 ||
+        DateTime.Minute > 59 ||
+        DateTime.Hour > 23 ||
+        DateTime.WeekDay > 7 || DateTime.WeekDay == 0 ||
+        DateTime.Day > 31 || DateTime.Day == 0 ||
+        DateTime.Month > 12 || DateTime.Month == 0 ||
+        DateTime.Year > 99)
+      return HT1382_INVALID_PARAM;
+
+    Buffer[0] = detail::RegSeconds;
+    Buffer[1 + detail::RegSeconds] = detail::DECtoBCD(DateTime.Second) & ~(1 << detail::SecondsCH);
+    Buffer[1 + detail::RegMinutes] = detail::DECtoBCD(DateTime.Minute);
+    Buffer[1 + detail::RegHours]   = detail::DECtoBCD(DateTime.Hour) | detail::Hours24H;
+    Buffer[1 + detail::RegDay]     = detail::DECtoBCD(DateTime.WeekDay);
+    Buffer[1 + detail::RegDate]    = detail::DECtoBCD(DateTime.Day);
+    Buffer[1 + detail::RegMonth]   = detail::DECtoBCD(DateTime.Month);
+    Buffer[1 + detail::RegYear]    = detail::DECtoBCD(DateTime.Year);
+
+    if (WriteProtection(false) < 0 ||
+        Bus::Send(detail::Address, Buffer, sizeof(Buffer)) < 0 ||
+        WriteProtection(true) < 0)
+      return HT1382_FAIL;
+
+    return HT1382_OK;
+  }
+
+  /**
+   * @brief  Get date and time from HT1382 real time chip
+   * @param  DateTime: date and time value structure
+   * @retval HT1382_Result_t
+   *         - HT1382_OK: Operation was successful.
+   *         - HT1382_FAIL: Failed to send or receive data.
+   */
+  static HT1382_Result_t
+  GetDateTime(HT1382_DateTime_t &DateTime)
+  {
+    uint8_t Buffer[7];
+
+    if (ReadRegs(detail::RegSeconds, Buffer, sizeof(Buffer)) < 0)
+      return HT1382_FAIL;
+
+    DateTime.Second = detail::BCDtoDEC(Buffer[detail::RegSeconds] & ~(1 << detail::SecondsCH));
+    DateTime.Minute = detail::BCDtoDEC(Buffer[detail::RegMinutes]);
+    DateTime.Hour   = HT1382_CHIP_HOURS_TO_DEC(Buffer[detail::RegHours]);
+    DateTime.WeekDay = detail::BCDtoDEC(Buffer[detail::RegDay]);
+    DateTime.Day     = detail::BCDtoDEC(Buffer[detail::RegDate]);
+    DateTime.Month   = detail::BCDtoDEC(Buffer[detail::RegMonth]);
+    DateTime.Year    = detail::BCDtoDEC(Buffer[detail::RegYear]);
+
+    return HT1382_OK;
+  }
+
+  /**
+   * @brief  Set output Wave on SQW/Out pin of HT1382
+   * @param  OutWave: where OutWave Shows different output wave states
+   * @retval HT1382_Result_t
+   *         - HT1382_OK: Operation was successful.
+   *         - HT1382_FAIL: Failed to send or receive data.
+   *         - HT1382_INVALID_PARAM: One of parameters is invalid.
+   */
+  static HT1382_Result_t
+  SetOutWave(HT1382_OutWave_t OutWave)
+  {
+    uint8_t Buffer[2] = {detail::RegOutWave, 0};
+
+    if (!HT1382_CHIP_OUTWAVE_VALID(OutWave))
+      return HT1382_INVALID_PARAM;
+
+    if (ReadRegs(detail::RegOutWave, &Buffer[1], 1) < 0)
+      return HT1382_FAIL;
+
+    Buffer[1] &= ~HT1382_CHIP_OUTWAVE_MASK;
+    Buffer[1] |= HT1382_CHIP_OUTWAVE_BITS(OutWave);
+
+    if (WriteProtection(false) < 0 ||
+        Bus::Send(detail::Address, Buffer, sizeof(Buffer)) < 0 ||
+        WriteProtection(true) < 0)
+      return HT1382_FAIL;
+
+    return HT1382_OK;
+  }
+
+  /**
+   * @brief  Write a register image built by MakeTimeImage, MakeOutWaveImage
+   *         or MakeIntImage
+   * @note   The frame is sent as it is: no validation and no conversion.
+   * @param  Image: encoded register frame
+   * @retval HT1382_Result_t
+   *         - HT1382_OK: Operation was successful.
+   *         - HT1382_FAIL: Failed to send or receive data.
+   */
+  template <uint8_t N>
+  static HT1382_Result_t
+  WriteRaw(const RegImage<N> &Image)
+  {
+    // Bus::Send does not write to the data
+    if (WriteProtection(false) < 0 ||
+        Bus::Send(detail::Address, const_cast<uint8_t *>(Image.Frame), sizeof(Image.Frame)) < 0 ||
+        WriteProtection(true) < 0)
+      return HT1382_FAIL;
+
+    return HT1382_OK;
+  }
+
+private:
+  static int8_t
+  ReadRegs(uint8_t StartReg, uint8_t *Data, uint8_t BytesCount)
+  {
+    if (Bus::Send(detail::Address, &StartReg, 1) < 0)
+      return -1;
+
+    return Bus::Receive(detail::Address, Data, BytesCount) < 0 ? -1 : 0;
+  }
+
+  static int8_t
+  WriteProtection(bool Enable)
+  {
+#if HT1382_CHIP_HAS_WP
+    uint8_t Buffer[2] = {HT1382_REG_ADDR_ST1, (uint8_t)(Enable ? (1 << HT1382_ST1_WP) : 0)};
+
+    return Bus::Send(detail::Address, Buffer, sizeof(Buffer)) < 0 ? -1 : 0;
+#else
+    (void)Enable;
+    return 0;
+#endif
+  }
+};
+
+
+
+/**
+ ==================================================================================
+                              ##### Clock #####                                    
+ ==================================================================================
+ */
+
+/**
+ * @brief  std::chrono Clock reading the RTC through Device<Bus>
+ * @note   The RTC is assumed to hold UTC, so the epoch is the Unix epoch and
+ *         time points convert to std::chrono::system_clock with to_sys().
+ * @note   now() returns the epoch if the bus transaction fails.
+ */
+template <class Bus>
+struct clock
+{
+  typedef std::chrono::seconds                      duration;
+  typedef duration::rep                             rep;
+  typedef duration::period                          period;
+  typedef std::chrono::time_point<clock, duration>  time_point;
+
+  static constexpr bool is_steady = false;
+
+  static time_point
+  now() noexcept
+  {
+    HT1382_DateTime_t DateTime = {};
+
+    if (Device<Bus>::GetDateTime(DateTime) != HT1382_OK)
+      return time_point();
+
+    return from_date_time(DateTime);
+  }
+
+  static time_point
+  from_date_time(const HT1382_DateTime_t &DateTime) noexcept
+  {
+    return time_point(duration(
+      (rep)detail::DaysFromCivil(2000 + DateTime.Year, DateTime.Month, DateTime.Day) * 86400 +
+      (rep)DateTime.Hour * 3600 + (rep)DateTime.Minute * 60 + DateTime.Second));
+  }
+
+  static std::chrono::system_clock::time_point
+  to_sys(const time_point &Time) noexcept
+  {
+    return std::chrono::system_clock::time_point(
+      std::chrono::duration_cast<std::chrono::system_clock::duration>(Time.time_since_epoch()));
+  }
+
+  static std::time_t
+  to_time_t(const time_point &Time) noexcept
+  {
+    return (std::time_t)Time.time_since_epoch().count();
+  }
+};
+
+} // namespace ht1382
+
+
+#endif //! _HT1382_HPP_
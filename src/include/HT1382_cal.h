@@ -0,0 +1,187 @@
+/**
+ **********************************************************************************
+ * @file   HT1382_cal.h
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  HT1382 MCU clock calibration module
+ *         Functionalities of the this file:
+ *          + Trim the MCU RC oscillator (OSCCAL on AVR) against SQW/OUT
+ *          + Full search and temperature tracking modes
+ **********************************************************************************
+ *
+ * Copyright (c) 2024 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+
+
+/**
+ * The RTC runs from a 32768 Hz crystal, so its SQW/OUT wave is a reference
+ * accurate to a few tens of ppm. HT1382_Cal_Run selects a reference wave,
+ * lets the port count MCU clock ticks over a number of its periods (timer
+ * input capture), moves the MCU oscillator trim until the count matches the
+ * nominal clock, and restores the out wave register as it was.
+ *
+ * The search relies on the oscillator frequency increasing with the trim
+ * value between TrimMin and TrimMax. On AVRs with two overlapping OSCCAL
+ * ranges (e.g. ATmega328P) keep TrimMin and TrimMax in one range.
+ *
+ * tools/cal simulates the loop against an RC oscillator model and reports
+ * the convergence time of both modes.
+ */
+
+/* Define to prevent recursive inclusion ----------------------------------------*/
+#ifndef _HT1382_CAL_H_
+#define _HT1382_CAL_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* Includes ---------------------------------------------------------------------*/
+#include <stdint.h>
+#include "HT1382.h"
+
+
+/* Functionality Options --------------------------------------------------------*/
+/**
+ * @brief  Measurements HT1382_CAL_TRACK makes before it falls back to a
+ *         binary search of the trims left
+ */
+#ifndef HT1382_CAL_TRACK_STEPS
+#define HT1382_CAL_TRACK_STEPS    6
+#endif
+
+
+/* Exported Constants -----------------------------------------------------------*/
+/**
+ * @brief  HT1382_Cal_Run modes
+ */
+#define HT1382_CAL_SEARCH         0x00  // Binary search over TrimMin..TrimMax
+#define HT1382_CAL_TRACK          0x01  // Secant steps from the current trim (drift)
+
+
+/* Exported Data Types ----------------------------------------------------------*/
+/**
+ * @brief  Function type for measuring the MCU clock against SQW/OUT.
+ * @note   Wait for a rising edge of SQW/OUT, then count timer ticks until
+ *         Periods more rising edges have passed.
+ * @param  Periods: Number of reference periods to measure
+ * @retval 
+ *         - >0: Timer ticks over Periods periods.
+ *         - -1: No edges (timeout).
+ */
+typedef int32_t (*HT1382_CalMeasure_t)(uint16_t Periods);
+
+/**
+ * @brief  Function types for reading and writing the oscillator trim.
+ */
+typedef uint8_t (*HT1382_CalGetTrim_t)(void);
+typedef void (*HT1382_CalSetTrim_t)(uint8_t Trim);
+
+/**
+ * @brief  Calibration data type
+ * @note   TickFreq * Periods must fit in 32 bits.
+ */
+typedef struct HT1382_Cal_s
+{
+  HT1382_Handler_t      *Handler;
+  HT1382_CalMeasure_t   Measure;
+  HT1382_CalGetTrim_t   GetTrim;
+  HT1382_CalSetTrim_t   SetTrim;
+
+  uint32_t              TickFreq;     // Measure tick frequency at the nominal clock (Hz)
+  HT1382_OutWave_t      OutWave;      // Reference: HT1382_OUTWAVE_1024HZ or HT1382_OUTWAVE_4096HZ
+  uint16_t              Periods;      // Reference periods per measurement
+  uint8_t               TrimMin;
+  uint8_t               TrimMax;
+
+  // Result of the last HT1382_Cal_Run
+  uint8_t               Trim;
+  int32_t               ErrorPpm;     // MCU clock error at Trim
+  uint8_t               Measurements;
+} HT1382_Cal_t;
+
+
+
+/**
+ ==================================================================================
+                         ##### Calibration Functions #####                        
+ ==================================================================================
+ */
+
+/**
+ * @brief  Initialize calibration with default settings
+ * @note   Selects the 4096 Hz wave, 32 periods (7.8 ms per measurement) and
+ *         the full 0-255 trim range. Change the fields before HT1382_Cal_Run
+ *         if needed.
+ * @param  Cal: Pointer to calibration
+ * @param  Handler: Pointer to an initialized HT1382 handler
+ * @param  Measure: Tick counter over reference periods
+ * @param  GetTrim: Trim read function
+ * @param  SetTrim: Trim write function
+ * @param  TickFreq: Measure tick frequency at the nominal clock (Hz)
+ * @retval HT1382_Result_t
+ *         - HT1382_OK: Operation was successful.
+ *         - HT1382_INVALID_PARAM: One of parameters is invalid.
+ */
+HT1382_Result_t
+HT1382_Cal_Init(HT1382_Cal_t *Cal, HT1382_Handler_t *Handler,
+                HT1382_CalMeasure_t Measure, HT1382_CalGetTrim_t GetTrim,
+                HT1382_CalSetTrim_t SetTrim, uint32_t TickFreq);
+
+
+/**
+ * @brief  Trim the MCU oscillator to the RTC
+ * @note   The out wave register is restored before returning, also on
+ *         failure. If the reference can not be measured, the trim is restored
+ *         too.
+ * @note   Anything timed by the MCU clock (UART, delays) is off while the
+ *         trim is being searched.
+ * @param  Cal: Pointer to calibration
+ * @param  Mode: HT1382_CAL_SEARCH or HT1382_CAL_TRACK
+ * @retval HT1382_Result_t
+ *         - HT1382_OK: Operation was successful.
+ *         - HT1382_FAIL: Failed to send or receive data, or no reference
+ *                        edges.
+ *         - HT1382_INVALID_PARAM: One of parameters is invalid.
+ */
+HT1382_Result_t
+HT1382_Cal_Run(HT1382_Cal_t *Cal, uint8_t Mode);
+
+
+/**
+ * @brief  Frequency of a reference wave
+ * @param  OutWave: HT1382_OUTWAVE_1024HZ or HT1382_OUTWAVE_4096HZ
+ * @retval Frequency in Hz, 0 for other waves
+ */
+uint16_t
+HT1382_Cal_WaveFreq(HT1382_OutWave_t OutWave);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif //! _HT1382_CAL_H_
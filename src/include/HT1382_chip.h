@@ -0,0 +1,332 @@
+/**
+ **********************************************************************************
+ * @file   HT1382_chip.h
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  Compile-time description of the supported RTC chips
+ **********************************************************************************
+ *
+ * Copyright (c) 2024 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+
+/* Define to prevent recursive inclusion ----------------------------------------*/
+#ifndef _HT1382_CHIP_H_
+#define _HT1382_CHIP_H_
+
+
+/**
+ * The driver core only uses the names below. Each chip block resolves them to
+ * constants, so selecting a chip (HT1382_CHIP in HT1382_config.h) changes the
+ * compiled code and never adds a runtime lookup or branch.
+ *
+ * To add a chip: add a HT1382_CHIP_xxx id and a block that defines every
+ * name of the HT1382 block. Register addresses and bits that the chip does
+ * not have may be left out only if the features using them are disabled
+ * by the capability macros (HT1382_CHIP_HAS_xxx).
+ */
+
+
+/* Chip Identifiers -------------------------------------------------------------*/
+#define HT1382_CHIP_HT1382              0
+#define HT1382_CHIP_DS1307              1 // DS1307, DS1338 and compatibles
+
+
+
+#if HT1382_CHIP == HT1382_CHIP_HT1382
+/**
+ ==================================================================================
+                                ##### HT1382 #####                                 
+ ==================================================================================
+ */
+
+/**
+ * @brief  The chip address on I2C BUS and the number of registers
+ */
+#define HT1382_ADDRESS                  0x68
+#define HT1382_CHIP_REG_COUNT           21
+
+/**
+ * @brief  Capabilities
+ */
+#define HT1382_CHIP_HAS_WP              1 // WP bit in ST1 guards all writes
+#define HT1382_CHIP_HAS_STATUS          1 // ST1/ST2/INT used by HT1382_Probe
+#define HT1382_CHIP_HAS_POWER           1 // LPM/OEOBM/AE/IME bits in INT
+
+/**
+ * @brief  Internal Registers Address
+ */
+#define HT1382_REG_ADDR_SECONDS         0x00
+#define HT1382_REG_ADDR_MINUTES         0x01
+#define HT1382_REG_ADDR_HOURS           0x02
+#define HT1382_REG_ADDR_DATE            0x03
+#define HT1382_REG_ADDR_MONTH           0x04
+#define HT1382_REG_ADDR_DAY             0x05
+#define HT1382_REG_ADDR_YEAR            0x06
+#define HT1382_REG_ADDR_ST1             0x07
+#define HT1382_REG_ADDR_ST2             0x08
+#define HT1382_REG_ADDR_INT             0x09
+#define HT1382_REG_ADDR_SECONDS_ALARM   0x0A
+#define HT1382_REG_ADDR_MINUTES_ALARM   0x0B
+#define HT1382_REG_ADDR_HOURS_ALARM     0x0C
+#define HT1382_REG_ADDR_DATE_ALARM      0x0D
+#define HT1382_REG_ADDR_MONTH_ALARM     0x0E
+#define HT1382_REG_ADDR_DAY_ALARM       0x0F
+#define HT1382_REG_ADDR_DT              0x10
+#define HT1382_REG_ADDR_USR1            0x11
+#define HT1382_REG_ADDR_USR2            0x12
+#define HT1382_REG_ADDR_USR3            0x13
+#define HT1382_REG_ADDR_USR4            0x14
+
+/**
+ * @brief  Register bits of Seconds register
+ */
+#define HT1382_SECONDS_CH               7
+
+/**
+ * @brief  Register bits of Hours register
+ */
+#define HT1382_HOURS_AM_PM              5
+#define HT1382_HOURS_12_24              7
+
+/**
+ * @brief  Register bits of ST1 register
+ */
+#define HT1382_ST1_WP                   7
+
+/**
+ * @brief  Register bits of ST2 register
+ */
+#define HT1382_ST2_BE                   1
+#define HT1382_ST2_AI                   2
+#define HT1382_ST2_EB                   3
+#define HT1382_ST2_EWE                  4
+#define HT1382_ST2_ARE                  7
+
+/**
+ * @brief  Register bits of INT register
+ */
+#define HT1382_INT_FO0                  0
+#define HT1382_INT_FO1                  1
+#define HT1382_INT_FO2                  2
+#define HT1382_INT_FO3                  3
+#define HT1382_INT_OEOBM                4
+#define HT1382_INT_LPM                  5
+#define HT1382_INT_AE                   6
+#define HT1382_INT_IME                  7
+
+/**
+ * @brief  Register bits of Seconds Alarm register
+ */
+#define HT1382_SECONDS_ALARM_SECEN      7
+
+/**
+ * @brief  Register bits of Minutes Alarm register
+ */
+#define HT1382_MINUTES_ALARM_MINEN      7
+
+/**
+ * @brief  Register bits of Hours Alarm register
+ */
+#define HT1382_HOURS_ALARM_HREN         7
+
+/**
+ * @brief  Register bits of Date Alarm register
+ */
+#define HT1382_DATE_ALARM_DTEN          7
+
+/**
+ * @brief  Register bits of Month Alarm register
+ */
+#define HT1382_MONTH_ALARM_MOEN         7
+
+/**
+ * @brief  Register bits of Day Alarm register
+ */
+#define HT1382_DAY_ALARM_DAYEN          7
+
+/**
+ * @brief  Register bits of DT register
+ */
+#define HT1382_DT_DT0                   0
+#define HT1382_DT_DT1                   1
+#define HT1382_DT_DT2                   2
+#define HT1382_DT_DT3                   3
+#define HT1382_DT_DT4                   4
+#define HT1382_DT_DT5                   5
+#define HT1382_DT_DT6                   6
+#define HT1382_DT_DTS                   7
+
+/**
+ * @brief  Hours register mode
+ * @note   HT1382_CHIP_HOURS_24H is ORed into the hours register on write.
+ */
+#define HT1382_CHIP_HOURS_24H           (1 << HT1382_HOURS_12_24)
+#define HT1382_CHIP_HOURS_IS_12H(REG)   (!(((REG) >> HT1382_HOURS_12_24) & 0x01))
+
+/**
+ * @brief  Out wave control (HT1382_OutWave_t values are the FO3:0 code)
+ */
+#define HT1382_CHIP_REG_OUTWAVE         HT1382_REG_ADDR_INT
+#define HT1382_CHIP_OUTWAVE_MASK        (0x0F << HT1382_INT_FO0)
+#define HT1382_CHIP_OUTWAVE_BITS(WAVE)  (((WAVE) & 0x0F) << HT1382_INT_FO0)
+#define HT1382_CHIP_OUTWAVE_VALID(WAVE) ((WAVE) <= HT1382_OUTWAVE_1_32HZ)
+
+/**
+ * @brief  Registers that never change by themselves (HT1382_ProbeBusSpeed)
+ */
+#define HT1382_CHIP_REG_STATIC          HT1382_REG_ADDR_INT
+#define HT1382_CHIP_STATIC_COUNT        (HT1382_CHIP_REG_COUNT - HT1382_REG_ADDR_INT)
+
+/**
+ * @brief  Control registers kept in the handler shadow (HT1382_CONFIG_SHADOW)
+ * @note   The shadow is filled by one burst of SHADOW_SPAN registers from
+ *         SHADOW_FIRST; ST1, ST2, INT and DT are kept.
+ */
+#define HT1382_CHIP_SHADOW_FIRST        HT1382_REG_ADDR_ST1
+#define HT1382_CHIP_SHADOW_SPAN         (HT1382_REG_ADDR_DT - HT1382_REG_ADDR_ST1 + 1)
+#define HT1382_CHIP_SHADOW_COUNT        4
+#define HT1382_CHIP_IS_SHADOW_REG(REG)  \
+  (((REG) >= HT1382_REG_ADDR_ST1 && (REG) <= HT1382_REG_ADDR_INT) || (REG) == HT1382_REG_ADDR_DT)
+#define HT1382_CHIP_SHADOW_INDEX(REG)   \
+  ((REG) == HT1382_REG_ADDR_DT ? 3 : (REG) - HT1382_REG_ADDR_ST1)
+
+
+
+#elif HT1382_CHIP == HT1382_CHIP_DS1307
+/**
+ ==================================================================================
+                                ##### DS1307 #####                                 
+ ==================================================================================
+ */
+
+/**
+ * @brief  The chip address on I2C BUS and the number of registers
+ * @note   Registers 0x08 to 0x3F are battery backed RAM.
+ */
+#define HT1382_ADDRESS                  0x68
+#define HT1382_CHIP_REG_COUNT           64
+
+/**
+ * @brief  Capabilities
+ */
+#define HT1382_CHIP_HAS_WP              0
+#define HT1382_CHIP_HAS_STATUS          0
+#define HT1382_CHIP_HAS_POWER           0
+
+/**
+ * @brief  Internal Registers Address
+ */
+#define HT1382_REG_ADDR_SECONDS         0x00
+#define HT1382_REG_ADDR_MINUTES         0x01
+#define HT1382_REG_ADDR_HOURS           0x02
+#define HT1382_REG_ADDR_DAY             0x03
+#define HT1382_REG_ADDR_DATE            0x04
+#define HT1382_REG_ADDR_MONTH           0x05
+#define HT1382_REG_ADDR_YEAR            0x06
+#define HT1382_REG_ADDR_CONTROL         0x07
+#define HT1382_REG_ADDR_RAM             0x08
+
+/**
+ * @brief  Register bits of Seconds register
+ */
+#define HT1382_SECONDS_CH               7
+
+/**
+ * @brief  Register bits of Hours register
+ */
+#define HT1382_HOURS_AM_PM              5
+#define HT1382_HOURS_12_24              6 // 1: 12-hour mode
+
+/**
+ * @brief  Register bits of Control register
+ */
+#define HT1382_CONTROL_RS0              0
+#define HT1382_CONTROL_RS1              1
+#define HT1382_CONTROL_SQWE             4
+#define HT1382_CONTROL_OUT              7
+
+/**
+ * @brief  Hours register mode
+ * @note   HT1382_CHIP_HOURS_24H is ORed into the hours register on write.
+ */
+#define HT1382_CHIP_HOURS_24H           0
+#define HT1382_CHIP_HOURS_IS_12H(REG)   (((REG) >> HT1382_HOURS_12_24) & 0x01)
+
+/**
+ * @brief  Out wave control
+ * @note   Only 1Hz, 4096Hz and 32768Hz (HT1382_OUTWAVE_32758HZ) exist. With
+ *         HT1382_OUTWAVE_DISABLE the pin is driven low.
+ */
+#define HT1382_CHIP_REG_OUTWAVE         HT1382_REG_ADDR_CONTROL
+#define HT1382_CHIP_OUTWAVE_MASK        ((1 << HT1382_CONTROL_OUT) | (1 << HT1382_CONTROL_SQWE) | \
+                                         (1 << HT1382_CONTROL_RS1) | (1 << HT1382_CONTROL_RS0))
+#define HT1382_CHIP_OUTWAVE_BITS(WAVE)  \
+  ((WAVE) == HT1382_OUTWAVE_1HZ     ? (1 << HT1382_CONTROL_SQWE) :                                \
+   (WAVE) == HT1382_OUTWAVE_4096HZ  ? (1 << HT1382_CONTROL_SQWE) | (1 << HT1382_CONTROL_RS0) :    \
+   (WAVE) == HT1382_OUTWAVE_32758HZ ? (1 << HT1382_CONTROL_SQWE) | (3 << HT1382_CONTROL_RS0) : 0)
+#define HT1382_CHIP_OUTWAVE_VALID(WAVE) \
+  ((WAVE) == HT1382_OUTWAVE_DISABLE || (WAVE) == HT1382_OUTWAVE_1HZ || \
+   (WAVE) == HT1382_OUTWAVE_4096HZ || (WAVE) == HT1382_OUTWAVE_32758HZ)
+
+/**
+ * @brief  Registers that never change by themselves (HT1382_ProbeBusSpeed)
+ */
+#define HT1382_CHIP_REG_STATIC          HT1382_REG_ADDR_CONTROL
+#define HT1382_CHIP_STATIC_COUNT        9
+
+/**
+ * @brief  Control registers kept in the handler shadow (HT1382_CONFIG_SHADOW)
+ */
+#define HT1382_CHIP_SHADOW_FIRST        HT1382_REG_ADDR_CONTROL
+#define HT1382_CHIP_SHADOW_SPAN         1
+#define HT1382_CHIP_SHADOW_COUNT        1
+#define HT1382_CHIP_IS_SHADOW_REG(REG)  ((REG) == HT1382_REG_ADDR_CONTROL)
+#define HT1382_CHIP_SHADOW_INDEX(REG)   ((REG) - HT1382_REG_ADDR_CONTROL)
+
+
+
+#else
+#error "HT1382_CHIP: unknown chip"
+#endif
+
+
+
+/**
+ ==================================================================================
+                              ##### All Chips #####                                
+ ==================================================================================
+ */
+
+/**
+ * @brief  Hour (0 ... 23) of an hours register in 12-hour or 24-hour mode
+ * @note   12 AM is hour 0 and 12 PM is hour 12. Every decoder of the hours
+ *         register uses this macro.
+ */
+#define HT1382_CHIP_HOURS_TO_DEC(REG)                                          \
+  (HT1382_CHIP_HOURS_IS_12H(REG) ?                                              \
+     (uint8_t)(((((REG) >> 4) & 0x01) * 10 + ((REG) & 0x0F)) % 12 +             \
+               (((REG) >> HT1382_HOURS_AM_PM) & 0x01) * 12) :                   \
+     (uint8_t)((((REG) >> 4) & 0x03) * 10 + ((REG) & 0x0F)))
+
+
+#endif //! _HT1382_CHIP_H_
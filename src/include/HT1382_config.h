@@ -0,0 +1,313 @@
+/**
+ **********************************************************************************
+ * @file   HT1382_config.h
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  HT1382 driver compile-time configuration
+ **********************************************************************************
+ *
+ * Copyright (c) 2024 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+
+/* Define to prevent recursive inclusion ----------------------------------------*/
+#ifndef _HT1382_CONFIG_H_
+#define _HT1382_CONFIG_H_
+
+
+/**
+ * Every option can be overridden from the compiler command line
+ * (e.g. -DHT1382_CONFIG_OUTWAVE=0). Disabled feature groups are not compiled
+ * at all, so their code, constant data and handler fields cost no flash or
+ * RAM. Groups beyond the time, out wave and power functions are disabled by
+ * default; enable the ones the application uses. Run "make" in tools/size
+ * to compare the footprint of configurations.
+ */
+
+
+/* Chip Selection ---------------------------------------------------------------*/
+/**
+ * @brief  Target chip (see HT1382_chip.h)
+ * @note   HT1382_CHIP_HT1382 or HT1382_CHIP_DS1307 (also DS1338)
+ */
+#ifndef HT1382_CHIP
+#define HT1382_CHIP               HT1382_CHIP_HT1382
+#endif
+
+#include "HT1382_chip.h"
+
+
+/* Feature Groups ---------------------------------------------------------------*/
+/**
+ * @brief  Parameter validation of public functions
+ * @note   When disabled, out of range values are written to the chip as they
+ *         are and HT1382_INVALID_PARAM is never returned.
+ * @note   1: Enable, 0: Disable
+ */
+#ifndef HT1382_CONFIG_VALIDATION
+#define HT1382_CONFIG_VALIDATION  1
+#endif
+
+/**
+ * @brief  Decode 12-hour mode in HT1382_GetDateTime
+ * @note   HT1382_SetDateTime always selects 24-hour mode. Disable it if no
+ *         other software sets the chip to 12-hour mode.
+ * @note   1: Enable, 0: Disable
+ */
+#ifndef HT1382_CONFIG_12H_DECODE
+#define HT1382_CONFIG_12H_DECODE  1
+#endif
+
+/**
+ * @brief  Out wave functions (HT1382_SetOutWave)
+ * @note   1: Enable, 0: Disable
+ */
+#ifndef HT1382_CONFIG_OUTWAVE
+#define HT1382_CONFIG_OUTWAVE     1
+#endif
+
+/**
+ * @brief  INT register and power functions (HT1382_SetIntConfig,
+ *         HT1382_EnterLowPower, ...)
+ * @note   Only available on chips with power control bits.
+ * @note   1: Enable, 0: Disable
+ */
+#ifndef HT1382_CONFIG_POWER
+#define HT1382_CONFIG_POWER       HT1382_CHIP_HAS_POWER
+#endif
+
+/**
+ * @brief  Control register shadow (HT1382_ResyncShadow)
+ * @note   When enabled, the control registers (ST1, ST2, INT and DT on
+ *         HT1382) are kept in the handler after the first access, so out wave
+ *         and INT updates are written without reading the register first, and
+ *         are not written at all when nothing changes. Call
+ *         HT1382_ResyncShadow if another master may have changed them.
+ * @note   1: Enable, 0: Disable
+ */
+#ifndef HT1382_CONFIG_SHADOW
+#define HT1382_CONFIG_SHADOW      1
+#endif
+
+/**
+ * @brief  Register image functions (HT1382_ReadImage, HT1382_WriteImage)
+ * @note   1: Enable, 0: Disable
+ */
+#ifndef HT1382_CONFIG_IMAGE
+#define HT1382_CONFIG_IMAGE       0
+#endif
+
+/**
+ * @brief  Armed time write (HT1382_ArmDateTime, HT1382_FireDateTime)
+ * @note   Adds 10 bytes to the handler and a busy flag store to every call.
+ * @note   1: Enable, 0: Disable
+ */
+#ifndef HT1382_CONFIG_ARMED
+#define HT1382_CONFIG_ARMED       0
+#endif
+
+/**
+ * @brief  Batched register queries (HT1382_ReadQuery)
+ * @note   1: Enable, 0: Disable
+ */
+#ifndef HT1382_CONFIG_QUERY
+#define HT1382_CONFIG_QUERY       0
+#endif
+
+/**
+ * @brief  Raw register write (HT1382_WriteRaw)
+ * @note   Sends frames built at compile time by HT1382_TIME_IMAGE,
+ *         HT1382_OUTWAVE_IMAGE and HT1382_INT_IMAGE.
+ * @note   1: Enable, 0: Disable
+ */
+#ifndef HT1382_CONFIG_RAW
+#define HT1382_CONFIG_RAW         0
+#endif
+
+/**
+ * @brief  Time register mirror (HT1382_Mirror_t)
+ * @note   When the port keeps the time registers in RAM (e.g. the STM32 port
+ *         with HT1382_MIRROR_HTIM), HT1382_GetDateTime decodes the latest
+ *         mirrored read without taking the lock or using the bus.
+ * @note   Adds a pointer to the handler.
+ * @note   1: Enable, 0: Disable
+ */
+#ifndef HT1382_CONFIG_MIRROR
+#define HT1382_CONFIG_MIRROR      0
+#endif
+
+/**
+ * @brief  Status functions (HT1382_Probe, HT1382_HealthCheck)
+ * @note   Only available on chips with status registers.
+ * @note   1: Enable, 0: Disable
+ */
+#ifndef HT1382_CONFIG_PROBE
+#define HT1382_CONFIG_PROBE       0
+#endif
+
+/**
+ * @brief  Bus speed probe (HT1382_ProbeBusSpeed)
+ * @note   1: Enable, 0: Disable
+ */
+#ifndef HT1382_CONFIG_BUS_PROBE
+#define HT1382_CONFIG_BUS_PROBE   0
+#endif
+
+/**
+ * @brief  Lock/Unlock platform functions (multi-task use)
+ * @note   When disabled, Platform.Lock and Platform.Unlock are never called.
+ * @note   When enabled, Platform.Lock and Platform.Unlock must be linked or
+ *         NULL: zero the handler before linking (HT1382_Handler_t H = {0}).
+ * @note   1: Enable, 0: Disable
+ */
+#ifndef HT1382_CONFIG_LOCK
+#define HT1382_CONFIG_LOCK        0
+#endif
+
+
+/* Functionality Options --------------------------------------------------------*/
+/**
+ * @brief  Coalesce concurrent HT1382_GetDateTime calls (single-flight)
+ * @note   When enabled and Lock/Unlock are linked, callers that block on the
+ *         lock while another caller's read is in flight reuse the result of
+ *         that read instead of issuing their own bus transaction.
+ * @note   Requires HT1382_CONFIG_LOCK.
+ * @note   1: Enable, 0: Disable
+ */
+#ifndef HT1382_SINGLE_FLIGHT
+#define HT1382_SINGLE_FLIGHT      0
+#endif
+
+/**
+ * @brief  Verify time snapshots read at second 59
+ * @note   HT1382_GetDateTime reads the time with a single 7-byte burst, which
+ *         the chip serves from a buffer latched at the START condition, so the
+ *         result is coherent and callers do not need "read twice until equal"
+ *         loops. Enable this only for ports whose Receive function splits a
+ *         read into several bus transactions (e.g. some USB-I2C bridges). It
+ *         adds a 1-byte seconds read when seconds is 59, and one more burst
+ *         read if the minute rolled over in between.
+ * @note   1: Enable, 0: Disable
+ */
+#ifndef HT1382_SNAPSHOT_CHECK
+#define HT1382_SNAPSHOT_CHECK     0
+#endif
+
+/**
+ * @brief  Probe the chip in HT1382_Init
+ * @note   When enabled, HT1382_Init fails if the chip does not answer and
+ *         stores the decoded status in Handler->Status.
+ * @note   Requires HT1382_CONFIG_PROBE.
+ * @note   1: Enable, 0: Disable
+ */
+#ifndef HT1382_INIT_PROBE
+#define HT1382_INIT_PROBE         0
+#endif
+
+/**
+ * @brief  Largest gap of unrequested registers HT1382_ReadQuery reads over
+ * @note   A new span costs a pointer write and a read header (START, slave
+ *         address and register pointer, then a repeated slave address), about
+ *         3 bytes on the wire, so reading over up to 3 registers is cheaper.
+ *         Use a larger value on ports where each Send/Receive call has a high
+ *         fixed cost (e.g. Linux i2c-dev).
+ */
+#ifndef HT1382_QUERY_MERGE_GAP
+#define HT1382_QUERY_MERGE_GAP    3
+#endif
+
+/**
+ * @brief  Memory barrier between the sequence and buffer accesses of
+ *         HT1382_Mirror_t
+ * @note   A compiler barrier is enough on single-core MCUs; hosts and
+ *         multi-core chips need a hardware barrier.
+ */
+#ifndef HT1382_MIRROR_BARRIER
+#if defined(__GNUC__) && !defined(__AVR__)
+#define HT1382_MIRROR_BARRIER()   __sync_synchronize()
+#elif defined(__GNUC__)
+#define HT1382_MIRROR_BARRIER()   __asm__ __volatile__("" ::: "memory")
+#else
+#define HT1382_MIRROR_BARRIER()
+#endif
+#endif
+
+/**
+ * @brief  HT1382_Probe options used by HT1382_Init (see HT1382_PROBE_xxx)
+ */
+#ifndef HT1382_INIT_PROBE_OPTIONS
+#define HT1382_INIT_PROBE_OPTIONS HT1382_PROBE_RESTART_OSC
+#endif
+
+/**
+ * @brief  Number of read-backs HT1382_ProbeBusSpeed compares at each rate
+ * @note   More reads give more confidence and take longer.
+ */
+#ifndef HT1382_BUS_PROBE_READS
+#define HT1382_BUS_PROBE_READS    4
+#endif
+
+
+/* Check Configuration ----------------------------------------------------------*/
+#if HT1382_SINGLE_FLIGHT && !HT1382_CONFIG_LOCK
+#error "HT1382_SINGLE_FLIGHT requires HT1382_CONFIG_LOCK"
+#endif
+
+#if HT1382_CONFIG_POWER && !HT1382_CHIP_HAS_POWER
+#error "HT1382_CONFIG_POWER is not supported by the selected chip"
+#endif
+
+#if HT1382_CONFIG_PROBE && !HT1382_CHIP_HAS_STATUS
+#error "HT1382_CONFIG_PROBE is not supported by the selected chip"
+#endif
+
+#if HT1382_CONFIG_MIRROR && !HT1382_CONFIG_LOCK
+#error "HT1382_CONFIG_MIRROR requires HT1382_CONFIG_LOCK"
+#endif
+
+#if HT1382_INIT_PROBE && !HT1382_CONFIG_PROBE
+#error "HT1382_INIT_PROBE requires HT1382_CONFIG_PROBE"
+#endif
+
+
+/* Constant Data ----------------------------------------------------------------*/
+/**
+ * @brief  Place constant tables in flash
+ * @note   On AVR, const data is copied to RAM at startup unless it is marked
+ *         PROGMEM and read with the pgm_read_xxx functions. Tables of the
+ *         library are declared with HT1382_CONST and read with
+ *         HT1382_READ_BYTE/HT1382_READ_WORD so they stay in flash there and
+ *         are plain const data everywhere else.
+ */
+#if defined(__AVR__)
+#include <avr/pgmspace.h>
+#define HT1382_CONST              PROGMEM
+#define HT1382_READ_BYTE(ADDR)    pgm_read_byte(ADDR)
+#define HT1382_READ_WORD(ADDR)    pgm_read_word(ADDR)
+#else
+#define HT1382_CONST
+#define HT1382_READ_BYTE(ADDR)    (*(const uint8_t *)(ADDR))
+#define HT1382_READ_WORD(ADDR)    (*(const uint16_t *)(ADDR))
+#endif
+
+
+#endif //! _HT1382_CONFIG_H_
@@ -0,0 +1,134 @@
+/**
+ **********************************************************************************
+ * @file   HT1382_decode.h
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  Bulk decode of raw HT1382 time registers (host side)
+ **********************************************************************************
+ *
+ * Copyright (c) 2024 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+
+/**
+ * A record is the 7 time registers (0x00-0x06) exactly as read from the chip,
+ * e.g. the Buffer of HT1382_GetDateTime or the first 7 bytes of a register
+ * image. Records are packed back to back without padding.
+ *
+ * HT1382_Decode_Bulk converts them to Unix time and validates them in the same
+ * pass: every BCD digit, every field range, unused register bits and the day
+ * of month against the month length. On x86 an SSE2 or AVX2 implementation is
+ * selected at runtime; other hosts use the portable scalar code. All
+ * implementations give identical results.
+ */
+
+/* Define to prevent recursive inclusion ----------------------------------------*/
+#ifndef _HT1382_DECODE_H_
+#define _HT1382_DECODE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* Includes ---------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stddef.h>
+#include "HT1382.h"
+
+
+/* Exported Constants -----------------------------------------------------------*/
+/**
+ * @brief  Size of one raw record in bytes
+ */
+#define HT1382_DECODE_RECORD_SIZE 7
+
+/**
+ * @brief  Epoch stored for records that fail validation
+ */
+#define HT1382_DECODE_INVALID     0xFFFFFFFFUL
+
+
+/* Exported Data Types ----------------------------------------------------------*/
+/**
+ * @brief  Decoder implementation
+ */
+typedef enum HT1382_DecodeImpl_e
+{
+  HT1382_DECODE_AUTO    = 0,  // Fastest supported by the CPU
+  HT1382_DECODE_SCALAR  = 1,  // Portable C
+  HT1382_DECODE_SSE2    = 2,  // x86 SSE2, 2 records per step
+  HT1382_DECODE_AVX2    = 3,  // x86 AVX2, 4 records per step
+} HT1382_DecodeImpl_t;
+
+
+
+/**
+ ==================================================================================
+                            ##### Decode Functions #####                          
+ ==================================================================================
+ */
+
+/**
+ * @brief  Decode one raw record to Unix time
+ * @note   12-hour records are accepted (12 AM is 00:00, 12 PM is 12:00). The CH
+ *         bit of the seconds register is ignored.
+ * @param  Record: Pointer to HT1382_DECODE_RECORD_SIZE bytes
+ * @param  Epoch: Pointer to Unix time, HT1382_DECODE_INVALID if invalid
+ * @retval HT1382_Result_t
+ *         - HT1382_OK: Operation was successful.
+ *         - HT1382_INVALID_PARAM: The record is not a valid date and time.
+ */
+HT1382_Result_t
+HT1382_Decode_Record(const uint8_t *Record, uint32_t *Epoch);
+
+
+/**
+ * @brief  Decode an array of raw records to Unix time
+ * @note   Records in 12-hour mode are valid but are decoded by the scalar code.
+ * @param  Records: Pointer to Count * HT1382_DECODE_RECORD_SIZE bytes
+ * @param  Count: Number of records
+ * @param  Epochs: Pointer to Count Unix times, HT1382_DECODE_INVALID for
+ *                 records that are not valid
+ * @retval Number of invalid records
+ */
+size_t
+HT1382_Decode_Bulk(const uint8_t *Records, size_t Count, uint32_t *Epochs);
+
+
+/**
+ * @brief  Select the implementation used by HT1382_Decode_Bulk
+ * @param  Impl: Implementation, HT1382_DECODE_AUTO for runtime detection
+ * @retval The selected implementation. It differs from Impl if Impl is not
+ *         supported by the CPU or the build (then the fastest supported one is
+ *         used).
+ */
+HT1382_DecodeImpl_t
+HT1382_Decode_SetImpl(HT1382_DecodeImpl_t Impl);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif //! _HT1382_DECODE_H_
@@ -0,0 +1,199 @@
+/**
+ **********************************************************************************
+ * @file   HT1382_stamp.h
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  HT1382 timestamp stream codec for event logs
+ **********************************************************************************
+ *
+ * Copyright (c) 2024 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+
+
+/**
+ * Stream format
+ *
+ * Every log record gets one stamp record, written in front of (or next to)
+ * the record payload. Stamps are Unix times with the 1 second resolution of
+ * the RTC.
+ *
+ *   Delta (1-4 bytes, bit 0 of the first byte is 0):
+ *     LEB128 varint of ZigZag(Epoch - PreviousEpoch) << 1. Deltas of
+ *     -32..31 s take 1 byte, -4096..4095 s take 2 bytes.
+ *
+ *   Keyframe (5 bytes, first byte HT1382_STAMP_KEY_TAG):
+ *     [0]    HT1382_STAMP_KEY_TAG
+ *     [1..4] Unix time, little-endian
+ *
+ * The first stamp, every Interval-th stamp, stamps after HT1382_StampEnc_Key
+ * and deltas that would need 5 bytes are keyframes. Decoding can start at
+ * any keyframe, e.g. at the first stamp of a flash page when the writer
+ * calls HT1382_StampEnc_Key for every new page.
+ *
+ * Other first bytes with bit 0 set are reserved.
+ */
+
+/* Define to prevent recursive inclusion ----------------------------------------*/
+#ifndef _HT1382_STAMP_H_
+#define _HT1382_STAMP_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* Includes ---------------------------------------------------------------------*/
+#include <stdint.h>
+#include "HT1382.h"
+
+
+/* Exported Constants -----------------------------------------------------------*/
+#define HT1382_STAMP_KEY_TAG      0x01
+#define HT1382_STAMP_KEY_SIZE     5
+#define HT1382_STAMP_RECORD_MAX   5     // largest stamp record in bytes
+
+/**
+ * @brief  Check if a stamp record is a keyframe
+ * @param  RECORD: Pointer to the first byte of the stamp record
+ */
+#define HT1382_STAMP_IS_KEY(RECORD)   ((RECORD)[0] == HT1382_STAMP_KEY_TAG)
+
+
+/* Exported Data Types ----------------------------------------------------------*/
+/**
+ * @brief  Stamp encoder data type
+ */
+typedef struct HT1382_StampEnc_s
+{
+  uint16_t  Interval;     // stamps per keyframe, 0: only forced keyframes
+  uint16_t  Count;        // stamps since the last keyframe
+  uint8_t   KeyPending;   // next stamp is a keyframe
+  uint32_t  Epoch;        // time of the last stamp
+
+  // PutRegs: registers 1..6 of the last call and Unix time of their second 0
+  uint8_t   MinuteValid;
+  uint8_t   MinuteRegs[6];
+  uint32_t  MinuteEpoch;
+} HT1382_StampEnc_t;
+
+/**
+ * @brief  Stamp decoder data type
+ */
+typedef struct HT1382_StampDec_s
+{
+  uint8_t   Synced;       // a keyframe was decoded
+  uint32_t  Epoch;        // time of the last stamp
+} HT1382_StampDec_t;
+
+
+
+/**
+ ==================================================================================
+                           ##### Encoder Functions #####                          
+ ==================================================================================
+ */
+
+/**
+ * @brief  Initialize stamp encoder
+ * @note   The first stamp is a keyframe.
+ * @param  Enc: Pointer to encoder
+ * @param  Interval: Stamps per keyframe (0: only the first stamp and stamps
+ *                   after HT1382_StampEnc_Key)
+ * @retval None
+ */
+void
+HT1382_StampEnc_Init(HT1382_StampEnc_t *Enc, uint16_t Interval);
+
+
+/**
+ * @brief  Make the next stamp a keyframe (e.g. at the start of a flash page)
+ * @param  Enc: Pointer to encoder
+ * @retval None
+ */
+void
+HT1382_StampEnc_Key(HT1382_StampEnc_t *Enc);
+
+
+/**
+ * @brief  Encode a stamp from Unix time
+ * @param  Enc: Pointer to encoder
+ * @param  Epoch: Unix time
+ * @param  Out: Output, at least HT1382_STAMP_RECORD_MAX bytes
+ * @retval Number of bytes written to Out
+ */
+uint8_t
+HT1382_StampEnc_Put(HT1382_StampEnc_t *Enc, uint32_t Epoch, uint8_t *Out);
+
+
+/**
+ * @brief  Encode a stamp from the raw time registers
+ * @note   Only the seconds register is decoded while registers 1..6 are the
+ *         same as in the last call, i.e. at most once per minute the date is
+ *         converted. The registers are not validated.
+ * @param  Enc: Pointer to encoder
+ * @param  Regs: The 7 time registers, Regs[n] holds register n (e.g. the
+ *               Regs of an HT1382_Image_t or a time query)
+ * @param  Out: Output, at least HT1382_STAMP_RECORD_MAX bytes
+ * @retval Number of bytes written to Out
+ */
+uint8_t
+HT1382_StampEnc_PutRegs(HT1382_StampEnc_t *Enc, const uint8_t *Regs, uint8_t *Out);
+
+
+
+/**
+ ==================================================================================
+                           ##### Decoder Functions #####                          
+ ==================================================================================
+ */
+
+/**
+ * @brief  Initialize stamp decoder
+ * @note   Decoding must start at a keyframe.
+ * @param  Dec: Pointer to decoder
+ * @retval None
+ */
+void
+HT1382_StampDec_Init(HT1382_StampDec_t *Dec);
+
+
+/**
+ * @brief  Decode one stamp
+ * @param  Dec: Pointer to decoder
+ * @param  Data: Pointer to the stamp record
+ * @param  Len: Number of bytes available at Data
+ * @param  Epoch: Pointer to Unix time of the stamp
+ * @retval Number of bytes of the stamp record, 0 if it is truncated, reserved
+ *         or a delta before the first keyframe
+ */
+uint8_t
+HT1382_StampDec_Get(HT1382_StampDec_t *Dec, const uint8_t *Data, uint16_t Len,
+                    uint32_t *Epoch);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif //! _HT1382_STAMP_H_
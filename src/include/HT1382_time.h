@@ -0,0 +1,239 @@
+/**
+ **********************************************************************************
+ * @file   HT1382_time.h
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  HT1382 system time module
+ *         Functionalities of the this file:
+ *          + Unix time conversion of HT1382_DateTime_t
+ *          + RTC time extrapolated from a monotonic tick
+ *          + newlib _gettimeofday and avr-libc system time hooks
+ **********************************************************************************
+ *
+ * Copyright (c) 2024 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+
+/* Define to prevent recursive inclusion ----------------------------------------*/
+#ifndef _HT1382_TIME_H_
+#define _HT1382_TIME_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* Includes ---------------------------------------------------------------------*/
+#include <stdint.h>
+#include "HT1382.h"
+
+
+/* Functionality Options --------------------------------------------------------*/
+/**
+ * @brief  Provide the newlib _gettimeofday syscall (time(), gettimeofday())
+ * @note   1: Enable, 0: Disable
+ */
+#ifndef HT1382_TIME_NEWLIB
+#define HT1382_TIME_NEWLIB        0
+#endif
+
+/**
+ * @brief  Provide HT1382_Time_SyncAvrLibc to load the avr-libc system time
+ * @note   1: Enable, 0: Disable
+ */
+#ifndef HT1382_TIME_AVRLIBC
+#define HT1382_TIME_AVRLIBC       0
+#endif
+
+
+/* Exported Constants -----------------------------------------------------------*/
+/**
+ * @brief  Unix time of 2000-01-01 00:00:00 (HT1382 year 0)
+ */
+#define HT1382_TIME_EPOCH_2000    946684800UL
+
+
+/* Exported Data Types ----------------------------------------------------------*/
+/**
+ * @brief  Function type for reading a free-running monotonic tick counter.
+ * @note   The counter may wrap at 2^32.
+ * @retval Current tick count
+ */
+typedef uint32_t (*HT1382_TimeGetTick_t)(void);
+
+/**
+ * @brief  Time base data type
+ * @note   The RTC is read once by HT1382_Time_Sync; after that the time is
+ *         extrapolated from GetTick. If ResyncPeriod is not zero, the RTC is
+ *         read again when that many seconds have passed since the last sync.
+ * @note   Not reentrant: do not share one time base between an ISR and the
+ *         main loop without masking interrupts.
+ */
+typedef struct HT1382_Time_s
+{
+  HT1382_Handler_t     *Handler;
+  HT1382_TimeGetTick_t GetTick;
+  uint32_t             TickFreq;      // GetTick frequency (Hz)
+  uint32_t             ResyncPeriod;  // seconds, 0: never resync
+
+  uint32_t             RefEpoch;      // Unix time at RefTick
+  uint32_t             RefTick;
+  uint32_t             SyncEpoch;     // Unix time of the last RTC read
+  uint8_t              Synced;
+} HT1382_Time_t;
+
+
+/* Exported Variables -----------------------------------------------------------*/
+/**
+ * @brief  Days before the first day of each month of a non-leap year, the
+ *         last entry is the length of the year (also used by HT1382_tz.c and
+ *         HT1382_decode.c)
+ * @note   Declared with HT1382_CONST: read it with HT1382_READ_WORD.
+ */
+extern const uint16_t HT1382_Time_DaysBeforeMonth[13] HT1382_CONST;
+
+
+
+/**
+ ==================================================================================
+                          ##### Conversion Functions #####                        
+ ==================================================================================
+ */
+
+/**
+ * @brief  Convert date and time to Unix time
+ * @note   WeekDay is ignored.
+ * @param  DateTime: pointer to date and time value structure (Year 0 = 2000)
+ * @retval Unix time (seconds since 1970-01-01 00:00:00)
+ */
+uint32_t
+HT1382_Time_ToEpoch(const HT1382_DateTime_t *DateTime);
+
+
+/**
+ * @brief  Convert Unix time to date and time
+ * @note   WeekDay is 1 for Sunday ... 7 for Saturday.
+ * @param  Epoch: Unix time, from 2000-01-01 to 2099-12-31
+ * @param  DateTime: pointer to date and time value structure
+ * @retval HT1382_Result_t
+ *         - HT1382_OK: Operation was successful.
+ *         - HT1382_INVALID_PARAM: Epoch is out of the RTC range.
+ */
+HT1382_Result_t
+HT1382_Time_FromEpoch(uint32_t Epoch, HT1382_DateTime_t *DateTime);
+
+
+
+/**
+ ==================================================================================
+                          ##### Time Base Functions #####                         
+ ==================================================================================
+ */
+
+/**
+ * @brief  Initialize time base
+ * @param  Time: Pointer to time base
+ * @param  Handler: Pointer to an initialized HT1382 handler
+ * @param  GetTick: Monotonic tick source
+ * @param  TickFreq: Tick frequency (Hz)
+ * @retval HT1382_Result_t
+ *         - HT1382_OK: Operation was successful.
+ *         - HT1382_INVALID_PARAM: One of parameters is invalid.
+ */
+HT1382_Result_t
+HT1382_Time_Init(HT1382_Time_t *Time, HT1382_Handler_t *Handler,
+                 HT1382_TimeGetTick_t GetTick, uint32_t TickFreq);
+
+
+/**
+ * @brief  Read the RTC and rebase the time base on it
+ * @param  Time: Pointer to time base
+ * @param  WaitEdge: If not zero, poll the seconds register until it changes
+ *                   so the sub-second phase is known (takes up to 1 second).
+ * @retval HT1382_Result_t
+ *         - HT1382_OK: Operation was successful.
+ *         - HT1382_FAIL: Failed to send or receive data.
+ */
+HT1382_Result_t
+HT1382_Time_Sync(HT1382_Time_t *Time, uint8_t WaitEdge);
+
+
+/**
+ * @brief  Get current time without touching the bus
+ * @note   Syncs first if the time base was never synced or ResyncPeriod
+ *         has passed.
+ * @param  Time: Pointer to time base
+ * @param  Seconds: Unix time
+ * @param  MicroSeconds: Sub-second part (can be NULL)
+ * @retval HT1382_Result_t
+ *         - HT1382_OK: Operation was successful.
+ *         - HT1382_FAIL: Failed to send or receive data.
+ */
+HT1382_Result_t
+HT1382_Time_Get(HT1382_Time_t *Time, uint32_t *Seconds, uint32_t *MicroSeconds);
+
+
+/**
+ * @brief  Write Unix time to the RTC and rebase the time base on it
+ * @param  Time: Pointer to time base
+ * @param  Epoch: Unix time
+ * @retval HT1382_Result_t
+ *         - HT1382_OK: Operation was successful.
+ *         - HT1382_FAIL: Failed to send or receive data.
+ *         - HT1382_INVALID_PARAM: Epoch is out of the RTC range.
+ */
+HT1382_Result_t
+HT1382_Time_Set(HT1382_Time_t *Time, uint32_t Epoch);
+
+
+/**
+ * @brief  Select the time base used by the C library hooks
+ * @param  Time: Pointer to time base (NULL to detach)
+ * @retval None
+ */
+void
+HT1382_Time_SetSystem(HT1382_Time_t *Time);
+
+
+#if HT1382_TIME_AVRLIBC
+/**
+ * @brief  Load the avr-libc system time from the time base
+ * @note   avr-libc time() counts with system_tick(), which the application
+ *         calls from a 1 Hz interrupt. The SQW/OUT pin of HT1382 configured
+ *         with HT1382_OUTWAVE_1HZ can drive that interrupt, so avr-libc time
+ *         stays locked to the RTC crystal.
+ * @param  Time: Pointer to time base
+ * @retval HT1382_Result_t
+ *         - HT1382_OK: Operation was successful.
+ *         - HT1382_FAIL: Failed to send or receive data.
+ */
+HT1382_Result_t
+HT1382_Time_SyncAvrLibc(HT1382_Time_t *Time);
+#endif
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif //! _HT1382_TIME_H_
@@ -0,0 +1,162 @@
+/**
+ **********************************************************************************
+ * @file   HT1382_trace.h
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  HT1382 bus transaction trace recorder
+ *         Functionalities of the this file:
+ *          + Record Send/Receive transactions into a ring buffer
+ *          + Export the ring in the binary trace format
+ **********************************************************************************
+ *
+ * Copyright (c) 2024 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+
+/**
+ * Trace format (all multi-byte fields little-endian)
+ *
+ *   File header (8 bytes):
+ *     [0..3] Magic "HTTR"
+ *     [4]    Version (HT1382_TRACE_VERSION)
+ *     [5]    Reserved (0)
+ *     [6..7] Number of records dropped because the ring was full
+ *
+ *   Record (7 + Len bytes):
+ *     [0]    bit 7: direction (0: Send, 1: Receive)
+ *            bit 0..6: negated platform result (0: success)
+ *     [1..4] Timestamp from the GetTick callback, taken before the transfer
+ *     [5]    Register: for Send the register pointer byte, for Receive the
+ *            register the chip pointer is at
+ *     [6]    Len: number of data bytes that follow (for Send without the
+ *            register pointer byte)
+ *     [7..]  Data
+ */
+
+/* Define to prevent recursive inclusion ----------------------------------------*/
+#ifndef _HT1382_TRACE_H_
+#define _HT1382_TRACE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* Includes ---------------------------------------------------------------------*/
+#include <stdint.h>
+#include "HT1382.h"
+
+
+/* Exported Constants -----------------------------------------------------------*/
+#define HT1382_TRACE_VERSION          1
+#define HT1382_TRACE_HEADER_SIZE      8
+#define HT1382_TRACE_RECORD_SIZE      7     // record size without data
+#define HT1382_TRACE_DIR_RECEIVE      0x80
+#define HT1382_TRACE_RESULT_MASK      0x7F
+
+
+/* Exported Data Types ----------------------------------------------------------*/
+/**
+ * @brief  Function type for reading the trace timestamp (e.g. microseconds)
+ */
+typedef uint32_t (*HT1382_TraceGetTick_t)(void);
+
+/**
+ * @brief  Trace recorder data type
+ * @note   Only one handler can be traced at a time because the platform
+ *         callbacks carry no context.
+ */
+typedef struct HT1382_Trace_s
+{
+  uint8_t                       *Buffer;
+  uint16_t                      Size;
+  uint16_t                      Head;     // offset of the oldest record
+  uint16_t                      Used;     // bytes used in the ring
+  uint16_t                      Dropped;  // records overwritten
+  HT1382_TraceGetTick_t         GetTick;
+  HT1382_PlatformSendReceive_t  Send;     // wrapped platform functions
+  HT1382_PlatformSendReceive_t  Receive;
+  uint8_t                       Pointer;  // register pointer of the chip
+} HT1382_Trace_t;
+
+
+
+/**
+ ==================================================================================
+                            ##### Trace Functions #####                           
+ ==================================================================================
+ */
+
+/**
+ * @brief  Start recording the bus transactions of a handler
+ * @param  Trace: Pointer to trace recorder
+ * @param  Handler: Pointer to handler (Send/Receive must be linked)
+ * @param  Buffer: Ring buffer memory
+ * @param  Size: Ring buffer size in bytes
+ * @param  GetTick: Timestamp source (can be NULL)
+ * @retval HT1382_Result_t
+ *         - HT1382_OK: Operation was successful.
+ *         - HT1382_INVALID_PARAM: One of parameters is invalid or another
+ *                                 handler is being traced.
+ */
+HT1382_Result_t
+HT1382_Trace_Start(HT1382_Trace_t *Trace, HT1382_Handler_t *Handler,
+                   uint8_t *Buffer, uint16_t Size, HT1382_TraceGetTick_t GetTick);
+
+
+/**
+ * @brief  Stop recording and restore the platform functions of the handler
+ * @param  Trace: Pointer to trace recorder
+ * @param  Handler: Pointer to handler
+ * @retval None
+ */
+void
+HT1382_Trace_Stop(HT1382_Trace_t *Trace, HT1382_Handler_t *Handler);
+
+
+/**
+ * @brief  Discard all recorded transactions
+ * @param  Trace: Pointer to trace recorder
+ * @retval None
+ */
+void
+HT1382_Trace_Clear(HT1382_Trace_t *Trace);
+
+
+/**
+ * @brief  Export the recorded transactions in the trace format
+ * @note   Records that do not fit in Out are left out (oldest first kept).
+ * @param  Trace: Pointer to trace recorder
+ * @param  Out: Output buffer
+ * @param  OutSize: Output buffer size (at least HT1382_TRACE_HEADER_SIZE)
+ * @retval Number of bytes written to Out
+ */
+uint16_t
+HT1382_Trace_Export(const HT1382_Trace_t *Trace, uint8_t *Out, uint16_t OutSize);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif //! _HT1382_TRACE_H_
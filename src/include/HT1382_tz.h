@@ -0,0 +1,176 @@
+/**
+ **********************************************************************************
+ * @file   HT1382_tz.h
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  HT1382 local time (time zone and DST) module
+ **********************************************************************************
+ *
+ * Copyright (c) 2024 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+
+
+/**
+ * A zone is a standard UTC offset and, optionally, a pair of yearly DST
+ * transitions in the POSIX TZ form "Mm.w.d/time" (month, week with 5 for the
+ * last one, weekday). Zone tables are generated by tools/tz/tzgen.py from
+ * IANA zone names or POSIX TZ strings and are placed in flash with
+ * HT1382_CONST, so nothing is parsed, allocated or cached at runtime.
+ *
+ * A conversion computes the two transition instants of the year in closed
+ * form: the cost is the same for every date and every zone. Local time is
+ * handled as "local epoch", the Unix time a UTC clock would show at the same
+ * wall clock reading, so HT1382_Time_FromEpoch turns it into date and time.
+ *
+ * A table holds the rule currently in force for a zone. Instants from
+ * before the rule took effect (e.g. before 2007 for US zones) use it too.
+ */
+
+/* Define to prevent recursive inclusion ----------------------------------------*/
+#ifndef _HT1382_TZ_H_
+#define _HT1382_TZ_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* Includes ---------------------------------------------------------------------*/
+#include <stdint.h>
+#include "HT1382.h"
+#include "HT1382_time.h"
+
+
+/* Exported Constants -----------------------------------------------------------*/
+/**
+ * @brief  Instant selected for wall clock times that occur twice (end of
+ *         DST) or never (start of DST)
+ */
+#define HT1382_TZ_EARLIER         0
+#define HT1382_TZ_LATER           1
+
+
+/* Exported Data Types ----------------------------------------------------------*/
+/**
+ * @brief  Yearly transition rule
+ */
+typedef struct HT1382_TzRule_s
+{
+  uint8_t   Month;    // 1 ... 12
+  uint8_t   Week;     // 1 ... 4, 5: last week of the month
+  uint8_t   WeekDay;  // 1: Sunday ... 7: Saturday
+  int16_t   Minute;   // wall clock time of the transition in minutes after
+                      // 00:00 of that day (can be negative or over 1440)
+} HT1382_TzRule_t;
+
+/**
+ * @brief  Zone data type (see tools/tz/tzgen.py)
+ * @note   StdOffset == DstOffset for zones without DST; Start and End are
+ *         then ignored.
+ */
+typedef struct HT1382_TzZone_s
+{
+  int16_t         StdOffset;  // standard time offset in minutes east of UTC
+  int16_t         DstOffset;  // DST offset in minutes east of UTC
+  HT1382_TzRule_t Start;      // standard time to DST, at standard wall clock
+  HT1382_TzRule_t End;        // DST to standard time, at DST wall clock
+} HT1382_TzZone_t;
+
+
+
+/**
+ ==================================================================================
+                          ##### Conversion Functions #####                        
+ ==================================================================================
+ */
+
+/**
+ * @brief  Check if DST is in effect
+ * @param  Zone: Pointer to zone (may be in flash, see HT1382_CONST)
+ * @param  Epoch: Unix time, from 2000-01-01 to 2099-12-31
+ * @retval 1: DST, 0: standard time
+ */
+uint8_t
+HT1382_Tz_IsDst(const HT1382_TzZone_t *Zone, uint32_t Epoch);
+
+
+/**
+ * @brief  Convert Unix time to local epoch
+ * @param  Zone: Pointer to zone (may be in flash, see HT1382_CONST)
+ * @param  Epoch: Unix time, from 2000-01-01 to 2099-12-31
+ * @param  IsDst: Pointer to DST flag (can be NULL)
+ * @retval Local epoch
+ */
+uint32_t
+HT1382_Tz_ToLocal(const HT1382_TzZone_t *Zone, uint32_t Epoch, uint8_t *IsDst);
+
+
+/**
+ * @brief  Convert local epoch to Unix time
+ * @param  Zone: Pointer to zone (may be in flash, see HT1382_CONST)
+ * @param  Local: Local epoch
+ * @param  Fold: HT1382_TZ_EARLIER or HT1382_TZ_LATER
+ * @retval Unix time
+ */
+uint32_t
+HT1382_Tz_ToUtc(const HT1382_TzZone_t *Zone, uint32_t Local, uint8_t Fold);
+
+
+/**
+ * @brief  Convert UTC date and time (e.g. read from the RTC) to local time
+ * @param  Zone: Pointer to zone (may be in flash, see HT1382_CONST)
+ * @param  Utc: pointer to UTC date and time
+ * @param  Local: pointer to local date and time
+ * @param  IsDst: Pointer to DST flag (can be NULL)
+ * @retval HT1382_Result_t
+ *         - HT1382_OK: Operation was successful.
+ *         - HT1382_INVALID_PARAM: Local time is out of the RTC range.
+ */
+HT1382_Result_t
+HT1382_Tz_DateTimeToLocal(const HT1382_TzZone_t *Zone,
+                          const HT1382_DateTime_t *Utc,
+                          HT1382_DateTime_t *Local, uint8_t *IsDst);
+
+
+/**
+ * @brief  Convert local date and time to UTC (e.g. to set the RTC)
+ * @param  Zone: Pointer to zone (may be in flash, see HT1382_CONST)
+ * @param  Local: pointer to local date and time
+ * @param  Fold: HT1382_TZ_EARLIER or HT1382_TZ_LATER
+ * @param  Utc: pointer to UTC date and time
+ * @retval HT1382_Result_t
+ *         - HT1382_OK: Operation was successful.
+ *         - HT1382_INVALID_PARAM: UTC time is out of the RTC range.
+ */
+HT1382_Result_t
+HT1382_Tz_DateTimeToUtc(const HT1382_TzZone_t *Zone,
+                        const HT1382_DateTime_t *Local, uint8_t Fold,
+                        HT1382_DateTime_t *Utc);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif //! _HT1382_TZ_H_
@@ -0,0 +1,339 @@
+/**
+ **********************************************************************************
+ * @file   main.c
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  Host simulation of the HT1382_cal.c control loop
+ **********************************************************************************
+ *
+ * Copyright (c) 2024 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+
+
+/**
+ * Usage: ht1382-cal-sim [--parts N] [--seed S]
+ *
+ * Runs the real HT1382_cal.c and HT1382.c against a RAM model of the RTC and
+ * a model of the ATmega RC oscillator:
+ *
+ *   f = 8 MHz * Part * 2^((OSCCAL - 128) / 128) * (1 + TempCo * (T - 25))
+ *
+ * where Part is the process spread (+-10 %), each OSCCAL step is about
+ * 0.54 % with a small per-step ripple and TempCo is 0.1 %/C. The reference
+ * has a +20 ppm crystal error and every capture has +-1 tick of jitter.
+ * Measurements start at a random phase of the reference, so one costs
+ * Periods + U(0,1) reference periods.
+ *
+ * For each reference wave and period count it reports the number of
+ * measurements, the wall time of HT1382_Cal_Run (measurements and I2C at
+ * 100 kHz) and the clock error left, for a full search from the factory
+ * trim and for tracking after temperature steps. "floor" is the error of
+ * the best trim, the resolution limit of OSCCAL.
+ *
+ * Results with the HT1382_Cal_Init defaults (4096 Hz, 32 periods; 1000
+ * parts, seed 1):
+ *
+ *   mode    case      meas     ms  max ms  |err| ppm  floor  best%
+ *   search  factory    8.0   65.5    66.1       1390   1390   99.3
+ *   track   dT 5C      2.4   21.2    26.1       1350   1350   99.5
+ *   track   dT 20C     4.0   33.8    41.7       1399   1399   99.8
+ *   track   dT 60C     4.3   36.1    42.1       1328   1328   99.7
+ *
+ * The loop ends on the best trim in over 99 % of the runs (the rest pick a
+ * neighbour within the measurement noise of it), so the error left is the OSCCAL step
+ * and more periods only add time. The 1024 Hz wave needs 4 times longer
+ * for the same resolution.
+ *
+ * (run "make sim" for the full table)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "HT1382_cal.h"
+
+
+#define SIM_F_NOMINAL       8000000.0
+#define SIM_TEMPCO          0.001     // per C
+#define SIM_REF_PPM         20.0
+#define SIM_I2C_BIT_US      10.0      // 100 kHz
+
+
+/* RAM model of the RTC ---------------------------------------------------------*/
+static uint8_t Sim_Regs[HT1382_CHIP_REG_COUNT];
+static uint8_t Sim_Pointer;
+static double Sim_BusUs;
+
+static int8_t
+Sim_Send(uint8_t Address, uint8_t *Data, uint8_t Len)
+{
+  uint8_t i = 0;
+
+  (void)Address;
+  Sim_BusUs += (Len + 1) * 9 * SIM_I2C_BIT_US;
+  Sim_Pointer = Data[0];
+  for (i = 1; i < Len; i++)
+    Sim_Regs[Sim_Pointer++ % HT1382_CHIP_REG_COUNT] = Data[i];
+  return 0;
+}
+
+static int8_t
+Sim_Receive(uint8_t Address, uint8_t *Data, uint8_t Len)
+{
+  uint8_t i = 0;
+
+  (void)Address;
+  Sim_BusUs += (Len + 1) * 9 * SIM_I2C_BIT_US;
+  for (i = 0; i < Len; i++)
+    Data[i] = Sim_Regs[Sim_Pointer++ % HT1382_CHIP_REG_COUNT];
+  return 0;
+}
+
+
+/* RC oscillator model ----------------------------------------------------------*/
+static uint32_t Rand_State = 1;
+
+static uint32_t
+Rand_Next(void)
+{
+  // xorshift32
+  Rand_State ^= Rand_State << 13;
+  Rand_State ^= Rand_State >> 17;
+  Rand_State ^= Rand_State << 5;
+  return Rand_State;
+}
+
+static double
+Rand_Uniform(void)
+{
+  return (Rand_Next() >> 8) / 16777216.0;
+}
+
+static struct
+{
+  double    Part;         // process factor
+  double    Ripple[256];  // per-step nonlinearity
+  double    Temp;         // C
+  uint8_t   Osccal;
+  double    RefFreq;
+  double    MeasureUs;
+} Sim;
+
+static double
+Sim_Freq(uint8_t Osccal)
+{
+  return SIM_F_NOMINAL * Sim.Part * pow(2.0, (Osccal - 128) / 128.0) *
+         (1.0 + Sim.Ripple[Osccal]) * (1.0 + SIM_TEMPCO * (Sim.Temp - 25.0));
+}
+
+static int32_t
+Sim_Measure(uint16_t Periods)
+{
+  double Ref = Sim.RefFreq * (1.0 + SIM_REF_PPM * 1e-6);
+  double Ticks = Periods * Sim_Freq(Sim.Osccal) / Ref;
+
+  Sim.MeasureUs += (Periods + Rand_Uniform()) * 1e6 / Ref;
+  return (int32_t)(Ticks + Rand_Uniform() * 2.0 - 1.0 + 0.5);
+}
+
+static uint8_t
+Sim_GetTrim(void)
+{
+  return Sim.Osccal;
+}
+
+static void
+Sim_SetTrim(uint8_t Trim)
+{
+  Sim.Osccal = Trim;
+}
+
+static void
+Sim_NewPart(void)
+{
+  int i = 0;
+
+  Sim.Part = 0.9 + 0.2 * Rand_Uniform();
+  for (i = 0; i < 256; i++)
+    Sim.Ripple[i] = (Rand_Uniform() - 0.5) * 0.001;
+  Sim.Temp = 25.0;
+  // factory calibration at 25 C: the best trim
+  Sim.Osccal = 0;
+  for (i = 1; i < 256; i++)
+  {
+    if (fabs(Sim_Freq((uint8_t)i) - SIM_F_NOMINAL) < fabs(Sim_Freq(Sim.Osccal) - SIM_F_NOMINAL))
+      Sim.Osccal = (uint8_t)i;
+  }
+  // then 3.3 V/8 MHz factory values are typically off by a few steps
+  i = Sim.Osccal + (int)(Rand_Next() % 9) - 4;
+  Sim.Osccal = (uint8_t)(i < 0 ? 0 : i > 255 ? 255 : i);
+}
+
+static double
+Sim_FloorPpm(void)
+{
+  double Best = 1e9;
+  int i = 0;
+
+  for (i = 0; i < 256; i++)
+  {
+    if (fabs(Sim_Freq((uint8_t)i) / SIM_F_NOMINAL - 1.0) < Best)
+      Best = fabs(Sim_Freq((uint8_t)i) / SIM_F_NOMINAL - 1.0);
+  }
+  return Best * 1e6;
+}
+
+
+/* Statistics -------------------------------------------------------------------*/
+typedef struct Stat_s
+{
+  double    Measurements;
+  double    TimeMs;
+  double    MaxTimeMs;
+  double    ErrPpm;
+  double    MaxErrPpm;
+  double    FloorPpm;
+  int       Runs;
+  int       Best;         // runs that ended on the best trim
+  int       Failures;
+} Stat_t;
+
+static int
+Sim_Run(HT1382_Cal_t *Cal, uint8_t Mode, Stat_t *Stat)
+{
+  double Floor = Sim_FloorPpm();
+  double Err = 0;
+  double Ms = 0;
+
+  Sim_BusUs = 0;
+  Sim.MeasureUs = 0;
+  if (HT1382_Cal_Run(Cal, Mode) != HT1382_OK)
+  {
+    Stat->Failures++;
+    return -1;
+  }
+
+  Err = fabs(Sim_Freq(Sim.Osccal) / SIM_F_NOMINAL - 1.0) * 1e6;
+  Ms = (Sim_BusUs + Sim.MeasureUs) / 1000.0;
+
+  Stat->Runs++;
+  if (Err <= Floor + 0.01)
+    Stat->Best++;
+  Stat->Measurements += Cal->Measurements;
+  Stat->TimeMs += Ms;
+  Stat->ErrPpm += Err;
+  Stat->FloorPpm += Floor;
+  if (Ms > Stat->MaxTimeMs)
+    Stat->MaxTimeMs = Ms;
+  if (Err > Stat->MaxErrPpm)
+    Stat->MaxErrPpm = Err;
+  return 0;
+}
+
+static void
+Stat_Print(const char *Mode, const char *Case, uint16_t Wave, uint16_t Periods, const Stat_t *Stat)
+{
+  int n = Stat->Runs ? Stat->Runs : 1;
+
+  printf("%-7s %-8s %5u %8u %6.1f %8.1f %8.1f %9.0f %6.0f %8.0f %6.1f %5d\n",
+         Mode, Case, Wave, Periods, Stat->Measurements / n, Stat->TimeMs / n, Stat->MaxTimeMs,
+         Stat->ErrPpm / n, Stat->MaxErrPpm, Stat->FloorPpm / n, 100.0 * Stat->Best / n,
+         Stat->Failures);
+}
+
+
+int main(int argc, char **argv)
+{
+  static const HT1382_OutWave_t Waves[] = {HT1382_OUTWAVE_4096HZ, HT1382_OUTWAVE_1024HZ};
+  static const uint16_t PeriodCounts[] = {8, 32, 128};
+  static const double TempSteps[] = {5.0, 20.0, 60.0};
+  HT1382_Handler_t Handler = {0};
+  HT1382_Cal_t Cal;
+  Stat_t Search;
+  Stat_t Track;
+  char Case[16];
+  int Parts = 1000;
+  size_t w = 0;
+  size_t p = 0;
+  size_t t = 0;
+  int i = 0;
+
+  for (i = 1; i < argc; i++)
+  {
+    if (!strcmp(argv[i], "--parts") && i + 1 < argc)
+      Parts = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--seed") && i + 1 < argc)
+      Rand_State = (uint32_t)strtoul(argv[++i], NULL, 0) | 1;
+    else
+    {
+      fprintf(stderr, "usage: %s [--parts N] [--seed S]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  HT1382_PLATFORM_LINK_SEND(&Handler, Sim_Send);
+  HT1382_PLATFORM_LINK_RECEIVE(&Handler, Sim_Receive);
+  if (HT1382_Init(&Handler) != HT1382_OK ||
+      HT1382_Cal_Init(&Cal, &Handler, Sim_Measure, Sim_GetTrim, Sim_SetTrim,
+                      (uint32_t)SIM_F_NOMINAL) != HT1382_OK)
+    return 1;
+
+  printf("%-7s %-8s %5s %8s %6s %8s %8s %9s %6s %8s %6s %5s\n", "mode", "case", "wave",
+         "periods", "meas", "ms", "max ms", "|err| ppm", "max", "floor", "best%", "fail");
+
+  for (w = 0; w < sizeof(Waves) / sizeof(Waves[0]); w++)
+  {
+    for (p = 0; p < sizeof(PeriodCounts) / sizeof(PeriodCounts[0]); p++)
+    {
+      Cal.OutWave = Waves[w];
+      Cal.Periods = PeriodCounts[p];
+      Sim.RefFreq = HT1382_Cal_WaveFreq(Waves[w]);
+
+      memset(&Search, 0, sizeof(Search));
+      for (i = 0; i < Parts; i++)
+      {
+        Sim_NewPart();
+        Sim_Run(&Cal, HT1382_CAL_SEARCH, &Search);
+      }
+      Stat_Print("search", "factory", (uint16_t)Sim.RefFreq, Cal.Periods, &Search);
+
+      for (t = 0; t < sizeof(TempSteps) / sizeof(TempSteps[0]); t++)
+      {
+        memset(&Track, 0, sizeof(Track));
+        for (i = 0; i < Parts; i++)
+        {
+          Sim_NewPart();
+          if (HT1382_Cal_Run(&Cal, HT1382_CAL_SEARCH) != HT1382_OK)
+            continue;
+          Sim.Temp += (Rand_Next() & 1) ? TempSteps[t] : -TempSteps[t];
+          Sim_Run(&Cal, HT1382_CAL_TRACK, &Track);
+        }
+        snprintf(Case, sizeof(Case), "dT %.0fC", TempSteps[t]);
+        Stat_Print("track", Case, (uint16_t)Sim.RefFreq, Cal.Periods, &Track);
+      }
+    }
+  }
+
+  return 0;
+}
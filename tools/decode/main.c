@@ -0,0 +1,217 @@
+/**
+ **********************************************************************************
+ * @file   main.c
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  Throughput benchmark of HT1382_Decode_Bulk
+ **********************************************************************************
+ *
+ * Copyright (c) 2024 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+
+/**
+ * Usage: ht1382-decode-bench [--records N] [--invalid PCT] [--12h PCT]
+ *                            [--rounds R] [--seed S]
+ *
+ * Builds N raw 7-byte records from random times between 2000 and 2099 (PCT %
+ * with one corrupted byte, PCT % in 12-hour mode), decodes them with every
+ * implementation the CPU supports and prints records/second. Every
+ * implementation is checked against the scalar decoder and the scalar
+ * decoder against the times the records were built from.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "HT1382_decode.h"
+#include "HT1382_time.h"
+
+
+static uint32_t Rand_State = 1;
+
+static uint32_t
+Rand_Next(void)
+{
+  // xorshift32
+  Rand_State ^= Rand_State << 13;
+  Rand_State ^= Rand_State >> 17;
+  Rand_State ^= Rand_State << 5;
+  return Rand_State;
+}
+
+static uint8_t
+DECtoBCD(uint8_t DEC)
+{
+  return (uint8_t)(((DEC / 10) << 4) | (DEC % 10));
+}
+
+static double
+Now(void)
+{
+  struct timespec Ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &Ts);
+  return Ts.tv_sec + Ts.tv_nsec * 1e-9;
+}
+
+/**
+ * @brief  Build a record, returns the expected epoch
+ */
+static uint32_t
+Record_Make(uint8_t *Record, unsigned InvalidPct, unsigned Hour12Pct)
+{
+  HT1382_DateTime_t DateTime;
+  uint32_t Epoch = HT1382_TIME_EPOCH_2000 + Rand_Next() % (36525UL * 86400UL);
+  uint8_t Hour = 0;
+
+  HT1382_Time_FromEpoch(Epoch, &DateTime);
+  Record[0] = DECtoBCD(DateTime.Second);
+  Record[1] = DECtoBCD(DateTime.Minute);
+  Record[2] = DECtoBCD(DateTime.Hour) | 0x80; // 24-hour mode
+  Record[3] = DECtoBCD(DateTime.Day);
+  Record[4] = DECtoBCD(DateTime.Month);
+  Record[5] = DECtoBCD(DateTime.WeekDay);
+  Record[6] = DECtoBCD(DateTime.Year);
+
+  if (Rand_Next() % 100 < Hour12Pct)
+  {
+    Hour = DateTime.Hour % 12;
+    Record[2] = DECtoBCD(Hour ? Hour : 12) | ((DateTime.Hour >= 12) << 5);
+  }
+
+  if (Rand_Next() % 100 < InvalidPct)
+  {
+    // a digit above 9 is invalid in every register
+    Record[Rand_Next() % 7] |= 0x0A;
+    Record[Rand_Next() % 7] |= 0x0A;
+    return HT1382_DECODE_INVALID;
+  }
+
+  return Epoch;
+}
+
+
+int main(int argc, char *argv[])
+{
+  static const struct { HT1382_DecodeImpl_t Impl; const char *Name; } Impls[] =
+  {
+    {HT1382_DECODE_SCALAR, "scalar"},
+    {HT1382_DECODE_SSE2,   "sse2"},
+    {HT1382_DECODE_AVX2,   "avx2"},
+  };
+  size_t Count = 10000000;
+  unsigned InvalidPct = 0;
+  unsigned Hour12Pct = 0;
+  unsigned Rounds = 5;
+  uint8_t *Records = NULL;
+  uint32_t *Expected = NULL;
+  uint32_t *Reference = NULL;
+  uint32_t *Epochs = NULL;
+  size_t Invalid = 0;
+  size_t Mismatch = 0;
+  double Start = 0, Best = 0, Elapsed = 0;
+  unsigned r = 0;
+  size_t i = 0, k = 0;
+  int Status = 0;
+
+  for (i = 1; i < (size_t)argc; i++)
+  {
+    if (!strcmp(argv[i], "--records") && i + 1 < (size_t)argc)
+      Count = strtoul(argv[++i], NULL, 0);
+    else if (!strcmp(argv[i], "--invalid") && i + 1 < (size_t)argc)
+      InvalidPct = strtoul(argv[++i], NULL, 0);
+    else if (!strcmp(argv[i], "--12h") && i + 1 < (size_t)argc)
+      Hour12Pct = strtoul(argv[++i], NULL, 0);
+    else if (!strcmp(argv[i], "--rounds") && i + 1 < (size_t)argc)
+      Rounds = strtoul(argv[++i], NULL, 0);
+    else if (!strcmp(argv[i], "--seed") && i + 1 < (size_t)argc)
+      Rand_State = strtoul(argv[++i], NULL, 0) | 1;
+    else
+    {
+      fprintf(stderr, "usage: %s [--records N] [--invalid PCT] [--12h PCT] "
+                      "[--rounds R] [--seed S]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  Records   = malloc(Count * HT1382_DECODE_RECORD_SIZE);
+  Expected  = malloc(Count * sizeof(uint32_t));
+  Reference = malloc(Count * sizeof(uint32_t));
+  Epochs    = malloc(Count * sizeof(uint32_t));
+  if (!Records || !Expected || !Reference || !Epochs)
+  {
+    fprintf(stderr, "out of memory\n");
+    return 1;
+  }
+
+  for (i = 0; i < Count; i++)
+    Expected[i] = Record_Make(Records + i * HT1382_DECODE_RECORD_SIZE, InvalidPct, Hour12Pct);
+
+  // the scalar decoder must reproduce the source times
+  HT1382_Decode_SetImpl(HT1382_DECODE_SCALAR);
+  Invalid = HT1382_Decode_Bulk(Records, Count, Reference);
+  for (i = 0; i < Count; i++)
+    Mismatch += (Reference[i] != Expected[i]);
+  printf("%zu records, %zu invalid, %u%% 12-hour, scalar check: %s\n",
+         Count, Invalid, Hour12Pct, Mismatch ? "FAIL" : "ok");
+  if (Mismatch)
+    Status = 1;
+
+  printf("%-8s %14s %10s %8s\n", "impl", "records/s", "ns/record", "check");
+  for (k = 0; k < sizeof(Impls) / sizeof(Impls[0]); k++)
+  {
+    if (HT1382_Decode_SetImpl(Impls[k].Impl) != Impls[k].Impl)
+    {
+      printf("%-8s %14s\n", Impls[k].Name, "not supported");
+      continue;
+    }
+
+    Best = 0;
+    for (r = 0; r < Rounds; r++)
+    {
+      memset(Epochs, 0, Count * sizeof(uint32_t));
+      Start = Now();
+      HT1382_Decode_Bulk(Records, Count, Epochs);
+      Elapsed = Now() - Start;
+      if (!r || Elapsed < Best)
+        Best = Elapsed;
+    }
+
+    Mismatch = 0;
+    for (i = 0; i < Count; i++)
+      Mismatch += (Epochs[i] != Reference[i]);
+    if (Mismatch)
+      Status = 1;
+
+    printf("%-8s %14.0f %10.2f %8s\n", Impls[k].Name, Count / Best,
+           Best * 1e9 / Count, Mismatch ? "FAIL" : "ok");
+  }
+
+  free(Records);
+  free(Expected);
+  free(Reference);
+  free(Epochs);
+  return Status;
+}
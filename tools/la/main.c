@@ -0,0 +1,1166 @@
+/**
+ **********************************************************************************
+ * @file   main.c
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  Host tool: annotate and time HT1382 traffic from logic analyzer captures
+ **********************************************************************************
+ *
+ * Copyright (c) 2024 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+
+/**
+ * Usage:
+ *   ht1382-la [--format sigrok|csv] [--samplerate HZ] [--op-gap US]
+ *             [--summary] FILE
+ *
+ * FILE is the I2C decoder output of a logic analyzer capture:
+ *
+ * - sigrok: annotations of the sigrok i2c decoder, one per line, as printed
+ *   by "sigrok-cli -i CAPTURE -P i2c:scl=D0:sda=D1 -A i2c
+ *   --protocol-decoder-samplenum" or exported from PulseView ("Export all
+ *   annotations"), e.g. "1200-1290 i2c-1: Address write: 68". Sample
+ *   numbers need --samplerate; numbers with a decimal point are taken as
+ *   seconds. Without the range prefix the traffic is annotated but not timed.
+ * - csv: I2C analyzer export of Saleae Logic 2 (columns type, start_time,
+ *   duration, ack, address, read and data; other columns are ignored).
+ *
+ * The format follows the file name (.csv) unless --format is given.
+ *
+ * Every transaction with the chip is printed with its registers, bytes and
+ * decoded content (time, WP state, ST2 flags, out wave and INT bits, alarm
+ * fields), its bus time and the idle gap before it. Transactions are grouped
+ * into driver operations: a register pointer write with its read, a
+ * WP off ... WP on bracket with the read before and the read-back after it.
+ * A gap longer than --op-gap (default 1000 us) always starts a new
+ * operation.
+ *
+ * A model of the chip registers is kept from the traffic, so redundant
+ * accesses are flagged: reads of registers whose value is already known and
+ * writes that change nothing. Time registers and ST2 change by themselves
+ * and are never flagged. A single bus master is assumed; a known register
+ * that reads back a different value is reported as changed.
+ *
+ * The summary lists bus time, host time (gaps inside operations) and the
+ * time spent in redundant transactions per operation, the gaps between
+ * operations and the SCL rate estimated from the transaction timing.
+ * With --summary only the summary is printed.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <string.h>
+#include <ctype.h>
+#include "HT1382_config.h"
+
+
+#define LA_LINE_MAX         1024
+#define LA_TXN_DATA_MAX     256
+#define LA_NAME_MAX         40
+#define LA_NOTE_MAX         256
+#define LA_STATS_MAX        64
+#define LA_REGS             HT1382_CHIP_REG_COUNT
+
+// registers that only change when written
+#define LA_IS_STABLE(REG)   ((REG) == HT1382_REG_ADDR_ST1 || (REG) >= HT1382_REG_ADDR_INT)
+
+
+typedef enum EventKind_e
+{
+  EV_START = 0,
+  EV_STOP,
+  EV_ADDRESS,
+  EV_DATA,
+  EV_NACK,
+} EventKind_t;
+
+typedef struct Event_s
+{
+  double    Start;
+  double    End;
+  uint8_t   Kind;
+  uint8_t   Value;
+  uint8_t   Read;
+} Event_t;
+
+typedef struct Txn_s
+{
+  double    Start;
+  double    End;
+  uint8_t   Address;
+  uint8_t   Read;
+  uint8_t   Nack;
+  uint16_t  Len;
+  uint8_t   Data[LA_TXN_DATA_MAX];
+} Txn_t;
+
+typedef struct Op_s
+{
+  unsigned  First;
+  unsigned  Count;
+  char      Name[LA_NAME_MAX];
+} Op_t;
+
+typedef struct Stat_s
+{
+  char      Name[LA_NAME_MAX];
+  unsigned  Ops;
+  unsigned  Transactions;
+  unsigned  Bytes;
+  double    Time;
+  double    TimeMax;
+  double    Bus;
+  unsigned  Redundant;
+  double    RedundantTime;
+} Stat_t;
+
+typedef struct Gaps_s
+{
+  unsigned  Count;
+  double    Sum;
+  double    Min;
+  double    Max;
+} Gaps_t;
+
+
+static const char *Reg_Names[LA_REGS] =
+{
+  "SECONDS", "MINUTES", "HOURS", "DATE", "MONTH", "DAY", "YEAR",
+  "ST1", "ST2", "INT", "SECONDS_ALARM", "MINUTES_ALARM", "HOURS_ALARM",
+  "DATE_ALARM", "MONTH_ALARM", "DAY_ALARM", "DT", "USR1", "USR2", "USR3", "USR4"
+};
+
+static const char *Wave_Names[16] =
+{
+  "off", "32768Hz", "4096Hz", "1024Hz", "64Hz", "32Hz", "16Hz", "8Hz",
+  "4Hz", "2Hz", "1Hz", "1/2Hz", "1/4Hz", "1/8Hz", "1/16Hz", "1/32Hz"
+};
+
+static const char *Alarm_Names[6] = {"sec", "min", "hour", "date", "month", "day"};
+
+static Event_t *Events = NULL;
+static unsigned EventCount = 0;
+static unsigned EventSize = 0;
+static Txn_t *Txns = NULL;
+static unsigned TxnCount = 0;
+static unsigned TxnSize = 0;
+static Op_t *Ops = NULL;
+static unsigned OpCount = 0;
+
+static int HasTime = 0;
+static double SampleRate = 0;
+static double OpGap = 1000e-6;
+
+// register model of the chip, Known holds transaction number + 1
+static uint8_t Model_Regs[LA_REGS];
+static unsigned Model_Known[LA_REGS];
+static int Model_Pointer = -1;
+
+static Stat_t Stats[LA_STATS_MAX];
+static unsigned StatCount = 0;
+static Gaps_t GapsInside = {0, 0, 1e9, 0};
+static Gaps_t GapsBetween = {0, 0, 1e9, 0};
+static unsigned OtherCount = 0;
+static unsigned NackCount = 0;
+
+
+/* Helpers ----------------------------------------------------------------------*/
+static void *
+Array_Reserve(void *Array, unsigned Count, unsigned *Size, size_t Item)
+{
+  if (Count < *Size)
+    return Array;
+
+  *Size = *Size ? *Size * 2 : 1024;
+  Array = realloc(Array, *Size * Item);
+  if (!Array)
+  {
+    fprintf(stderr, "out of memory\n");
+    exit(1);
+  }
+
+  return Array;
+}
+
+static uint8_t
+BCD(uint8_t Value)
+{
+  return (uint8_t)((Value >> 4) * 10 + (Value & 0x0F));
+}
+
+static void
+Note_Add(char *Note, const char *Format, ...)
+{
+  size_t Len = strlen(Note);
+  va_list Args;
+
+  if (Len >= LA_NOTE_MAX - 1)
+    return;
+
+  va_start(Args, Format);
+  vsnprintf(Note + Len, LA_NOTE_MAX - Len, Format, Args);
+  va_end(Args);
+}
+
+static void
+Gaps_Add(Gaps_t *Gaps, double Gap)
+{
+  Gaps->Count++;
+  Gaps->Sum += Gap;
+  if (Gap < Gaps->Min)
+    Gaps->Min = Gap;
+  if (Gap > Gaps->Max)
+    Gaps->Max = Gap;
+}
+
+static void
+Gaps_Print(const char *Name, const Gaps_t *Gaps)
+{
+  if (!Gaps->Count)
+    return;
+
+  printf("%-32s %6u  min %9.1f  mean %9.1f  max %9.1f us\n", Name, Gaps->Count,
+         Gaps->Min * 1e6, Gaps->Sum * 1e6 / Gaps->Count, Gaps->Max * 1e6);
+}
+
+static int
+Double_Compare(const void *A, const void *B)
+{
+  double a = *(const double *)A;
+  double b = *(const double *)B;
+
+  return (a > b) - (a < b);
+}
+
+static void
+Reg_Span(char *Out, size_t Size, unsigned First, unsigned Count)
+{
+  if (!Count)
+    snprintf(Out, Size, "%s", "-");
+  else if (Count == 1)
+    snprintf(Out, Size, "%s", Reg_Names[First % LA_REGS]);
+  else
+    snprintf(Out, Size, "%s..%s", Reg_Names[First % LA_REGS],
+             Reg_Names[(First + Count - 1) % LA_REGS]);
+}
+
+
+/* Input ------------------------------------------------------------------------*/
+static void
+Event_Add(double Start, double End, uint8_t Kind, uint8_t Value, uint8_t Read)
+{
+  Event_t *Ev = NULL;
+
+  Events = (Event_t *)Array_Reserve(Events, EventCount, &EventSize, sizeof(Event_t));
+  Ev = &Events[EventCount++];
+  Ev->Start = Start;
+  Ev->End = End;
+  Ev->Kind = Kind;
+  Ev->Value = Value;
+  Ev->Read = Read;
+}
+
+/**
+ * @brief  Parse one sigrok i2c decoder annotation
+ * @retval 0: parsed or ignored, -1: error
+ */
+static int
+Sigrok_Line(char *Line, unsigned LineNo)
+{
+  static const struct
+  {
+    const char  *Text;
+    uint8_t     Kind;
+    uint8_t     Read;
+  } Keys[] =
+  {
+    {"Address read: ",  EV_ADDRESS, 1},
+    {"Address write: ", EV_ADDRESS, 0},
+    {"Data read: ",     EV_DATA,    1},
+    {"Data write: ",    EV_DATA,    0},
+    {"Start",           EV_START,   0}, // also "Start repeat"
+    {"Stop",            EV_STOP,    0},
+    {"NACK",            EV_NACK,    0},
+  };
+  double Start = 0;
+  double End = 0;
+  char *p = Line;
+  char *Mark = NULL;
+  unsigned Value = 0;
+  size_t i;
+
+  // optional "START-END " range in samples or seconds
+  if (isdigit((unsigned char)*p))
+  {
+    Start = strtod(p, &p);
+    if (*p == '-')
+      End = strtod(p + 1, &p);
+    else
+      End = Start;
+
+    if (!memchr(Line, '.', (size_t)(p - Line)))
+    {
+      if (!SampleRate)
+      {
+        fprintf(stderr, "line %u: sample numbers need --samplerate\n", LineNo);
+        return -1;
+      }
+      Start /= SampleRate;
+      End /= SampleRate;
+    }
+    HasTime = 1;
+  }
+
+  for (i = 0; i < sizeof(Keys) / sizeof(Keys[0]); i++)
+  {
+    Mark = strstr(p, Keys[i].Text);
+    if (!Mark)
+      continue;
+
+    if (Keys[i].Kind == EV_ADDRESS || Keys[i].Kind == EV_DATA)
+    {
+      if (sscanf(Mark + strlen(Keys[i].Text), "%x", &Value) != 1)
+        return 0;
+    }
+    Event_Add(Start, End, Keys[i].Kind, (uint8_t)Value, Keys[i].Read);
+    return 0;
+  }
+
+  return 0; // ACK, Read/Write bit, Bits, Warnings
+}
+
+/**
+ * @brief  Split a CSV line in place (double quotes are removed)
+ * @retval Number of fields
+ */
+static int
+Csv_Split(char *Line, char **Fields, int Max)
+{
+  int Count = 0;
+  char *p = Line;
+  char *Out = NULL;
+  int Quoted = 0;
+
+  while (Count < Max)
+  {
+    Fields[Count++] = Out = p;
+    Quoted = 0;
+    for (; *p && *p != '\n' && *p != '\r' && (Quoted || *p != ','); p++)
+    {
+      if (*p == '"')
+        Quoted = !Quoted;
+      else
+        *Out++ = *p;
+    }
+    if (*p != ',')
+    {
+      *Out = '\0';
+      break;
+    }
+    p++;
+    *Out = '\0';
+  }
+
+  return Count;
+}
+
+static int
+Csv_Column(char **Fields, int Count, const char *Name)
+{
+  int i;
+
+  for (i = 0; i < Count; i++)
+    if (!strcmp(Fields[i], Name))
+      return i;
+
+  return -1;
+}
+
+static int
+Input_Csv(FILE *File)
+{
+  enum {COL_TYPE, COL_START, COL_DURATION, COL_ACK, COL_ADDRESS, COL_READ, COL_DATA, COL_COUNT};
+  static const char *Names[COL_COUNT] =
+  {
+    "type", "start_time", "duration", "ack", "address", "read", "data"
+  };
+  char Line[LA_LINE_MAX];
+  char *Fields[32];
+  int Col[COL_COUNT];
+  int Count = 0;
+  int i;
+  unsigned LineNo = 1;
+  double Start = 0;
+  double End = 0;
+  int Value = 0;
+  const char *Type = NULL;
+
+  if (!fgets(Line, sizeof(Line), File))
+    return -1;
+  Count = Csv_Split(Line, Fields, 32);
+  for (i = 0; i < COL_COUNT; i++)
+  {
+    Col[i] = Csv_Column(Fields, Count, Names[i]);
+    if (Col[i] < 0 && i != COL_DURATION)
+    {
+      fprintf(stderr, "csv: no \"%s\" column\n", Names[i]);
+      return -1;
+    }
+  }
+  HasTime = 1;
+
+  while (fgets(Line, sizeof(Line), File))
+  {
+    LineNo++;
+    Count = Csv_Split(Line, Fields, 32);
+    if (Count <= Col[COL_TYPE] || Count <= Col[COL_START])
+      continue;
+
+    Type = Fields[Col[COL_TYPE]];
+    Start = strtod(Fields[Col[COL_START]], NULL);
+    End = Start;
+    if (Col[COL_DURATION] >= 0 && Count > Col[COL_DURATION])
+      End += strtod(Fields[Col[COL_DURATION]], NULL);
+
+    if (!strcmp(Type, "start"))
+    {
+      Event_Add(Start, End, EV_START, 0, 0);
+    }
+    else if (!strcmp(Type, "stop"))
+    {
+      Event_Add(Start, End, EV_STOP, 0, 0);
+    }
+    else if (!strcmp(Type, "address") || !strcmp(Type, "data"))
+    {
+      i = !strcmp(Type, "address") ? Col[COL_ADDRESS] : Col[COL_DATA];
+      if (Count <= i || sscanf(Fields[i], "%i", &Value) != 1)
+      {
+        fprintf(stderr, "line %u: no %s value\n", LineNo, Type);
+        continue;
+      }
+      if (Type[0] == 'a')
+      {
+        // 8-bit address display setting
+        if (Value > 0x7F)
+          Value >>= 1;
+        Event_Add(Start, End, EV_ADDRESS, (uint8_t)Value,
+                  Count > Col[COL_READ] && !strcmp(Fields[Col[COL_READ]], "true"));
+      }
+      else
+      {
+        Event_Add(Start, End, EV_DATA, (uint8_t)Value, 0);
+      }
+      if (Count > Col[COL_ACK] && !strcmp(Fields[Col[COL_ACK]], "false"))
+        Event_Add(End, End, EV_NACK, 0, 0);
+    }
+  }
+
+  return 0;
+}
+
+static int
+Input_Sigrok(FILE *File)
+{
+  char Line[LA_LINE_MAX];
+  unsigned LineNo = 0;
+
+  while (fgets(Line, sizeof(Line), File))
+  {
+    LineNo++;
+    if (Sigrok_Line(Line, LineNo) < 0)
+      return -1;
+  }
+
+  return 0;
+}
+
+/**
+ * @brief  Build transactions from START to STOP or repeated START
+ */
+static void
+Txn_Build(void)
+{
+  Txn_t *Cur = NULL;
+  const Event_t *Ev = NULL;
+  unsigned i;
+
+  for (i = 0; i < EventCount; i++)
+  {
+    Ev = &Events[i];
+    switch (Ev->Kind)
+    {
+    case EV_START:
+      if (Cur)
+      {
+        Cur->End = Ev->Start;
+        if (Cur->Address != 0xFF)
+          TxnCount++;
+      }
+      Txns = (Txn_t *)Array_Reserve(Txns, TxnCount, &TxnSize, sizeof(Txn_t));
+      Cur = &Txns[TxnCount];
+      memset(Cur, 0, sizeof(*Cur));
+      Cur->Start = Ev->Start;
+      Cur->End = Ev->End;
+      Cur->Address = 0xFF;
+      break;
+
+    case EV_ADDRESS:
+      if (!Cur)
+        break; // capture started inside a transaction
+      Cur->Address = Ev->Value;
+      Cur->Read = Ev->Read;
+      Cur->End = Ev->End;
+      break;
+
+    case EV_DATA:
+      if (!Cur || Cur->Address == 0xFF)
+        break;
+      if (Cur->Len < LA_TXN_DATA_MAX)
+        Cur->Data[Cur->Len++] = Ev->Value;
+      Cur->End = Ev->End;
+      break;
+
+    case EV_NACK:
+      // a master NACKs the last byte of every read
+      if (Cur && !Cur->Read)
+        Cur->Nack = 1;
+      break;
+
+    case EV_STOP:
+      if (!Cur)
+        break;
+      Cur->End = Ev->End;
+      if (Cur->Address != 0xFF)
+        TxnCount++;
+      Cur = NULL;
+      break;
+
+    default:
+      break;
+    }
+  }
+}
+
+
+/* Operations -------------------------------------------------------------------*/
+static int
+Txn_IsChip(unsigned i)
+{
+  return i < TxnCount && Txns[i].Address == HT1382_ADDRESS && !Txns[i].Nack;
+}
+
+static int
+Txn_IsPointer(unsigned i)
+{
+  return Txn_IsChip(i) && !Txns[i].Read && Txns[i].Len == 1;
+}
+
+static int
+Txn_IsWP(unsigned i, uint8_t Enable)
+{
+  return Txn_IsChip(i) && !Txns[i].Read && Txns[i].Len == 2 &&
+         Txns[i].Data[0] == HT1382_REG_ADDR_ST1 &&
+         ((Txns[i].Data[1] >> HT1382_ST1_WP) & 0x01) == Enable;
+}
+
+static double
+Txn_Gap(unsigned i)
+{
+  if (!HasTime || !i || i >= TxnCount)
+    return 0;
+
+  return Txns[i].Start - Txns[i - 1].End;
+}
+
+static int
+Txn_Near(unsigned i)
+{
+  return i < TxnCount && (!HasTime || Txn_Gap(i) <= OpGap);
+}
+
+/**
+ * @brief  Register pointer write followed by a read
+ * @retval Number of transactions, 0 if none
+ */
+static unsigned
+Txn_ReadOp(unsigned i)
+{
+  if (Txn_IsPointer(i) && Txn_Near(i + 1) &&
+      Txn_IsChip(i + 1) && Txns[i + 1].Read)
+    return 2;
+
+  return 0;
+}
+
+static void
+Op_Name(Op_t *Op)
+{
+  const Txn_t *Txn = NULL;
+  unsigned Writes = 0;
+  unsigned Unlock = 0;
+  unsigned Lock = 0;
+  unsigned Time = 0;
+  unsigned Reads = 0;
+  unsigned WriteReg = 0, WriteLen = 0;
+  unsigned ReadReg = 0, ReadLen = 0;
+  char Span[32];
+  unsigned i;
+
+  Txn = &Txns[Op->First];
+  if (Txn->Address != HT1382_ADDRESS)
+  {
+    snprintf(Op->Name, sizeof(Op->Name), "device 0x%02X", Txn->Address);
+    return;
+  }
+  if (Txn->Nack)
+  {
+    snprintf(Op->Name, sizeof(Op->Name), "%s", "NACK");
+    return;
+  }
+
+  for (i = Op->First; i < Op->First + Op->Count; i++)
+  {
+    Txn = &Txns[i];
+    if (Txn_IsWP(i, 0))
+      Unlock++;
+    else if (Txn_IsWP(i, 1))
+      Lock++;
+    else if (Txn->Read && i > Op->First && Txn_IsPointer(i - 1))
+    {
+      Reads++;
+      ReadReg = Txns[i - 1].Data[0];
+      ReadLen = Txn->Len;
+    }
+    else if (!Txn->Read && Txn->Len > 1)
+    {
+      Writes++;
+      WriteReg = Txn->Data[0];
+      WriteLen = Txn->Len - 1;
+      if (WriteReg == HT1382_REG_ADDR_SECONDS && WriteLen >= 7)
+        Time = 1;
+    }
+  }
+
+  if (Time)
+  {
+    snprintf(Op->Name, sizeof(Op->Name), "%s", Unlock ? "SetDateTime" : "FireDateTime");
+  }
+  else if (Writes > 1)
+  {
+    snprintf(Op->Name, sizeof(Op->Name), "%s", "WriteImage");
+  }
+  else if (Writes)
+  {
+    Reg_Span(Span, sizeof(Span), WriteReg, WriteLen);
+    snprintf(Op->Name, sizeof(Op->Name), "write %s", Span);
+  }
+  else if (Reads && ReadReg == HT1382_REG_ADDR_SECONDS && ReadLen == 7)
+  {
+    snprintf(Op->Name, sizeof(Op->Name), "%s", "GetDateTime");
+  }
+  else if (Reads && ReadReg == HT1382_REG_ADDR_SECONDS && ReadLen == 10)
+  {
+    snprintf(Op->Name, sizeof(Op->Name), "%s", "Probe");
+  }
+  else if (Reads && ReadReg == HT1382_REG_ADDR_SECONDS && ReadLen == LA_REGS)
+  {
+    snprintf(Op->Name, sizeof(Op->Name), "%s", "ReadImage");
+  }
+  else if (Reads)
+  {
+    Reg_Span(Span, sizeof(Span), ReadReg, ReadLen);
+    snprintf(Op->Name, sizeof(Op->Name), "read %s", Span);
+  }
+  else if (Unlock || Lock)
+  {
+    snprintf(Op->Name, sizeof(Op->Name), "%s", Unlock ? "unlock" : "lock");
+  }
+  else
+  {
+    Txn = &Txns[Op->First];
+    snprintf(Op->Name, sizeof(Op->Name), "%s", Txn->Read ? "read" : Txn->Len ? "pointer" : "ping");
+  }
+}
+
+/**
+ * @brief  Group transactions into driver operations
+ */
+static void
+Op_Build(void)
+{
+  unsigned i = 0;
+  unsigned j = 0;
+  unsigned n = 0;
+
+  Ops = (Op_t *)calloc(TxnCount ? TxnCount : 1, sizeof(Op_t));
+  while (i < TxnCount)
+  {
+    j = i + 1;
+    if (Txn_IsChip(i))
+    {
+      // [pointer + read], WP off ... WP on, [pointer + read]
+      n = Txn_ReadOp(i);
+      j = i + n;
+      if (Txn_IsWP(j, 0) && (!n || Txn_Near(j)))
+      {
+        for (j++; Txn_Near(j) && Txn_IsChip(j) && !Txn_IsWP(j, 1); j++)
+          ;
+        if (Txn_Near(j) && Txn_IsWP(j, 1))
+        {
+          j++;
+          if (Txn_Near(j))
+            j += Txn_ReadOp(j);
+        }
+      }
+      else if (!n && !Txns[i].Read && Txns[i].Len > 1 &&
+               Txn_Near(i + 1) && Txn_IsWP(i + 1, 1))
+      {
+        j = i + 2; // write while WP was already off, then lock
+      }
+      else if (!n)
+      {
+        j = i + 1;
+      }
+    }
+
+    Ops[OpCount].First = i;
+    Ops[OpCount].Count = j - i;
+    Op_Name(&Ops[OpCount]);
+    OpCount++;
+    i = j;
+  }
+}
+
+
+/* Annotation -------------------------------------------------------------------*/
+/**
+ * @brief  Decode the registers of a transaction
+ * @param  First: Register of Data[0]
+ */
+static void
+Annotate_Regs(char *Note, unsigned First, const uint8_t *Data, unsigned Count)
+{
+  uint8_t Regs[LA_REGS];
+  uint8_t Have[LA_REGS];
+  uint8_t Value = 0;
+  unsigned Reg;
+  unsigned i;
+
+  memset(Have, 0, sizeof(Have));
+  for (i = 0; i < Count && i < LA_REGS; i++)
+  {
+    Reg = (First + i) % LA_REGS;
+    Regs[Reg] = Data[i];
+    Have[Reg] = 1;
+  }
+
+  for (Reg = HT1382_REG_ADDR_SECONDS; Reg <= HT1382_REG_ADDR_YEAR && Have[Reg]; Reg++)
+    ;
+  if (Reg > HT1382_REG_ADDR_YEAR)
+  {
+    Value = Regs[HT1382_REG_ADDR_HOURS];
+    Note_Add(Note, "  [20%02u-%02u-%02u %02u:%02u:%02u wd%u%s]",
+             BCD(Regs[HT1382_REG_ADDR_YEAR]), BCD(Regs[HT1382_REG_ADDR_MONTH]),
+             BCD(Regs[HT1382_REG_ADDR_DATE]),
+             HT1382_CHIP_HOURS_TO_DEC(Value),
+             BCD(Regs[HT1382_REG_ADDR_MINUTES]),
+             BCD(Regs[HT1382_REG_ADDR_SECONDS] & 0x7F), BCD(Regs[HT1382_REG_ADDR_DAY]),
+             (Regs[HT1382_REG_ADDR_SECONDS] >> HT1382_SECONDS_CH) & 0x01 ? " CH" : "");
+  }
+
+  if (Have[HT1382_REG_ADDR_ST1])
+    Note_Add(Note, "  [WP %s]",
+             (Regs[HT1382_REG_ADDR_ST1] >> HT1382_ST1_WP) & 0x01 ? "on" : "off");
+
+  if (Have[HT1382_REG_ADDR_ST2])
+  {
+    Value = Regs[HT1382_REG_ADDR_ST2];
+    Note_Add(Note, "  [ST2%s%s%s%s%s%s]",
+             (Value >> HT1382_ST2_ARE) & 0x01 ? " ARE" : "",
+             (Value >> HT1382_ST2_EWE) & 0x01 ? " EWE" : "",
+             (Value >> HT1382_ST2_EB) & 0x01 ? " EB" : "",
+             (Value >> HT1382_ST2_AI) & 0x01 ? " AI" : "",
+             (Value >> HT1382_ST2_BE) & 0x01 ? " BE" : "",
+             Value ? "" : " clear");
+  }
+
+  if (Have[HT1382_REG_ADDR_INT])
+  {
+    Value = Regs[HT1382_REG_ADDR_INT];
+    Note_Add(Note, "  [wave %s%s%s%s%s]", Wave_Names[(Value >> HT1382_INT_FO0) & 0x0F],
+             (Value >> HT1382_INT_IME) & 0x01 ? " IME" : "",
+             (Value >> HT1382_INT_AE) & 0x01 ? " AE" : "",
+             (Value >> HT1382_INT_LPM) & 0x01 ? " LPM" : "",
+             (Value >> HT1382_INT_OEOBM) & 0x01 ? " OEOBM" : "");
+  }
+
+  // alarm fields take part in the compare when their enable bit is set
+  for (Reg = HT1382_REG_ADDR_SECONDS_ALARM; Reg <= HT1382_REG_ADDR_DAY_ALARM && !Have[Reg]; Reg++)
+    ;
+  if (Reg <= HT1382_REG_ADDR_DAY_ALARM)
+  {
+    Note_Add(Note, "  [alarm");
+    for (Reg = HT1382_REG_ADDR_SECONDS_ALARM; Reg <= HT1382_REG_ADDR_DAY_ALARM; Reg++)
+    {
+      if (!Have[Reg])
+        continue;
+      if ((Regs[Reg] >> HT1382_SECONDS_ALARM_SECEN) & 0x01)
+        Note_Add(Note, " %s %u", Alarm_Names[Reg - HT1382_REG_ADDR_SECONDS_ALARM],
+                 BCD(Regs[Reg] & 0x7F));
+      else
+        Note_Add(Note, " %s *", Alarm_Names[Reg - HT1382_REG_ADDR_SECONDS_ALARM]);
+    }
+    Note_Add(Note, "]");
+  }
+
+  if (Have[HT1382_REG_ADDR_DT])
+    Note_Add(Note, "  [DT %c%u]",
+             (Regs[HT1382_REG_ADDR_DT] >> HT1382_DT_DTS) & 0x01 ? '-' : '+',
+             Regs[HT1382_REG_ADDR_DT] & 0x7F);
+}
+
+/**
+ * @brief  Run a chip transaction through the register model
+ * @param  Redundant: Set to 1 if no byte of the transaction was needed
+ * @retval Number of redundant registers
+ */
+static unsigned
+Model_Apply(unsigned Index, char *Note, int *Redundant)
+{
+  const Txn_t *Txn = &Txns[Index];
+  const uint8_t *Data = Txn->Data;
+  unsigned Count = Txn->Len;
+  unsigned Dup = 0;
+  unsigned Reg = 0;
+  unsigned Protected = 0;
+  char List[LA_NOTE_MAX] = "";
+  unsigned i;
+
+  *Redundant = 0;
+
+  if (!Txn->Read)
+  {
+    if (!Count)
+      return 0;
+    Model_Pointer = Data[0] % LA_REGS;
+    Data++;
+    Count--;
+  }
+  else if (Model_Pointer < 0)
+  {
+    Note_Add(Note, "  (pointer unknown)");
+    return 0;
+  }
+
+  Annotate_Regs(Note, (unsigned)Model_Pointer, Data, Count);
+
+  for (i = 0; i < Count; i++)
+  {
+    Reg = (unsigned)Model_Pointer;
+    Model_Pointer = (Model_Pointer + 1) % LA_REGS;
+
+    if (!Txn->Read && Reg != HT1382_REG_ADDR_ST1 && Model_Known[HT1382_REG_ADDR_ST1] &&
+        (Model_Regs[HT1382_REG_ADDR_ST1] >> HT1382_ST1_WP) & 0x01)
+    {
+      Protected++;
+      continue; // ignored by the chip
+    }
+
+    if (LA_IS_STABLE(Reg) && Model_Known[Reg])
+    {
+      if (Model_Regs[Reg] == Data[i])
+      {
+        Dup++;
+        Note_Add(List, "%s%s", Dup > 1 ? "," : "", Reg_Names[Reg]);
+      }
+      else if (Txn->Read)
+      {
+        Note_Add(Note, "  ! %s changed %02X->%02X", Reg_Names[Reg], Model_Regs[Reg], Data[i]);
+      }
+    }
+    Model_Regs[Reg] = Data[i];
+    Model_Known[Reg] = Index + 1;
+  }
+
+  if (Protected)
+    Note_Add(Note, "  ! %u byte(s) ignored: WP on", Protected);
+  if (Dup)
+  {
+    Note_Add(Note, "  ! redundant %s %s", Txn->Read ? "read" : "write", List);
+    *Redundant = (Dup == Count);
+  }
+
+  return Dup;
+}
+
+
+/* Report -----------------------------------------------------------------------*/
+static Stat_t *
+Stat_Get(const char *Name)
+{
+  unsigned i;
+
+  for (i = 0; i < StatCount; i++)
+    if (!strcmp(Stats[i].Name, Name))
+      return &Stats[i];
+
+  if (StatCount == LA_STATS_MAX)
+    return &Stats[LA_STATS_MAX - 1];
+
+  snprintf(Stats[StatCount].Name, LA_NAME_MAX, "%s", Name);
+  return &Stats[StatCount++];
+}
+
+/**
+ * @param  Pointer: Register pointer before the transaction, -1: unknown
+ */
+static void
+Report_Txn(unsigned Index, int Pointer, const char *Note)
+{
+  const Txn_t *Txn = &Txns[Index];
+  char Span[48] = "-";
+  unsigned First = 0;
+  unsigned i;
+
+  if (Txn->Address != HT1382_ADDRESS)
+    snprintf(Span, sizeof(Span), "dev 0x%02X", Txn->Address);
+  else if (!Txn->Read && Txn->Len == 1)
+    snprintf(Span, sizeof(Span), "ptr %s", Reg_Names[Txn->Data[0] % LA_REGS]);
+  else if (!Txn->Read && Txn->Len)
+    Reg_Span(Span, sizeof(Span), Txn->Data[0], Txn->Len - 1);
+  else if (Txn->Read && Pointer >= 0)
+    Reg_Span(Span, sizeof(Span), (unsigned)Pointer, Txn->Len);
+
+  printf("  #%-6u", Index);
+  if (HasTime)
+    printf(" %12.4f ms  gap %9.1f us  %8.1f us",
+           Txn->Start * 1e3, Txn_Gap(Index) * 1e6, (Txn->End - Txn->Start) * 1e6);
+  printf("  %c %-26s", Txn->Read ? 'R' : 'W', Span);
+
+  First = (!Txn->Read && Txn->Address == HT1382_ADDRESS) ? 1 : 0;
+  if (First)
+    printf(" @%02X", Txn->Data[0]);
+  for (i = First; i < Txn->Len; i++)
+    printf(" %02X", Txn->Data[i]);
+  printf("%s%s\n", Txn->Nack ? "  NACK" : "", Note);
+}
+
+static int
+Report(int Summary)
+{
+  const Op_t *Op = NULL;
+  const Txn_t *Txn = NULL;
+  Stat_t *Stat = NULL;
+  Stat_t Total;
+  char Note[LA_NOTE_MAX];
+  double *Rates = NULL;
+  unsigned RateCount = 0;
+  double Time = 0;
+  double Bus = 0;
+  double Wasted = 0;
+  unsigned Redundant = 0;
+  int Whole = 0;
+  int Pointer = -1;
+  unsigned o, i;
+
+  Rates = (double *)calloc(TxnCount ? TxnCount : 1, sizeof(double));
+  memset(&Total, 0, sizeof(Total));
+
+  for (o = 0; o < OpCount; o++)
+  {
+    Op = &Ops[o];
+    Stat = Stat_Get(Op->Name);
+    Stat->Ops++;
+    Redundant = 0;
+    Wasted = 0;
+    Bus = 0;
+
+    Txn = &Txns[Op->First];
+    Time = Txns[Op->First + Op->Count - 1].End - Txn->Start;
+    if (HasTime && o)
+      Gaps_Add(&GapsBetween, Txn_Gap(Op->First));
+
+    if (!Summary)
+    {
+      printf("%s", Op->Name);
+      if (HasTime)
+        printf("  (%u tx, %.1f us)", Op->Count, Time * 1e6);
+      printf("\n");
+    }
+
+    for (i = Op->First; i < Op->First + Op->Count; i++)
+    {
+      Txn = &Txns[i];
+      Note[0] = '\0';
+      Pointer = Model_Pointer;
+      Stat->Transactions++;
+      Stat->Bytes += 1 + Txn->Len;
+      Bus += Txn->End - Txn->Start;
+      if (HasTime && i > Op->First)
+        Gaps_Add(&GapsInside, Txn_Gap(i));
+      if (HasTime && Txn->End > Txn->Start && Txn->Len)
+        Rates[RateCount++] = (9.0 * (1 + Txn->Len) + 2) / (Txn->End - Txn->Start);
+
+      if (Txn->Address != HT1382_ADDRESS)
+      {
+        OtherCount++;
+      }
+      else if (Txn->Nack)
+      {
+        NackCount++;
+      }
+      else
+      {
+        Redundant += Model_Apply(i, Note, &Whole);
+        if (Whole)
+        {
+          // a redundant read also wastes its pointer write
+          Wasted += Txn->End - Txn->Start;
+          if (Txn->Read && i > Op->First && Txn_IsPointer(i - 1))
+            Wasted += Txn->Start - Txns[i - 1].Start;
+        }
+      }
+
+      if (!Summary)
+        Report_Txn(i, Pointer, Note);
+    }
+
+    Stat->Time += Time;
+    if (Time > Stat->TimeMax)
+      Stat->TimeMax = Time;
+    Stat->Bus += Bus;
+    Stat->Redundant += Redundant;
+    Stat->RedundantTime += Wasted;
+  }
+
+  printf("%stransactions: %u, operations: %u, other devices: %u, NACK: %u\n",
+         Summary ? "" : "\n", TxnCount, OpCount, OtherCount, NackCount);
+  if (!HasTime)
+  {
+    printf("no timing in the input\n");
+    free(Rates);
+    return 0;
+  }
+
+  printf("\n%-32s %6s %6s %7s %10s %10s %10s %10s %6s %11s\n", "operation", "ops", "tx",
+         "bytes", "mean us", "max us", "bus us", "host us", "redund", "redund us");
+  for (i = 0; i < StatCount; i++)
+  {
+    Stat = &Stats[i];
+    printf("%-32s %6u %6u %7u %10.1f %10.1f %10.1f %10.1f %6u %11.1f\n", Stat->Name,
+           Stat->Ops, Stat->Transactions, Stat->Bytes, Stat->Time * 1e6 / Stat->Ops,
+           Stat->TimeMax * 1e6, Stat->Bus * 1e6 / Stat->Ops,
+           (Stat->Time - Stat->Bus) * 1e6 / Stat->Ops, Stat->Redundant,
+           Stat->RedundantTime * 1e6);
+    Total.Ops += Stat->Ops;
+    Total.Transactions += Stat->Transactions;
+    Total.Bytes += Stat->Bytes;
+    Total.Time += Stat->Time;
+    Total.Bus += Stat->Bus;
+    Total.Redundant += Stat->Redundant;
+    Total.RedundantTime += Stat->RedundantTime;
+  }
+  printf("%-32s %6u %6u %7u %10s %10s %10s %10s %6u %11.1f\n", "total", Total.Ops,
+         Total.Transactions, Total.Bytes, "", "", "", "", Total.Redundant,
+         Total.RedundantTime * 1e6);
+  printf("\nbus time %.1f us, host time inside operations %.1f us",
+         Total.Bus * 1e6, (Total.Time - Total.Bus) * 1e6);
+  if (TxnCount)
+    printf(", capture span %.1f us", (Txns[TxnCount - 1].End - Txns[0].Start) * 1e6);
+  printf("\n\n");
+
+  Gaps_Print("gaps inside operations", &GapsInside);
+  Gaps_Print("gaps between operations", &GapsBetween);
+
+  if (RateCount)
+  {
+    qsort(Rates, RateCount, sizeof(double), Double_Compare);
+    printf("%-32s %.1f kHz (median of %u transactions)\n",
+           "SCL estimate", Rates[RateCount / 2] / 1e3, RateCount);
+  }
+
+  free(Rates);
+  return 0;
+}
+
+
+int main(int argc, char *argv[])
+{
+  const char *Path = NULL;
+  const char *Format = NULL;
+  const char *Ext = NULL;
+  int Summary = 0;
+  FILE *File = NULL;
+  int Result = 0;
+  int i;
+
+  for (i = 1; i < argc; i++)
+  {
+    if (!strcmp(argv[i], "--format") && i + 1 < argc)
+      Format = argv[++i];
+    else if (!strcmp(argv[i], "--samplerate") && i + 1 < argc)
+      SampleRate = strtod(argv[++i], NULL);
+    else if (!strcmp(argv[i], "--op-gap") && i + 1 < argc)
+      OpGap = strtod(argv[++i], NULL) * 1e-6;
+    else if (!strcmp(argv[i], "--summary"))
+      Summary = 1;
+    else if (argv[i][0] != '-' && !Path)
+      Path = argv[i];
+    else
+      Path = NULL, i = argc;
+  }
+
+  if (!Path)
+  {
+    fprintf(stderr, "usage: %s [--format sigrok|csv] [--samplerate HZ] "
+                    "[--op-gap US] [--summary] FILE\n", argv[0]);
+    return 2;
+  }
+
+  if (!Format)
+  {
+    Ext = strrchr(Path, '.');
+    Format = (Ext && !strcmp(Ext, ".csv")) ? "csv" : "sigrok";
+  }
+
+  File = fopen(Path, "r");
+  if (!File)
+  {
+    perror(Path);
+    return 1;
+  }
+  if (!strcmp(Format, "csv"))
+    Result = Input_Csv(File);
+  else
+    Result = Input_Sigrok(File);
+  fclose(File);
+  if (Result < 0)
+    return 1;
+
+  Txn_Build();
+  Op_Build();
+
+  return Report(Summary);
+}
@@ -0,0 +1,457 @@
+/**
+ **********************************************************************************
+ * @file   main.c
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  Host model of the STM32 port time register mirror
+ **********************************************************************************
+ *
+ * Copyright (c) 2024 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+
+
+
+/**
+ * Usage: ht1382-mirror-sim [--ms N] [--us N] [--single]
+ *
+ * Single-core model of the STM32 port with HT1382_MIRROR_HTIM. The main loop
+ * is the thread context and calls HT1382_GetDateTime (and now and then
+ * HT1382_SetDateTime) of the real HT1382.c. A SIGALRM every --us
+ * microseconds is the interrupt context: it either runs the timer tick of the
+ * port, which starts a mirror read, or moves the running DMA read on by one
+ * byte and runs the completion callback after the 7th byte. One read in 64
+ * fails at a random byte and runs the error callback instead. Every 16th
+ * interrupt also calls HT1382_GetDateTime, which must either decode the
+ * mirror or fail at once because the port Lock refuses interrupt context.
+ * The application mutex linked before MirrorStart is a flag that must never
+ * be taken twice.
+ *
+ * Every chip time encodes one value v (0..23) in all 7 fields, so a decoded
+ * time that mixes two reads is caught ("torn"). A DMA byte or timer tick
+ * while the driver owns the bus is a "collision". --single lets the DMA
+ * write the latest buffer in place, which the check must catch.
+ *
+ * Results (2 s, 20 us):
+ *
+ *   mode    reads/s  fallback%  published  errors  writes   torn  collisions  isr fail%
+ *   double   ~17M        1.0      ~12000    ~200    ~500       0           0      ~6.5
+ *   single   ~17M        1.0      ~12000    ~200    ~500    ~26M           0      ~6.5
+ *
+ * The mirror serves about 99 % of the reads without the lock. With --single
+ * most reads see a half written buffer, with the double buffer none does.
+ * Interrupt reads fail only while the mirror is not valid.
+ *
+ * Fallbacks are the reads after a failed read or a write, until the next
+ * read completes; they read the chip under Platform.Lock.
+ *
+ * Exits with 1 if a read was torn, the bus collided or the mutex was taken
+ * twice.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/time.h>
+#include "HT1382.h"
+
+#if !HT1382_CONFIG_MIRROR
+#error "build with -DHT1382_CONFIG_MIRROR=1"
+#endif
+
+
+/* RAM model of the RTC ---------------------------------------------------------*/
+static uint8_t Sim_Regs[HT1382_CHIP_REG_COUNT];
+static uint8_t Sim_Pointer;
+static uint32_t Sim_Time;
+// the thread context is in a driver transfer
+static volatile uint8_t Sim_BusOwner;
+
+static uint8_t
+Sim_BCD(uint8_t Value)
+{
+  return (uint8_t)(((Value / 10) << 4) | (Value % 10));
+}
+
+static void
+Sim_EncodeTime(uint8_t *Regs)
+{
+  uint8_t v = Sim_Time % 24;
+
+  Regs[HT1382_REG_ADDR_SECONDS] = Sim_BCD(v);
+  Regs[HT1382_REG_ADDR_MINUTES] = Sim_BCD(v);
+  Regs[HT1382_REG_ADDR_HOURS] = Sim_BCD(v) | HT1382_CHIP_HOURS_24H;
+  Regs[HT1382_REG_ADDR_DATE] = Sim_BCD(v + 1);
+  Regs[HT1382_REG_ADDR_MONTH] = Sim_BCD(v % 12 + 1);
+  Regs[HT1382_REG_ADDR_DAY] = v % 7 + 1;
+  Regs[HT1382_REG_ADDR_YEAR] = Sim_BCD(v);
+}
+
+static int
+Sim_Check(const HT1382_DateTime_t *DateTime)
+{
+  uint8_t v = DateTime->Second;
+
+  return v < 24 && DateTime->Minute == v && DateTime->Hour == v &&
+         DateTime->Day == v + 1 && DateTime->Month == v % 12 + 1 &&
+         DateTime->WeekDay == v % 7 + 1 && DateTime->Year == v;
+}
+
+
+/* Port model (see port/STM32-HAL/HT1382_platform.c) ----------------------------*/
+static HT1382_Mirror_t Mirror;
+static volatile uint8_t MirrorBusy;
+static volatile uint8_t MirrorPaused;
+static int MirrorSingle;
+
+// DMA transfer of the running mirror read
+static uint8_t *Dma_Buffer;
+static uint8_t Dma_Frame[7];
+static uint8_t Dma_Index;
+static uint8_t Dma_FailAt;
+
+static volatile uint32_t Stat_Collisions;
+static volatile uint32_t Stat_Published;
+static volatile uint32_t Stat_Errors;
+static uint32_t Stat_Fallbacks;
+static volatile uint32_t Stat_IsrReads;
+static volatile uint32_t Stat_IsrFails;
+static volatile uint32_t Stat_IsrTorn;
+static volatile uint32_t Stat_MutexErrors;
+static int Sim_InRead;
+// the signal handler runs (the port checks IPSR)
+static volatile uint8_t Sim_InInterrupt;
+static HT1382_Handler_t *Sim_Handler;
+
+static uint32_t Rand_State = 1;
+
+static uint32_t
+Rand_Next(void)
+{
+  // xorshift32
+  Rand_State ^= Rand_State << 13;
+  Rand_State ^= Rand_State >> 17;
+  Rand_State ^= Rand_State << 5;
+  return Rand_State;
+}
+
+static void
+Mirror_Tick(void)
+{
+  if (MirrorBusy)
+    return;
+
+  MirrorBusy = 1;
+  HT1382_MIRROR_BARRIER();
+  if (MirrorPaused)
+  {
+    MirrorBusy = 0;
+    return;
+  }
+
+  if (Sim_BusOwner)
+    Stat_Collisions++;
+
+  // HAL_I2C_Mem_Read_DMA: the chip latches the time at the register pointer
+  Sim_Time++;
+  Sim_EncodeTime(Dma_Frame);
+  Dma_Buffer = Mirror.Buffer[(uint8_t)(Mirror.Seq + (MirrorSingle ? 0 : 1)) & 1];
+  Dma_Index = 0;
+  Dma_FailAt = (Rand_Next() % 64) ? 7 : (Rand_Next() % 7);
+}
+
+static void
+Mirror_Done(void)
+{
+  HT1382_MIRROR_BARRIER();
+  Mirror.Seq++;
+  Mirror.Valid = 1;
+  MirrorBusy = 0;
+  Stat_Published++;
+}
+
+static void
+Mirror_Error(void)
+{
+  Mirror.Valid = 0;
+  MirrorBusy = 0;
+  Stat_Errors++;
+}
+
+static void
+Sim_InterruptRead(void)
+{
+  static uint8_t Count = 0;
+  HT1382_DateTime_t DateTime;
+
+  if (++Count % 16)
+    return;
+
+  Stat_IsrReads++;
+  if (HT1382_GetDateTime(Sim_Handler, &DateTime) != HT1382_OK)
+    Stat_IsrFails++;
+  else if (!Sim_Check(&DateTime))
+    Stat_IsrTorn++;
+}
+
+static void
+Sim_Interrupt(int Signal)
+{
+  (void)Signal;
+
+  Sim_InInterrupt = 1;
+  Sim_InterruptRead();
+  Sim_InInterrupt = 0;
+
+  if (!MirrorBusy)
+  {
+    Mirror_Tick();
+    return;
+  }
+
+  if (Sim_BusOwner)
+    Stat_Collisions++;
+
+  if (Dma_Index == Dma_FailAt)
+  {
+    Mirror_Error();
+    return;
+  }
+
+  Dma_Buffer[Dma_Index] = Dma_Frame[Dma_Index];
+  if (++Dma_Index == 7)
+    Mirror_Done();
+}
+
+// application mutex
+static volatile uint8_t User_Held;
+
+static int8_t
+User_Lock(void)
+{
+  if (User_Held)
+    Stat_MutexErrors++;
+  User_Held = 1;
+  return 0;
+}
+
+static int8_t
+User_Unlock(void)
+{
+  User_Held = 0;
+  return 0;
+}
+
+static HT1382_PlatformLockUnlock_t Platform_UserLock;
+static HT1382_PlatformLockUnlock_t Platform_UserUnlock;
+
+static int8_t
+Platform_Lock(void)
+{
+  if (Sim_InInterrupt)
+    return -1;
+
+  if (Sim_InRead)
+    Stat_Fallbacks++;
+
+  if (Platform_UserLock)
+    if (Platform_UserLock() < 0)
+      return -1;
+
+  MirrorPaused = 1;
+  HT1382_MIRROR_BARRIER();
+  while (MirrorBusy)
+    ;
+
+  return 0;
+}
+
+static int8_t
+Platform_Unlock(void)
+{
+  MirrorPaused = 0;
+
+  if (Platform_UserUnlock)
+    return Platform_UserUnlock();
+
+  return 0;
+}
+
+static int8_t
+Platform_WriteData(uint8_t Address, uint8_t *Data, uint8_t Len)
+{
+  uint8_t i = 0;
+
+  (void)Address;
+  if (Len > 1)
+    Mirror.Valid = 0;
+
+  Sim_BusOwner = 1;
+  Sim_Pointer = Data[0];
+  for (i = 1; i < Len; i++, Sim_Pointer++)
+  {
+    if (Sim_Pointer == HT1382_REG_ADDR_SECONDS)
+      Sim_Time = (Data[i] >> 4) * 10 + (Data[i] & 0x0F);
+    Sim_Regs[Sim_Pointer % HT1382_CHIP_REG_COUNT] = Data[i];
+  }
+  Sim_BusOwner = 0;
+
+  return 0;
+}
+
+static int8_t
+Platform_ReadData(uint8_t Address, uint8_t *Data, uint8_t Len)
+{
+  uint8_t Time[7];
+  uint8_t i = 0;
+
+  (void)Address;
+  Sim_BusOwner = 1;
+  Sim_EncodeTime(Time);
+  for (i = 0; i < Len; i++, Sim_Pointer++)
+  {
+    if (Sim_Pointer < 7)
+      Data[i] = Time[Sim_Pointer];
+    else
+      Data[i] = Sim_Regs[Sim_Pointer % HT1382_CHIP_REG_COUNT];
+  }
+  Sim_BusOwner = 0;
+
+  return 0;
+}
+
+
+static double
+Sim_Now(void)
+{
+  struct timespec Now;
+
+  clock_gettime(CLOCK_MONOTONIC, &Now);
+  return Now.tv_sec + Now.tv_nsec * 1e-9;
+}
+
+
+int main(int argc, char *argv[])
+{
+  HT1382_Handler_t Handler = {0};
+  HT1382_DateTime_t DateTime = {0};
+  struct sigaction Action;
+  struct itimerval Timer;
+  unsigned long Ms = 2000;
+  unsigned long Us = 20;
+  unsigned long Reads = 0;
+  unsigned long Torn = 0;
+  unsigned long Writes = 0;
+  double Start = 0;
+  double Elapsed = 0;
+  int i = 0;
+
+  for (i = 1; i < argc; i++)
+  {
+    if (!strcmp(argv[i], "--ms") && i + 1 < argc)
+      Ms = strtoul(argv[++i], NULL, 0);
+    else if (!strcmp(argv[i], "--us") && i + 1 < argc)
+      Us = strtoul(argv[++i], NULL, 0);
+    else if (!strcmp(argv[i], "--single"))
+      MirrorSingle = 1;
+    else
+    {
+      fprintf(stderr, "usage: %s [--ms N] [--us N] [--single]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  HT1382_PLATFORM_LINK_SEND(&Handler, Platform_WriteData);
+  HT1382_PLATFORM_LINK_RECEIVE(&Handler, Platform_ReadData);
+  if (HT1382_Init(&Handler) != HT1382_OK)
+    return 1;
+
+  HT1382_PLATFORM_LINK_LOCK(&Handler, User_Lock);
+  HT1382_PLATFORM_LINK_UNLOCK(&Handler, User_Unlock);
+
+  // HT1382_Platform_MirrorStart
+  Platform_UserLock = Handler.Platform.Lock;
+  Platform_UserUnlock = Handler.Platform.Unlock;
+  HT1382_PLATFORM_LINK_LOCK(&Handler, Platform_Lock);
+  HT1382_PLATFORM_LINK_UNLOCK(&Handler, Platform_Unlock);
+  Handler.Mirror = &Mirror;
+  Sim_Handler = &Handler;
+
+  memset(&Action, 0, sizeof(Action));
+  Action.sa_handler = Sim_Interrupt;
+  Action.sa_flags = SA_RESTART;
+  sigaction(SIGALRM, &Action, NULL);
+  Timer.it_interval.tv_sec = 0;
+  Timer.it_interval.tv_usec = (long)Us;
+  Timer.it_value = Timer.it_interval;
+  setitimer(ITIMER_REAL, &Timer, NULL);
+
+  Start = Sim_Now();
+  while (Elapsed * 1000 < Ms)
+  {
+    Sim_InRead = 1;
+    if (HT1382_GetDateTime(&Handler, &DateTime) != HT1382_OK)
+      return 1;
+    Sim_InRead = 0;
+
+    if (!Sim_Check(&DateTime))
+    {
+      if (Torn < 5)
+        printf("torn: %02u:%02u:%02u %u %02u/%02u/%02u\n",
+               DateTime.Hour, DateTime.Minute, DateTime.Second, DateTime.WeekDay,
+               DateTime.Year, DateTime.Month, DateTime.Day);
+      Torn++;
+    }
+    Reads++;
+
+    if (!(Reads & 0xFFFF))
+    {
+      uint8_t v = Rand_Next() % 24;
+      HT1382_DateTime_t Set = {v, v, v, v % 7 + 1, v + 1, v % 12 + 1, v};
+
+      if (HT1382_SetDateTime(&Handler, &Set) != HT1382_OK)
+        return 1;
+      Writes++;
+    }
+
+    if (!(Reads & 0x3FF))
+      Elapsed = Sim_Now() - Start;
+  }
+
+  memset(&Timer, 0, sizeof(Timer));
+  setitimer(ITIMER_REAL, &Timer, NULL);
+
+  printf("%-7s %8s %10s %10s %7s %7s %10s %7s %10s\n", "mode", "reads/s", "fallback%",
+         "published", "errors", "writes", "torn", "collisions", "isr fail%");
+  printf("%-7s %8.2fM %10.2f %10lu %7lu %7lu %10lu %7lu %10.2f\n",
+         MirrorSingle ? "single" : "double", Reads / Elapsed / 1e6,
+         100.0 * Stat_Fallbacks / Reads, (unsigned long)Stat_Published,
+         (unsigned long)Stat_Errors, Writes, Torn + Stat_IsrTorn,
+         (unsigned long)Stat_Collisions,
+         Stat_IsrReads ? 100.0 * Stat_IsrFails / Stat_IsrReads : 0.0);
+  if (Stat_MutexErrors)
+    printf("mutex taken twice: %lu\n", (unsigned long)Stat_MutexErrors);
+
+  return (Torn || Stat_IsrTorn || Stat_Collisions || Stat_MutexErrors) ? 1 : 0;
+}
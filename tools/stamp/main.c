@@ -0,0 +1,465 @@
+/**
+ **********************************************************************************
+ * @file   main.c
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  Size and speed benchmark of the HT1382_stamp.c codec
+ **********************************************************************************
+ *
+ * Copyright (c) 2024 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+
+
+
+/**
+ * Usage: ht1382-stamp-bench [--records N] [--seed S]
+ *
+ * Generates N event times for each of these logs, starting on a random
+ * date between 2000 and 2090:
+ *
+ *   1kHz     1000 events per second
+ *   10Hz     10 events per second
+ *   1Hz      one event per second with 1 in 1000 missed
+ *   minute   one event per minute +-5 s
+ *   sparse   random gaps, mean 1 hour
+ *
+ * and reports the stamp bytes per record for keyframe intervals 0, 256 and
+ * 64 next to a 4-byte epoch (4.00) and the raw time registers (7.00), and
+ * the ns per record with interval 256 of HT1382_StampEnc_Put (from Unix
+ * time), HT1382_StampEnc_PutRegs (from raw registers), a full decode of the
+ * registers + HT1382_Time_ToEpoch + HT1382_StampEnc_Put ("full") and
+ * HT1382_StampDec_Get. Every stream is decoded back from the start and from
+ * every keyframe and compared. A 12-hour mode log over two days (midnight
+ * and noon included) must give the same stream from PutRegs, from Put and
+ * from HT1382_GetDateTime + HT1382_Time_ToEpoch + Put on the same registers.
+ *
+ * Results (1M records, seed 1, x86-64 gcc -O2):
+ *
+ *   log       key=0  key=256  key=64  put ns  regs ns  full ns  get ns
+ *   1kHz       1.00     1.02    1.06     2.5      4.7      9.2     3.6
+ *   10Hz       1.00     1.02    1.06     2.4      4.5      9.9     3.5
+ *   1Hz        1.00     1.02    1.06     2.5      4.9      8.9     3.7
+ *   minute     2.00     2.01    2.05     3.2     12.5     10.7     4.9
+ *   sparse     2.31     2.32    2.35     9.7     28.1     23.5    12.3
+ *
+ * Logs with more than one event per minute mostly take the PutRegs fast
+ * path (seconds register only) at half the cost of a full decode; when
+ * every event is in a new minute the register compare is extra work.
+ * Deltas of -32..31 s fit in one byte, so the minute log needs two.
+ *
+ * (run "make bench" for the numbers of this machine)
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "HT1382_stamp.h"
+#include "HT1382_time.h"
+
+
+#define BENCH_ROUNDS    5
+
+
+static uint32_t Rand_State = 1;
+
+static uint32_t
+Rand_Next(void)
+{
+  // xorshift32
+  Rand_State ^= Rand_State << 13;
+  Rand_State ^= Rand_State >> 17;
+  Rand_State ^= Rand_State << 5;
+  return Rand_State;
+}
+
+static uint8_t
+DECtoBCD(uint8_t DEC)
+{
+  return (uint8_t)(((DEC / 10) << 4) | (DEC % 10));
+}
+
+static uint8_t
+BCDtoDEC(uint8_t BCD)
+{
+  return (uint8_t)((BCD >> 4) * 10 + (BCD & 0x0F));
+}
+
+static double
+Now(void)
+{
+  struct timespec Ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &Ts);
+  return Ts.tv_sec + Ts.tv_nsec * 1e-9;
+}
+
+
+/* Event logs -------------------------------------------------------------------*/
+typedef struct Log_s
+{
+  const char  *Name;
+  double      Rate;       // events per second, 0: random gaps
+} Log_t;
+
+static const Log_t Logs[] =
+{
+  {"1kHz", 1000}, {"10Hz", 10}, {"1Hz", 1}, {"minute", 1.0 / 60}, {"sparse", 0},
+};
+
+static void
+Log_Generate(const Log_t *Log, uint32_t *Epochs, uint8_t *Regs, size_t Count)
+{
+  HT1382_DateTime_t DateTime;
+  double t = HT1382_TIME_EPOCH_2000 + (double)(Rand_Next() % (90 * 365)) * 86400;
+  uint8_t *r = NULL;
+  size_t i = 0;
+
+  for (i = 0; i < Count; i++)
+  {
+    if (!Log->Rate)
+      t += -3600 * log((Rand_Next() + 1.0) / 4294967297.0);
+    else if (Log->Rate < 1)
+      t += 1 / Log->Rate + (double)(Rand_Next() % 11) - 5;
+    else
+      t += (Log->Rate == 1 && !(Rand_Next() % 1000)) ? 2 : 1 / Log->Rate;
+
+    // the RTC range ends in 2099: start over in 2000 like a clock reset
+    if (t >= HT1382_TIME_EPOCH_2000 + 36524.0 * 86400)
+      t -= 90 * 365 * 86400.0;
+
+    Epochs[i] = (uint32_t)t;
+    HT1382_Time_FromEpoch(Epochs[i], &DateTime);
+    r = &Regs[i * 7];
+    r[HT1382_REG_ADDR_SECONDS] = DECtoBCD(DateTime.Second);
+    r[HT1382_REG_ADDR_MINUTES] = DECtoBCD(DateTime.Minute);
+    r[HT1382_REG_ADDR_HOURS] = DECtoBCD(DateTime.Hour) | HT1382_CHIP_HOURS_24H;
+    r[HT1382_REG_ADDR_DATE] = DECtoBCD(DateTime.Day);
+    r[HT1382_REG_ADDR_MONTH] = DECtoBCD(DateTime.Month);
+    r[HT1382_REG_ADDR_DAY] = DateTime.WeekDay;
+    r[HT1382_REG_ADDR_YEAR] = DECtoBCD(DateTime.Year);
+  }
+}
+
+
+/* Codec runs -------------------------------------------------------------------*/
+static size_t
+Bench_Encode(const uint32_t *Epochs, const uint8_t *Regs, size_t Count,
+             uint16_t Interval, uint8_t *Out)
+{
+  HT1382_StampEnc_t Enc;
+  size_t Len = 0;
+  size_t i = 0;
+
+  HT1382_StampEnc_Init(&Enc, Interval);
+  for (i = 0; i < Count; i++)
+  {
+    if (Regs)
+      Len += HT1382_StampEnc_PutRegs(&Enc, &Regs[i * 7], &Out[Len]);
+    else
+      Len += HT1382_StampEnc_Put(&Enc, Epochs[i], &Out[Len]);
+  }
+
+  return Len;
+}
+
+/**
+ * @brief  Encode with a full decode of every record (the path PutRegs avoids)
+ */
+static size_t
+Bench_EncodeFull(const uint8_t *Regs, size_t Count, uint16_t Interval, uint8_t *Out)
+{
+  HT1382_StampEnc_t Enc;
+  HT1382_DateTime_t DateTime;
+  const uint8_t *r = NULL;
+  size_t Len = 0;
+  size_t i = 0;
+
+  HT1382_StampEnc_Init(&Enc, Interval);
+  for (i = 0; i < Count; i++)
+  {
+    r = &Regs[i * 7];
+    DateTime.Second = BCDtoDEC(r[HT1382_REG_ADDR_SECONDS] & 0x7F);
+    DateTime.Minute = BCDtoDEC(r[HT1382_REG_ADDR_MINUTES]);
+    DateTime.Hour = BCDtoDEC(r[HT1382_REG_ADDR_HOURS] & 0x3F);
+    DateTime.Day = BCDtoDEC(r[HT1382_REG_ADDR_DATE]);
+    DateTime.Month = BCDtoDEC(r[HT1382_REG_ADDR_MONTH]);
+    DateTime.WeekDay = r[HT1382_REG_ADDR_DAY];
+    DateTime.Year = BCDtoDEC(r[HT1382_REG_ADDR_YEAR]);
+    Len += HT1382_StampEnc_Put(&Enc, HT1382_Time_ToEpoch(&DateTime), &Out[Len]);
+  }
+
+  return Len;
+}
+
+/**
+ * @brief  Decode from the start and from every keyframe, returns mismatches
+ */
+static size_t
+Bench_Check(const uint32_t *Epochs, size_t Count, const uint8_t *Stream, size_t Len)
+{
+  HT1382_StampDec_t Dec;
+  HT1382_StampDec_t KeyDec;
+  size_t Errors = 0;
+  size_t Pos = 0;
+  size_t i = 0;
+  uint32_t Epoch = 0;
+  uint32_t KeyEpoch = 0;
+  uint8_t Size = 0;
+
+  HT1382_StampDec_Init(&Dec);
+  HT1382_StampDec_Init(&KeyDec);
+  for (i = 0; i < Count; i++)
+  {
+    // a fresh decoder at every keyframe must agree with the running one
+    if (HT1382_STAMP_IS_KEY(&Stream[Pos]))
+      HT1382_StampDec_Init(&KeyDec);
+
+    Size = HT1382_StampDec_Get(&Dec, &Stream[Pos], (uint16_t)(Len - Pos > 0xFFFF ? 0xFFFF : Len - Pos), &Epoch);
+    if (!Size ||
+        HT1382_StampDec_Get(&KeyDec, &Stream[Pos], Size, &KeyEpoch) != Size ||
+        Epoch != Epochs[i] || KeyEpoch != Epochs[i])
+    {
+      Errors++;
+      if (!Size)
+        break;
+    }
+    Pos += Size;
+  }
+
+  return Errors + (Pos != Len);
+}
+
+static double
+Bench_DecodeTime(const uint8_t *Stream, size_t Len, size_t Count)
+{
+  HT1382_StampDec_t Dec;
+  volatile uint32_t Sink = 0;
+  uint32_t Epoch = 0;
+  size_t Pos = 0;
+  size_t i = 0;
+  double Start = Now();
+
+  HT1382_StampDec_Init(&Dec);
+  for (i = 0; i < Count; i++)
+  {
+    Pos += HT1382_StampDec_Get(&Dec, &Stream[Pos], HT1382_STAMP_RECORD_MAX, &Epoch);
+    Sink += Epoch;
+  }
+  (void)Sink;
+  (void)Len;
+
+  return Now() - Start;
+}
+
+
+/* 12-hour mode check -----------------------------------------------------------*/
+// time registers served to the driver
+static uint8_t Sim_Regs[7];
+static uint8_t Sim_Pointer;
+
+static int8_t
+Sim_Send(uint8_t Address, uint8_t *Data, uint8_t Len)
+{
+  (void)Address;
+  (void)Len;
+  Sim_Pointer = Data[0];
+  return 0;
+}
+
+static int8_t
+Sim_Receive(uint8_t Address, uint8_t *Data, uint8_t Len)
+{
+  uint8_t i = 0;
+
+  (void)Address;
+  for (i = 0; i < Len; i++, Sim_Pointer++)
+    Data[i] = (Sim_Pointer < 7) ? Sim_Regs[Sim_Pointer] : 0;
+  return 0;
+}
+
+/**
+ * @brief  PutRegs and the driver decode on 12-hour mode registers against Put,
+ *         returns mismatches
+ */
+static size_t
+Check_12Hour(void)
+{
+  static uint8_t FromRegs[2 * 2880 * HT1382_STAMP_RECORD_MAX];
+  static uint8_t FromEpochs[2 * 2880 * HT1382_STAMP_RECORD_MAX];
+  static uint8_t FromDriver[2 * 2880 * HT1382_STAMP_RECORD_MAX];
+  HT1382_Handler_t Handler = {0};
+  HT1382_StampEnc_t RegsEnc;
+  HT1382_StampEnc_t EpochEnc;
+  HT1382_StampEnc_t DriverEnc;
+  HT1382_DateTime_t DateTime;
+  uint8_t *Regs = Sim_Regs;
+  uint8_t Hour = 0;
+  uint32_t Epoch = HT1382_TIME_EPOCH_2000 + 8825 * 86400UL; // 2024-02-28
+  size_t RegsLen = 0;
+  size_t EpochLen = 0;
+  size_t DriverLen = 0;
+  size_t i = 0;
+
+  HT1382_PLATFORM_LINK_SEND(&Handler, Sim_Send);
+  HT1382_PLATFORM_LINK_RECEIVE(&Handler, Sim_Receive);
+  if (HT1382_Init(&Handler) != HT1382_OK)
+    return 1;
+
+  HT1382_StampEnc_Init(&RegsEnc, 0);
+  HT1382_StampEnc_Init(&EpochEnc, 0);
+  HT1382_StampEnc_Init(&DriverEnc, 0);
+  for (i = 0; i < 2 * 2880; i++, Epoch += 30 + i % 3)
+  {
+    HT1382_Time_FromEpoch(Epoch, &DateTime);
+    Hour = (DateTime.Hour % 12) ? DateTime.Hour % 12 : 12;
+
+    Regs[HT1382_REG_ADDR_SECONDS] = DECtoBCD(DateTime.Second);
+    Regs[HT1382_REG_ADDR_MINUTES] = DECtoBCD(DateTime.Minute);
+    Regs[HT1382_REG_ADDR_HOURS] = DECtoBCD(Hour) | ((DateTime.Hour >= 12) << HT1382_HOURS_AM_PM);
+    if (!HT1382_CHIP_HOURS_IS_12H(Regs[HT1382_REG_ADDR_HOURS]))
+      Regs[HT1382_REG_ADDR_HOURS] ^= (1 << HT1382_HOURS_12_24);
+    Regs[HT1382_REG_ADDR_DATE] = DECtoBCD(DateTime.Day);
+    Regs[HT1382_REG_ADDR_MONTH] = DECtoBCD(DateTime.Month);
+    Regs[HT1382_REG_ADDR_DAY] = DateTime.WeekDay;
+    Regs[HT1382_REG_ADDR_YEAR] = DECtoBCD(DateTime.Year);
+
+    RegsLen += HT1382_StampEnc_PutRegs(&RegsEnc, Regs, &FromRegs[RegsLen]);
+    EpochLen += HT1382_StampEnc_Put(&EpochEnc, Epoch, &FromEpochs[EpochLen]);
+
+    if (HT1382_GetDateTime(&Handler, &DateTime) != HT1382_OK)
+      return 1;
+    DriverLen += HT1382_StampEnc_Put(&DriverEnc, HT1382_Time_ToEpoch(&DateTime),
+                                     &FromDriver[DriverLen]);
+  }
+
+  return (RegsLen != EpochLen || memcmp(FromRegs, FromEpochs, RegsLen) ||
+          DriverLen != EpochLen || memcmp(FromDriver, FromEpochs, DriverLen)) ? 1 : 0;
+}
+
+
+int main(int argc, char *argv[])
+{
+  static const uint16_t Intervals[] = {0, 256, 64};
+  uint32_t *Epochs = NULL;
+  uint8_t *Regs = NULL;
+  uint8_t *Stream = NULL;
+  size_t Count = 1000000;
+  size_t Len = 0;
+  size_t Errors = 0;
+  double Best[4];
+  double Start = 0;
+  double Elapsed = 0;
+  unsigned l = 0;
+  unsigned k = 0;
+  unsigned r = 0;
+  int i = 0;
+
+  for (i = 1; i < argc; i++)
+  {
+    if (!strcmp(argv[i], "--records") && i + 1 < argc)
+      Count = strtoul(argv[++i], NULL, 0);
+    else if (!strcmp(argv[i], "--seed") && i + 1 < argc)
+      Rand_State = (uint32_t)strtoul(argv[++i], NULL, 0) | 1;
+    else
+    {
+      fprintf(stderr, "usage: %s [--records N] [--seed S]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  Epochs = malloc(Count * sizeof(uint32_t));
+  Regs = malloc(Count * 7);
+  // padded so the timing loop can always offer HT1382_STAMP_RECORD_MAX bytes
+  Stream = malloc(Count * HT1382_STAMP_RECORD_MAX + HT1382_STAMP_RECORD_MAX);
+  if (!Epochs || !Regs || !Stream || !Count)
+  {
+    fprintf(stderr, "out of memory\n");
+    return 1;
+  }
+
+  printf("%zu records per log\n", Count);
+  printf("%-8s %7s %8s %7s %8s %8s %8s %7s %6s\n", "log", "key=0", "key=256", "key=64",
+         "put ns", "regs ns", "full ns", "get ns", "check");
+
+  for (l = 0; l < sizeof(Logs) / sizeof(Logs[0]); l++)
+  {
+    Log_Generate(&Logs[l], Epochs, Regs, Count);
+    printf("%-8s", Logs[l].Name);
+
+    for (k = 0; k < sizeof(Intervals) / sizeof(Intervals[0]); k++)
+    {
+      Len = Bench_Encode(Epochs, NULL, Count, Intervals[k], Stream);
+      Errors += Bench_Check(Epochs, Count, Stream, Len);
+      if (Bench_Encode(Epochs, Regs, Count, Intervals[k], Stream) != Len)
+        Errors++;
+      Errors += Bench_Check(Epochs, Count, Stream, Len);
+      printf(" %7.2f", (double)Len / Count);
+    }
+
+    // timing with keyframe interval 256
+    Best[0] = Best[1] = Best[2] = Best[3] = 1e9;
+    for (r = 0; r < BENCH_ROUNDS; r++)
+    {
+      Start = Now();
+      Len = Bench_Encode(Epochs, NULL, Count, 256, Stream);
+      Elapsed = Now() - Start;
+      Best[0] = Elapsed < Best[0] ? Elapsed : Best[0];
+
+      Start = Now();
+      Len = Bench_Encode(Epochs, Regs, Count, 256, Stream);
+      Elapsed = Now() - Start;
+      Best[1] = Elapsed < Best[1] ? Elapsed : Best[1];
+
+      Start = Now();
+      if (Bench_EncodeFull(Regs, Count, 256, Stream) != Len)
+        Errors++;
+      Elapsed = Now() - Start;
+      Best[3] = Elapsed < Best[3] ? Elapsed : Best[3];
+
+      Elapsed = Bench_DecodeTime(Stream, Len, Count);
+      Best[2] = Elapsed < Best[2] ? Elapsed : Best[2];
+    }
+
+    printf(" %8.1f %8.1f %8.1f %7.1f %6s\n", Best[0] * 1e9 / Count, Best[1] * 1e9 / Count,
+           Best[3] * 1e9 / Count, Best[2] * 1e9 / Count, Errors ? "FAIL" : "ok");
+  }
+
+  if (Check_12Hour())
+  {
+    printf("12-hour registers: FAIL\n");
+    Errors++;
+  }
+  else
+  {
+    printf("12-hour registers: ok\n");
+  }
+
+  free(Epochs);
+  free(Regs);
+  free(Stream);
+
+  return Errors ? 1 : 0;
+}
@@ -0,0 +1,354 @@
+/**
+ **********************************************************************************
+ * @file   main.c
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  Host check of the HT1382_time.c time base and conversions
+ **********************************************************************************
+ *
+ * Copyright (c) 2024 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+
+
+
+/**
+ * Usage: ht1382-time-check [--seed S]
+ *
+ * Runs HT1382_time.c against a RAM model of the RTC and a fake tick source,
+ * both driven by one simulated clock:
+ *
+ *   conversions  HT1382_Time_ToEpoch/FromEpoch against gmtime for every day
+ *                of 2000-2099 at a random second, and the range limits
+ *   wrap         HT1382_Time_Get at random steps of up to 0.3 s for 60 s
+ *                while the 1 kHz tick counter wraps at 2^32; the result
+ *                must stay within 2 ms of the simulated clock after
+ *                HT1382_Time_Sync with WaitEdge
+ *   resync       a tick 500 ppm fast for one simulated hour, with
+ *                ResyncPeriod 60 s (error must stay below 1 s and the RTC
+ *                must be read about once a minute) and without it (the
+ *                error grows to 1.8 s)
+ *
+ * Every bus transfer advances the simulated clock by 100 us.
+ *
+ * Exits with 1 if a check fails.
+ */
+
+#define _DEFAULT_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "HT1382_time.h"
+
+
+#define SIM_TICK_FREQ     1000
+#define SIM_BUS_US        100
+#define SIM_START_EPOCH   1700000000ULL   // 2023-11-14 22:13:20
+
+
+/* Simulated clock, RTC and tick ------------------------------------------------*/
+static uint64_t Sim_Us;           // simulated true time since SIM_START_EPOCH
+static int64_t Sim_RtcOffsetUs;   // RTC time - true time
+static uint32_t Sim_TickOffset;   // tick counter at Sim_Us = 0
+static int32_t Sim_TickPpm;       // tick frequency error
+static uint8_t Sim_Regs[HT1382_CHIP_REG_COUNT];
+static uint8_t Sim_Pointer;
+static uint32_t Sim_Reads;
+
+static uint8_t
+DECtoBCD(uint8_t DEC)
+{
+  return (uint8_t)(((DEC / 10) << 4) | (DEC % 10));
+}
+
+static uint8_t
+BCDtoDEC(uint8_t BCD)
+{
+  return (uint8_t)((BCD >> 4) * 10 + (BCD & 0x0F));
+}
+
+static time_t
+Sim_RtcEpoch(void)
+{
+  return (time_t)(SIM_START_EPOCH + (Sim_Us + Sim_RtcOffsetUs) / 1000000);
+}
+
+static void
+Sim_RtcEncode(void)
+{
+  time_t T = Sim_RtcEpoch();
+  struct tm Tm;
+
+  gmtime_r(&T, &Tm);
+  Sim_Regs[HT1382_REG_ADDR_SECONDS] = DECtoBCD((uint8_t)Tm.tm_sec);
+  Sim_Regs[HT1382_REG_ADDR_MINUTES] = DECtoBCD((uint8_t)Tm.tm_min);
+  Sim_Regs[HT1382_REG_ADDR_HOURS] = DECtoBCD((uint8_t)Tm.tm_hour) | HT1382_CHIP_HOURS_24H;
+  Sim_Regs[HT1382_REG_ADDR_DATE] = DECtoBCD((uint8_t)Tm.tm_mday);
+  Sim_Regs[HT1382_REG_ADDR_MONTH] = DECtoBCD((uint8_t)(Tm.tm_mon + 1));
+  Sim_Regs[HT1382_REG_ADDR_DAY] = (uint8_t)(Tm.tm_wday + 1);
+  Sim_Regs[HT1382_REG_ADDR_YEAR] = DECtoBCD((uint8_t)(Tm.tm_year - 100));
+}
+
+static int8_t
+Sim_Send(uint8_t Address, uint8_t *Data, uint8_t Len)
+{
+  struct tm Tm;
+  uint8_t i = 0;
+
+  (void)Address;
+  Sim_Us += SIM_BUS_US;
+  Sim_RtcEncode();
+  Sim_Pointer = Data[0];
+  for (i = 1; i < Len; i++)
+    Sim_Regs[Sim_Pointer++ % HT1382_CHIP_REG_COUNT] = Data[i];
+
+  // a time write restarts the RTC second
+  if (Len > 1 && Data[0] == HT1382_REG_ADDR_SECONDS)
+  {
+    memset(&Tm, 0, sizeof(Tm));
+    Tm.tm_sec = BCDtoDEC(Sim_Regs[HT1382_REG_ADDR_SECONDS] & 0x7F);
+    Tm.tm_min = BCDtoDEC(Sim_Regs[HT1382_REG_ADDR_MINUTES]);
+    Tm.tm_hour = BCDtoDEC(Sim_Regs[HT1382_REG_ADDR_HOURS] & 0x3F);
+    Tm.tm_mday = BCDtoDEC(Sim_Regs[HT1382_REG_ADDR_DATE]);
+    Tm.tm_mon = BCDtoDEC(Sim_Regs[HT1382_REG_ADDR_MONTH]) - 1;
+    Tm.tm_year = BCDtoDEC(Sim_Regs[HT1382_REG_ADDR_YEAR]) + 100;
+    Sim_RtcOffsetUs = (int64_t)(timegm(&Tm) - SIM_START_EPOCH) * 1000000 - (int64_t)Sim_Us;
+  }
+
+  return 0;
+}
+
+static int8_t
+Sim_Receive(uint8_t Address, uint8_t *Data, uint8_t Len)
+{
+  uint8_t i = 0;
+
+  (void)Address;
+  Sim_Us += SIM_BUS_US;
+  Sim_Reads++;
+  Sim_RtcEncode();
+  for (i = 0; i < Len; i++)
+    Data[i] = Sim_Regs[Sim_Pointer++ % HT1382_CHIP_REG_COUNT];
+
+  return 0;
+}
+
+static uint32_t
+Sim_GetTick(void)
+{
+  uint64_t Ticks = Sim_Us * SIM_TICK_FREQ / 1000000;
+
+  Ticks += (uint64_t)((double)Ticks * Sim_TickPpm / 1e6);
+  return Sim_TickOffset + (uint32_t)Ticks;
+}
+
+static uint32_t Rand_State = 1;
+
+static uint32_t
+Rand_Next(void)
+{
+  // xorshift32
+  Rand_State ^= Rand_State << 13;
+  Rand_State ^= Rand_State >> 17;
+  Rand_State ^= Rand_State << 5;
+  return Rand_State;
+}
+
+
+/* Checks -----------------------------------------------------------------------*/
+static int
+Check_Conversions(void)
+{
+  HT1382_DateTime_t DateTime;
+  struct tm Tm;
+  time_t T = 0;
+  uint32_t Day = 0;
+  uint32_t Epoch = 0;
+  int Errors = 0;
+
+  for (Day = 0; Day < 36525; Day++)
+  {
+    T = (time_t)(HT1382_TIME_EPOCH_2000 + Day * 86400UL + Rand_Next() % 86400);
+    gmtime_r(&T, &Tm);
+
+    if (HT1382_Time_FromEpoch((uint32_t)T, &DateTime) != HT1382_OK ||
+        DateTime.Second != Tm.tm_sec || DateTime.Minute != Tm.tm_min ||
+        DateTime.Hour != Tm.tm_hour || DateTime.Day != Tm.tm_mday ||
+        DateTime.Month != Tm.tm_mon + 1 || DateTime.Year != Tm.tm_year - 100 ||
+        DateTime.WeekDay != Tm.tm_wday + 1)
+    {
+      if (Errors++ < 5)
+        printf("  FromEpoch(%lld) differs from gmtime\n", (long long)T);
+      continue;
+    }
+
+    Epoch = HT1382_Time_ToEpoch(&DateTime);
+    if (Epoch != (uint32_t)T && Errors++ < 5)
+      printf("  ToEpoch(FromEpoch(%lld)) = %lu\n", (long long)T, (unsigned long)Epoch);
+  }
+
+  // 1999-12-31 23:59:59 and 2100-01-01 00:00:00 are out of range
+  if (HT1382_Time_FromEpoch(HT1382_TIME_EPOCH_2000 - 1, &DateTime) != HT1382_INVALID_PARAM ||
+      HT1382_Time_FromEpoch(4102444800UL, &DateTime) != HT1382_INVALID_PARAM)
+  {
+    printf("  out of range epoch accepted\n");
+    Errors++;
+  }
+
+  printf("%-12s 36525 days  %s\n", "conversions", Errors ? "FAIL" : "ok");
+  return Errors;
+}
+
+/**
+ * @brief  Time base error against the simulated clock in microseconds
+ */
+static int64_t
+Check_Error(HT1382_Time_t *Time, int *Errors)
+{
+  uint32_t Seconds = 0;
+  uint32_t MicroSeconds = 0;
+  int64_t TrueUs = 0;
+
+  if (HT1382_Time_Get(Time, &Seconds, &MicroSeconds) != HT1382_OK)
+  {
+    (*Errors)++;
+    return 0;
+  }
+
+  TrueUs = (int64_t)(SIM_START_EPOCH * 1000000 + Sim_Us);
+  return (int64_t)Seconds * 1000000 + MicroSeconds - TrueUs;
+}
+
+static int
+Check_Wrap(HT1382_Handler_t *Handler)
+{
+  HT1382_Time_t Time;
+  int64_t Err = 0;
+  int64_t MaxErr = 0;
+  uint32_t FirstTick = 0;
+  int Wrapped = 0;
+  int Errors = 0;
+
+  Sim_Us = 0;
+  Sim_RtcOffsetUs = 0;
+  Sim_TickPpm = 0;
+  Sim_TickOffset = 0xFFFFFFFFUL - 5 * SIM_TICK_FREQ;  // wraps after 5 s
+  FirstTick = Sim_GetTick();
+
+  HT1382_Time_Init(&Time, Handler, Sim_GetTick, SIM_TICK_FREQ);
+  if (HT1382_Time_Sync(&Time, 1) != HT1382_OK)
+    return 1;
+
+  while (Sim_Us < 60000000ULL)
+  {
+    Sim_Us += Rand_Next() % 300000;
+    Err = Check_Error(&Time, &Errors);
+    if (Err < 0)
+      Err = -Err;
+    if (Err > MaxErr)
+      MaxErr = Err;
+    if (Sim_GetTick() < FirstTick)
+      Wrapped = 1;
+  }
+
+  if (!Wrapped || MaxErr > 2000)
+    Errors++;
+
+  printf("%-12s max error %lld us, tick %s  %s\n", "wrap", (long long)MaxErr,
+         Wrapped ? "wrapped" : "did not wrap", Errors ? "FAIL" : "ok");
+  return Errors;
+}
+
+static int
+Check_Resync(HT1382_Handler_t *Handler, uint32_t ResyncPeriod)
+{
+  HT1382_Time_t Time;
+  int64_t Err = 0;
+  int64_t MaxErr = 0;
+  uint32_t Reads = 0;
+  int Errors = 0;
+
+  Sim_Us = 0;
+  Sim_RtcOffsetUs = 0;
+  Sim_TickPpm = 500;
+  Sim_TickOffset = Rand_Next();
+
+  HT1382_Time_Init(&Time, Handler, Sim_GetTick, SIM_TICK_FREQ);
+  Time.ResyncPeriod = ResyncPeriod;
+  if (HT1382_Time_Sync(&Time, 1) != HT1382_OK)
+    return 1;
+
+  Reads = Sim_Reads;
+  while (Sim_Us < 3600000000ULL)
+  {
+    Sim_Us += 100000 + Rand_Next() % 900000;
+    Err = Check_Error(&Time, &Errors);
+    if (Err < 0)
+      Err = -Err;
+    if (Err > MaxErr)
+      MaxErr = Err;
+  }
+  Reads = Sim_Reads - Reads;
+
+  // 500 ppm over one hour is 1.8 s
+  if (ResyncPeriod ? (MaxErr >= 1000000 || Reads < 3600 / ResyncPeriod - 1 ||
+                      Reads > 3600 / ResyncPeriod + 1)
+                   : (MaxErr < 1700000 || Reads))
+    Errors++;
+
+  printf("%-12s period %2lu s: max error %lld us, %lu RTC reads  %s\n", "resync",
+         (unsigned long)ResyncPeriod, (long long)MaxErr, (unsigned long)Reads,
+         Errors ? "FAIL" : "ok");
+  return Errors;
+}
+
+
+int main(int argc, char *argv[])
+{
+  HT1382_Handler_t Handler = {0};
+  int Errors = 0;
+  int i = 0;
+
+  for (i = 1; i < argc; i++)
+  {
+    if (!strcmp(argv[i], "--seed") && i + 1 < argc)
+      Rand_State = (uint32_t)strtoul(argv[++i], NULL, 0) | 1;
+    else
+    {
+      fprintf(stderr, "usage: %s [--seed S]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  HT1382_PLATFORM_LINK_SEND(&Handler, Sim_Send);
+  HT1382_PLATFORM_LINK_RECEIVE(&Handler, Sim_Receive);
+  if (HT1382_Init(&Handler) != HT1382_OK)
+    return 1;
+
+  Errors += Check_Conversions();
+  Errors += Check_Wrap(&Handler);
+  Errors += Check_Resync(&Handler, 60);
+  Errors += Check_Resync(&Handler, 0);
+
+  return Errors ? 1 : 0;
+}
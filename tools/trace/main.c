@@ -0,0 +1,574 @@
+/**
+ **********************************************************************************
+ * @file   main.c
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  Host tool: decode and replay HT1382 bus traces
+ **********************************************************************************
+ *
+ * Copyright (c) 2024 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+
+/**
+ * Usage:
+ *   ht1382-trace dump FILE [--rate HZ]
+ *   ht1382-trace replay FILE [--rate HZ] [--check]
+ *   ht1382-trace record FILE
+ *
+ * FILE is the output of HT1382_Trace_Export (see HT1382_trace.h).
+ *
+ * record writes a sample trace: HT1382_trace.c records a short session
+ * (time reads, a time write, out wave changes, an image read and a probe)
+ * of the driver of this tree against the simulated chip.
+ *
+ * dump prints every transaction with register names and decoded time.
+ *
+ * replay groups the recorded transactions into driver operations
+ * (HT1382_GetDateTime, HT1382_SetDateTime, HT1382_SetOutWave, ...), runs the
+ * same operations with the same arguments through the driver of this tree
+ * against a simulated chip, and compares the bus cost of the recorded run
+ * with the replayed one. Wire time is estimated at the given bus rate
+ * (default 100 kHz, 9 bit times per byte plus START/STOP). With --check the
+ * exit code is 1 if the replay costs more bus time than the recording.
+ * The replay handler starts with a loaded control register shadow, as the
+ * handler of a session that was running before the trace began.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "HT1382.h"
+#include "HT1382_trace.h"
+
+
+#define TRACE_MAX_RECORDS   65536
+#define SIM_REGS            0x15
+
+
+typedef struct Record_s
+{
+  uint8_t   Receive;
+  int8_t    Result;
+  uint32_t  Tick;
+  uint8_t   Reg;
+  uint8_t   Len;
+  uint8_t   Data[255];
+} Record_t;
+
+typedef enum OpType_e
+{
+  OP_GET_DATETIME = 0,
+  OP_SET_DATETIME,
+  OP_SET_OUTWAVE,
+  OP_READ_IMAGE,
+  OP_PROBE,
+  OP_RAW,
+  OP_COUNT
+} OpType_t;
+
+typedef struct Cost_s
+{
+  unsigned  Ops;
+  unsigned  Transactions;
+  unsigned  Bytes;
+} Cost_t;
+
+
+static const char *Op_Names[OP_COUNT] =
+{
+  "GetDateTime", "SetDateTime", "SetOutWave", "ReadImage", "Probe", "raw"
+};
+
+static const char *Reg_Names[SIM_REGS] =
+{
+  "SECONDS", "MINUTES", "HOURS", "DATE", "MONTH", "DAY", "YEAR",
+  "ST1", "ST2", "INT", "SECONDS_ALARM", "MINUTES_ALARM", "HOURS_ALARM",
+  "DATE_ALARM", "MONTH_ALARM", "DAY_ALARM", "DT", "USR1", "USR2", "USR3", "USR4"
+};
+
+static Record_t *Records = NULL;
+static unsigned RecordCount = 0;
+static unsigned Dropped = 0;
+static unsigned long Rate = 100000;
+
+
+/* Trace file -------------------------------------------------------------------*/
+static int
+Trace_Load(const char *Path)
+{
+  FILE *File = fopen(Path, "rb");
+  uint8_t Header[HT1382_TRACE_HEADER_SIZE];
+  uint8_t RecHeader[HT1382_TRACE_RECORD_SIZE];
+  Record_t *Rec = NULL;
+
+  if (!File)
+  {
+    perror(Path);
+    return -1;
+  }
+
+  if (fread(Header, 1, sizeof(Header), File) != sizeof(Header) ||
+      memcmp(Header, "HTTR", 4) || Header[4] != HT1382_TRACE_VERSION)
+  {
+    fprintf(stderr, "%s: not an HT1382 trace\n", Path);
+    fclose(File);
+    return -1;
+  }
+  Dropped = Header[6] | (Header[7] << 8);
+
+  Records = (Record_t *)calloc(TRACE_MAX_RECORDS, sizeof(Record_t));
+  while (RecordCount < TRACE_MAX_RECORDS &&
+         fread(RecHeader, 1, sizeof(RecHeader), File) == sizeof(RecHeader))
+  {
+    Rec = &Records[RecordCount];
+    Rec->Receive = (RecHeader[0] & HT1382_TRACE_DIR_RECEIVE) ? 1 : 0;
+    Rec->Result  = (int8_t)-(RecHeader[0] & HT1382_TRACE_RESULT_MASK);
+    Rec->Tick    = RecHeader[1] | (RecHeader[2] << 8) |
+                   ((uint32_t)RecHeader[3] << 16) | ((uint32_t)RecHeader[4] << 24);
+    Rec->Reg     = RecHeader[5];
+    Rec->Len     = RecHeader[6];
+    if (fread(Rec->Data, 1, Rec->Len, File) != Rec->Len)
+    {
+      fprintf(stderr, "%s: truncated record %u\n", Path, RecordCount);
+      break;
+    }
+    RecordCount++;
+  }
+
+  fclose(File);
+  return 0;
+}
+
+/**
+ * @brief  Bytes on the wire: slave address + (register pointer) + data
+ */
+static unsigned
+Record_WireBytes(const Record_t *Rec)
+{
+  return 1 + (Rec->Receive ? 0 : 1) + Rec->Len;
+}
+
+static double
+Cost_WireUs(const Cost_t *Cost)
+{
+  // 9 bit times per byte, about 2 bit times for START and STOP
+  return ((double)Cost->Bytes * 9 + Cost->Transactions * 2) * 1e6 / Rate;
+}
+
+static uint8_t
+BCD(uint8_t Value)
+{
+  return (uint8_t)((Value >> 4) * 10 + (Value & 0x0F));
+}
+
+
+/* Dump -------------------------------------------------------------------------*/
+static void
+Dump_Time(const uint8_t *Regs)
+{
+  printf("  [20%02u-%02u-%02u %02u:%02u:%02u wd%u%s]",
+         BCD(Regs[6]), BCD(Regs[4]), BCD(Regs[3]),
+         (Regs[2] & 0x80) ? BCD(Regs[2] & 0x3F) :
+                            BCD(Regs[2] & 0x1F) + ((Regs[2] & 0x20) ? 12 : 0),
+         BCD(Regs[1]), BCD(Regs[0] & 0x7F), BCD(Regs[5]),
+         (Regs[0] & 0x80) ? " CH" : "");
+}
+
+static int
+Cmd_Dump(void)
+{
+  const Record_t *Rec = NULL;
+  uint32_t PrevTick = 0;
+  unsigned i, j;
+
+  printf("records: %u, dropped: %u\n", RecordCount, Dropped);
+  for (i = 0; i < RecordCount; i++)
+  {
+    Rec = &Records[i];
+    printf("%10lu %+8ld %s %-13s",
+           (unsigned long)Rec->Tick, i ? (long)(Rec->Tick - PrevTick) : 0L,
+           Rec->Receive ? "R" : "W",
+           Rec->Reg < SIM_REGS ? Reg_Names[Rec->Reg] : "?");
+    for (j = 0; j < Rec->Len; j++)
+      printf(" %02X", Rec->Data[j]);
+    if (Rec->Result)
+      printf("  result %d", Rec->Result);
+    if (Rec->Reg == 0 && Rec->Len >= 7)
+      Dump_Time(Rec->Data);
+    if (!Rec->Receive && Rec->Reg == 0x07 && Rec->Len == 1)
+      printf("  [WP %s]", (Rec->Data[0] & 0x80) ? "on" : "off");
+    if (Rec->Reg <= 0x09 && Rec->Reg + Rec->Len > 0x09 && (!Rec->Receive || Rec->Len))
+      printf("  [FO %u]", Rec->Data[0x09 - Rec->Reg] & 0x0F);
+    printf("\n");
+    PrevTick = Rec->Tick;
+  }
+
+  return 0;
+}
+
+
+/* Simulated chip ---------------------------------------------------------------*/
+static uint8_t Sim_Regs[SIM_REGS];
+static uint8_t Sim_Pointer = 0;
+static Cost_t *Sim_Cost = NULL;
+
+static int8_t
+Sim_Send(uint8_t Address, uint8_t *Data, uint8_t Len)
+{
+  uint8_t i;
+
+  (void)Address;
+  Sim_Cost->Transactions++;
+  Sim_Cost->Bytes += 1 + Len;
+  Sim_Pointer = Data[0];
+  for (i = 1; i < Len; i++)
+    Sim_Regs[(Sim_Pointer++) % SIM_REGS] = Data[i];
+
+  return 0;
+}
+
+static int8_t
+Sim_Receive(uint8_t Address, uint8_t *Data, uint8_t Len)
+{
+  uint8_t i;
+
+  (void)Address;
+  Sim_Cost->Transactions++;
+  Sim_Cost->Bytes += 1 + Len;
+  for (i = 0; i < Len; i++)
+    Data[i] = Sim_Regs[(Sim_Pointer++) % SIM_REGS];
+
+  return 0;
+}
+
+
+/* Replay -----------------------------------------------------------------------*/
+static int
+Rec_Is(unsigned i, uint8_t Receive, uint8_t Reg, int Len)
+{
+  return i < RecordCount && Records[i].Receive == Receive &&
+         Records[i].Reg == Reg && (Len < 0 || Records[i].Len == Len);
+}
+
+static int
+Rec_IsWP(unsigned i, uint8_t Enable)
+{
+  return Rec_Is(i, 0, 0x07, 1) && ((Records[i].Data[0] & 0x80) ? 1 : 0) == Enable;
+}
+
+/**
+ * @brief  Recognize the operation starting at record i
+ * @retval Number of records of the operation
+ */
+static unsigned
+Op_Match(unsigned i, OpType_t *Type)
+{
+  // pointer set followed by a read
+  if (Rec_Is(i, 0, 0x00, 0) && Rec_Is(i + 1, 1, 0x00, -1))
+  {
+    switch (Records[i + 1].Len)
+    {
+    case 7:  *Type = OP_GET_DATETIME; return 2;
+    case 10: *Type = OP_PROBE;        return 2;
+    case 21: *Type = OP_READ_IMAGE;   return 2;
+    default: break;
+    }
+  }
+
+  // WP off, 7 time registers, WP on
+  if (Rec_IsWP(i, 0) && Rec_Is(i + 1, 0, 0x00, 7) && Rec_IsWP(i + 2, 1))
+  {
+    *Type = OP_SET_DATETIME;
+    return 3;
+  }
+
+  // [read INT], WP off, write INT, WP on, [read INT]
+  if (Rec_Is(i, 0, 0x09, 0) && Rec_Is(i + 1, 1, 0x09, 1) &&
+      Rec_IsWP(i + 2, 0) && Rec_Is(i + 3, 0, 0x09, 1) && Rec_IsWP(i + 4, 1))
+  {
+    *Type = OP_SET_OUTWAVE;
+    if (Rec_Is(i + 5, 0, 0x09, 0) && Rec_Is(i + 6, 1, 0x09, 1))
+      return 7;
+    return 5;
+  }
+  if (Rec_IsWP(i, 0) && Rec_Is(i + 1, 0, 0x09, 1) && Rec_IsWP(i + 2, 1))
+  {
+    *Type = OP_SET_OUTWAVE;
+    return 3;
+  }
+
+  *Type = OP_RAW;
+  return 1;
+}
+
+static void
+Op_Replay(HT1382_Handler_t *Handler, OpType_t Type, unsigned i)
+{
+  const Record_t *Rec = &Records[i];
+  HT1382_DateTime_t DateTime;
+  HT1382_Image_t Image;
+  HT1382_Status_t Status;
+  uint8_t Buffer[256];
+
+  switch (Type)
+  {
+  case OP_GET_DATETIME:
+    HT1382_GetDateTime(Handler, &DateTime);
+    break;
+
+  case OP_SET_DATETIME:
+    Rec = &Records[i + 1];
+    DateTime.Second  = BCD(Rec->Data[0] & 0x7F);
+    DateTime.Minute  = BCD(Rec->Data[1]);
+    DateTime.Hour    = BCD(Rec->Data[2] & 0x3F);
+    DateTime.Day     = BCD(Rec->Data[3]);
+    DateTime.Month   = BCD(Rec->Data[4]);
+    DateTime.WeekDay = BCD(Rec->Data[5]);
+    DateTime.Year    = BCD(Rec->Data[6]);
+    HT1382_SetDateTime(Handler, &DateTime);
+    break;
+
+  case OP_SET_OUTWAVE:
+    Rec = (Records[i].Len == 0) ? &Records[i + 3] : &Records[i + 1];
+    HT1382_SetOutWave(Handler, (HT1382_OutWave_t)(Rec->Data[0] & 0x0F));
+    break;
+
+  case OP_READ_IMAGE:
+    HT1382_ReadImage(Handler, &Image);
+    break;
+
+  case OP_PROBE:
+    HT1382_Probe(Handler, &Status, HT1382_PROBE_READ_ONLY);
+    break;
+
+  case OP_RAW:
+  default:
+    Buffer[0] = Rec->Reg;
+    memcpy(Buffer + 1, Rec->Data, Rec->Len);
+    if (Rec->Receive)
+      Handler->Platform.Receive(0x68, Buffer, Rec->Len);
+    else
+      Handler->Platform.Send(0x68, Buffer, Rec->Len + 1);
+    break;
+  }
+}
+
+/**
+ * @brief  Initialize a handler on the simulated chip, not counted in any cost
+ */
+static int
+Replay_Init(HT1382_Handler_t *Handler)
+{
+  static Cost_t Scratch;
+
+  Sim_Cost = &Scratch;
+  HT1382_PLATFORM_LINK_SEND(Handler, Sim_Send);
+  HT1382_PLATFORM_LINK_RECEIVE(Handler, Sim_Receive);
+  if (HT1382_Init(Handler) != HT1382_OK)
+    return -1;
+
+#if HT1382_CONFIG_SHADOW
+  // the recorded session loaded its shadow before the trace began
+  if (HT1382_ResyncShadow(Handler) != HT1382_OK)
+    return -1;
+#endif
+
+  return 0;
+}
+
+static int
+Cmd_Replay(int Check)
+{
+  HT1382_Handler_t Handler = {0};
+  Cost_t Recorded[OP_COUNT] = {{0}};
+  Cost_t Replayed[OP_COUNT] = {{0}};
+  Cost_t TotalRec = {0}, TotalRep = {0};
+  uint8_t Seeded[SIM_REGS] = {0};
+  OpType_t Type;
+  unsigned i, j, n;
+
+  // seed the simulated chip with the first value read from each register; the
+  // driver leaves write protection on between calls
+  Sim_Regs[0x07] = 0x80;
+  for (i = 0; i < RecordCount; i++)
+    if (Records[i].Receive)
+      for (j = 0; j < Records[i].Len; j++)
+        if (Records[i].Reg + j < SIM_REGS && !Seeded[Records[i].Reg + j])
+        {
+          Sim_Regs[Records[i].Reg + j] = Records[i].Data[j];
+          Seeded[Records[i].Reg + j] = 1;
+        }
+
+  if (Replay_Init(&Handler) < 0)
+    return 1;
+
+  for (i = 0; i < RecordCount; i += n)
+  {
+    n = Op_Match(i, &Type);
+
+    Recorded[Type].Ops++;
+    for (j = i; j < i + n; j++)
+    {
+      Recorded[Type].Transactions++;
+      Recorded[Type].Bytes += Record_WireBytes(&Records[j]);
+    }
+
+    Sim_Cost = &Replayed[Type];
+    Replayed[Type].Ops++;
+    Op_Replay(&Handler, Type, i);
+  }
+
+  printf("records: %u, dropped: %u, bus rate: %lu Hz\n\n", RecordCount, Dropped, Rate);
+  printf("%-12s %6s | %6s %6s %9s | %6s %6s %9s\n", "operation", "ops",
+         "rec tx", "bytes", "wire us", "new tx", "bytes", "wire us");
+  for (i = 0; i < OP_COUNT; i++)
+  {
+    if (!Recorded[i].Ops)
+      continue;
+    printf("%-12s %6u | %6u %6u %9.0f | %6u %6u %9.0f\n", Op_Names[i], Recorded[i].Ops,
+           Recorded[i].Transactions, Recorded[i].Bytes, Cost_WireUs(&Recorded[i]),
+           Replayed[i].Transactions, Replayed[i].Bytes, Cost_WireUs(&Replayed[i]));
+    TotalRec.Transactions += Recorded[i].Transactions;
+    TotalRec.Bytes += Recorded[i].Bytes;
+    TotalRep.Transactions += Replayed[i].Transactions;
+    TotalRep.Bytes += Replayed[i].Bytes;
+  }
+  printf("%-12s %6s | %6u %6u %9.0f | %6u %6u %9.0f\n", "total", "",
+         TotalRec.Transactions, TotalRec.Bytes, Cost_WireUs(&TotalRec),
+         TotalRep.Transactions, TotalRep.Bytes, Cost_WireUs(&TotalRep));
+  if (RecordCount > 1)
+    printf("\nrecorded span: %lu ticks\n",
+           (unsigned long)(Records[RecordCount - 1].Tick - Records[0].Tick));
+
+  if (Check && Cost_WireUs(&TotalRep) > Cost_WireUs(&TotalRec))
+  {
+    printf("bus cost regression\n");
+    return 1;
+  }
+
+  return 0;
+}
+
+
+/* Sample trace -----------------------------------------------------------------*/
+static uint32_t Record_Tick = 0;
+
+static uint32_t
+Record_GetTick(void)
+{
+  // microseconds, about one 100 kHz transaction apart
+  Record_Tick += 250;
+  return Record_Tick;
+}
+
+static int
+Cmd_Record(const char *Path)
+{
+  static uint8_t Buffer[2048];
+  static uint8_t Out[2048];
+  HT1382_Handler_t Handler = {0};
+  HT1382_Trace_t Trace;
+  HT1382_DateTime_t DateTime = {0};
+  HT1382_Image_t Image;
+#if HT1382_CONFIG_PROBE
+  HT1382_Status_t Status;
+#endif
+  FILE *File = NULL;
+  uint16_t Len = 0;
+  int i;
+
+  // 2024-05-01 12:30:00, 24-hour mode
+  Sim_Regs[0x00] = 0x00;
+  Sim_Regs[0x01] = 0x30;
+  Sim_Regs[0x02] = 0x92;
+  Sim_Regs[0x03] = 0x01;
+  Sim_Regs[0x04] = 0x05;
+  Sim_Regs[0x05] = 0x04;
+  Sim_Regs[0x06] = 0x24;
+  if (Replay_Init(&Handler) < 0 ||
+      HT1382_Trace_Start(&Trace, &Handler, Buffer, sizeof(Buffer), Record_GetTick) != HT1382_OK)
+    return 1;
+
+  for (i = 0; i < 3; i++)
+    HT1382_GetDateTime(&Handler, &DateTime);
+  DateTime.Minute = 45;
+  HT1382_SetDateTime(&Handler, &DateTime);
+  HT1382_SetOutWave(&Handler, HT1382_OUTWAVE_1HZ);
+  HT1382_SetOutWave(&Handler, HT1382_OUTWAVE_4096HZ);
+  HT1382_ReadImage(&Handler, &Image);
+#if HT1382_CONFIG_PROBE
+  HT1382_Probe(&Handler, &Status, HT1382_PROBE_READ_ONLY);
+#endif
+  HT1382_GetDateTime(&Handler, &DateTime);
+
+  HT1382_Trace_Stop(&Trace, &Handler);
+  Len = HT1382_Trace_Export(&Trace, Out, sizeof(Out));
+
+  File = fopen(Path, "wb");
+  if (!File || fwrite(Out, 1, Len, File) != Len)
+  {
+    perror(Path);
+    if (File)
+      fclose(File);
+    return 1;
+  }
+  fclose(File);
+
+  printf("%s: %u bytes\n", Path, (unsigned)Len);
+  return 0;
+}
+
+
+int main(int argc, char *argv[])
+{
+  int Check = 0;
+  int i;
+
+  if (argc < 3 || (strcmp(argv[1], "dump") && strcmp(argv[1], "replay") &&
+                    strcmp(argv[1], "record")))
+  {
+    fprintf(stderr, "usage: %s dump|replay|record FILE [--rate HZ] [--check]\n", argv[0]);
+    return 2;
+  }
+
+  if (!strcmp(argv[1], "record"))
+    return Cmd_Record(argv[2]);
+
+  for (i = 3; i < argc; i++)
+  {
+    if (!strcmp(argv[i], "--rate") && i + 1 < argc)
+      Rate = strtoul(argv[++i], NULL, 0);
+    else if (!strcmp(argv[i], "--check"))
+      Check = 1;
+  }
+  if (!Rate)
+    Rate = 100000;
+
+  if (Trace_Load(argv[2]) < 0)
+    return 1;
+
+  if (!strcmp(argv[1], "dump"))
+    return Cmd_Dump();
+
+  return Cmd_Replay(Check);
+}
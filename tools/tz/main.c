@@ -0,0 +1,250 @@
+/**
+ **********************************************************************************
+ * @file   main.c
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  Check and benchmark of the HT1382_tz conversions
+ **********************************************************************************
+ *
+ * Copyright (c) 2024 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+
+
+/**
+ * Usage: ht1382-tz-check [--from YEAR] [--bench]
+ *
+ * For every zone of the generated table (see makefile), compares
+ * HT1382_Tz_ToLocal with the C library (TZ=:Name) every 15 minutes and at
+ * random seconds from YEAR (default 2012, the first year the current rule
+ * of every zone of the makefile is in force) to 2099, and checks that
+ * HT1382_Tz_ToUtc maps every local time back to its instant. With --bench,
+ * prints the cost of one conversion in CPU timestamp counter cycles (x86) or
+ * nanoseconds.
+ */
+
+#define _DEFAULT_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "HT1382_tz.h"
+#include "HT1382_tz_zones.h"
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_UNIT  "cycles"
+#else
+#define BENCH_UNIT  "ns"
+#endif
+
+
+#define CHECK_FROM    2012
+
+#define BENCH_SAMPLES 4096
+#define BENCH_ROUNDS  2000
+
+
+static uint32_t Rand_State = 1;
+
+static uint32_t
+Rand_Next(void)
+{
+  // xorshift32
+  Rand_State ^= Rand_State << 13;
+  Rand_State ^= Rand_State >> 17;
+  Rand_State ^= Rand_State << 5;
+  return Rand_State;
+}
+
+static uint64_t
+Bench_Now(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  struct timespec Ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &Ts);
+  return (uint64_t)Ts.tv_sec * 1000000000ULL + Ts.tv_nsec;
+#endif
+}
+
+static uint32_t
+Year_Epoch(int Year)
+{
+  HT1382_DateTime_t DateTime = {0, 0, 0, 1, 1, 1, (uint8_t)(Year - 2000)};
+
+  return HT1382_Time_ToEpoch(&DateTime);
+}
+
+/**
+ * @brief  Compare one instant with the C library, returns 0 if equal
+ */
+static int
+Check_One(int Zone, uint32_t Epoch)
+{
+  const HT1382_TzZone_t *Tz = &HT1382_TzZones[Zone];
+  time_t T = (time_t)Epoch;
+  struct tm Tm;
+  uint32_t Local = 0;
+  uint32_t Earlier = 0;
+  uint32_t Later = 0;
+  uint8_t IsDst = 0;
+
+  localtime_r(&T, &Tm);
+  Local = HT1382_Tz_ToLocal(Tz, Epoch, &IsDst);
+  if (Local != Epoch + (uint32_t)Tm.tm_gmtoff || IsDst != (Tm.tm_isdst > 0))
+  {
+    printf("%s: %lu: local %+ld dst %u, libc %+ld dst %d\n",
+           HT1382_TzZoneNames[Zone], (unsigned long)Epoch,
+           (long)(int32_t)(Local - Epoch), IsDst, (long)Tm.tm_gmtoff, Tm.tm_isdst);
+    return 1;
+  }
+
+  Earlier = HT1382_Tz_ToUtc(Tz, Local, HT1382_TZ_EARLIER);
+  Later = HT1382_Tz_ToUtc(Tz, Local, HT1382_TZ_LATER);
+  if ((Earlier != Epoch && Later != Epoch) || Earlier > Later)
+  {
+    printf("%s: %lu: back to %lu / %lu\n", HT1382_TzZoneNames[Zone],
+           (unsigned long)Epoch, (unsigned long)Earlier, (unsigned long)Later);
+    return 1;
+  }
+
+  return 0;
+}
+
+static int
+Check(int From)
+{
+  uint32_t Epoch = 0;
+  uint32_t End = Year_Epoch(2099) + 365 * 86400UL;
+  unsigned long Count = 0;
+  int Errors = 0;
+  int Zone = 0;
+
+  for (Zone = 0; Zone < HT1382_TZ_COUNT; Zone++)
+  {
+    char Env[64];
+
+    snprintf(Env, sizeof(Env), ":%s", HT1382_TzZoneNames[Zone]);
+    setenv("TZ", Env, 1);
+    tzset();
+
+    for (Epoch = Year_Epoch(From); Epoch < End && Errors < 10; Epoch += 900)
+    {
+      Errors += Check_One(Zone, Epoch);
+      Errors += Check_One(Zone, Epoch + Rand_Next() % 900);
+      Count += 2;
+    }
+  }
+
+  printf("%lu instants in %d zones checked from %d: %s\n",
+         Count, HT1382_TZ_COUNT, From, Errors ? "FAIL" : "OK");
+  return Errors ? 1 : 0;
+}
+
+static void
+Bench(void)
+{
+  static uint32_t Epochs[BENCH_SAMPLES];
+  static HT1382_DateTime_t DateTimes[BENCH_SAMPLES];
+  HT1382_DateTime_t Local;
+  volatile uint32_t Sink = 0;
+  uint64_t Start = 0;
+  double Cost[3];
+  int Zone = 0;
+  int Round = 0;
+  int i = 0;
+
+  for (i = 0; i < BENCH_SAMPLES; i++)
+  {
+    Epochs[i] = Year_Epoch(2000) + Rand_Next() % (3155760000UL);
+    HT1382_Time_FromEpoch(Epochs[i], &DateTimes[i]);
+  }
+
+  printf("%-20s %12s %12s %12s   (%s per conversion)\n",
+         "zone", "ToLocal", "ToUtc", "DateTime", BENCH_UNIT);
+  for (Zone = 0; Zone < HT1382_TZ_COUNT; Zone++)
+  {
+    const HT1382_TzZone_t *Tz = &HT1382_TzZones[Zone];
+
+    Start = Bench_Now();
+    for (Round = 0; Round < BENCH_ROUNDS; Round++)
+      for (i = 0; i < BENCH_SAMPLES; i++)
+        Sink += HT1382_Tz_ToLocal(Tz, Epochs[i], NULL);
+    Cost[0] = (double)(Bench_Now() - Start) / ((double)BENCH_ROUNDS * BENCH_SAMPLES);
+
+    Start = Bench_Now();
+    for (Round = 0; Round < BENCH_ROUNDS; Round++)
+      for (i = 0; i < BENCH_SAMPLES; i++)
+        Sink += HT1382_Tz_ToUtc(Tz, Epochs[i], HT1382_TZ_EARLIER);
+    Cost[1] = (double)(Bench_Now() - Start) / ((double)BENCH_ROUNDS * BENCH_SAMPLES);
+
+    Start = Bench_Now();
+    for (Round = 0; Round < BENCH_ROUNDS; Round++)
+      for (i = 0; i < BENCH_SAMPLES; i++)
+      {
+        HT1382_Tz_DateTimeToLocal(Tz, &DateTimes[i], &Local, NULL);
+        Sink += Local.Second;
+      }
+    Cost[2] = (double)(Bench_Now() - Start) / ((double)BENCH_ROUNDS * BENCH_SAMPLES);
+
+    printf("%-20s %12.1f %12.1f %12.1f\n",
+           HT1382_TzZoneNames[Zone], Cost[0], Cost[1], Cost[2]);
+  }
+  (void)Sink;
+}
+
+
+int main(int argc, char *argv[])
+{
+  int From = CHECK_FROM;
+  int DoBench = 0;
+  int i = 0;
+
+  for (i = 1; i < argc; i++)
+  {
+    if (!strcmp(argv[i], "--from") && i + 1 < argc)
+      From = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--bench"))
+      DoBench = 1;
+    else
+    {
+      fprintf(stderr, "usage: %s [--from YEAR] [--bench]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  if (From < 2000 || From > 2099)
+  {
+    fprintf(stderr, "%s: --from must be within 2000 ... 2099\n", argv[0]);
+    return 2;
+  }
+
+  if (DoBench)
+  {
+    Bench();
+    return 0;
+  }
+
+  return Check(From);
+}
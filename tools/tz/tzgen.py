@@ -0,0 +1,196 @@
+#!/usr/bin/env python3
+"""Generate HT1382_tz zone tables.
+
+Each zone is given as an IANA name (its current rule is taken from the POSIX
+TZ string at the end of the compiled tzdata file) or as NAME=POSIX_TZ:
+
+    tzgen.py -o build/HT1382_tz_zones Europe/Berlin America/New_York \
+             Office=EST5EDT,M3.2.0,M11.1.0
+
+writes build/HT1382_tz_zones.h (zone indexes) and build/HT1382_tz_zones.c
+(the HT1382_TzZones table in flash).
+"""
+
+import argparse
+import os
+import re
+import sys
+
+
+def fail(msg):
+    sys.exit("tzgen: " + msg)
+
+
+def read_footer(zoneinfo, name):
+    path = os.path.join(zoneinfo, name)
+    try:
+        with open(path, "rb") as f:
+            data = f.read()
+    except OSError as e:
+        fail("%s: %s" % (name, e.strerror))
+    if data[:4] != b"TZif" or data[4:5] < b"2":
+        fail("%s: not a version 2+ TZif file" % name)
+    footer = data.rstrip(b"\n").rsplit(b"\n", 1)[-1].decode("ascii")
+    if not footer:
+        fail("%s: no POSIX TZ footer" % name)
+    return footer
+
+
+def tzdata_version(zoneinfo):
+    try:
+        with open(os.path.join(zoneinfo, "tzdata.zi")) as f:
+            m = re.match(r"# version (\S+)", f.readline())
+            return m.group(1) if m else None
+    except OSError:
+        return None
+
+
+class Parser:
+    """POSIX TZ string parser (IEEE 1003.1 with the RFC 8536 extensions)"""
+
+    def __init__(self, text):
+        self.text = text
+        self.pos = 0
+
+    def error(self, what):
+        fail("'%s': %s at position %d" % (self.text, what, self.pos))
+
+    def peek(self):
+        return self.text[self.pos:self.pos + 1]
+
+    def name(self):
+        if self.peek() == "<":
+            end = self.text.find(">", self.pos)
+            if end < 0:
+                self.error("unterminated <name>")
+            self.pos = end + 1
+            return
+        m = re.compile(r"[A-Za-z]{3,}").match(self.text, self.pos)
+        if not m:
+            self.error("zone abbreviation expected")
+        self.pos = m.end()
+
+    def time(self, signed):
+        """[+-]hh[:mm[:ss]] in seconds"""
+        m = re.compile(r"([+-]?)(\d{1,3})(?::(\d{2}))?(?::(\d{2}))?").match(self.text, self.pos)
+        if not m or (m.group(1) and not signed):
+            self.error("time expected")
+        self.pos = m.end()
+        value = int(m.group(2)) * 3600 + int(m.group(3) or 0) * 60 + int(m.group(4) or 0)
+        return -value if m.group(1) == "-" else value
+
+    def rule(self):
+        m = re.compile(r"M(\d{1,2})\.(\d)\.(\d)").match(self.text, self.pos)
+        if not m:
+            self.error("only Mm.w.d transition rules are supported")
+        self.pos = m.end()
+        month, week, day = (int(g) for g in m.groups())
+        if not (1 <= month <= 12 and 1 <= week <= 5 and 0 <= day <= 6):
+            self.error("transition rule out of range")
+        seconds = 7200
+        if self.peek() == "/":
+            self.pos += 1
+            seconds = self.time(signed=True)
+        return month, week, day + 1, seconds
+
+    def parse(self):
+        self.name()
+        std = -self.time(signed=True)
+        if self.pos == len(self.text):
+            return std, std, None, None
+        self.name()
+        dst = std + 3600
+        if self.peek() not in (",", ""):
+            dst = -self.time(signed=True)
+        if self.peek() != ",":
+            self.error("DST zone without transition rules")
+        self.pos += 1
+        start = self.rule()
+        if self.peek() != ",":
+            self.error("',' expected")
+        self.pos += 1
+        end = self.rule()
+        if self.pos != len(self.text):
+            self.error("trailing characters")
+        return std, dst, start, end
+
+
+def minutes(seconds, what, tz):
+    if seconds % 60:
+        fail("'%s': %s is not a whole minute" % (tz, what))
+    return seconds // 60
+
+
+def identifier(name):
+    return "HT1382_TZ_" + re.sub(r"[^A-Z0-9]+", "_", name.upper()).strip("_")
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    ap.add_argument("zones", nargs="+", metavar="ZONE",
+                    help="IANA zone name or NAME=POSIX_TZ")
+    ap.add_argument("-o", "--output", required=True,
+                    help="output path without extension (.h and .c are written)")
+    ap.add_argument("--zoneinfo", default="/usr/share/zoneinfo",
+                    help="compiled tzdata directory (default: %(default)s)")
+    ap.add_argument("--names", action="store_true",
+                    help="also emit the HT1382_TzZoneNames string table")
+    args = ap.parse_args()
+
+    zones = []
+    uses_tzdata = False
+    for arg in args.zones:
+        if "=" in arg:
+            name, tz = arg.split("=", 1)
+        else:
+            name, tz = arg, read_footer(args.zoneinfo, arg)
+            uses_tzdata = True
+        std, dst, start, end = Parser(tz).parse()
+        row = [minutes(std, "offset", tz), minutes(dst, "DST offset", tz)]
+        for rule in (start, end):
+            if rule is None:
+                row.append("{0, 0, 0, 0}")
+            else:
+                row.append("{%d, %d, %d, %d}" % (rule[0], rule[1], rule[2],
+                                                 minutes(rule[3], "transition time", tz)))
+        if identifier(name) in (z[1] for z in zones):
+            fail("duplicate zone identifier %s" % identifier(name))
+        zones.append((name, identifier(name), tz, row))
+
+    source = "tools/tz/tzgen.py"
+    if uses_tzdata:
+        version = tzdata_version(args.zoneinfo)
+        source += " from tzdata " + (version or "(unknown version)")
+    base = os.path.basename(args.output)
+    guard = "_" + re.sub(r"[^A-Z0-9]", "_", base.upper()) + "_H_"
+    width = max(len(z[1]) for z in zones) + 1
+
+    with open(args.output + ".h", "w") as f:
+        f.write("/* Generated by %s -- do not edit */\n\n" % source)
+        f.write("#ifndef %s\n#define %s\n\n" % (guard, guard))
+        f.write('#include "HT1382_tz.h"\n\n')
+        f.write("/* Zone indexes in HT1382_TzZones */\n")
+        for i, z in enumerate(zones):
+            f.write("#define %-*s %d\n" % (width, z[1], i))
+        f.write("#define %-*s %d\n\n" % (width, "HT1382_TZ_COUNT", len(zones)))
+        f.write("extern const HT1382_TzZone_t HT1382_TzZones[HT1382_TZ_COUNT];\n")
+        if args.names:
+            f.write("extern const char *const HT1382_TzZoneNames[HT1382_TZ_COUNT];\n")
+        f.write("\n#endif\n")
+
+    with open(args.output + ".c", "w") as f:
+        f.write("/* Generated by %s -- do not edit */\n\n" % source)
+        f.write('#include "%s.h"\n\n' % base)
+        f.write("const HT1382_TzZone_t HT1382_TzZones[HT1382_TZ_COUNT] HT1382_CONST =\n{\n")
+        for z in zones:
+            f.write("  {%d, %d, %s, %s}, // %s: %s\n" % (z[3][0], z[3][1], z[3][2], z[3][3], z[0], z[2]))
+        f.write("};\n")
+        if args.names:
+            f.write("\nconst char *const HT1382_TzZoneNames[HT1382_TZ_COUNT] =\n{\n")
+            for z in zones:
+                f.write('  "%s",\n' % z[0])
+            f.write("};\n")
+
+
+if __name__ == "__main__":
+    main()